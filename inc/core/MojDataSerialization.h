@@ -32,6 +32,7 @@ public:
 	MojErr writeUInt8(MojByte val) { return m_buf.writeByte(val); }
 	MojErr writeUInt16(MojUInt16 val);
 	MojErr writeUInt32(MojUInt32 val);
+	MojErr writeVarUInt32(MojUInt32 val);
 	MojErr writeInt64(MojInt64 val);
 	MojErr writeDecimal(const MojDecimal& val);
 	MojErr writeChars(const MojChar* chars, MojSize len);
@@ -55,6 +56,7 @@ public:
 	MojErr readUInt8(MojByte& val);
 	MojErr readUInt16(MojUInt16& val);
 	MojErr readUInt32(MojUInt32& val);
+	MojErr readVarUInt32(MojUInt32& val);
 	MojErr readInt64(MojInt64& val);
 	MojErr readDecimal(MojDecimal& val);
 	MojErr skip(MojSize len);
@@ -0,0 +1,150 @@
+/* @@@LICENSE
+*
+*  Copyright (c) 2014 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef MOJFLATMAP_H_
+#define MOJFLATMAP_H_
+
+#include "core/MojCoreDefs.h"
+#include "core/MojComp.h"
+#include "core/MojVector.h"
+
+// Map with the same interface and ordering as MojMap, but whose entries live in one
+// sorted, copy-on-write vector. Lookups are binary searches over contiguous memory
+// and a map costs a single allocation instead of one tree node per entry, which
+// suits small maps such as object properties. Inserts and deletes move the entries
+// after the affected position, and invalidate iterators into the same map.
+template<class KEY, class VAL, class LKEY = KEY,
+		 class KCOMP = MojComp<LKEY>, class VCOMP = MojComp<VAL> >
+class MojFlatMap
+{
+	struct Entry;
+public:
+	class Iterator;
+	typedef KEY KeyType;
+	typedef VAL ValueType;
+	typedef LKEY LookupType;
+
+	// like MojMap, the end iterator is null so that a default iterator compares equal to end()
+	class ConstIterator
+	{
+		friend class Iterator;
+		friend class MojFlatMap;
+	public:
+		ConstIterator() : m_pos(NULL), m_end(NULL) {}
+
+		const KeyType& key() const { MojAssert(m_pos); return m_pos->m_key; }
+		const ValueType& value() const { MojAssert(m_pos); return m_pos->m_val; }
+
+		void operator++() { MojAssert(m_pos); if (++m_pos == m_end) m_pos = m_end = NULL; }
+		const ConstIterator operator++(int) { return MojPostIncrement(*this); }
+		bool operator==(const ConstIterator& rhs) const { return m_pos == rhs.m_pos; }
+		bool operator==(const Iterator& rhs) const { return m_pos == rhs.m_pos; }
+		bool operator!=(const ConstIterator& rhs) const { return m_pos != rhs.m_pos; }
+		bool operator!=(const Iterator& rhs) const { return m_pos != rhs.m_pos; }
+		const ValueType& operator*() const { return value(); }
+		const ValueType* operator->() const { return &value(); }
+
+	private:
+		ConstIterator(const Entry* pos, const Entry* end) : m_pos(pos == end ? NULL : pos), m_end(pos == end ? NULL : end) {}
+		const Entry* m_pos;
+		const Entry* m_end;
+	};
+
+	class Iterator
+	{
+		friend class ConstIterator;
+		friend class MojFlatMap;
+	public:
+		Iterator() : m_pos(NULL), m_end(NULL) {}
+
+		const KeyType& key() const { MojAssert(m_pos); return m_pos->m_key; }
+		ValueType& value() const { MojAssert(m_pos); return m_pos->m_val; }
+
+		void operator++() { MojAssert(m_pos); if (++m_pos == m_end) m_pos = m_end = NULL; }
+		const Iterator operator++(int) { return MojPostIncrement(*this); }
+		bool operator==(const ConstIterator& rhs) const { return m_pos == rhs.m_pos; }
+		bool operator==(const Iterator& rhs) const { return m_pos == rhs.m_pos; }
+		bool operator!=(const ConstIterator& rhs) const { return m_pos != rhs.m_pos; }
+		bool operator!=(const Iterator& rhs) const { return m_pos != rhs.m_pos; }
+		ValueType& operator*() const { return value(); }
+		ValueType* operator->() const { return &value(); }
+
+	private:
+		Iterator(Entry* pos, Entry* end) : m_pos(pos == end ? NULL : pos), m_end(pos == end ? NULL : end) {}
+		Entry* m_pos;
+		Entry* m_end;
+	};
+
+	MojFlatMap() {}
+	MojFlatMap(const MojFlatMap& map) : m_vec(map.m_vec) {}
+
+	MojSize size() const { return m_vec.size(); }
+	bool empty() const { return m_vec.empty(); }
+
+	ConstIterator begin() const { return ConstIterator(m_vec.begin(), m_vec.end()); }
+	ConstIterator end() const { return ConstIterator(); }
+
+	MojErr begin(Iterator& iter) { return iterAt(0, iter); }
+	MojErr end(Iterator& iter) { iter = Iterator(); return MojErrNone; }
+
+	void clear() { m_vec.clear(); }
+	void swap(MojFlatMap& map) { m_vec.swap(map.m_vec); }
+	void assign(const MojFlatMap& map) { m_vec.assign(map.m_vec); }
+	MojErr reserve(MojSize numElems) { return m_vec.reserve(numElems); }
+	int compare(const MojFlatMap& map) const;
+
+	bool contains(const LookupType& key) const { return find(key) != end(); }
+	bool get(const LookupType& key, ValueType& valOut) const;
+	MojErr del(const LookupType& key, bool& foundOut);
+	MojErr put(const KeyType& key, const ValueType& val);
+	MojErr put(const MojFlatMap& map);
+
+	ConstIterator find(const LookupType& key) const;
+	MojErr find(const LookupType& key, Iterator& iter);
+	ConstIterator lowerBound(const LookupType& key) const;
+	MojErr lowerBound(const LookupType& key, Iterator& iter);
+	ConstIterator upperBound(const LookupType& key) const;
+	MojErr upperBound(const LookupType& key, Iterator& iter);
+
+	MojFlatMap& operator=(const MojFlatMap& rhs) { assign(rhs); return *this; }
+	bool operator==(const MojFlatMap& rhs) const { return size() == rhs.size() && compare(rhs) == 0; }
+	bool operator!=(const MojFlatMap& rhs) const { return !operator==(rhs); }
+	bool operator<(const MojFlatMap& rhs) const { return compare(rhs) < 0; }
+	bool operator<=(const MojFlatMap& rhs) const { return compare(rhs) <= 0; }
+	bool operator>(const MojFlatMap& rhs) const { return compare(rhs) > 0; }
+	bool operator>=(const MojFlatMap& rhs) const { return compare(rhs) >= 0; }
+
+private:
+	struct Entry
+	{
+		Entry() {}
+		Entry(const KeyType& key, const ValueType& val) : m_key(key), m_val(val) {}
+		KeyType m_key;
+		ValueType m_val;
+	};
+	typedef MojVector<Entry> EntryVec;
+
+	MojSize lowerIndex(const LookupType& key, bool& foundOut) const;
+	MojErr iterAt(MojSize idx, Iterator& iter);
+
+	EntryVec m_vec;
+};
+
+#include "core/internal/MojFlatMapInternal.h"
+
+#endif /* MOJFLATMAP_H_ */
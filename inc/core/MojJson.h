@@ -46,6 +46,9 @@ public:
 
 private:
 	static const MojSize InitialSize = 1024;
+	// reset() frees buffers bigger than this so that long-lived messages
+	// (subscriptions) do not pin the memory of their largest reply
+	static const MojSize MaxRetainedSize = 64 * 1024;
 
 	MojErr writeString(const MojChar* val, MojSize len);
 	MojErr writeComma();
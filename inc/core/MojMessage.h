@@ -22,6 +22,7 @@
 
 #include "core/MojCoreDefs.h"
 #include "core/MojSignal.h"
+#include "core/MojTime.h"
 
 class MojMessage : public MojSignalHandler
 {
@@ -34,6 +35,7 @@ protected:
 	friend class MojMessageDispatcher;
 
 	MojListEntry m_queueEntry;
+	MojTime m_scheduleTime;
 };
 
 #endif /* MOJMESSAGE_H_ */
@@ -21,52 +21,102 @@
 #define MOJMESSAGEDISPATCHER_H_
 
 #include "core/MojCoreDefs.h"
+#include "core/MojHashMap.h"
 #include "core/MojMessage.h"
+#include "core/MojObject.h"
 #include "core/MojString.h"
 #include "core/MojThread.h"
 
+// Dispatches messages on a pool of worker threads. Messages with the same queue name are
+// dispatched in order, one at a time. Ready queues are served round-robin; a queue with
+// weight n gets up to n consecutive messages per turn.
 class MojMessageDispatcher : private MojNoCopy
 {
 public:
+	static const MojChar* const NumThreadsKey;
+	static const MojChar* const QueueWeightsKey;
+	static const MojChar* const StatsKey;
+	static const MojInt32 NumThreadsDefault = 3;
+	static const MojSize NumLatencyBuckets = 12;
+	static const MojSize MaxStatsQueues = 256;
+
 	MojMessageDispatcher();
 	~MojMessageDispatcher();
 
+	MojErr configure(const MojObject& conf);
 	MojErr schedule(MojMessage* msg);
+	MojErr start();
 	MojErr start(MojInt32 numThreads);
 	MojErr stop();
 	MojErr wait();
 
+	MojErr setWeight(const MojChar* queueName, MojUInt32 weight);
+	void enableStats(bool val) { m_collectStats = val; }
+	MojErr stats(MojObject& objOut) const;
+
+	MojInt32 numThreads() const { return m_numThreads; }
+
 private:
 	class Queue
 	{
 	public:
 		typedef MojList<MojMessage, &MojMessage::m_queueEntry> MessageList;
 
+		Queue() : m_weight(1), m_credits(1), m_scheduled(false) {}
+
 		bool empty() const { return m_messageList.empty(); }
 		const MojString& name() const { return m_name; }
 
 		MojErr init(const MojChar* name) { return m_name.assign(name); }
 		MojRefCountedPtr<MojMessage> pop();
 		void push(MojMessage* msg);
+		void clear();
 
 		MojString m_name;
 		MojListEntry m_entry;
 		MessageList m_messageList;
+		MojUInt32 m_weight;
+		MojUInt32 m_credits;
+		bool m_scheduled;
+	};
+
+	// dispatch latency (schedule to dispatch) histogram; bucket i counts latencies under 2^i ms,
+	// the last bucket collects everything slower
+	struct LatencyStats
+	{
+		LatencyStats();
+		void add(const MojTime& latency, const MojTime& now);
+		bool operator==(const LatencyStats& rhs) const;
+
+		MojInt64 m_count;
+		MojInt64 m_totalUs;
+		MojInt64 m_maxUs;
+		MojInt64 m_buckets[NumLatencyBuckets];
+		MojTime m_lastTime;
 	};
 
 	typedef MojList<Queue, &Queue::m_entry> QueueList;
+	typedef MojHashMap<MojString, Queue*, const MojChar*> QueueMap;
+	typedef MojHashMap<MojString, MojUInt32, const MojChar*> WeightMap;
+	typedef MojHashMap<MojString, LatencyStats, const MojChar*> StatsMap;
 	typedef MojVector<MojThreadT> ThreadVec;
 
 	MojErr dispatch(bool& stoppedOut);
+	MojErr recordLatency(const MojString& queueName, const MojTime& scheduleTime);
+	MojErr evictStats();
+	void deleteQueue(Queue* queue);
 
-	static Queue* findQueue(const MojChar* name, QueueList& list);
 	static MojErr threadMain(void* arg);
 
-	MojThreadMutex m_mutex;
+	mutable MojThreadMutex m_mutex;
 	MojThreadCond m_cond;
 	ThreadVec m_threads;
 	QueueList m_scheduledList;
-	QueueList m_pendingList;
+	QueueMap m_queues;
+	WeightMap m_weights;
+	StatsMap m_stats;
+	MojInt32 m_numThreads;
+	bool m_collectStats;
 	bool m_stop;
 };
 
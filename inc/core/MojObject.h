@@ -24,6 +24,9 @@
 #include "core/MojDecimal.h"
 #include "core/MojMap.h"
 #include "core/MojString.h"
+#ifdef MOJ_FLAT_OBJECT_MAP
+#include "core/MojFlatMap.h"
+#endif
 #include "core/MojVector.h"
 
 class MojObject
@@ -47,19 +50,26 @@ public:
 	typedef MojVector<MojObject> ObjectVec;
 	typedef ObjectVec::ConstIterator ConstArrayIterator;
 	typedef ObjectVec::Iterator ArrayIterator;
+#ifdef MOJ_FLAT_OBJECT_MAP
+	// props are kept in one sorted vector instead of a tree node per prop
+	typedef MojFlatMap<MojString, MojObject, const MojChar*> PropMap;
+#else
 	typedef MojMap<MojString, MojObject, const MojChar*> PropMap;
+#endif
 	typedef PropMap::ConstIterator ConstIterator;
 	typedef PropMap::Iterator Iterator;
 
-	MojObject() { m_implementation = new UndefinedImpl(); }
-	MojObject(const MojObject& obj) { m_implementation = 0; init(obj); }
-	MojObject(bool val) { m_implementation = new BoolImpl(val); }
-	MojObject(MojInt64 val) { m_implementation = new IntImpl(val); }
-	MojObject(MojInt32 val) { m_implementation = new IntImpl(val); }
-	MojObject(MojUInt32 val) { m_implementation = new IntImpl(val); } //mapped to IntImpl
-	MojObject(const MojDecimal& val) { m_implementation = new DecimalImpl(val); }
-	MojObject(const MojString& val) { m_implementation = new StringImpl(val); }
-	explicit MojObject(Type type) { m_implementation = 0; init(type); }
+	// impls are constructed in place, so scalars never touch the heap and copying
+	// a container only shares its copy-on-write map, vector or string
+	MojObject() { new (&m_impl) UndefinedImpl(); }
+	MojObject(const MojObject& obj) { obj.impl()->copyTo(&m_impl); }
+	MojObject(bool val) { new (&m_impl) BoolImpl(val); }
+	MojObject(MojInt64 val) { new (&m_impl) IntImpl(val); }
+	MojObject(MojInt32 val) { new (&m_impl) IntImpl(val); }
+	MojObject(MojUInt32 val) { new (&m_impl) IntImpl(val); } //mapped to IntImpl
+	MojObject(const MojDecimal& val) { new (&m_impl) DecimalImpl(val); }
+	MojObject(const MojString& val) { new (&m_impl) StringImpl(val); }
+	explicit MojObject(Type type) { new (&m_impl) UndefinedImpl(); init(type); }
 	~MojObject() { release(); }
 
 	inline Type type() const { return impl()->type(); }
@@ -158,7 +168,7 @@ private:
 	public:
 		virtual ~Impl() {}
 		virtual Type type() const = 0;
-		virtual Impl* clone() const = 0;
+		virtual void copyTo(void* buf) const = 0;
 		virtual int compare (const Impl& rhs) const = 0;
 		virtual bool equals(const Impl& rhs) const = 0;
 		virtual MojSize hashCode() const = 0;
@@ -181,7 +191,7 @@ private:
 	{
 	public:
 		virtual Type type() const { return TypeNull; }
-		virtual Impl* clone() const { return new NullImpl(); }
+		virtual void copyTo(void* buf) const { new (buf) NullImpl(); }
 		virtual int compare (const Impl& rhs) const;
 		virtual bool equals(const Impl& rhs) const;
 		virtual MojSize hashCode() const;
@@ -192,7 +202,7 @@ private:
 	{
 	public:
 		virtual Type type() const { return TypeUndefined; }
-		virtual Impl* clone() const { return new UndefinedImpl(); }
+		virtual void copyTo(void* buf) const { new (buf) UndefinedImpl(); }
 		virtual MojSize hashCode() const;
 		virtual MojSize objectSize() const  { return sizeof(UndefinedImpl); }
 	};
@@ -200,7 +210,7 @@ private:
 	{
 	public:
 		virtual Type type() const { return TypeObject; }
-		virtual Impl* clone() const { return new  ObjectImpl(*this); }
+		virtual void copyTo(void* buf) const { new (buf) ObjectImpl(*this); }
 		virtual int compare (const Impl& rhs) const;
 		virtual bool equals(const Impl& rhs) const;
 		virtual MojSize hashCode() const;
@@ -218,7 +228,7 @@ private:
 	{
 	public:
 		virtual Type type() const { return TypeArray; }
-		virtual Impl* clone() const { return new ArrayImpl(*this); }
+		virtual void copyTo(void* buf) const { new (buf) ArrayImpl(*this); }
 		virtual int compare (const Impl& rhs) const;
 		virtual bool equals(const Impl& rhs) const;
 		virtual MojSize hashCode() const;
@@ -239,7 +249,7 @@ private:
 		StringImpl() {}
 		StringImpl(const MojString& str) : m_val(str) {}
 		virtual Type type() const { return TypeString; }
-		virtual Impl* clone() const { return new StringImpl(*this); }
+		virtual void copyTo(void* buf) const { new (buf) StringImpl(*this); }
 		virtual int compare (const Impl& rhs) const;
 		virtual bool equals(const Impl& rhs) const;
 		virtual MojSize hashCode() const;
@@ -258,7 +268,7 @@ private:
 		BoolImpl() : m_val(false) {}
 		BoolImpl(bool val) : m_val(val) {}
 		virtual Type type() const { return TypeBool; }
-		virtual Impl* clone() const { return new BoolImpl(*this); }
+		virtual void copyTo(void* buf) const { new (buf) BoolImpl(*this); }
 		virtual int compare (const Impl& rhs) const;
 		virtual bool equals(const Impl& rhs) const;
 		virtual MojSize hashCode() const;
@@ -276,7 +286,7 @@ private:
 		DecimalImpl() {}
 		DecimalImpl(const MojDecimal& val) : m_val(val) {}
 		virtual Type type() const { return TypeDecimal; }
-		virtual Impl* clone() const { return new DecimalImpl(*this); }
+		virtual void copyTo(void* buf) const { new (buf) DecimalImpl(*this); }
 		virtual int compare (const Impl& rhs) const;
 		virtual bool equals(const Impl& rhs) const;
 		virtual MojSize hashCode() const;
@@ -294,7 +304,7 @@ private:
 		IntImpl() : m_val(0) {}
 		IntImpl(MojInt64 val) : m_val(val) {}
 		virtual Type type() const { return TypeInt; }
-		virtual Impl* clone() const { return new IntImpl(*this); }
+		virtual void copyTo(void* buf) const { new (buf) IntImpl(*this); }
 		virtual int compare (const Impl& rhs) const;
 		virtual bool equals(const Impl& rhs) const;
 		virtual MojSize hashCode() const;
@@ -313,15 +323,28 @@ private:
 	void release();
 	ObjectImpl& ensureObject();
 	ArrayImpl& ensureArray();
-	Impl* impl() { return m_implementation; }
-	const Impl* impl() const { return m_implementation; }
+	Impl* impl() { return reinterpret_cast<Impl*>(&m_impl); }
+	const Impl* impl() const { return reinterpret_cast<const Impl*>(&m_impl); }
 
 	template<class T>
 	MojErr getRequiredT(const MojChar* key, T& valOut) const;
 	template<class T>
 	MojErr getRequiredErrT(const MojChar* key, T& valOut) const;
 
-	Impl* m_implementation;
+	union ImplStorage
+	{
+		MojByte m_object[sizeof(ObjectImpl)];
+		MojByte m_array[sizeof(ArrayImpl)];
+		MojByte m_string[sizeof(StringImpl)];
+		MojByte m_bool[sizeof(BoolImpl)];
+		MojByte m_decimal[sizeof(DecimalImpl)];
+		MojByte m_int[sizeof(IntImpl)];
+		MojByte m_undefined[sizeof(UndefinedImpl)];
+		void* m_alignPtr;
+		MojInt64 m_alignInt;
+	};
+
+	ImplStorage m_impl;
 };
 
 class MojObjectVisitor : private MojNoCopy
@@ -341,6 +364,11 @@ public:
 	virtual MojErr intValue(MojInt64 val) = 0;
 	virtual MojErr decimalValue(const MojDecimal& val) = 0;
 	virtual MojErr stringValue(const MojChar* val, MojSize len) = 0;
+	// Called instead of propName/stringValue when the string is already allocated and
+	// interned (e.g. a token name shared by all objects of a kind). Visitors that keep
+	// the string can share its refcounted data instead of copying it.
+	virtual MojErr sharedPropName(const MojString& name) { return propName(name, name.length()); }
+	virtual MojErr sharedStringValue(const MojString& val) { return stringValue(val, val.length()); }
 
 	// convenience methods
 	MojErr propName(const MojChar* name) { return propName(name, MojStrLen(name)); }
@@ -40,10 +40,16 @@ public:
 	virtual MojErr intValue(MojInt64 val);
 	virtual MojErr decimalValue(const MojDecimal& val);
 	virtual MojErr stringValue(const MojChar* val, MojSize len);
+	virtual MojErr sharedPropName(const MojString& name);
+	virtual MojErr sharedStringValue(const MojString& val);
 
 	const MojObject& object() const { return m_obj; }
 	MojObject& object() { return m_obj; }
 
+	// chars of prop names that were shared with an interned string vs. copied, since construction
+	MojSize sharedNameBytes() const { return m_sharedNameBytes; }
+	MojSize copiedNameBytes() const { return m_copiedNameBytes; }
+
 private:
 	struct Rec
 	{
@@ -61,6 +67,8 @@ private:
 	ObjStack m_stack;
 	MojObject m_obj;
 	MojString m_propName;
+	MojSize m_sharedNameBytes;
+	MojSize m_copiedNameBytes;
 };
 
 #endif /* MOJOBJECTBUILDER_H_ */
@@ -23,6 +23,8 @@
 #include "core/MojCoreDefs.h"
 #include "core/MojDataSerialization.h"
 #include "core/MojObject.h"
+#include "core/MojSet.h"
+#include "core/MojString.h"
 #include "core/MojTokenSet.h"
 
 class MojObjectWriter : public MojObjectVisitor
@@ -53,7 +55,11 @@ public:
 	};
 
 	static const MojUInt8 Version = 1;
+	// Prop names (and string values equal to a prop name) of a kind are written as tokens.
+	// Tokens below ExtendedTokenMarker take a single byte; larger ones are written as
+	// ExtendedTokenMarker followed by the token as a varint.
 	static const MojUInt8 TokenStartMarker = 32;
+	static const MojUInt8 ExtendedTokenMarker = 0xFF;
 
 	MojObjectWriter() : m_writer(m_buf), m_tokenSet(NULL) {}
 	MojObjectWriter(MojBuffer& buf, MojTokenSet* tokenSet) : m_writer(buf), m_tokenSet(tokenSet) {}
@@ -90,6 +96,8 @@ private:
 class MojObjectReader : private MojNoCopy
 {
 public:
+	typedef MojSet<MojString> PropSet;
+
 	MojObjectReader();
 	MojObjectReader(const MojByte* data, MojSize size);
 
@@ -106,10 +114,16 @@ public:
 	void data(const MojByte* data, MojSize size);
 	void skipBeginObj() { m_skipBeginObj = true; }
 	void tokenSet(MojTokenSet* tokenSet) { m_tokenSet = tokenSet; }
+	// Restricts reading to the given top-level props. Values of all other props are
+	// skipped without being decoded or visited. Call after tokenSet() so that the
+	// selected names can be matched against tokens directly.
+	MojErr select(const PropSet* props);
 
 	static MojErr read(MojObjectVisitor& visitor, const MojByte* data, MojSize size);
 	static MojErr readInt(MojDataReader& dataReader, MojByte marker, MojInt64& valOut);
 	static MojErr readString(MojDataReader& reader, MojChar const*& str, MojSize& strLen);
+	static MojErr readToken(MojDataReader& reader, MojByte marker, MojUInt32& tokenOut);
+	static MojErr skip(MojDataReader& reader);
 
 	MojErr read(MojObjectVisitor& visitor);
 
@@ -121,10 +135,17 @@ private:
 		StateArray
 	} State;
 
+	bool selected(const MojChar* name, MojSize len) const;
+	bool selected(MojUInt32 token) const;
+	bool selecting() const { return m_select && m_stack.size() == 1; }
+
 	MojDataReader m_reader;
 	MojVector<MojByte> m_stack;
 	bool m_skipBeginObj;
 	MojTokenSet* m_tokenSet;
+	const PropSet* m_select;
+	MojUInt32 m_selectTokens[8];
+	MojVector<MojUInt32> m_selectExtTokens;
 };
 
 #endif /* MOJOBJECTSERIALIZATION_H_ */
@@ -83,6 +83,7 @@ public:
 	virtual MojErr close();
 
 	virtual MojErr addCategory(const MojChar* name, CategoryHandler* handler);
+	MojMessageDispatcher* dispatcher() const { return m_dispatcher; }
 	virtual MojErr createRequest(MojRefCountedPtr<MojServiceRequest>& reqOut) = 0;
 	virtual MojErr dispatch() = 0; // for test purposes only
 
@@ -37,6 +37,7 @@ public:
 	virtual ~MojServiceMessage();
 
 	MojSize numReplies() const { return m_numReplies; }
+	MojService* service() const { return m_service; }
 	MojService::Category* serviceCategory() const { return m_category; }
 	bool subscribed() const { return m_subscribed; }
 	bool fixmode() const { return m_fixmode; }
@@ -79,6 +79,8 @@ public:
 	MojErr signal() { return MojThreadCondSignal(&m_cond); }
 	MojErr broadcast() { return MojThreadCondBroadcast(&m_cond); }
 	MojErr wait(MojThreadMutex& mutex);
+	// returns MojErrTimedOut if not signalled within timeout
+	MojErr wait(MojThreadMutex& mutex, const MojTime& timeout);
 
 private:
 	MojThreadCondT m_cond;
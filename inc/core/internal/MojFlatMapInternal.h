@@ -0,0 +1,218 @@
+/* @@@LICENSE
+*
+*  Copyright (c) 2014 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+#ifndef MOJFLATMAPINTERNAL_H_
+#define MOJFLATMAPINTERNAL_H_
+
+template<class KEY, class VAL, class LKEY, class KCOMP, class VCOMP>
+int MojFlatMap<KEY, VAL, LKEY, KCOMP, VCOMP>::compare(const MojFlatMap& map) const
+{
+	const Entry* i1 = m_vec.begin();
+	const Entry* i2 = map.m_vec.begin();
+	if (i1 == i2)
+		return 0;
+	const Entry* end1 = m_vec.end();
+	const Entry* end2 = map.m_vec.end();
+	for (;;) {
+		if (i1 == end1)
+			return i2 == end2 ? 0 : -1;
+		if (i2 == end2)
+			return 1;
+		int comp = KCOMP()(i1->m_key, i2->m_key);
+		if (comp == 0)
+			comp = VCOMP()(i1->m_val, i2->m_val);
+		if (comp != 0)
+			return comp;
+		++i1;
+		++i2;
+	}
+	MojAssertNotReached();
+	return 0;
+}
+
+template<class KEY, class VAL, class LKEY, class KCOMP, class VCOMP>
+bool MojFlatMap<KEY, VAL, LKEY, KCOMP, VCOMP>::get(const LookupType& key, ValueType& valOut) const
+{
+	bool found = false;
+	MojSize idx = lowerIndex(key, found);
+	if (!found)
+		return false;
+	valOut = m_vec.at(idx).m_val;
+	return true;
+}
+
+template<class KEY, class VAL, class LKEY, class KCOMP, class VCOMP>
+MojErr MojFlatMap<KEY, VAL, LKEY, KCOMP, VCOMP>::del(const LookupType& key, bool& foundOut)
+{
+	MojSize idx = lowerIndex(key, foundOut);
+	if (foundOut) {
+		MojErr err = m_vec.erase(idx);
+		MojErrCheck(err);
+	}
+	return MojErrNone;
+}
+
+template<class KEY, class VAL, class LKEY, class KCOMP, class VCOMP>
+MojErr MojFlatMap<KEY, VAL, LKEY, KCOMP, VCOMP>::put(const KeyType& key, const ValueType& val)
+{
+	// key and val may refer into this map, so copy them before entries move
+	Entry entry(key, val);
+	// entries usually arrive in order (e.g. when read back from storage), so try the end first
+	if (m_vec.empty() || KCOMP()(m_vec.back().m_key, entry.m_key) < 0) {
+		MojErr err = m_vec.push(entry);
+		MojErrCheck(err);
+		return MojErrNone;
+	}
+	bool found = false;
+	MojSize idx = lowerIndex(entry.m_key, found);
+	if (found) {
+		Iterator iter;
+		MojErr err = iterAt(idx, iter);
+		MojErrCheck(err);
+		iter.m_pos->m_val = entry.m_val;
+	} else {
+		MojErr err = m_vec.insert(idx, 1, entry);
+		MojErrCheck(err);
+	}
+	return MojErrNone;
+}
+
+template<class KEY, class VAL, class LKEY, class KCOMP, class VCOMP>
+MojErr MojFlatMap<KEY, VAL, LKEY, KCOMP, VCOMP>::put(const MojFlatMap& map)
+{
+	if (empty()) {
+		assign(map);
+		return MojErrNone;
+	}
+	MojErr err = m_vec.reserve(size() + map.size());
+	MojErrCheck(err);
+	for (const Entry* i = map.m_vec.begin(); i != map.m_vec.end(); ++i) {
+		err = put(i->m_key, i->m_val);
+		MojErrCheck(err);
+	}
+	return MojErrNone;
+}
+
+template<class KEY, class VAL, class LKEY, class KCOMP, class VCOMP>
+typename MojFlatMap<KEY, VAL, LKEY, KCOMP, VCOMP>::ConstIterator
+MojFlatMap<KEY, VAL, LKEY, KCOMP, VCOMP>::find(const LookupType& key) const
+{
+	bool found = false;
+	MojSize idx = lowerIndex(key, found);
+	if (!found)
+		return end();
+	return ConstIterator(m_vec.begin() + idx, m_vec.end());
+}
+
+template<class KEY, class VAL, class LKEY, class KCOMP, class VCOMP>
+MojErr MojFlatMap<KEY, VAL, LKEY, KCOMP, VCOMP>::find(const LookupType& key, Iterator& iter)
+{
+	bool found = false;
+	MojSize idx = lowerIndex(key, found);
+	if (!found) {
+		iter = Iterator();
+		return MojErrNone;
+	}
+	MojErr err = iterAt(idx, iter);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+template<class KEY, class VAL, class LKEY, class KCOMP, class VCOMP>
+typename MojFlatMap<KEY, VAL, LKEY, KCOMP, VCOMP>::ConstIterator
+MojFlatMap<KEY, VAL, LKEY, KCOMP, VCOMP>::lowerBound(const LookupType& key) const
+{
+	bool found = false;
+	MojSize idx = lowerIndex(key, found);
+	return ConstIterator(m_vec.begin() + idx, m_vec.end());
+}
+
+template<class KEY, class VAL, class LKEY, class KCOMP, class VCOMP>
+MojErr MojFlatMap<KEY, VAL, LKEY, KCOMP, VCOMP>::lowerBound(const LookupType& key, Iterator& iter)
+{
+	bool found = false;
+	MojSize idx = lowerIndex(key, found);
+	MojErr err = iterAt(idx, iter);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+template<class KEY, class VAL, class LKEY, class KCOMP, class VCOMP>
+typename MojFlatMap<KEY, VAL, LKEY, KCOMP, VCOMP>::ConstIterator
+MojFlatMap<KEY, VAL, LKEY, KCOMP, VCOMP>::upperBound(const LookupType& key) const
+{
+	bool found = false;
+	MojSize idx = lowerIndex(key, found);
+	if (found)
+		++idx;
+	return ConstIterator(m_vec.begin() + idx, m_vec.end());
+}
+
+template<class KEY, class VAL, class LKEY, class KCOMP, class VCOMP>
+MojErr MojFlatMap<KEY, VAL, LKEY, KCOMP, VCOMP>::upperBound(const LookupType& key, Iterator& iter)
+{
+	bool found = false;
+	MojSize idx = lowerIndex(key, found);
+	if (found)
+		++idx;
+	MojErr err = iterAt(idx, iter);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+template<class KEY, class VAL, class LKEY, class KCOMP, class VCOMP>
+MojSize MojFlatMap<KEY, VAL, LKEY, KCOMP, VCOMP>::lowerIndex(const LookupType& key, bool& foundOut) const
+{
+	// binary search for the first entry not less than key
+	foundOut = false;
+	const Entry* entries = m_vec.begin();
+	MojSize low = 0;
+	MojSize high = m_vec.size();
+	while (low < high) {
+		MojSize mid = low + (high - low) / 2;
+		int comp = KCOMP()(entries[mid].m_key, key);
+		if (comp < 0) {
+			low = mid + 1;
+		} else {
+			if (comp == 0)
+				foundOut = true;
+			high = mid;
+		}
+	}
+	return low;
+}
+
+template<class KEY, class VAL, class LKEY, class KCOMP, class VCOMP>
+MojErr MojFlatMap<KEY, VAL, LKEY, KCOMP, VCOMP>::iterAt(MojSize idx, Iterator& iter)
+{
+	MojAssert(idx <= size());
+
+	// getting a mutable iterator un-shares the entries
+	typename EntryVec::Iterator begin;
+	MojErr err = m_vec.begin(begin);
+	MojErrCheck(err);
+	iter = Iterator(begin + idx, begin + size());
+
+	return MojErrNone;
+}
+
+#endif /* MOJFLATMAPINTERNAL_H_ */
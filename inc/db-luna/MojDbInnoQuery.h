@@ -36,7 +36,7 @@ public:
 	virtual MojErr close();
 
 private:
-	virtual MojErr seekImpl(const ByteVec& key, bool desc, bool& foundOut);
+	virtual MojErr seekImpl(const MojDbKey& key, bool desc, bool& foundOut);
 	virtual MojErr next(bool& foundOut);
 	virtual MojErr getVal(MojDbStorageItem*& itemOut);
 	MojErr loadKey(bool& foundOut);
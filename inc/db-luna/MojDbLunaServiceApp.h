@@ -43,7 +43,6 @@ public:
     virtual MojErr close();
 private:
     static const MojChar* const VersionString;
-    static const MojInt32 NumThreads = 3;
 
     typedef MojReactorApp<MojGmainReactor> Base;
 
@@ -21,13 +21,13 @@
 
 #include "core/MojNoCopy.h"
 
-#include <map>
-#include <string>
+#include "db-luna/leveldb/MojDbLevelTxnBuffer.h"
 
+// walks the pending puts of a transaction buffer, stepping over tombstones
 class MojDbLevelContainerIterator : public MojNoCopy
 {
-    typedef std::map<std::string, std::string> container_t;
-    typedef container_t::iterator iterator_t;
+    typedef MojDbLevelTxnBuffer container_t;
+    typedef const MojDbLevelTxnBuffer::Node* iterator_t;
 
 public:
     MojDbLevelContainerIterator(container_t& container);
@@ -35,7 +35,7 @@ public:
     ~MojDbLevelContainerIterator();
 
     inline bool isBegin() const { return m_start; }
-    inline bool isEnd() const { return !isBegin() && m_it == m_container.end(); }
+    inline bool isEnd() const { return !isBegin() && m_it == NULL; }
     inline bool isValid() const { return !(isBegin() || isEnd()); }
 
     void toBegin();
@@ -44,17 +44,18 @@ public:
     void toLast();
 
     MojDbLevelContainerIterator& operator++ ();
-    //MojDbLevelContainerIterator operator++ (int);
     MojDbLevelContainerIterator& operator-- ();
-    //MojDbLevelContainerIterator operator-- (int);
 
+    // positions at the first put at or after iterator (lower bound semantic)
     MojDbLevelContainerIterator& operator= (iterator_t iterator);
 
     operator iterator_t () { return m_it; }
-    iterator_t::value_type* operator->() { return &(*m_it); }
-    const iterator_t::value_type* operator->() const { return &(*m_it); }
+    iterator_t operator->() const { return m_it; }
 
 private:
+    static iterator_t skipForward(iterator_t it);
+    static iterator_t skipBackward(iterator_t it);
+
     container_t& m_container;
     iterator_t m_it;
 
@@ -55,6 +55,8 @@ public:
 
     leveldb::DB* impl() { return m_db; }
     MojDbLevelEngine* engine() { return m_engine; }
+    const MojString& file() const { return m_file; }
+    const MojString& name() const { return m_name; }
 
 private:
     friend class MojDbLevelEngine;
@@ -20,6 +20,7 @@
 #define MOJDBLEVELENGINE_H_
 
 #include <leveldb/db.h>
+#include <leveldb/write_batch.h>
 #include "db/MojDbDefs.h"
 #include "db/MojDbStorageEngine.h"
 #include "core/MojLogDb8.h"
@@ -52,6 +53,15 @@ public:
     MojErr removeSeq(MojDbLevelSeq* seq);
 
     MojDbLevelDatabase* indexDb() { return m_indexDb.get(); }
+    MojDbLevelDatabase* redoDb() { return m_redoDb.get(); }
+
+    // redo log for txns spanning several leveldb databases
+    // name relative to path(), which is what redo records store
+    MojErr dbName(leveldb::DB* db, MojString& nameOut);
+    MojErr redoBegin(const std::string& record, std::string& keyOut);
+    MojErr redoEnd(const std::string& key);
+    MojErr redoCheckpoint();
+    bool redoPending();
 
     static const leveldb::WriteOptions& getWriteOptions() { return WriteOptions; }
     static const leveldb::ReadOptions& getReadOptions() { return ReadOptions; }
@@ -69,6 +79,17 @@ private:
     SequenceVec m_seqs;
     bool m_isOpen;
 
+    MojErr redoReplay();
+    MojErr redoApply(const leveldb::Slice& record);
+
+    MojThreadMutex m_redoMutex;
+    MojThreadMutex m_redoSyncMutex;
+    MojRefCountedPtr<MojDbLevelDatabase> m_redoDb;
+    MojUInt64 m_redoSeq;
+    MojSize m_redoPending;
+    MojSize m_redoRetiredCount;
+    leveldb::WriteBatch m_redoRetired;
+
     static leveldb::ReadOptions ReadOptions;
     static leveldb::WriteOptions WriteOptions;
     static leveldb::Options OpenOptions;
@@ -42,7 +42,7 @@ private:
 	static const MojUInt32 SeekEmptyFlags[2];
 	static const MojUInt32 NextFlags[2];
 
-	virtual MojErr seekImpl(const ByteVec& key, bool desc, bool& foundOut);
+	virtual MojErr seekImpl(const MojDbKey& key, bool desc, bool& foundOut);
 	virtual MojErr next(bool& foundOut);
 	virtual MojErr getVal(MojDbStorageItem*& itemOut, bool& foundOut);
 	MojErr getKey(bool& foundOut, MojUInt32 flags);
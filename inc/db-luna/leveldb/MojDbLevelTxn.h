@@ -19,7 +19,6 @@
 #ifndef __MOJDBLEVELTXN_H
 #define __MOJDBLEVELTXN_H
 
-#include <map>
 #include <set>
 #include <list>
 #include <string>
@@ -31,6 +30,8 @@
 #include <core/MojErr.h>
 #include <db/MojDbStorageEngine.h>
 
+#include "db-luna/leveldb/MojDbLevelTxnBuffer.h"
+
 namespace leveldb
 {
     class DB;
@@ -65,19 +66,29 @@ public:
     MojDbLevelTxnIterator* createIterator();
     void detach(MojDbLevelTxnIterator *it);
 
+    bool empty() const { return m_pending.empty(); }
+    const MojDbLevelTxnBuffer& pending() const { return m_pending; }
+
     MojErr commitImpl();
+    MojErr commitImpl(const leveldb::WriteOptions& options);
+
+    // redo records let a commit that spans several databases be replayed after a crash
+    void appendRedo(std::string& record) const;
+    static MojErr parseRedo(leveldb::Slice& record, leveldb::WriteBatch& batchOut);
+    static void putFixed32(std::string& dst, uint32_t val);
+    static bool getFixed32(leveldb::Slice& src, uint32_t& valOut);
+    static void putBytes(std::string& dst, const leveldb::Slice& bytes);
+    static bool getBytes(leveldb::Slice& src, leveldb::Slice& bytesOut);
 
 private:
     void cleanup();
+    void fillBatch(leveldb::WriteBatch& batch) const;
 
     // where and how to write this batch
     leveldb::DB *m_db;
 
     // local view for pending writes
-    typedef std::map<std::string, std::string> PendingValues;
-    typedef std::set<std::string> PendingDeletes;
-    PendingValues m_pendingValues;
-    PendingDeletes m_pendingDeletes;
+    MojDbLevelTxnBuffer m_pending;
     std::set<MojDbLevelTxnIterator*> m_iterators;
 
     friend class MojDbLevelTxnIterator;
@@ -86,6 +97,7 @@ private:
 class MojDbLevelEnvTxn final : public MojDbStorageTxn
 {
 public:
+    MojDbLevelEnvTxn() : m_engine(NULL) {}
     ~MojDbLevelEnvTxn()
     { abort(); }
 
@@ -97,9 +109,12 @@ public:
     MojDbLevelTableTxn &tableTxn(leveldb::DB &db);
 
 private:
+    typedef std::list<MojSharedPtr<MojDbLevelTableTxn> > TableTxns;
+
     MojErr commitImpl();
+    MojErr commitAtomic(const TableTxns& txns);
 
-    typedef std::list<MojSharedPtr<MojDbLevelTableTxn> > TableTxns;
+    MojDbLevelEngine* m_engine;
     TableTxns m_tableTxns;
 };
 
@@ -0,0 +1,115 @@
+/* @@@LICENSE
+*
+* Copyright (c) 2014 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef MOJDBLEVELTXNBUFFER_H
+#define MOJDBLEVELTXNBUFFER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include <leveldb/slice.h>
+
+#include "core/MojNoCopy.h"
+
+/**
+ * Bump allocator owned by a single transaction. Memory is only released
+ * all at once by clear().
+ * @class MojDbLevelArena
+ */
+class MojDbLevelArena : public MojNoCopy
+{
+public:
+    static const size_t BlockSize = 4096;
+
+    MojDbLevelArena();
+    ~MojDbLevelArena();
+
+    char* allocate(size_t bytes);
+    char* allocateAligned(size_t bytes);
+    leveldb::Slice copy(const leveldb::Slice& data);
+    void clear();
+
+    size_t memoryUsage() const { return m_memoryUsage; }
+    size_t blockCount() const { return m_blocks.size(); }
+
+private:
+    char* allocateFallback(size_t bytes);
+    char* allocateBlock(size_t bytes);
+
+    char* m_ptr;
+    size_t m_remaining;
+    size_t m_memoryUsage;
+    std::vector<char*> m_blocks;
+};
+
+/**
+ * Ordered view of writes pending in a transaction. Puts and delete
+ * tombstones share one skiplist whose keys, values and nodes all live in
+ * an arena, so buffering a write costs no heap allocation of its own.
+ * Nodes are never unlinked before clear(), which keeps them valid for
+ * iterators while the transaction is being modified.
+ * @class MojDbLevelTxnBuffer
+ */
+class MojDbLevelTxnBuffer : public MojNoCopy
+{
+public:
+    struct Node
+    {
+        leveldb::Slice key;
+        leveldb::Slice value;
+        bool deleted;
+        Node* prev;
+        Node* next[1]; // actual height is picked at insertion
+    };
+
+    MojDbLevelTxnBuffer();
+
+    void put(const leveldb::Slice& key, const leveldb::Slice& val);
+    void del(const leveldb::Slice& key);
+    void clear();
+
+    // lookups return tombstones too; callers check Node::deleted
+    const Node* find(const leveldb::Slice& key) const;
+    const Node* lowerBound(const leveldb::Slice& key) const;
+    const Node* first() const { return m_head->next[0]; }
+    const Node* last() const { return m_tail; }
+
+    bool empty() const { return m_puts == 0 && m_deletes == 0; }
+    size_t puts() const { return m_puts; }
+    size_t deletes() const { return m_deletes; }
+    const MojDbLevelArena& arena() const { return m_arena; }
+
+private:
+    static const int MaxHeight = 12;
+
+    Node* newNode(const leveldb::Slice& key, int height);
+    Node* findGreaterOrEqual(const leveldb::Slice& key, Node** prevOut) const;
+    int randomHeight();
+    Node* insert(const leveldb::Slice& key);
+
+    MojDbLevelArena m_arena;
+    Node* m_head;
+    Node* m_tail;
+    int m_height;
+    uint32_t m_rnd;
+    size_t m_puts;
+    size_t m_deletes;
+};
+
+#endif
@@ -27,9 +27,7 @@
 #include "db-luna/leveldb/MojDbLevelContainerIterator.h"
 #include "db-luna/leveldb/MojDbLevelIterator.h"
 
-#include <map>
 #include <string>
-#include <set>
 
 class MojDbLevelTableTxn;
 
@@ -39,8 +37,6 @@ class MojDbLevelTableTxn;
  */
 class MojDbLevelTxnIterator : public MojNoCopy
 {
-    typedef std::map<std::string, std::string> inserts_t;
-    typedef std::set<std::string> deletes_t;
 public:
     MojDbLevelTxnIterator(MojDbLevelTableTxn *txn);
     ~MojDbLevelTxnIterator();
@@ -64,7 +60,7 @@ public:
     bool isValid() const;
     bool isBegin() const { return m_it.isBegin() && m_insertsItertor.isBegin(); }
     bool isEnd() const { return m_it.isEnd() && m_insertsItertor.isEnd(); }
-    bool isDeleted(const std::string& key) const;
+    bool isDeleted(const leveldb::Slice& key) const;
     void prev();
     void next();
     void seek(const std::string& key);
@@ -77,8 +73,7 @@ public:
 private:
     void skipDeleted();
 
-    inserts_t &inserts;
-    deletes_t &deletes;
+    MojDbLevelTxnBuffer &pending;
 
     leveldb::DB* leveldb;
 
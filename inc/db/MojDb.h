@@ -22,7 +22,9 @@
 
 #include "db/MojDbDefs.h"
 #include "db/MojDbCursor.h"
+#include "db/MojDbDump.h"
 #include "db/MojDbIdGenerator.h"
+#include "db/MojDbIndexBuilder.h"
 #include "db/MojDbKindEngine.h"
 #include "db/MojDbPermissionEngine.h"
 #include "db/MojDbQuotaEngine.h"
@@ -32,6 +34,7 @@
 #include "db/MojDbShardIdCache.h"
 #include "db/MojDbShardEngine.h"
 #include "db/MojDbWatcher.h"
+#include "db/MojDbWatchNotifier.h"
 #include "db/MojDbReq.h"
 #include "db/MojDbSearchCache.h"
 #include "core/MojHashMap.h"
@@ -49,7 +52,8 @@ public:
 		FlagForce			= (1 << 0),
 		FlagMerge			= (1 << 1),
 		FlagPurge			= (1 << 2),
-		FlagIgnoreMissing		= (1 << 3)
+		FlagIgnoreMissing		= (1 << 3),
+		FlagBulk			= (1 << 4)	// load: defer index writes and commit in large steps
 	};
 
 	typedef MojSignal<> WatchSignal;
@@ -61,6 +65,9 @@ public:
 	static const MojChar* const KindKey;
 	static const MojChar* const RevKey;
 	static const MojChar* const SyncKey;
+	// stats() keys everything else by kind id; stats of other components sit in one
+	// object under this key, each under its component's own StatsKey
+	static const MojChar* const StatsInternalKey;
     static const MojChar* const KindIdPrefix;
     static const MojChar* const QuotaIdPrefix;
     static const MojChar* const PermissionIdPrefix;
@@ -85,6 +92,7 @@ public:
 	MojErr dump(const MojChar* path, MojUInt32& countOut, bool incDel = true, MojDbReqRef req = MojDbReq(), bool backup = false,
 			MojUInt32 maxBytes = 0, const MojObject* incrementalKey = NULL, MojObject* backupResponse = NULL);
 	MojErr load(const MojChar* path, MojUInt32& countOut, MojUInt32 flags = FlagNone, MojDbReqRef req = MojDbReq());
+	MojErr retokenize(MojUInt32& countOut, MojDbReqRef req = MojDbReq());
 
 	MojErr del(const MojObject& id, bool& foundOut, MojUInt32 flags = FlagNone, MojDbReqRef req = MojDbReq());
 	MojErr del(const MojObject* idsBegin, const MojObject* idsEnd, MojUInt32& countOut, MojObject& arrOut, MojUInt32 flags = FlagNone, MojDbReqRef req = MojDbReq());
@@ -112,12 +120,20 @@ public:
 	MojDbStorageEngine* storageEngine() { return m_storageEngine.get(); }
 	MojDbStorageDatabase* storageDatabase() { return m_objDb.get(); }
     MojDbShardEngine* shardEngine () { return &m_shardEngine; }
+	MojDbIndexBuilder* indexBuilder() { return &m_indexBuilder; }
+	MojDbWatchNotifier* watchNotifier() { return &m_watchNotifier; }
+	MojDbDumpWriter::Format dumpFormat() const { return m_dumpFormat; }
 	MojInt64 version() { return DatabaseVersion; }
+	// version found on disk by the last open, before any upgrade
+	MojInt64 openedVersion() const { return m_openedVersion; }
 	MojErr commitBatch(MojDbReq& req);
     MojInt64 purgeWindow() {return m_purgeWindow;}
 
     // Search Cache
     MojDbSearchCache* searchCache() { return &m_searchCache; }
+    // sort runs larger than this are spilled to searchTempDir
+    MojSize searchRunBytes() const { return (MojSize) m_searchRunBytes; }
+    const MojChar* searchTempDir() const { return m_searchTempDir.empty() ? SearchTempDirDefault : m_searchTempDir.data(); }
 
     //verify _kind
     MojErr isValidKind (MojString& i_kindStr, bool & ret);
@@ -142,16 +158,24 @@ private:
 	static const MojChar* const TimestampKey;
 	static const MojChar* const VersionFileName;
 
-	static const MojInt64 DatabaseVersion = 8;
+	// version 9 added extended prop tokens. Older databases are opened as is and only
+	// stamped with the current version once retokenize has rewritten their objects.
+	static const MojInt64 DatabaseVersion = 9;
+	static const MojInt64 MinDatabaseVersion = 8;
 	static const int PurgeNumDaysDefault = 14;
         // The magic number 173 is just an arbitrary number in the high hundreds, which is prime. Primality is
         // not required, just handy to avoid any likliehood of synchronizing with loaded data sets.
 	static const MojInt64 LoadStepSizeDefault = 173;
+	static const MojInt64 BulkLoadStepSizeDefault = 8192;
+	static const MojInt64 SearchRunBytesDefault = 512 * 1024;
+	static const MojChar* const SearchTempDirDefault;
 
 	void readLock() { m_schemaLock.readLock(); }
 	void writeLock() { m_schemaLock.writeLock(); }
 	void unlock() { m_schemaLock.unlock(); }
 
+	struct DumpState;
+
 	MojErr createEngine();
 	MojErr requireOpen();
 	MojErr requireNotOpen();
@@ -169,22 +193,28 @@ private:
 	MojErr putConfig(MojObject* begin, const MojObject* end, MojDbReq& req, MojDbPutHandler& handler);
 
 	MojErr updateLocaleImpl(const MojString& oldLocale, const MojString& newLocale, MojDbReq& req);
-	MojErr dumpImpl(MojFile& file, bool backup, bool incDel, const MojObject& revParam, const MojObject& delRevParam, bool skipKinds, MojUInt32& countOut, MojDbReq& req,
-			MojObject* response, const MojChar* keyName, MojSize& bytesWritten, MojSize& warns, MojUInt32 maxBytes = 0);
-	MojErr dumpObj(MojFile& file, MojObject obj, MojSize& bytesWrittenOut, MojUInt32 maxBytes = 0);
+	MojErr dumpImpl(MojDbDumpWriter& writer, bool backup, bool incDel, const MojObject& revParam, const MojObject& delRevParam, bool skipKinds, MojUInt32& countOut, MojDbReq& req,
+			MojObject* response, const MojChar* keyName, MojSize& warns, MojUInt32 maxBytes = 0);
+	MojErr dumpKinds(MojDbDumpWriter& writer, MojUInt32& countOut, MojSize& warns);
+	MojErr dumpKind(const MojString& kindId, DumpState& state, MojDbDumpWriter::Chunk& chunk, MojUInt32& countOut, MojSize& warnsOut);
+	MojErr dumpObj(MojDbDumpWriter& writer, MojObject obj, MojUInt32 maxBytes = 0);
+	static MojErr dumpThread(void* arg);
 	MojErr findImpl(const MojDbQuery& query, MojDbCursor& cursor, MojDbWatcher* watcher, MojDbReq& req, MojDbOp op);
 	MojErr getImpl(const MojObject& id, MojObjectVisitor& visitor, MojDbOp op, MojDbReq& req);
 	MojErr handleBackupFull(const MojObject& revParam, const MojObject& delRevParam, MojObject& response, const MojChar* keyName);
 	MojErr insertIncrementalKey(MojObject& response, const MojChar* keyName, const MojObject& curRev);
 	MojErr loadImpl(MojObject& obj, MojUInt32 flags, MojDbReq& req);
 	MojErr purgeImpl(MojObject& obj, MojUInt32& countOut, MojDbReq& req);
+	MojErr retokenizeImpl(bool incDel, MojUInt32& countOut, MojDbReq& req);
+	MojErr retokenizeObj(MojObject& obj, MojDbReq& req);
 
     MojErr attachShardId(MojString shardId, MojObject& id);
-	MojErr nextId(MojInt64& idOut);
+	MojErr nextId(MojInt64& idOut, MojDbStorageTxn* txn = NULL);
 	MojErr getState(const MojChar* key, MojObject& valOut, MojDbReq& req);
 	MojErr updateState(const MojChar* key, const MojObject& val, MojDbReq& req);
 	MojErr checkDbVersion(const MojChar* path);
     MojErr createVersionFile(const MojChar* path, const MojString versionFileName);
+    MojErr updateVersion();
 
 	MojErr beginReq(MojDbReq& req, bool lockSchema = false);
 	MojErr commitKind(const MojString& id, MojDbReq& req, MojErr err);
@@ -202,11 +232,21 @@ private:
 	MojDbPermissionEngine m_permissionEngine;
     MojDbQuotaEngine m_quotaEngine;
 	MojDbShardEngine m_shardEngine;
+	MojDbIndexBuilder m_indexBuilder;
+	MojDbWatchNotifier m_watchNotifier;
 	MojThreadRwLock m_schemaLock;
 	MojString m_engineName;
 	MojObject m_conf;
 	MojInt64 m_purgeWindow;
 	MojInt64 m_loadStepSize;
+	MojInt64 m_bulkLoadStepSize;
+	MojDbDumpWriter::Format m_dumpFormat;
+	bool m_dumpCompress;
+	MojInt64 m_dumpThreads;
+	MojInt64 m_searchRunBytes;
+	MojString m_searchTempDir;
+	MojInt64 m_openedVersion;
+	MojString m_path;
 	bool m_isOpen;
     // Search Cache
     MojDbSearchCache m_searchCache;
@@ -29,6 +29,9 @@
 class MojDbCursor : private MojNoCopy
 {
 public:
+	static const MojChar* const EstimatedKeysKey;
+	static const MojChar* const ScannedKeysKey;
+
 	MojDbCursor();
 	virtual ~MojDbCursor();
 	virtual MojErr close();
@@ -37,6 +40,7 @@ public:
 	virtual MojErr visit(MojObjectVisitor& visitor);
 	virtual MojErr count(MojUInt32& countOut);
 	virtual MojErr nextPage(MojDbQuery::Page& pageOut);
+	MojErr explain(MojObject& objOut);
 
 	bool isOpen() const { return m_storageQuery.get() != NULL; }
     const MojDbStorageQuery * storageQuery() { return m_storageQuery.get();  }
@@ -54,9 +58,11 @@ protected:
 	virtual MojErr init(const MojDbQuery& query);
 	MojErr initImpl(const MojDbQuery& query);
 	MojErr visitObject(MojObjectVisitor& visitor, bool& foundOut);
+	bool countsWholeIndex();
 	void txn(MojDbStorageTxn* txn, bool ownTxn);
 	void kindEngine(MojDbKindEngine* kindEngine) { m_kindEngine = kindEngine; }
 	void excludeKinds(const MojSet<MojString>& toExclude);
+	static MojErr addRootProp(const MojString& path, MojDbStorageItem::PropSet& propsOut);
 
 	bool m_ownTxn;
 	MojErr m_lastErr;
@@ -65,9 +71,11 @@ protected:
 	MojRefCountedPtr<MojDbStorageTxn> m_txn;
 	MojRefCountedPtr<MojDbStorageQuery> m_storageQuery;
 	MojAutoPtr<MojObjectFilter> m_objectFilter;
+	MojDbStorageItem::PropSet m_selectProps;
 	MojAutoPtr<MojDbQueryFilter> m_queryFilter;
 	MojRefCountedPtr<MojDbWatcher> m_watcher;
 	MojDbIndex* m_dbIndex;
+	MojSize m_estimate;
 	bool m_vmode;
 };
 
@@ -47,6 +47,7 @@ class MojDbServiceHandler;
 class MojDbTextCollator;
 class MojDbTextTokenizer;
 class MojDbWatcher;
+class MojDbWatchNotifier;
 
 class MojDbStorageCursor;
 class MojDbStorageDatabase;
@@ -0,0 +1,148 @@
+/* @@@LICENSE
+*
+*  Copyright (c) 2014 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+#ifndef MOJDBDUMP_H_
+#define MOJDBDUMP_H_
+
+#include "db/MojDbDefs.h"
+#include "core/MojFile.h"
+#include "core/MojJson.h"
+#include "core/MojObject.h"
+#include "core/MojObjectBuilder.h"
+#include "core/MojObjectSerialization.h"
+#include "core/MojThread.h"
+#include "core/MojVector.h"
+
+// Writes dump files. Objects are serialized into chunks and a chunk only reaches the
+// file once it is full, so a dump makes a few large writes instead of one per object.
+// Chunks are filled independently, which lets several threads dump into the same file.
+//
+// The json format is the classic one: one object per line. The binary format starts with
+// Magic and a version byte, followed by chunks of
+//   [u32 rawSize][u32 storedSize][u32 crc32][u8 flags][storedSize bytes]
+// where the raw bytes are records of [u32 size][MojObjectWriter bytes]. A chunk is snappy
+// compressed (FlagCompressed) if compression was asked for and made it smaller.
+class MojDbDumpWriter : private MojNoCopy
+{
+public:
+	enum Format {
+		FormatJson,
+		FormatBinary
+	};
+
+	class Chunk : private MojNoCopy
+	{
+	public:
+		Chunk(Format format) : m_format(format) {}
+
+		MojErr append(const MojObject& obj);
+		void clear() { m_data.clear(); }
+		bool empty() const { return m_data.empty(); }
+		MojSize size() const { return m_data.size(); }
+		const MojVector<MojByte>& data() const { return m_data; }
+		MojErr truncate(MojSize size) { return m_data.resize(size); }
+
+	private:
+		friend class MojDbDumpWriter;
+
+		Format m_format;
+		MojJsonWriter m_jsonWriter;
+		MojObjectWriter m_writer;
+		MojVector<MojByte> m_data;
+		MojVector<MojByte> m_compressed;
+	};
+
+	static const MojChar* const FormatKey;
+	static const MojChar* const CompressKey;
+	static const MojChar* const ThreadsKey;
+	static const MojChar* const FormatJsonName;
+	static const MojChar* const FormatBinaryName;
+	static const MojByte Magic[];
+	static const MojSize MagicSize = 8;
+	static const MojByte Version = 1;
+	static const MojSize ChunkHeaderSize = 13;
+	static const MojSize ChunkSizeDefault = 256 * 1024;
+	static const MojUInt32 ThreadsDefault = 4;
+	static const MojByte FlagCompressed = 1;
+
+	MojDbDumpWriter();
+
+	MojErr open(const MojChar* path, Format format, bool compress, MojSize chunkSize = ChunkSizeDefault);
+	MojErr close();
+	// appends to the writer's own chunk; fails with MojErrDbBackupFull instead of
+	// letting the dump grow past maxBytes. Not for use alongside writeChunk.
+	MojErr write(const MojObject& obj, MojUInt32 maxBytes = 0);
+	// writes out a chunk filled by another thread and clears it. Thread-safe.
+	MojErr writeChunk(Chunk& chunk);
+
+	Format format() const { return m_format; }
+	MojSize chunkSize() const { return m_chunkSize; }
+	MojSize bytesWritten() const { return m_bytesWritten + m_chunk.size(); }
+
+	static MojErr parseFormat(const MojString& name, Format& formatOut);
+
+private:
+	MojErr encode(Chunk& chunk, MojByte* header, const MojByte*& storedOut, MojSize& storedSizeOut);
+	MojErr writeBytes(const MojByte* data, MojSize size);
+
+	MojFile m_file;
+	MojThreadMutex m_mutex;
+	Format m_format;
+	bool m_compress;
+	MojSize m_chunkSize;
+	MojSize m_bytesWritten;
+	Chunk m_chunk;
+};
+
+// Reads back the objects of a dump file in either format, telling them apart by Magic.
+// Binary chunks are checked against their crc before any record in them is used.
+class MojDbDumpReader : private MojNoCopy
+{
+public:
+	static const MojSize ReadBufSize = 64 * 1024;
+
+	MojDbDumpReader();
+
+	MojErr open(const MojChar* path);
+	MojErr next(bool& foundOut);
+	MojObject& object() { return m_builder.object(); }
+	MojDbDumpWriter::Format format() const { return m_format; }
+
+private:
+	MojErr fill();
+	MojErr nextJson(bool& foundOut);
+	MojErr nextBinary(bool& foundOut);
+	MojErr readChunk(bool& foundOut);
+	MojErr readFully(MojByte* buf, MojSize size, MojSize& sizeOut);
+
+	MojFile m_file;
+	MojDbDumpWriter::Format m_format;
+	MojJsonParser m_parser;
+	MojObjectBuilder m_builder;
+	MojVector<MojChar> m_buf;
+	MojChar* m_bufBegin;
+	const MojChar* m_pos;
+	const MojChar* m_end;
+	bool m_eof;
+	MojVector<MojByte> m_stored;
+	MojVector<MojByte> m_chunk;
+	MojDataReader m_reader;
+};
+
+#endif /* MOJDBDUMP_H_ */
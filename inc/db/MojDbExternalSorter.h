@@ -0,0 +1,129 @@
+/* @@@LICENSE
+*
+*  Copyright (c) 2014 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef MOJDBEXTERNALSORTER_H_
+#define MOJDBEXTERNALSORTER_H_
+
+#include "db/MojDbDefs.h"
+#include "db/MojDbKey.h"
+#include "core/MojFile.h"
+#include "core/MojString.h"
+#include "core/MojVector.h"
+
+// Sorts (key, id) records using bounded memory. Records are buffered until the run
+// reaches runBytes, at which point the run is sorted and spilled to a temp file.
+// finish() merges spilled runs in passes of at most MaxOpenRuns until the rest can
+// be held open at once, and next() then k-way merges those. Keys and ids compare
+// as raw bytes; either can be ordered descending.
+class MojDbExternalSorter : private MojNoCopy
+{
+public:
+	static const MojSize RunBytesDefault = 512 * 1024;
+	static const MojSize MaxOpenRuns = 64;
+
+	MojDbExternalSorter();
+	~MojDbExternalSorter();
+
+	MojErr open(const MojChar* tmpDir, MojSize runBytes = RunBytesDefault, bool descKeys = false, bool descIds = false);
+	MojErr close();
+	MojErr put(const MojDbKey& key, const MojDbKey& id);
+	MojErr finish();
+	MojErr next(MojDbKey& keyOut, MojDbKey& idOut, bool& foundOut);
+
+	MojSize count() const { return m_count; }
+	MojSize runCount() const { return m_runCount; }
+	MojSize mergeCount() const { return m_mergeCount; }
+
+private:
+	static const MojSize BufSize = 16 * 1024;
+
+	struct Record
+	{
+		MojDbKey m_key;
+		MojDbKey m_id;
+	};
+
+	class RecordComp
+	{
+	public:
+		RecordComp(bool descKeys = false, bool descIds = false) : m_descKeys(descKeys), m_descIds(descIds) {}
+		int operator()(const Record& r1, const Record& r2) const;
+
+	private:
+		bool m_descKeys;
+		bool m_descIds;
+	};
+
+	class Run : private MojNoCopy
+	{
+	public:
+		Run() : m_pos(0), m_end(0), m_eof(false) {}
+
+		MojErr open(const MojChar* path);
+		MojErr next();
+		bool eof() const { return m_eof; }
+		const Record& rec() const { return m_rec; }
+		Record& rec() { return m_rec; }
+
+	private:
+		MojErr read(MojByte* dest, MojSize len, MojSize& readOut);
+		MojErr readKey(MojDbKey& keyOut, bool& eofOut);
+
+		MojFile m_file;
+		MojByte m_buf[BufSize];
+		MojSize m_pos;
+		MojSize m_end;
+		Record m_rec;
+		bool m_eof;
+	};
+
+	typedef MojVector<Record> RecordVec;
+	typedef MojVector<Run*> RunVec;
+	typedef MojVector<MojString> PathVec;
+
+	MojErr spill();
+	MojErr mergeRuns(MojSize numRuns);
+	MojErr openRuns(MojSize numRuns);
+	MojErr beginRun(MojFile& file, MojString& pathOut);
+	MojErr endRun(MojFile& file, const MojString& path);
+	void abandonRun(MojFile& file, const MojString& path);
+	MojErr pop(MojDbKey& keyOut, MojDbKey& idOut, bool& foundOut);
+	void heapify();
+	MojErr write(MojFile& file, const MojByte* data, MojSize len);
+	MojErr writeKey(MojFile& file, const MojDbKey& key);
+	MojErr flush(MojFile& file);
+	void heapDown(MojSize idx);
+	bool less(const Run* r1, const Run* r2) const { return m_comp(r1->rec(), r2->rec()) < 0; }
+
+	MojString m_tmpDir;
+	MojSize m_runBytes;
+	MojSize m_bytes;
+	MojSize m_count;
+	MojSize m_runCount;
+	MojSize m_mergeCount;
+	MojSize m_memPos;
+	RecordComp m_comp;
+	RecordVec m_records;
+	RunVec m_runs;
+	PathVec m_paths;
+	MojByte m_writeBuf[BufSize];
+	MojSize m_writeLen;
+	bool m_finished;
+};
+
+#endif /* MOJDBEXTERNALSORTER_H_ */
@@ -24,23 +24,33 @@
 #include "db/MojDbExtractor.h"
 #include "db/MojDbStorageEngine.h"
 #include "db/MojDbWatcher.h"
+#include "db/MojDbWatcherTree.h"
+#include "core/MojAtomicInt.h"
 #include "core/MojSet.h"
 #include "core/MojThread.h"
 
 class MojDbIndex : public MojSignalHandler
 {
 public:
+	static const MojChar* const BuildingKey;
+	static const MojChar* const BuiltKey;
 	static const MojChar* const CountKey;
 	static const MojChar* const DelMissesKey;
 	static const MojChar* const DefaultKey;
+	static const MojChar* const IndexKey;
 	static const MojChar* const IncludeDeletedKey;
+	static const MojChar* const LiveCountKey;
+	static const MojChar* const LowerKey;
 	static const MojChar* const MultiKey;
 	static const MojChar* const NameKey;
 	static const MojChar* const PropsKey;
+	static const MojChar* const RangesKey;
 	static const MojChar* const SizeKey;
 	static const MojChar* const TypeKey;
+	static const MojChar* const UpperKey;
 	static const MojChar* const WatchesKey;
 	static const MojSize MaxIndexNameLen = 128;
+	static const MojUInt32 EstimateSampleSize = 100;
 
 	typedef MojVector<MojString> StringVec;
 
@@ -51,18 +61,33 @@ public:
 	MojErr addProp(const MojObject& propObj, bool pushFront = false);
 	void incDel(bool val) { MojAssert(!isOpen()); m_includeDeleted = val; }
 
-	MojErr open(MojDbStorageIndex* index, const MojObject& id, MojDbReq& req, bool created = false);
+	MojErr open(MojDbStorageIndex* index, const MojObject& id, MojDbReq& req, bool created = false, bool building = false);
 	MojErr close();
 	MojErr stats(MojObject& objOut, MojSize& usageOut, MojDbReq& req);
 	MojErr drop(MojDbReq& req);
 	MojErr updateLocale(const MojChar* locale, MojDbReq& req);
 
 	MojErr find(MojDbCursor& cursor, MojDbWatcher* watcher, MojDbReq& req);
+	MojErr beginTxn(MojDbCursor& cursor, MojDbReq& req);
 	MojErr update(const MojObject* newObj, const MojObject* oldObj, MojDbStorageTxn* txn, bool forcedel);
 	MojErr cancelWatch(MojDbWatcher* watcher);
+	MojErr buildStep(MojUInt32 stepSize, MojDbReq& req, bool& doneOut);
+	MojErr buildCount(MojDbReq& req);
+	// samples through txn if given, otherwise only the tracked key count is used;
+	// MojInvalidSize if neither tells us anything
+	MojErr estimate(const MojDbQuery& query, MojDbStorageTxn* txn, MojSize& keysOut);
+	MojErr explain(const MojDbQuery& query, MojObject& objOut);
+	MojErr liveCount(MojDbStorageTxn* txn, MojUInt32& countOut, bool& foundOut);
+	MojErr applyCount(MojInt64 offset, MojDbStorageTxn* txn);
+	MojErr resetCount();
+	void uncacheCount() { m_countCached = false; }	// caller holds countLock()
+	void applyKeyCount(MojInt64 offset) { if (m_keyCount.value() >= 0) m_keyCount.add((int) offset); }
+	MojErr insertSorted(MojDbStorageTxn::KeyVec& keys, MojDbStorageTxn* txn);
 
 	bool canAnswer(const MojDbQuery& query) const;
 	bool includeDeleted() const { return m_includeDeleted; }
+	bool building() const { return m_building && isOpen(); }
+	bool isIdIndex() const;
 	MojSize idIndex() const { return m_idIndex; }
 	MojSize size() const { return m_props.size(); }
 	const MojObject& id() const { return m_id; }
@@ -72,6 +97,7 @@ public:
 	const MojString& locale() const { return m_locale; }
 	const MojString& name() const { return m_name; }
     MojDbCollationStrength collation(MojSize idx) const { return (m_props.at(idx)->collation()); }
+	MojThreadMutex& countLock() { return m_countLock; }
 
 private:
 	static const MojSize WatchWarningThreshold = 20;
@@ -82,12 +108,10 @@ private:
 	typedef MojSet<MojDbKey> KeySet;
 	typedef MojSet<MojObject> ObjectSet;
 	typedef MojVector<MojObject> ObjectVec;
-	typedef MojVector<MojRefCountedPtr<MojDbWatcher> > WatcherVec;
 	typedef MojMap<MojString, MojSize> WatcherMap;
 	typedef MojDbStorageTxn::CommitSignal::Slot<MojDbIndex> CommitSlot;
 
 	bool isOpen() const { return m_collection != NULL; }
-	bool isIdIndex() const;
 	bool includeObj(const MojObject* obj) const;
 	MojErr createExtractor(const MojObject& propObj, MojRefCountedPtr<MojDbExtractor>& extractorOut);
 	MojErr addBuiltinProps();
@@ -97,8 +121,17 @@ private:
 	MojErr delKeys(const KeySet& keys, MojDbStorageTxn* txn, bool forcedel);
 	MojErr insertKeys(const KeySet& keys, MojDbStorageTxn* txn);
 	MojErr getKeys(const MojObject& obj, KeySet& keysOut) const;
+	bool keyCount(MojSize& countOut) const;
+	MojErr initCount(bool created, MojDbReq& req);
+	MojErr offsetLiveCount(MojDbStorageTxn* txn, const MojObject* newObj, MojSize newKeys,
+						   const MojObject* oldObj, MojSize oldKeys);
+	MojErr getCount(MojDbStorageTxn* txn, bool forUpdate, MojInt64& countOut, MojRefCountedPtr<MojDbStorageItem>& itemOut);
+	MojErr putCount(MojInt64 count, MojDbStorageItem* oldItem, MojDbStorageTxn* txn);
+	MojErr delCount(MojDbStorageTxn* txn);
+	MojErr sampleKeys(const MojDbQuery& query, MojDbStorageTxn* txn, MojSize& keysOut, bool& completeOut);
 	MojErr handlePreCommit(MojDbStorageTxn* txn);
 	MojErr handlePostCommit(MojDbStorageTxn* txn);
+	MojErr handleBuilt(MojDbStorageTxn* txn);
 	MojErr build(MojDbStorageTxn* txn);
 	static MojErr validateName(const MojString& name);
 
@@ -109,12 +142,17 @@ private:
 	PropVec m_props;
 	MojObject m_obj;
 	MojObject m_id;
+	MojDbQuery::Page m_buildPage;
 	KeySet m_idSet;
-	WatcherVec m_watcherVec;
+	MojDbWatcherTree m_watchers;
 	WatcherMap m_watcherMap;
 	MojThreadRwLock m_lock;
+	MojThreadMutex m_countLock;	// held while a commit rewrites this index's live count
+	MojInt64 m_cachedCount;		// the count the last ordered commit wrote, guarded by m_countLock
+	bool m_countCached;
 	CommitSlot m_preCommitSlot;
 	CommitSlot m_postCommitSlot;
+	CommitSlot m_builtSlot;
 	MojRefCountedPtr<MojDbStorageIndex> m_index;
 	MojDbKind* m_kind;
 	MojDbKindEngine* m_kindEngine;
@@ -122,7 +160,11 @@ private:
 	MojSize m_idIndex;
 	bool m_includeDeleted;
 	bool m_ready;
+	bool m_building;
+	bool m_countPending;	// opened without a live count, so the index builder takes one
 	MojUInt32 m_delMisses;
+	MojUInt32 m_buildCount;
+	MojAtomicInt m_keyCount;	// approximate, -1 unless tracked since the index was created
 };
 
 #endif /* MOJDBINDEX_H_ */
@@ -0,0 +1,69 @@
+/* @@@LICENSE
+*
+*  Copyright (c) 2014 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#ifndef MOJDBINDEXBUILDER_H_
+#define MOJDBINDEXBUILDER_H_
+
+#include "db/MojDbDefs.h"
+#include "db/MojDbIndex.h"
+#include "core/MojObject.h"
+#include "core/MojThread.h"
+#include "core/MojVector.h"
+
+// Fills newly created indexes on a worker thread instead of inside the putKind transaction.
+// Each step indexes at most stepSize() objects under the schema write lock, so puts are only
+// held off for one batch at a time. Until an index is complete it is not used for queries.
+// Indexes that have no live count yet (just built, or from before counts were kept) are
+// counted here too, in one step, so that opening the db does not have to walk them.
+class MojDbIndexBuilder : private MojNoCopy
+{
+public:
+	static const MojChar* const BackgroundKey;
+	static const MojChar* const StepSizeKey;
+	static const MojUInt32 StepSizeDefault = 200;
+
+	MojDbIndexBuilder(MojDb& db);
+	~MojDbIndexBuilder();
+
+	MojErr configure(const MojObject& conf);
+	MojErr schedule(MojDbIndex* index);
+	MojErr stop();
+
+	bool enabled() const { return m_enabled; }
+	MojUInt32 stepSize() const { return m_stepSize; }
+
+private:
+	typedef MojVector<MojRefCountedPtr<MojDbIndex> > IndexVec;
+
+	static MojErr threadMain(void* arg);
+	MojErr run();
+	MojErr buildIndex(MojDbIndex* index);
+	MojErr step(MojDbIndex* index, bool& doneOut);
+	bool stopping();
+
+	MojDb& m_db;
+	MojThreadT m_thread;
+	MojThreadMutex m_mutex;
+	MojThreadCond m_cond;
+	IndexVec m_queue;
+	MojUInt32 m_stepSize;
+	bool m_enabled;
+	bool m_stop;
+};
+
+#endif /* MOJDBINDEXBUILDER_H_ */
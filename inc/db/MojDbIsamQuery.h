@@ -36,6 +36,7 @@ public:
 	virtual MojErr count(MojUInt32& countOut);
 	virtual MojErr nextPage(MojDbQuery::Page& pageOut);
 	virtual MojUInt32 groupCount() const;
+	virtual MojUInt32 keysScanned() const { return m_keysScanned; }
 	
 
 protected:
@@ -48,19 +49,26 @@ protected:
 	};
 	typedef MojVector<MojByte> ByteVec;
 	typedef MojVector<MojDbKeyRange> RangeVec;
+	typedef MojVector<MojObject> ObjectVec;
 
-	virtual MojErr seekImpl(const ByteVec& key, bool desc, bool& foundOut) = 0;
+	static const MojSize CountBatchSize = 256;
+
+	virtual MojErr seekImpl(const MojDbKey& key, bool desc, bool& foundOut) = 0;
 	virtual MojErr next(bool& foundOut) = 0;
 	virtual MojErr getVal(MojDbStorageItem*& itemOut, bool& foundOut) = 0;
+	// counts the ids whose objects exist. engines that can check for a key without
+	// reading its value override this; the default gets each object.
+	virtual MojErr countIds(const ObjectVec& ids, MojUInt32& countOut);
 
 	MojDbIsamQuery();
 	MojErr open(MojAutoPtr<MojDbQueryPlan> plan, MojDbStorageTxn* txn);
     MojErr distinct(MojDbStorageItem*& itemOut, bool& distinct);
 	MojErr getImpl(MojDbStorageItem*& itemOut, bool& foundOut, bool getItem);
+	MojErr countKeys(MojInt32& missesOut);
 	void init();
 	bool match();
 	bool limitEnforced() { return m_count >= m_plan->limit(); }
-	int compareKey(const ByteVec& key);
+	int compareKey(const MojDbKey& key);
 	MojErr incrementCount();
 	MojErr seek(bool& foundOut);
 	MojErr getKey(MojUInt32& groupOut, bool& foundOut);
@@ -71,6 +79,7 @@ protected:
 
 	bool m_isOpen;
 	MojUInt32 m_count;
+	MojUInt32 m_keysScanned;
 	State m_state;
 	RangeVec::ConstIterator m_iter;
 	MojDbStorageTxn* m_txn;
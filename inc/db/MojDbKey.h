@@ -24,42 +24,58 @@
 #include "core/MojBuffer.h"
 #include "core/MojObject.h"
 #include "core/MojSet.h"
+#include "core/MojUtil.h"
 #include "core/MojVector.h"
 
+// Keys up to InlineSize bytes, which covers most index keys, are stored inline
+// so that building and copying them does not allocate. Longer keys, and keys
+// whose byteVec() has been requested, are kept in a ByteVec. Reading a key never
+// changes how it is stored, so const keys are safe to share between threads.
 class MojDbKey
 {
 public:
 	typedef MojVector<MojByte> ByteVec;
+	static const MojSize InlineSize = 48;
 
-	MojDbKey() {}
-	explicit MojDbKey(const ByteVec& vec) : m_vec(vec) {}
+	MojDbKey() : m_size(0), m_heap(false) {}
+	MojDbKey(const MojDbKey& key) : m_size(0), m_heap(false) { assignKey(key); }
+	explicit MojDbKey(const ByteVec& vec) : m_size(0), m_heap(true), m_vec(vec) {}
 
-	void clear() { m_vec.clear(); }
-	MojErr assign(const MojByte* data, MojSize size) { return m_vec.assign(data, data + size); }
-	MojErr assign(const MojBuffer& buf) { return buf.toByteVec(m_vec); }
+	void clear() { m_vec.clear(); m_size = 0; m_heap = false; }
+	MojErr assign(const MojByte* data, MojSize size);
+	MojErr assign(const MojBuffer& buf);
 	MojErr assign(const MojObject& obj, MojDbTextCollator* coll = NULL);
+	MojErr append(const MojByte* data, MojSize size);
+	MojErr truncate(MojSize size);
 	MojErr increment();
 	MojErr prepend(const MojDbKey& key);
 
-	const ByteVec& byteVec() const { return m_vec; }
-	ByteVec& byteVec() { return m_vec; }
-	const MojByte* data() const { return m_vec.begin(); }
-	bool empty() const { return m_vec.empty(); }
-	MojSize size() const { return m_vec.size(); }
-	int compare(const MojDbKey& rhs) const { return m_vec.compare(rhs.m_vec); }
+	// moves the key out of inline storage for in-place edits; read with data() and size()
+	MojErr byteVec(ByteVec*& vecOut);
+	const MojByte* data() const { return m_heap ? m_vec.begin() : m_inline; }
+	bool empty() const { return size() == 0; }
+	MojSize size() const { return m_heap ? m_vec.size() : m_size; }
+	int compare(const MojDbKey& rhs) const { return MojLexicalCompare(data(), size(), rhs.data(), rhs.size()); }
 	bool prefixOf(const MojDbKey& key) const;
 	bool stringPrefixOf(const MojDbKey& key) const;
 
-	MojDbKey& operator=(const ByteVec& rhs) { m_vec = rhs; return *this; }
-	bool operator==(const MojDbKey& rhs) const { return m_vec == rhs.m_vec; }
-	bool operator!=(const MojDbKey& rhs) const { return m_vec != rhs.m_vec; }
-	bool operator<(const MojDbKey& rhs) const { return m_vec < rhs.m_vec; }
-	bool operator<=(const MojDbKey& rhs) const { return m_vec <= rhs.m_vec; }
-	bool operator>(const MojDbKey& rhs) const { return m_vec > rhs.m_vec; }
-	bool operator>=(const MojDbKey& rhs) const { return m_vec >= rhs.m_vec; }
+	MojDbKey& operator=(const MojDbKey& rhs) { assignKey(rhs); return *this; }
+	MojDbKey& operator=(const ByteVec& rhs) { m_vec = rhs; m_size = 0; m_heap = true; return *this; }
+	bool operator==(const MojDbKey& rhs) const { return size() == rhs.size() && MojMemCmp(data(), rhs.data(), size()) == 0; }
+	bool operator!=(const MojDbKey& rhs) const { return !operator==(rhs); }
+	bool operator<(const MojDbKey& rhs) const { return compare(rhs) < 0; }
+	bool operator<=(const MojDbKey& rhs) const { return compare(rhs) <= 0; }
+	bool operator>(const MojDbKey& rhs) const { return compare(rhs) > 0; }
+	bool operator>=(const MojDbKey& rhs) const { return compare(rhs) >= 0; }
 
 private:
+	void assignKey(const MojDbKey& key);
+	MojErr spill();
+
+	MojSize m_size;			// inline size, unused once on the heap
+	bool m_heap;
 	ByteVec m_vec;
+	MojByte m_inline[InlineSize];
 };
 
 class MojDbKeyRange
@@ -89,6 +105,9 @@ private:
 	MojUInt32 m_group;
 };
 
+// Builds the cartesian product of one value per pushed property. The values
+// are copied into a single arena when pushed, and each key of the product is
+// put together from arena slices.
 class MojDbKeyBuilder : private MojNoCopy
 {
 public:
@@ -96,26 +115,29 @@ public:
 
 	MojDbKeyBuilder() {}
 
-	void clear() { m_stack.clear(); }
+	void clear() { m_props.clear(); m_vals.clear(); m_arena.clear(); }
 	MojErr push(const KeySet& vals);
 	MojErr keys(KeySet& keysOut);
 
 private:
-	struct PropRec {
-		PropRec(const KeySet& vals) : m_vals(vals) { reset(); }
-		void reset() { m_iter = m_vals.begin(); }
-		KeySet m_vals;
-		KeySet::ConstIterator m_iter;
+	struct Val {
+		MojSize m_offset;
+		MojSize m_size;
 	};
-	typedef MojVector<PropRec> PropStack;
+	typedef MojVector<Val> ValVec;
+	typedef MojVector<MojSize> SizeVec;
+
+	MojSize propEnd(MojSize idx) const { return idx + 1 < m_props.size() ? m_props.at(idx + 1) : m_vals.size(); }
 
-	PropStack m_stack;
+	SizeVec m_props;		// index of each property's first value in m_vals
+	ValVec m_vals;
+	MojDbKey::ByteVec m_arena;
 };
 
 template<>
 struct MojComp<MojDbKey>
 {
-	int operator()(const MojDbKey& val1, const MojDbKey& val2)
+	int operator()(const MojDbKey& val1, const MojDbKey& val2) const
 	{
 		return val1.compare(val2);
 	}
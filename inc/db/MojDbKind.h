@@ -41,6 +41,7 @@ public:
 	typedef MojVector<MojDbKind*> KindVec;
 	typedef MojVector<MojByte> ByteVec;
 
+	static const MojChar* const CompressKey;
 	static const MojChar* const CountKey;
 	static const MojChar* const DelCountKey;
 	static const MojChar* const DelSizeKey;
@@ -71,6 +72,7 @@ public:
 	const StringVec& superIds() const { return m_superIds; }
 	const KindVec& supers() const { return m_supers; }
     bool isBuiltin() const { return m_builtin; }
+	bool compress() const { return m_compress; }
 	MojDbKindEngine* kindEngine() const { return m_kindEngine; }
 	MojInt64 token() const { return m_state->token(); }
 	MojUInt32 version() const { return m_version; }
@@ -85,6 +87,7 @@ public:
 	MojErr drop(MojDbReq& req);
 	MojErr close();
 	MojErr updateLocale(const MojChar* locale, MojDbReq& req);
+	MojErr indexBuilt(const MojString& indexName, MojDbReq& req);
 
 	MojErr update(MojObject* newObj, const MojObject* oldObj, MojDbOp op,
                   MojDbReq& req, bool checkSchema = true);
@@ -117,6 +120,8 @@ private:
 
 	bool hasOwnerPermission(MojDbReq& req);
 	MojDbIndex* indexForQuery(const MojDbQuery& query) const;
+	MojErr chooseIndex(const MojDbQuery& query, MojDbCursor& cursor, MojDbWatcher* watcher, MojDbReq& req,
+					   MojDbIndex*& indexOut, MojSize& estimateOut);
 	MojDbPermissionEngine::Value objectPermission(const MojChar* op, MojDbReq& req);
 	MojErr deny(MojDbReq& req);
 	MojErr updateIndexes(const MojObject* newObj, const MojObject* oldObj, const MojDbReq& req, MojDbOp op, MojVector<MojDbKind*>& kindVec, MojInt32& idxcount);
@@ -150,6 +155,7 @@ private:
 	MojRefCountedPtr<MojDbKindState> m_state;
 	bool m_backup;
 	bool m_builtin;
+	bool m_compress;
 
     MojUInt32 m_updateRev;
 };
@@ -44,6 +44,16 @@ public:
 
 	typedef MojHashMap<MojString, MojRefCountedPtr<MojDbKind>, const MojChar*> KindMap;
 
+	// names of the props that MojDbObjectHeader adds to every object, allocated once
+	// so that loaded objects share them
+	struct HeaderNames
+	{
+		MojString m_id;
+		MojString m_kind;
+		MojString m_rev;
+		MojString m_del;
+	};
+
 	MojDbKindEngine();
 	~MojDbKindEngine();
 
@@ -71,11 +81,13 @@ public:
 	MojDbQuotaEngine* quotaEngine();
 	MojDbStorageSeq* indexSeq() { return m_indexIdSeq.get(); }
 	MojDbStorageDatabase* indexIdDb() { return m_indexIdDb.get(); }
+	MojDbStorageDatabase* indexCountDb() { return m_indexCountDb.get(); }
 	MojDbStorageDatabase* kindDb() { return m_kindDb.get(); }
 	KindMap& kindMap() { return m_kinds; }
 	MojErr tokenSet(const MojChar* kindName, MojTokenSet& tokenSetOut);
 	MojErr tokenFromId(const MojChar* id, MojInt64& tokOut);
 	MojErr idFromToken(MojInt64 tok, MojString& idOut);
+	const HeaderNames& headerNames() const { return m_headerNames; }
 	MojErr getKind(const MojObject& obj, MojDbKind*& kind);
 	MojErr getKind(const MojChar* kindName, MojDbKind*& kind);
 	bool   isExist(const MojChar* kindName, MojDbKind*& kind);
@@ -90,6 +102,7 @@ private:
 	static const MojChar* const KindIdPrefix;
 	static const MojChar* const KindsDbName;
 	static const MojChar* const IndexIdsDbName;
+	static const MojChar* const IndexCountsDbName;
 	static const MojChar* const IndexIdsSeqName;
 	static const MojChar* const RootKindJson;
 	static const MojChar* const KindKindJson;
@@ -100,6 +113,7 @@ private:
 
 	bool isOpen() const { return m_db != NULL; }
 	MojErr setupRootKind();
+	MojErr initHeaderNames();
 	MojErr addBuiltin(const MojChar* json, MojDbReq& req);
 	MojErr createKind(const MojString& id, const MojObject& obj, MojDbReq& req, bool builtIn = false);
 	MojErr loadKinds(MojDbReq& req);
@@ -108,9 +122,11 @@ private:
 	MojDb* m_db;
 	MojRefCountedPtr<MojDbStorageDatabase> m_kindDb;
 	MojRefCountedPtr<MojDbStorageDatabase> m_indexIdDb;
+	MojRefCountedPtr<MojDbStorageDatabase> m_indexCountDb;
 	MojRefCountedPtr<MojDbStorageSeq> m_indexIdSeq;
 	KindMap m_kinds;
 	TokMap m_tokens;
+	HeaderNames m_headerNames;
 	MojString m_locale;
 };
 
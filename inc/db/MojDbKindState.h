@@ -27,6 +27,7 @@
 class MojDbKindState : public MojSharedTokenSet
 {
 public:
+	static const MojChar* const BuildingIndexesKey;
 	static const MojChar* const IndexIdsKey;
 	static const MojChar* const KindTokensKey;
 	static const MojChar* const TokensKey;
@@ -39,13 +40,20 @@ public:
 	MojErr init(const StringSet& strings, MojDbReq& req);
 	MojErr indexId(const MojChar* indexName, MojDbReq& req, MojObject& idOut, bool& createdOut);
 	MojErr delIndex(const MojChar* indexName, MojDbReq& req);
+	MojErr indexBuilding(const MojChar* indexName, MojDbReq& req, bool& buildingOut);
+	MojErr setIndexBuilding(const MojChar* indexName, bool building, MojDbReq& req);
 
 	MojInt64 token() const { return m_kindToken; }
 	virtual MojErr tokenSet(TokenVec& vecOut, MojObject& tokensObjOut) const;
-	virtual MojErr addToken(const MojChar* propName, MojUInt8& tokenOut, TokenVec& vecOut, MojObject& tokenObjOut);
+	virtual MojErr addToken(const MojChar* propName, MojUInt32& tokenOut, TokenVec& vecOut, MojObject& tokenObjOut);
 
 private:
-	MojErr addPropImpl(const MojChar* propName, bool write, MojUInt8& tokenOut, TokenVec& vecOut, MojObject& tokenObjOut);
+	// largest token handed out; it still fits in a two-byte varint after the extended token
+	// marker. Kinds that keep inventing prop names (e.g. ids used as keys) store the names
+	// beyond it inline, as they did before tokens could exceed one byte.
+	static const MojUInt32 MaxToken = 0x3FFF;
+
+	MojErr addPropImpl(const MojChar* propName, bool write, MojUInt32& tokenOut, TokenVec& vecOut, MojObject& tokenObjOut);
 	MojErr initKindToken(MojDbReq& req);
 	MojErr initTokens(MojDbReq& req, const StringSet& strings);
 	MojErr id(const MojChar* name, const MojChar* objKey, MojDbReq& req, MojObject& idOut, bool& createdOut);
@@ -63,7 +71,7 @@ private:
 	MojObject m_tokensObj;
 	TokenVec m_tokenVec;
 	MojInt64 m_kindToken;
-	MojUInt8 m_nextToken;
+	MojUInt32 m_nextToken;
 	MojDbKindEngine* m_kindEngine;
 };
 
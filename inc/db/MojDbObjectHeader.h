@@ -44,7 +44,10 @@ public:
 	MojObjectReader& reader() { return m_reader; }
 
 private:
-	static const MojUInt8 Version = 1;
+	// version 2 objects may contain extended (multi-byte) prop tokens. Version 1
+	// objects are a subset of that format, so they are still read as is.
+	static const MojUInt8 Version = 2;
+	static const MojUInt8 MinVersion = 1;
 
 	MojErr readHeader();
 	MojErr readRev();
@@ -21,16 +21,27 @@
 
 #include "db/MojDbQuery.h"
 #include "db/MojDbCursor.h"
+#include "core/MojHashMap.h"
+#include "core/MojList.h"
+#include "core/MojThread.h"
 #include "core/MojVector.h"
-#include <map>
 
-class MojDbSearchCache
+// Keeps the sorted id lists of search queries. Entries are kept in LRU order within a
+// byte budget, and an entry is dropped as soon as its kind is updated past the
+// revision it was built from.
+class MojDbSearchCache : private MojNoCopy
 {
 public :
+    static const MojChar* const MaxBytesKey;
+    static const MojChar* const StatsKey;
+    static const MojSize MaxBytesDefault = 1024 * 1024;
+
     class QueryKey{
         friend class MojDbSearchCache;
 
     public:
+        QueryKey() : m_rev(0) {}
+
         MojUInt32 getRev() const { return m_rev; }
         void setRev(MojUInt32 rev) { m_rev = rev; }
 
@@ -41,6 +52,7 @@ public :
         const MojString& getKind() const { return m_kind; }
         void setKind(const MojString& a_kind) { m_kind = a_kind; }
 
+        MojSize hash() const;
         bool operator<(const QueryKey& rhsKey) const;
         bool operator==(const QueryKey& rhsKey) const;
 
@@ -55,19 +67,64 @@ public :
     friend class QueryKey;
 
     typedef MojVector<MojObject> IdSet;
-    typedef std::map<QueryKey, IdSet> Container;
 
-    const Container& container() const { return m_container; }
+    MojDbSearchCache();
+    ~MojDbSearchCache();
+
+    MojErr configure(const MojObject& conf);
+
     MojErr createCache(const QueryKey& a_key, const IdSet& a_ids);
     MojErr destroyCache(const QueryKey& a_key);
     MojErr destroyCache(const MojString& a_kind);
     MojErr updateCache(const QueryKey& key, const IdSet& ids);
-    MojErr getIdSet(const QueryKey& a_key, IdSet& a_ids) const;
+    MojErr getIdSet(const QueryKey& a_key, IdSet& a_ids);
+    MojErr getIdSet(const QueryKey& a_key, IdSet& a_ids, bool& foundOut);
+    MojErr invalidate(const MojString& a_kind, MojUInt32 a_revision);
+    MojErr stats(MojObject& objOut) const;
 
     bool contain(const QueryKey& a_key) const;
+    MojSize size() const;
+    MojSize bytes() const;
+    MojSize maxBytes() const { return m_maxBytes; }
 
 private :
-    Container m_container;
+    struct Entry
+    {
+        QueryKey m_key;
+        IdSet m_ids;
+        MojSize m_bytes;
+        MojListEntry m_entry;
+    };
+
+    struct KeyHasher
+    {
+        MojSize operator()(const QueryKey& key) { return key.hash(); }
+    };
+
+    typedef MojHashMap<QueryKey, Entry*, QueryKey, KeyHasher> EntryMap;
+    typedef MojHashMap<MojString, MojUInt32, const MojChar*> KindCountMap;
+    typedef MojList<Entry, &Entry::m_entry> EntryList;
+
+    static MojSize idSetBytes(const QueryKey& key, const IdSet& ids);
+
+    MojErr insert(const QueryKey& key, const IdSet& ids);
+    MojErr erase(Entry* entry);
+    MojErr eraseKind(const MojString& kind, MojUInt32 belowRev, MojInt64& countOut);
+    MojErr evict(MojSize needed);
+    void clear();
+
+    mutable MojThreadMutex m_mutex;
+    EntryMap m_entries;
+    KindCountMap m_kindCounts;
+    EntryList m_lru;
+    MojSize m_bytes;
+    MojSize m_maxBytes;
+
+    // counters
+    MojInt64 m_hits;
+    MojInt64 m_misses;
+    MojInt64 m_evictions;
+    MojInt64 m_invalidations;
 };
 
 #endif /* MOJDBSEARCHCACHE_H_ */
@@ -22,11 +22,16 @@
 
 #include "db/MojDbDefs.h"
 #include "db/MojDbCursor.h"
+#include "db/MojDbExternalSorter.h"
 #include "db/MojDbObjectItem.h"
 #include "db/MojDbSearchCache.h"
 #include "db/MojDbQuery.h"
 #include <map>
 
+// Executes queries that need an in-memory sort or a full-text search. Candidate ids and
+// then matching ids are sorted through MojDbExternalSorters, so neither the id set nor
+// the sort keys of the result set are held at once (both spill to disk beyond
+// searchRunBytes) and objects are fetched for the requested page only.
 class MojDbSearchCursor : public MojDbCursor
 {
 public:
@@ -35,41 +40,34 @@ public:
 	virtual MojErr close();
 	virtual MojErr get(MojDbStorageItem*& itemOut, bool& foundOut);
 	virtual MojErr count(MojUInt32& countOut);
-    virtual MojErr setPagePosition();
     virtual MojErr nextPage(MojDbQuery::Page& pageOut);
     MojDbCollationStrength collation() const { return m_collation; }
-    virtual MojErr getIds(MojDbSearchCache::IdSet& sortedId);
-    virtual MojErr loadFromCache(const MojDbSearchCache* cache);
+    virtual MojErr loadFromCache(const MojDbSearchCache::IdSet& ids);
 
 private:
-	struct ItemComp
-	{
-		int operator()(const MojRefCountedPtr<MojDbObjectItem>& i1, const MojRefCountedPtr<MojDbObjectItem>& i2) const
-		{
-			return i1->sortKeys().compare(i2->sortKeys());
-		}
-	};
 	typedef MojSet<MojDbKey> KeySet;
-	typedef MojSet<MojObject> ObjectSet;
-	typedef MojMap<MojUInt32, MojSharedPtr<ObjectSet> > GroupMap;
-	typedef MojVector<MojRefCountedPtr<MojDbObjectItem>, MojEq<MojRefCountedPtr<MojDbObjectItem> >, ItemComp > ItemVec;
-
-	static const MojUInt32 MaxResults = 10000;
+	typedef MojSet<MojUInt32> GroupSet;
+	typedef MojVector<MojRefCountedPtr<MojDbObjectItem> > ItemVec;
 
 	virtual MojErr init(const MojDbQuery& query);
     MojErr retrieveCollation(const MojDbQuery& query);
 	bool loaded() const { return m_pos != NULL; }
 	MojErr begin();
-	MojErr load(bool fromCache);
-	MojErr loadIds(ObjectSet& idsOut);
-	MojErr loadObjects(const ObjectSet& ids);
-	MojErr sort();
-	MojErr distinct();
+	MojErr load(bool fromCache, const MojDbSearchCache::IdSet& cachedIds);
+	MojErr loadIds(MojDbExternalSorter& idSorter, bool& matchOut);
+	MojErr loadSorted();
+	MojErr sort(MojDbExternalSorter& idSorter, MojDbExternalSorter& sorter);
+	MojErr sortId(const MojDbKey& idKey, MojDbPropExtractor& extractor, MojDbExternalSorter& sorter, bool& warnOut);
+	MojErr initExtractor(MojDbPropExtractor& extractor, MojRefCountedPtr<MojDbTextCollator>& collatorOut);
+	MojErr addResult(const MojObject& id);
     const MojDbQuery::Page& page() const { return m_page; }
 
+	static MojErr encodeSortKey(const KeySet& keys, MojDbKey& keyOut);
+
 	ItemVec m_items;
 	MojString m_orderProp;
 	MojString m_distinct;
+	MojDbStorageItem::PropSet m_sortProps;
 	MojUInt32 m_limit;
 	ItemVec::ConstIterator m_pos;
 	ItemVec::ConstIterator m_limitPos;
@@ -78,6 +76,7 @@ private:
     MojDbQuery::Page m_page;
     MojObject m_pageObject;
     MojUInt32 m_count;
+    bool m_inPage;
     MojDbSearchCache::QueryKey m_queryKey;
     MojDbQuery m_cacheQuery;
 };
@@ -36,6 +36,7 @@ public:
 	static const MojChar* const DevicesKey;
 	static const MojChar* const DescriptionKey;
 	static const MojChar* const DirKey;
+	static const MojChar* const ExplainKey;
 	static const MojChar* const ExtendKey;
 	static const MojChar* const FilesKey;
 	static const MojChar* const FiredKey;
@@ -76,6 +76,8 @@ private:
 		MojErr handleWatch();
 		MojErr handleCancel(MojServiceMessage* msg);
 
+		// with async watch delivery, handleWatch runs on the notifier thread and can race handleCancel
+		MojThreadMutex m_mutex;
 		MojRefCountedPtr<MojServiceMessage> m_msg;
 		MojDb::WatchSignal::Slot<Watcher> m_watchSlot;
 		MojServiceMessage::CancelSignal::Slot<Watcher> m_cancelSlot;
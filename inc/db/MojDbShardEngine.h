@@ -63,6 +63,11 @@ public:
      */
     MojErr getAllActive (std::list<MojDbShardInfo>& shardInfo, MojUInt32& count, MojDbReqRef req = MojDbReq());
 
+    /**
+     * is any known shard currently inactive?
+     */
+    bool hasInactiveShards (void) const { return m_cache.hasInactive(); }
+
     /**
      * update shardInfo
      */
@@ -33,6 +33,7 @@ public:
     ~MojDbShardIdCache();
 
     bool isExist (const MojUInt32 id) const;
+    bool hasInactive (void) const;
     void put (const MojUInt32 id, const MojObject& obj);
     bool get (const MojUInt32 id, MojObject& o_obj) const;
     bool update (const MojUInt32 id, const MojObject& i_obj);
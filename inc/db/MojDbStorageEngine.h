@@ -29,6 +29,7 @@
 #include "core/MojObject.h"
 #include "core/MojVector.h"
 #include "core/MojHashMap.h"
+#include "core/MojSet.h"
 #include "core/MojSignal.h"
 
 class MojDbEnv : public MojRefCounted
@@ -42,14 +43,20 @@ class MojDbEnv : public MojRefCounted
 class MojDbStorageItem : public MojRefCounted
 {
 public:
+	typedef MojSet<MojString> PropSet;
+
 	virtual ~MojDbStorageItem() {}
 	virtual MojErr close() = 0;
 	virtual MojErr kindId(MojString& kindIdOut, MojDbKindEngine& kindEngine) = 0;
 	virtual MojErr visit(MojObjectVisitor& visitor, MojDbKindEngine& kindEngine, bool headerExpected = true) const = 0;
 	virtual const MojObject& id() const = 0;
 	virtual MojSize size() const = 0;
+	// visits the header props and only the given top-level props of the object.
+	// engines that can skip serialized values override this; the default visits everything.
+	virtual MojErr visitProps(MojObjectVisitor& visitor, MojDbKindEngine& kindEngine, const PropSet& props) const;
 
 	MojErr toObject(MojObject& objOut, MojDbKindEngine& kindEngine, bool headerExpected = true) const;
+	MojErr toObject(MojObject& objOut, MojDbKindEngine& kindEngine, const PropSet& props) const;
 	MojErr toJson(MojString& strOut, MojDbKindEngine& kindEngine) const;
 
 protected:
@@ -72,6 +79,7 @@ public:
 	virtual MojErr nextPage(MojDbQuery::Page& pageOut) = 0;
 	virtual void excludeKinds(const StringSet& toExclude) { m_excludeKinds = toExclude; }
 	virtual MojUInt32 groupCount() const = 0;
+	virtual MojUInt32 keysScanned() const { return 0; }
 	const MojDbKey& endKey() const { return m_endKey; }
 	StringSet& excludeKinds() { return m_excludeKinds; }
 	bool verify() { return m_verify; }
@@ -90,21 +98,42 @@ public:
 	virtual ~MojDbStorageSeq() {}
 	virtual MojErr close() = 0;
 	virtual MojErr get(MojInt64& valOut) = 0;
+	// engines that can persist their reservations with the caller's txn override this;
+	// the default ignores txn.
+	virtual MojErr get(MojInt64& valOut, MojDbStorageTxn* txn) { return get(valOut); }
 };
 
 class MojDbStorageTxn : public MojSignalHandler
 {
 public:
 	typedef MojVector<MojByte> ByteVec;
+	typedef MojVector<MojDbKey> KeyVec;
 	typedef MojSignal<MojDbStorageTxn*> CommitSignal;
 
-	virtual ~MojDbStorageTxn() {}
+	virtual ~MojDbStorageTxn();
 	virtual MojErr abort() = 0;
     virtual bool isValid() = 0;
 	MojErr commit();
-
-	MojErr addWatcher(MojDbWatcher* watcher, const MojDbKey& key);
+	// engines call this from commitImpl once the txn's place in the commit order is
+	// fixed, so the count locks are not held while the txn waits to become durable
+	void commitOrdered();
+
+	MojErr addWatcher(MojDbIndex* index, MojDbWatcher* watcher, const MojDbKey& key);
+	// hand watchers to this notifier on commit rather than firing them inline
+	void watchNotifier(MojDbWatchNotifier* notifier) { m_watchNotifier = notifier; }
+	// while deferring, index keys are collected per index and written in key order
+	// by flushIndexKeys, which commit calls before anything else.
+	void deferIndexKeys(bool val) { m_deferIndexKeys = val; }
+	bool deferringIndexKeys() const { return m_deferIndexKeys; }
+	MojErr deferIndexKey(MojDbIndex* index, const MojDbKey& key);
+	MojErr flushIndexKeys();
 	MojErr offsetQuota(MojInt64 amount);
+	MojErr offsetCount(MojDbIndex* index, MojInt64 offset);
+	MojInt64 countOffset(MojDbIndex* index) const;
+	// key count changes only reach the index's estimate once the txn has committed
+	MojErr offsetKeyCount(MojDbIndex* index, MojInt64 offset);
+	// forgets the pending count changes and deferred keys of an index that is being dropped
+	MojErr dropCounts(MojDbIndex* index);
 	void quotaEnabled(bool val) { m_quotaEnabled = val; }
 	void refreshQuotas() { m_refreshQuotas = true; }
 
@@ -120,19 +149,55 @@ private:
 
 	struct WatcherInfo
 	{
-		WatcherInfo(MojDbWatcher* watcher, const MojDbKey& key)
-		: m_watcher(watcher), m_key(key) {}
+		// out of line: MojDbIndex is incomplete here
+		WatcherInfo(MojDbIndex* index, MojDbWatcher* watcher, const MojDbKey& key);
+		WatcherInfo(const WatcherInfo& other);
+		~WatcherInfo();
+		WatcherInfo& operator=(const WatcherInfo& rhs);
 
+		MojRefCountedPtr<MojDbIndex> m_index;	// firing cancels the watch on its index
 		MojRefCountedPtr<MojDbWatcher> m_watcher;
 		MojDbKey m_key;
 	};
 	typedef MojVector<WatcherInfo> WatcherVec;
+	struct CountOffset
+	{
+		// out of line: MojDbIndex is incomplete here
+		CountOffset();
+		CountOffset(const CountOffset& other);
+		~CountOffset();
+		CountOffset& operator=(const CountOffset& rhs);
+
+		MojRefCountedPtr<MojDbIndex> m_index;	// a dropped kind frees its indexes before we commit
+		MojInt64 m_offset;
+	};
+	typedef MojMap<MojDbIndex*, CountOffset, MojDbIndex*, MojComp<MojDbIndex*>, MojCompAddr<CountOffset> > CountMap;
+	// keys deferred while a kind was current, charged to that kind's quota when written
+	struct DeferredKeys
+	{
+		MojRefCountedPtr<MojDbQuotaEngine::Offset> m_quotaOffset;
+		KeyVec m_keys;
+	};
+	typedef MojVector<DeferredKeys> DeferredKeysVec;
+	typedef MojMap<MojDbIndex*, DeferredKeysVec, MojDbIndex*, MojComp<MojDbIndex*>, MojCompAddr<DeferredKeysVec> > DeferredKeyMap;
+
+	MojErr addOffset(CountMap& map, MojDbIndex* index, MojInt64 offset);
+	MojErr applyCounts();
+	void lockCounts();
+	void unlockCounts();
 
 	bool m_quotaEnabled;
 	bool m_refreshQuotas;
+	bool m_deferIndexKeys;
+	bool m_countsLocked;
+	bool m_countsOrdered;
 	MojDbQuotaEngine* m_quotaEngine;
+	MojDbWatchNotifier* m_watchNotifier;
 	MojDbQuotaEngine::OffsetMap m_offsetMap;
 	MojRefCountedPtr<MojDbQuotaEngine::Offset> m_curQuotaOffset;
+	CountMap m_countOffsets;
+	CountMap m_keyCountOffsets;
+	DeferredKeyMap m_deferredKeys;
 	WatcherVec m_watchers;
 	CommitSignal m_preCommit;
 	CommitSignal m_postCommit;
@@ -168,6 +233,9 @@ public:
 	virtual MojErr del(const MojObject& id, MojDbStorageTxn* txn, bool& foundOut) = 0;
 	virtual MojErr get(const MojObject& id, MojDbStorageTxn* txn, bool forUpdate, MojRefCountedPtr<MojDbStorageItem>& itemOut) = 0;
 	virtual MojErr openIndex(const MojObject& id, MojDbStorageTxn* txn, MojRefCountedPtr<MojDbStorageIndex>& indexOut) = 0;
+	// engines that can compress values override these; the default stores val as is.
+	virtual MojErr insertCompressed(const MojObject& id, MojBuffer& val, MojDbStorageTxn* txn) { return insert(id, val, txn); }
+	virtual MojErr updateCompressed(const MojObject& id, MojBuffer& val, MojDbStorageItem* oldVal, MojDbStorageTxn* txn) { return update(id, val, oldVal, txn); }
 //hack:
 	virtual MojErr mutexStats(int* total_mutexes, int* mutexes_free, int* mutexes_used, int* mutexes_used_highwater, int* mutexes_regionsize) 
 		{ if (total_mutexes) *total_mutexes = 0;
@@ -199,6 +267,7 @@ public:
     static MojErr setEngineFactory(MojDbStorageEngineFactory* factory);
     static MojErr setEngineFactory(const MojChar *name);
     static const MojDbStorageEngineFactory* engineFactory() {return m_factory.get();}
+    static const MojChar* const StatsKey;
 
     virtual ~MojDbStorageEngine() {}
     virtual MojErr configure(const MojObject& config) = 0;
@@ -210,6 +279,8 @@ public:
     virtual MojErr beginTxn(MojRefCountedPtr<MojDbStorageTxn>& txnOut) = 0;
     virtual MojErr openDatabase(const MojChar* name, MojDbStorageTxn* txn, MojRefCountedPtr<MojDbStorageDatabase>& dbOut) = 0;
     virtual MojErr openSequence(const MojChar* name, MojDbStorageTxn* txn,  MojRefCountedPtr<MojDbStorageSeq>& seqOut) = 0;
+    // engines with counters of their own report them here; the default has none
+    virtual MojErr stats(MojObject& objOut) { return MojErrNone; }
 
 protected:
 	MojDbStorageEngine();
@@ -0,0 +1,93 @@
+/* @@@LICENSE
+*
+*  Copyright (c) 2014 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+#ifndef MOJDBWATCHNOTIFIER_H_
+#define MOJDBWATCHNOTIFIER_H_
+
+#include "db/MojDbDefs.h"
+#include "db/MojDbKey.h"
+#include "db/MojDbWatcher.h"
+#include "core/MojMap.h"
+#include "core/MojObject.h"
+#include "core/MojThread.h"
+#include "core/MojTime.h"
+
+// Fires watchers on a worker thread instead of inside the committing transaction.
+// Fires that reach a watcher within window() of each other are merged into one,
+// keeping the smallest key, so a burst of commits signals each subscriber once.
+// Once stopped, the notifier fires on the posting thread until it is started again.
+class MojDbWatchNotifier : private MojNoCopy
+{
+public:
+	static const MojChar* const AsyncKey;
+	static const MojChar* const WindowKey;
+	static const MojChar* const StatsKey;
+	static const MojUInt32 WindowDefault = 5;	// ms
+
+	MojDbWatchNotifier();
+	~MojDbWatchNotifier();
+
+	MojErr configure(const MojObject& conf);
+	void start();
+	MojErr post(MojDbIndex* index, MojDbWatcher* watcher, const MojDbKey& key);
+	MojErr flush();
+	MojErr stop();
+	MojErr stats(MojObject& objOut);
+
+	bool enabled() const { return m_enabled; }
+	MojTime window() const { return m_window; }
+
+private:
+	struct Pending
+	{
+		MojRefCountedPtr<MojDbIndex> m_index;	// kept alive until the watcher has cancelled on it
+		MojRefCountedPtr<MojDbWatcher> m_watcher;
+		MojDbKey m_key;
+		MojTime m_posted;
+	};
+	typedef MojMap<MojDbWatcher*, Pending, MojDbWatcher*, MojComp<MojDbWatcher*>, MojCompAddr<Pending> > PendingMap;
+
+	static MojErr threadMain(void* arg);
+	MojErr startThread();
+	MojErr run();
+	MojErr runLoop(MojThreadGuard& guard);
+	static MojErr deliver(const PendingMap& pending, MojInt64& totalLatencyOut, MojInt64& maxLatencyOut);
+
+	MojThreadT m_thread;
+	MojThreadMutex m_mutex;
+	MojThreadCond m_cond;
+	MojThreadCond m_idleCond;
+	PendingMap m_pending;
+	MojTime m_oldest;
+	MojTime m_window;
+	MojUInt32 m_flushes;
+	bool m_enabled;
+	bool m_delivering;
+	bool m_stop;
+	bool m_stopped;
+	bool m_exited;
+
+	MojInt64 m_posts;
+	MojInt64 m_coalesced;
+	MojInt64 m_delivered;
+	MojInt64 m_totalLatency;
+	MojInt64 m_maxLatency;
+};
+
+#endif /* MOJDBWATCHNOTIFIER_H_ */
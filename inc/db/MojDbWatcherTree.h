@@ -0,0 +1,89 @@
+/* @@@LICENSE
+*
+*  Copyright (c) 2014 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+#ifndef MOJDBWATCHERTREE_H_
+#define MOJDBWATCHERTREE_H_
+
+#include "db/MojDbDefs.h"
+#include "db/MojDbKey.h"
+#include "db/MojDbWatcher.h"
+#include "core/MojMap.h"
+#include "core/MojVector.h"
+
+// Holds the watchers of an index keyed on their key ranges. Ranges live in an
+// AVL tree ordered by lower key, where each node also tracks the largest upper
+// key below it, so finding the watchers of a key only descends into subtrees
+// that can hold a match instead of testing every range. Not thread-safe; the
+// index guards it with its lock.
+class MojDbWatcherTree : private MojNoCopy
+{
+public:
+	typedef MojDbWatcher::RangeVec RangeVec;
+	typedef MojVector<MojDbWatcher*> WatcherVec;
+
+	MojDbWatcherTree();
+	~MojDbWatcherTree();
+
+	MojSize size() const { return m_watchers.size(); }
+	bool empty() const { return m_watchers.empty(); }
+
+	MojErr put(MojDbWatcher* watcher, const RangeVec& ranges);
+	MojErr del(MojDbWatcher* watcher, bool& foundOut);
+	MojErr find(const MojDbKey& key, WatcherVec& watchersOut) const;
+	void clear();
+
+private:
+	struct Node : private MojNoCopy
+	{
+		Node(const MojDbKeyRange& range, MojDbWatcher* watcher, MojUInt64 seq);
+
+		MojDbKeyRange m_range;
+		MojDbWatcher* m_watcher;
+		MojUInt64 m_seq;
+		Node* m_left;
+		Node* m_right;
+		const MojDbKey* m_maxUpper;	// NULL if a range in this subtree has no upper bound
+		int m_height;
+	};
+	typedef MojVector<Node*> NodeVec;
+	struct Entry
+	{
+		MojRefCountedPtr<MojDbWatcher> m_watcher;
+		NodeVec m_nodes;
+	};
+	typedef MojMap<MojDbWatcher*, Entry, MojDbWatcher*, MojComp<MojDbWatcher*>, MojCompAddr<Entry> > WatcherMap;
+
+	static int compare(const Node* node1, const Node* node2);
+	static int height(const Node* node) { return node ? node->m_height : 0; }
+	static void update(Node* node);
+	static Node* rotateLeft(Node* node);
+	static Node* rotateRight(Node* node);
+	static Node* balance(Node* node);
+	static Node* insert(Node* root, Node* node);
+	static Node* remove(Node* root, const Node* node);
+	static Node* removeMin(Node* root, Node*& minOut);
+	static void destroy(Node* root);
+	static MojErr find(const Node* root, const MojDbKey& key, WatcherVec& watchersOut);
+
+	Node* m_root;
+	MojUInt64 m_seq;
+	WatcherMap m_watchers;
+};
+
+#endif /* MOJDBWATCHERTREE_H_ */
@@ -36,6 +36,21 @@ MojErr MojDataWriter::writeUInt32(MojUInt32 val)
 	return MojErrNone;
 }
 
+MojErr MojDataWriter::writeVarUInt32(MojUInt32 val)
+{
+	// 7 bits per byte, least significant first, high bit set on all but the last byte
+	MojByte bytes[5];
+	MojSize len = 0;
+	while (val >= 0x80) {
+		bytes[len++] = (MojByte) (val | 0x80);
+		val >>= 7;
+	}
+	bytes[len++] = (MojByte) val;
+	MojErr err = m_buf.write(bytes, len);
+	MojErrCheck(err);
+	return MojErrNone;
+}
+
 MojErr MojDataWriter::writeInt64(MojInt64 val)
 {
 	val = MojInt64ToBigEndian(val);
@@ -123,6 +138,22 @@ MojErr MojDataReader::readUInt32(MojUInt32& val)
 	return MojErrNone;
 }
 
+MojErr MojDataReader::readVarUInt32(MojUInt32& val)
+{
+	val = 0;
+	for (MojSize shift = 0; ; shift += 7) {
+		if (available() == 0)
+			MojErrThrow(MojErrUnexpectedEof);
+		if (shift > 28)
+			MojErrThrow(MojErrValueOutOfRange);
+		MojByte b = *m_pos++;
+		val |= (MojUInt32) (b & 0x7F) << shift;
+		if (!(b & 0x80))
+			break;
+	}
+	return MojErrNone;
+}
+
 MojErr MojDataReader::readInt64(MojInt64& val)
 {
 	if (available() < sizeof(val))
@@ -53,7 +53,12 @@ MojJsonWriter::MojJsonWriter()
 
 MojErr MojJsonWriter::reset()
 {
-	m_str.clear();
+	if (m_str.capacity() > MaxRetainedSize) {
+		MojString empty;
+		m_str.swap(empty);
+	} else {
+		m_str.clear();
+	}
 	m_writeComma = false;
 	return MojErrNone;
 }
@@ -132,7 +137,20 @@ MojErr MojJsonWriter::intValue(MojInt64 val)
 {
 	MojErr err = writeComma();
 	MojErrCheck(err);
-	err = m_str.appendFormat(_T("%lld"), val);
+
+	// format by hand; results are mostly ints and appendFormat goes through vsnprintf
+	MojChar buf[24];
+	MojChar* end = buf + sizeof(buf) / sizeof(MojChar);
+	MojChar* pos = end;
+	MojUInt64 mag = (val < 0) ? (MojUInt64) 0 - (MojUInt64) val : (MojUInt64) val;
+	do {
+		*(--pos) = (MojChar) (_T('0') + (mag % 10));
+		mag /= 10;
+	} while (mag > 0);
+	if (val < 0)
+		*(--pos) = _T('-');
+
+	err = m_str.append(pos, end - pos);
 	MojErrCheck(err);
 	return MojErrNone;
 }
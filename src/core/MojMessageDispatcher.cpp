@@ -19,8 +19,14 @@
 
 #include "core/MojMessageDispatcher.h"
 
+const MojChar* const MojMessageDispatcher::NumThreadsKey = _T("dispatcherThreads");
+const MojChar* const MojMessageDispatcher::QueueWeightsKey = _T("dispatcherQueueWeights");
+const MojChar* const MojMessageDispatcher::StatsKey = _T("dispatcherStats");
+
 MojMessageDispatcher::MojMessageDispatcher()
-: m_stop(false)
+: m_numThreads(NumThreadsDefault),
+  m_collectStats(false),
+  m_stop(false)
 {
 }
 
@@ -30,39 +36,82 @@ MojMessageDispatcher::~MojMessageDispatcher()
 	MojErrCatchAll(err);
 	err = wait();
 	MojErrCatchAll(err);
+
+	for (QueueMap::ConstIterator i = m_queues.begin(); i != m_queues.end(); ++i) {
+		(*i)->clear();
+		delete *i;
+	}
+}
+
+MojErr MojMessageDispatcher::configure(const MojObject& conf)
+{
+	MojInt64 numThreads = NumThreadsDefault;
+	if (conf.get(NumThreadsKey, numThreads) && numThreads > 0 && numThreads <= MojInt32Max) {
+		m_numThreads = (MojInt32) numThreads;
+	} else {
+		m_numThreads = NumThreadsDefault;
+	}
+
+	bool collectStats = false;
+	conf.get(StatsKey, collectStats);
+	m_collectStats = collectStats;
+
+	MojObject weights;
+	if (conf.get(QueueWeightsKey, weights)) {
+		for (MojObject::ConstIterator i = weights.begin(); i != weights.end(); ++i) {
+			MojInt64 weight = i->intValue();
+			if (weight <= 0 || weight > MojUInt32Max)
+				MojErrThrowMsg(MojErrInvalidArg, _T("dispatcher: invalid weight for queue '%s'"), i.key().data());
+			MojErr err = setWeight(i.key(), (MojUInt32) weight);
+			MojErrCheck(err);
+		}
+	}
+	return MojErrNone;
 }
 
 MojErr MojMessageDispatcher::schedule(MojMessage* msg)
 {
 	MojAssert(msg);
+	if (m_collectStats) {
+		MojErr err = MojGetCurrentTime(msg->m_scheduleTime);
+		MojErrCheck(err);
+	}
 	MojThreadGuard guard(m_mutex);
 
 	const MojChar* queueName = msg->queue();
-	// first look for a scheduled queue
-	Queue* queue = findQueue(queueName, m_scheduledList);
-	if (!queue) {
-		// then look for a pending queue
-		queue = findQueue(queueName, m_pendingList);
-
-		// then create a new queue if we didn't find one
-		if (!queue) {
-			MojAutoPtr<Queue> newQueue(new Queue);
-			MojAllocCheck(newQueue.get());
-			queue = newQueue.get();
-			MojErr err = queue->init(queueName);
-			MojErrCheck(err);
-
-			// add it to scheduled list and wake up a thread
-			m_scheduledList.pushBack(newQueue.release());
-			err = m_cond.signal();
-			MojErrCheck(err);
+	Queue* queue = NULL;
+	if (!m_queues.get(queueName, queue)) {
+		// create a new queue if we didn't find one
+		MojAutoPtr<Queue> newQueue(new Queue);
+		MojAllocCheck(newQueue.get());
+		MojErr err = newQueue->init(queueName);
+		MojErrCheck(err);
+		MojUInt32 weight = 1;
+		if (m_weights.get(queueName, weight)) {
+			newQueue->m_weight = weight;
+			newQueue->m_credits = weight;
 		}
+		err = m_queues.put(newQueue->name(), newQueue.get());
+		MojErrCheck(err);
+		queue = newQueue.release();
+
+		// add it to scheduled list and wake up a thread
+		queue->m_scheduled = true;
+		m_scheduledList.pushBack(queue);
+		err = m_cond.signal();
+		MojErrCheck(err);
 	}
+	// queues that are being dispatched pick up the new message when they are rescheduled
 	queue->push(msg);
 
 	return MojErrNone;
 }
 
+MojErr MojMessageDispatcher::start()
+{
+	return start(m_numThreads);
+}
+
 MojErr MojMessageDispatcher::start(MojInt32 numThreads)
 {
 	for (MojInt32 i = 0; i < numThreads; ++i) {
@@ -103,6 +152,52 @@ MojErr MojMessageDispatcher::wait()
 	return err;
 }
 
+MojErr MojMessageDispatcher::setWeight(const MojChar* queueName, MojUInt32 weight)
+{
+	MojAssert(queueName);
+	if (weight == 0)
+		MojErrThrow(MojErrInvalidArg);
+
+	MojThreadGuard guard(m_mutex);
+	MojString name;
+	MojErr err = name.assign(queueName);
+	MojErrCheck(err);
+	err = m_weights.put(name, weight);
+	MojErrCheck(err);
+
+	Queue* queue = NULL;
+	if (m_queues.get(queueName, queue)) {
+		queue->m_weight = weight;
+		queue->m_credits = MojMin(queue->m_credits, weight);
+	}
+	return MojErrNone;
+}
+
+MojErr MojMessageDispatcher::stats(MojObject& objOut) const
+{
+	MojThreadGuard guard(m_mutex);
+
+	for (StatsMap::ConstIterator i = m_stats.begin(); i != m_stats.end(); ++i) {
+		MojObject queueObj;
+		MojErr err = queueObj.put(_T("count"), i->m_count);
+		MojErrCheck(err);
+		err = queueObj.put(_T("avgUs"), i->m_count ? i->m_totalUs / i->m_count : (MojInt64) 0);
+		MojErrCheck(err);
+		err = queueObj.put(_T("maxUs"), i->m_maxUs);
+		MojErrCheck(err);
+		MojObject histogram(MojObject::TypeArray);
+		for (MojSize j = 0; j < NumLatencyBuckets; ++j) {
+			err = histogram.push(i->m_buckets[j]);
+			MojErrCheck(err);
+		}
+		err = queueObj.put(_T("histogram"), histogram);
+		MojErrCheck(err);
+		err = objOut.put(i.key(), queueObj);
+		MojErrCheck(err);
+	}
+	return MojErrNone;
+}
+
 MojErr MojMessageDispatcher::dispatch(bool& stoppedOut)
 {
 	MojThreadGuard guard(m_mutex);
@@ -119,10 +214,14 @@ MojErr MojMessageDispatcher::dispatch(bool& stoppedOut)
 		MojAssert(m_stop);
 		stoppedOut = true;
 	} else {
-		// move queue from scheduled list to pending list and pop a message
+		// take queue off the scheduled list while its message is dispatched
 		Queue* queue = m_scheduledList.popFront();
-		m_pendingList.pushBack(queue);
+		queue->m_scheduled = false;
 		MojRefCountedPtr<MojMessage> msg = queue->pop();
+		if (m_collectStats) {
+			MojErr err = recordLatency(queue->name(), msg->m_scheduleTime);
+			MojErrCatchAll(err);
+		}
 
 		// unlock and dispatch
 		guard.unlock();
@@ -130,27 +229,77 @@ MojErr MojMessageDispatcher::dispatch(bool& stoppedOut)
 		MojErrCatchAll(err);
 		guard.lock();
 
-		// remove from pending list
-		m_pendingList.erase(queue);
 		if (queue->empty()) {
 			// we're done with this queue
-			delete queue;
+			deleteQueue(queue);
 		} else {
-			// if queue has more messages, add it back to scheduled list
+			// if queue has more messages, reschedule it
 			// no need to signal since this thread will loop back around and pick it up
-			m_scheduledList.pushBack(queue);
+			queue->m_scheduled = true;
+			if (--queue->m_credits > 0) {
+				m_scheduledList.pushFront(queue);
+			} else {
+				queue->m_credits = queue->m_weight;
+				m_scheduledList.pushBack(queue);
+			}
 		}
 	}
 	return MojErrNone;
 }
 
-MojMessageDispatcher::Queue* MojMessageDispatcher::findQueue(const MojChar* name, QueueList& list)
+MojErr MojMessageDispatcher::recordLatency(const MojString& queueName, const MojTime& scheduleTime)
 {
-	for (QueueList::Iterator i = list.begin(); i != list.end(); ++i) {
-		if ((*i)->name() == name)
-			return *i;
+	MojTime now;
+	MojErr err = MojGetCurrentTime(now);
+	MojErrCheck(err);
+
+	StatsMap::Iterator iter;
+	err = m_stats.find(queueName, iter);
+	MojErrCheck(err);
+	if (iter == m_stats.end()) {
+		if (m_stats.size() >= MaxStatsQueues) {
+			err = evictStats();
+			MojErrCheck(err);
+		}
+		err = m_stats.put(queueName, LatencyStats());
+		MojErrCheck(err);
+		err = m_stats.find(queueName, iter);
+		MojErrCheck(err);
 	}
-	return NULL;
+	iter->add(now - scheduleTime, now);
+
+	return MojErrNone;
+}
+
+MojErr MojMessageDispatcher::evictStats()
+{
+	// queues are named after senders, which come and go, so drop the one idle longest
+	StatsMap::ConstIterator oldest = m_stats.end();
+	for (StatsMap::ConstIterator i = m_stats.begin(); i != m_stats.end(); ++i) {
+		if (oldest == m_stats.end() || i->m_lastTime.microsecs() < oldest->m_lastTime.microsecs())
+			oldest = i;
+	}
+	if (oldest == m_stats.end())
+		return MojErrNone;
+
+	MojString name = oldest.key();
+	bool found = false;
+	MojErr err = m_stats.del(name, found);
+	MojErrCheck(err);
+	MojAssert(found);
+
+	return MojErrNone;
+}
+
+void MojMessageDispatcher::deleteQueue(Queue* queue)
+{
+	MojAssert(queue && queue->empty() && !queue->m_scheduled);
+
+	bool found = false;
+	MojErr err = m_queues.del(queue->name(), found);
+	MojErrCatchAll(err);
+	MojAssert(found);
+	delete queue;
 }
 
 MojErr MojMessageDispatcher::threadMain(void* arg)
@@ -181,3 +330,43 @@ MojRefCountedPtr<MojMessage> MojMessageDispatcher::Queue::pop()
 	msg->release();
 	return msg;
 }
+
+void MojMessageDispatcher::Queue::clear()
+{
+	while (!empty())
+		(void) pop();
+}
+
+MojMessageDispatcher::LatencyStats::LatencyStats()
+: m_count(0),
+  m_totalUs(0),
+  m_maxUs(0)
+{
+	for (MojSize i = 0; i < NumLatencyBuckets; ++i)
+		m_buckets[i] = 0;
+}
+
+void MojMessageDispatcher::LatencyStats::add(const MojTime& latency, const MojTime& now)
+{
+	m_lastTime = now;
+	MojInt64 us = MojMax(latency.microsecs(), (MojInt64) 0);
+	++m_count;
+	m_totalUs += us;
+	m_maxUs = MojMax(m_maxUs, us);
+
+	MojSize bucket = 0;
+	for (MojInt64 ms = us / 1000; ms > 0 && bucket < NumLatencyBuckets - 1; ms >>= 1)
+		++bucket;
+	++m_buckets[bucket];
+}
+
+bool MojMessageDispatcher::LatencyStats::operator==(const LatencyStats& rhs) const
+{
+	if (m_count != rhs.m_count || m_totalUs != rhs.m_totalUs || m_maxUs != rhs.m_maxUs)
+		return false;
+	for (MojSize i = 0; i < NumLatencyBuckets; ++i) {
+		if (m_buckets[i] != rhs.m_buckets[i])
+			return false;
+	}
+	return true;
+}
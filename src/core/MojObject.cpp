@@ -467,81 +467,73 @@ bool MojObject::operator==(const MojObject& rhs) const
 
 void MojObject::init(const MojObject& obj)
 {
-    release();
+	if (&obj == this)
+		return;
 
-    if (obj.impl())
-        m_implementation = obj.impl()->clone();
-    else
-        m_implementation = new UndefinedImpl();
+	// copy first: obj may live inside the container we are about to release
+	ImplStorage tmp;
+	obj.impl()->copyTo(&tmp);
+	release();
+	// impls hold no pointers to themselves, so they can be moved bitwise
+	MojMemCpy(&m_impl, &tmp, sizeof(m_impl));
 }
 
 void MojObject::init(Type type)
 {
-    release();
+	release();
 
-    switch(type) {
+	switch(type) {
 	case TypeObject:
-		m_implementation = new ObjectImpl();
+		new (&m_impl) ObjectImpl();
 		break;
 	case TypeArray:
-		m_implementation = new ArrayImpl();
+		new (&m_impl) ArrayImpl();
 		break;
 	case TypeString:
-		m_implementation = new StringImpl();
+		new (&m_impl) StringImpl();
 		break;
 	case TypeBool:
-		m_implementation = new BoolImpl();
+		new (&m_impl) BoolImpl();
 		break;
 	case TypeDecimal:
-		m_implementation = new DecimalImpl();
+		new (&m_impl) DecimalImpl();
 		break;
 	case TypeInt:
-		m_implementation = new IntImpl();
+		new (&m_impl) IntImpl();
 		break;
 	case TypeNull:
-		m_implementation = new NullImpl();
+		new (&m_impl) NullImpl();
 		break;
 	case TypeUndefined:
-		m_implementation = new UndefinedImpl();
+		new (&m_impl) UndefinedImpl();
 		break;
 	default:
-        m_implementation = new UndefinedImpl();
-        MojAssertNotReached(); 	// fall through to undefined
+		new (&m_impl) UndefinedImpl();
+		MojAssertNotReached(); 	// fall through to undefined
 	}
 }
 
 void MojObject::release()
 {
-    if (m_implementation)  {
-        delete m_implementation;  m_implementation = 0;
-    }
-
+	impl()->~Impl();
 }
 
 MojObject::ObjectImpl& MojObject::ensureObject()
 {
-    ObjectImpl* myImpl;
-    if (type() != TypeObject) {
-        release();
-        myImpl = new ObjectImpl();
-        m_implementation = myImpl;
-    } else {
-        myImpl = dynamic_cast<ObjectImpl*>(m_implementation);
-    }
-    return *myImpl;
+	if (type() != TypeObject) {
+		release();
+		new (&m_impl) ObjectImpl();
+	}
+	return *static_cast<ObjectImpl*>(impl());
 }
 
 MojObject::ArrayImpl& MojObject::ensureArray()
 {
-    ArrayImpl* myImpl;
-    if (type() != TypeArray) {
-        release();
-        myImpl = new ArrayImpl();
-        m_implementation = myImpl;
-    } else {
-        myImpl = dynamic_cast<ArrayImpl*>(m_implementation);
-    }
-    return *myImpl;
+	if (type() != TypeArray) {
+		release();
+		new (&m_impl) ArrayImpl();
+	}
+	return *static_cast<ArrayImpl*>(impl());
 }
 
 MojErr MojObject::Impl::stringValue(MojString& valOut) const
@@ -634,8 +626,7 @@ MojErr MojObject::ObjectImpl::visit(MojObjectVisitor& visitor) const
 	MojErr err = visitor.beginObject();
 	MojErrCheck(err);
 	for (PropMap::ConstIterator i = m_props.begin(); i != m_props.end(); ++i) {
-		const MojString& propName = i.key();
-		err = visitor.propName(propName, propName.length());
+		err = visitor.sharedPropName(i.key());
 		MojErrCheck(err);
 		err = i.value().impl()->visit(visitor);
 		MojErrCheck(err);
@@ -780,7 +771,7 @@ MojErr MojObject::StringImpl::stringValue(MojString& valOut) const
 
 MojErr MojObject::StringImpl::visit(MojObjectVisitor& visitor) const
 {
-	MojErr err = visitor.stringValue(m_val, m_val.length());
+	MojErr err = visitor.sharedStringValue(m_val);
 	MojErrCheck(err);
 	return MojErrNone;
 }
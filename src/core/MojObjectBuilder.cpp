@@ -20,6 +20,8 @@
 #include "core/MojObjectBuilder.h"
 
 MojObjectBuilder::MojObjectBuilder()
+: m_sharedNameBytes(0),
+  m_copiedNameBytes(0)
 {
 }
 
@@ -64,6 +66,15 @@ MojErr MojObjectBuilder::propName(const MojChar* name, MojSize len)
 {
 	MojErr err = m_propName.assign(name, len);
 	MojErrCheck(err);
+	m_copiedNameBytes += len;
+
+	return MojErrNone;
+}
+
+MojErr MojObjectBuilder::sharedPropName(const MojString& name)
+{
+	m_propName = name;
+	m_sharedNameBytes += name.length();
 
 	return MojErrNone;
 }
@@ -111,6 +122,14 @@ MojErr MojObjectBuilder::stringValue(const MojChar* val, MojSize len)
 	return MojErrNone;
 }
 
+MojErr MojObjectBuilder::sharedStringValue(const MojString& val)
+{
+	MojErr err = value(val);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
 MojErr MojObjectBuilder::push(MojObject::Type type)
 {
 	m_stack.push(Rec(type, m_propName));
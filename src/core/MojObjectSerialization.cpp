@@ -171,12 +171,19 @@ MojSize MojObjectWriter::stringSize(const MojChar* val, MojSize len)
 MojErr MojObjectWriter::writeString(const MojChar* val, MojSize len, bool addToken)
 {
 	if (m_tokenSet) {
-		MojUInt8 token = MojTokenSet::InvalidToken;
+		MojUInt32 token = MojTokenSet::InvalidToken;
 		MojErr err = m_tokenSet->tokenFromString(val, token, addToken);
 		MojErrCheck(err);
 		if (token != MojTokenSet::InvalidToken) {
-			err = m_writer.writeUInt8(token);
-			MojErrCheck(err);
+			if (token < ExtendedTokenMarker) {
+				err = m_writer.writeUInt8((MojUInt8) token);
+				MojErrCheck(err);
+			} else {
+				err = m_writer.writeUInt8(ExtendedTokenMarker);
+				MojErrCheck(err);
+				err = m_writer.writeVarUInt32(token);
+				MojErrCheck(err);
+			}
 			return MojErrNone;
 		}
 	}
@@ -192,17 +199,20 @@ MojErr MojObjectWriter::writeString(const MojChar* val, MojSize len, bool addTok
 
 MojObjectReader::MojObjectReader()
 : m_skipBeginObj(false),
-  m_tokenSet(NULL)
+  m_tokenSet(NULL),
+  m_select(NULL)
 {
-
+	MojZero(m_selectTokens, sizeof(m_selectTokens));
 }
 
 MojObjectReader::MojObjectReader(const MojByte* data, MojSize size)
 : m_reader(data, size),
   m_skipBeginObj(false),
-  m_tokenSet(NULL)
+  m_tokenSet(NULL),
+  m_select(NULL)
 {
 	MojAssert(data || size == 0);
+	MojZero(m_selectTokens, sizeof(m_selectTokens));
 }
 
 void MojObjectReader::data(const MojByte* data, MojSize size)
@@ -210,6 +220,48 @@ void MojObjectReader::data(const MojByte* data, MojSize size)
 	m_reader.data(data, size);
 	m_skipBeginObj = false;
 	m_tokenSet = NULL;
+	m_select = NULL;
+}
+
+MojErr MojObjectReader::select(const PropSet* props)
+{
+	m_select = props;
+	MojZero(m_selectTokens, sizeof(m_selectTokens));
+	m_selectExtTokens.clear();
+	if (props && m_tokenSet) {
+		// resolve names to tokens once so that tokenized props are matched without a lookup
+		for (PropSet::ConstIterator i = props->begin(); i != props->end(); ++i) {
+			MojUInt32 token = MojTokenSet::InvalidToken;
+			MojErr err = m_tokenSet->tokenFromString(*i, token, false);
+			MojErrCheck(err);
+			if (token == MojTokenSet::InvalidToken)
+				continue;
+			if (token < MojObjectWriter::ExtendedTokenMarker) {
+				m_selectTokens[token >> 5] |= (1U << (token & 31));
+			} else {
+				err = m_selectExtTokens.push(token);
+				MojErrCheck(err);
+			}
+		}
+	}
+	return MojErrNone;
+}
+
+bool MojObjectReader::selected(MojUInt32 token) const
+{
+	if (token < MojObjectWriter::ExtendedTokenMarker)
+		return (m_selectTokens[token >> 5] & (1U << (token & 31))) != 0;
+	return m_selectExtTokens.find(token) != MojInvalidIndex;
+}
+
+bool MojObjectReader::selected(const MojChar* name, MojSize len) const
+{
+	MojAssert(m_select);
+	for (PropSet::ConstIterator i = m_select->begin(); i != m_select->end(); ++i) {
+		if (i->length() == len && i->compare(name, len) == 0)
+			return true;
+	}
+	return false;
 }
 
 MojObjectWriter::Marker MojObjectReader::peek() const
@@ -323,10 +375,13 @@ Redo:
 		}
 		default: {
 			if (m_tokenSet) {
+				MojUInt32 token = 0;
+				err = readToken(m_reader, marker, token);
+				MojErrCheck(err);
 				MojString val;
-				err = m_tokenSet->stringFromToken(marker, val);
+				err = m_tokenSet->stringFromToken(token, val);
 				MojErrCheck(err);
-				err = visitor.stringValue(val);
+				err = visitor.sharedStringValue(val);
 				MojErrCheck(err);
 				break;
 			}
@@ -345,6 +400,11 @@ Redo:
 		case MojObjectWriter::MarkerStringValue:
 			err = readString(m_reader, str, strLen);
 			MojErrCheck(err);
+			if (selecting() && !selected(str, strLen)) {
+				err = skip(m_reader);
+				MojErrCheck(err);
+				break;
+			}
 			err = visitor.propName(str, strLen);
 			MojErrCheck(err);
 			err = m_stack.push(StateValue);
@@ -353,10 +413,18 @@ Redo:
 		default:
 			// if a token set exists, look up this marker
 			if (m_tokenSet) {
+				MojUInt32 token = 0;
+				err = readToken(m_reader, marker, token);
+				MojErrCheck(err);
+				if (selecting() && !selected(token)) {
+					err = skip(m_reader);
+					MojErrCheck(err);
+					break;
+				}
 				MojString name;
-				err = m_tokenSet->stringFromToken(marker, name);
+				err = m_tokenSet->stringFromToken(token, name);
 				MojErrCheck(err);
-				err = visitor.propName(name);
+				err = visitor.sharedPropName(name);
 				MojErrCheck(err);
 				err = m_stack.push(StateValue);
 				MojErrCheck(err);
@@ -452,6 +520,110 @@ MojErr MojObjectReader::readString(MojDataReader& reader, MojChar const*& str, M
 #endif /* MOJ_ENCODING_UTF8 */
 }
 
+MojErr MojObjectReader::readToken(MojDataReader& reader, MojByte marker, MojUInt32& tokenOut)
+{
+	if (marker < MojObjectWriter::TokenStartMarker)
+		MojErrThrow(MojErrObjectReaderUnexpectedMarker);
+	if (marker != MojObjectWriter::ExtendedTokenMarker) {
+		tokenOut = marker;
+		return MojErrNone;
+	}
+	MojErr err = reader.readVarUInt32(tokenOut);
+	MojErrCheck(err);
+	if (tokenOut < MojObjectWriter::ExtendedTokenMarker)
+		MojErrThrow(MojErrDbInvalidToken);
+
+	return MojErrNone;
+}
+
+MojErr MojObjectReader::skip(MojDataReader& reader)
+{
+	// the format has no length prefixes, so a subtree is skipped by walking its markers
+	MojByte marker;
+	MojErr err = reader.readUInt8(marker);
+	MojErrCheck(err);
+
+	switch (marker) {
+	case MojObjectWriter::MarkerObjectBegin:
+	case MojObjectWriter::MarkerArrayBegin: {
+		bool isObject = (marker == MojObjectWriter::MarkerObjectBegin);
+		for (;;) {
+			if (reader.available() == 0)
+				MojErrThrow(MojErrUnexpectedEof);
+			if (*reader.pos() == MojObjectWriter::MarkerObjectEnd)
+				break;
+			if (isObject) {
+				// prop name is either an inline string or a token
+				MojByte nameMarker;
+				err = reader.readUInt8(nameMarker);
+				MojErrCheck(err);
+				if (nameMarker == MojObjectWriter::MarkerStringValue) {
+					const MojChar* str = NULL;
+					MojSize strLen = 0;
+					err = readString(reader, str, strLen);
+					MojErrCheck(err);
+				} else {
+					MojUInt32 token = 0;
+					err = readToken(reader, nameMarker, token);
+					MojErrCheck(err);
+				}
+			}
+			err = skip(reader);
+			MojErrCheck(err);
+		}
+		err = reader.skip(1);
+		MojErrCheck(err);
+		break;
+	}
+	case MojObjectWriter::MarkerStringValue: {
+		const MojChar* str = NULL;
+		MojSize strLen = 0;
+		err = readString(reader, str, strLen);
+		MojErrCheck(err);
+		break;
+	}
+	case MojObjectWriter::MarkerNullValue:
+	case MojObjectWriter::MarkerTrueValue:
+	case MojObjectWriter::MarkerFalseValue:
+	case MojObjectWriter::MarkerZeroIntValue:
+		break;
+	case MojObjectWriter::MarkerUInt8Value:
+		err = reader.skip(sizeof(MojByte));
+		MojErrCheck(err);
+		break;
+	case MojObjectWriter::MarkerUInt16Value:
+		err = reader.skip(sizeof(MojUInt16));
+		MojErrCheck(err);
+		break;
+	case MojObjectWriter::MarkerUInt32Value:
+		err = reader.skip(sizeof(MojUInt32));
+		MojErrCheck(err);
+		break;
+	case MojObjectWriter::MarkerNegativeDecimalValue:
+	case MojObjectWriter::MarkerPositiveDecimalValue:
+	case MojObjectWriter::MarkerNegativeIntValue:
+	case MojObjectWriter::MarkerInt64Value:
+		err = reader.skip(sizeof(MojInt64));
+		MojErrCheck(err);
+		break;
+	case MojObjectWriter::MarkerExtensionValue: {
+		MojUInt32 extSize;
+		err = reader.readUInt32(extSize);
+		MojErrCheck(err);
+		err = reader.skip(extSize);
+		MojErrCheck(err);
+		break;
+	}
+	default: {
+		// tokenized string value
+		MojUInt32 token = 0;
+		err = readToken(reader, marker, token);
+		MojErrCheck(err);
+	}
+	}
+	return MojErrNone;
+}
+
 MojErr MojObjectReader::read(MojObjectVisitor& visitor)
 {
     // TODO: remove this debug
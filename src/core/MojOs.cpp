@@ -575,4 +575,19 @@ MojErr MojThreadJoin(MojThreadT thread, MojErr& errOut)
 
 	return MojErrNone;
 }
+
+MojErr MojThreadCondTimedWait(MojThreadCondT* cond, MojThreadMutexT* mutex, const MojTime& timeout)
+{
+	MojAssert(cond && mutex);
+
+	// pthread wants an absolute deadline
+	MojTime deadline;
+	MojErr err = MojGetCurrentTime(deadline);
+	MojErrCheck(err);
+	deadline += timeout;
+	MojTimespecT ts;
+	deadline.toTimespec(&ts);
+
+	return (MojErr) pthread_cond_timedwait(cond, mutex, &ts);
+}
 #endif /* MOJ_USE_PTHREADS */
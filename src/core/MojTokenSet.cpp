@@ -33,7 +33,7 @@ MojErr MojTokenSet::init(MojSharedTokenSet* sharedSet)
 	return MojErrNone;
 }
 
-MojErr MojTokenSet::tokenFromString(const MojChar* str, MojUInt8& tokenOut, bool add)
+MojErr MojTokenSet::tokenFromString(const MojChar* str, MojUInt32& tokenOut, bool add)
 {
 	tokenOut = InvalidToken;
 
@@ -43,8 +43,8 @@ MojErr MojTokenSet::tokenFromString(const MojChar* str, MojUInt8& tokenOut, bool
 	MojErr err = m_obj.get(str, token, found);
 	MojErrCheck(err);
 	if (found) {
-		MojAssert(token <= MojUInt8Max && token != InvalidToken);
-		tokenOut = (MojUInt8) token;
+		MojAssert(token != InvalidToken);
+		tokenOut = token;
 	} else if (add) {
 		TokenVec updatedVec;
 		MojObject updatedObj;
@@ -56,7 +56,7 @@ MojErr MojTokenSet::tokenFromString(const MojChar* str, MojUInt8& tokenOut, bool
 	return MojErrNone;
 }
 
-MojErr MojTokenSet::stringFromToken(MojUInt8 token, MojString& propNameOut) const
+MojErr MojTokenSet::stringFromToken(MojUInt32 token, MojString& propNameOut) const
 {
 	if (token < MojObjectWriter::TokenStartMarker ||
 		(MojSize)(token - MojObjectWriter::TokenStartMarker) >= m_tokenVec.size()) {
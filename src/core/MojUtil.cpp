@@ -250,29 +250,30 @@ MojErr MojBase64DecodeImpl(const MojByte vals[], MojSize size, const MojChar* sr
 
 int MojLexicalCompare(const MojByte* data1, MojSize size1, const MojByte* data2, MojSize size2)
 {
-	// lexical comparison of two keys
-	const MojByte* end = data1 + MojMin(size1, size2);
-	while (data1 != end) {
-		if (*data1 != *data2)
-			return *data1 - *data2;
-		++data1;
-		++data2;
-	}
-	return (int) (size1 - size2);
+	// lexical comparison of two keys. memcmp compares many bytes per instruction,
+	// and unlike the difference of the sizes, the result can't overflow an int.
+	int comp = MojMemCmp(data1, data2, MojMin(size1, size2));
+	if (comp != 0)
+		return comp;
+	return (size1 < size2) ? -1 : (size1 > size2);
 }
 
 MojSize MojPrefixSize(const MojByte* data1, MojSize size1, const MojByte* data2, MojSize size2)
 {
-	// find length of shared prefix
+	// find length of shared prefix, a word at a time until the words differ
+	MojSize size = MojMin(size1, size2);
 	MojSize prefixSize = 0;
-	const MojByte* end = data1 + MojMin(size1, size2);
-	while (data1 != end) {
-		if (*data1 != *data2)
+	while (size - prefixSize >= sizeof(MojUInt64)) {
+		MojUInt64 word1;
+		MojUInt64 word2;
+		MojMemCpy(&word1, data1 + prefixSize, sizeof(word1));
+		MojMemCpy(&word2, data2 + prefixSize, sizeof(word2));
+		if (word1 != word2)
 			break;
-		++data1;
-		++data2;
-		++prefixSize;
+		prefixSize += sizeof(MojUInt64);
 	}
+	while (prefixSize < size && data1[prefixSize] == data2[prefixSize])
+		++prefixSize;
 	return prefixSize;
 }
 
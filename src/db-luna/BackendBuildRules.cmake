@@ -82,6 +82,7 @@ foreach (backend ${WEBOS_DB8_BACKEND})
 			src/db-luna/leveldb/MojDbLevelTxnIterator.cpp
 			src/db-luna/leveldb/MojDbLevelIterator.cpp
 			src/db-luna/leveldb/MojDbLevelContainerIterator.cpp
+			src/db-luna/leveldb/MojDbLevelTxnBuffer.cpp
 	   )
 
 		set (DB_BACKEND_WRAPPER_CFLAGS "${DB_BACKEND_WRAPPER_CFLAGS} -DMOJ_USE_LDB")
@@ -111,6 +112,13 @@ foreach (backend ${WEBOS_DB8_BACKEND})
 		)
 
 		set (DB_BACKEND_WRAPPER_CFLAGS "${DB_BACKEND_WRAPPER_CFLAGS} -I${CMAKE_SOURCE_DIR}/src/storage-sandwich -DMOJ_USE_SANDWICH")
+
+		# -- snappy is optional; without it kinds asking for compression are stored as is
+		find_library(SNAPPY NAMES snappy ${WEBOS_INSTALL_ROOT}/lib)
+		if(NOT SNAPPY STREQUAL "SNAPPY-NOTFOUND")
+			set (DB_BACKEND_LIB ${DB_BACKEND_LIB} ${SNAPPY})
+			set (DB_BACKEND_WRAPPER_CFLAGS "${DB_BACKEND_WRAPPER_CFLAGS} -DMOJ_USE_SNAPPY")
+		endif()
 	else ()
 		message(FATAL_ERROR "WEBOS_DB8_BACKEND: unsuported value '${backend}'")
 	endif ()
@@ -115,7 +115,7 @@ MojErr MojDbBerkeleyQuery::getById(const MojObject& id, MojDbStorageItem*& itemO
 	return MojErrNone;
 }
 
-MojErr MojDbBerkeleyQuery::seekImpl(const ByteVec& key, bool desc, bool& foundOut)
+MojErr MojDbBerkeleyQuery::seekImpl(const MojDbKey& key, bool desc, bool& foundOut)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
@@ -125,7 +125,7 @@ MojErr MojDbBerkeleyQuery::seekImpl(const ByteVec& key, bool desc, bool& foundOu
 		MojErrCheck(err);
 	} else {
 		// otherwise seek to the key
-		MojErr err = m_key.fromBytes(key.begin(), key.size());
+		MojErr err = m_key.fromBytes(key.data(), key.size());
 		MojErrCheck(err);
 		err = getKey(foundOut, SeekFlags);
 		MojErrCheck(err);
@@ -96,6 +96,8 @@ MojErr MojDbLunaServiceApp::configure(const MojObject& conf)
 
     err = m_mainService.configure(dbConf);
     MojErrCheck(err);
+    err = m_dispatcher.configure(dbConf);
+    MojErrCheck(err);
 
     return MojErrNone;
 }
@@ -109,7 +111,7 @@ MojErr MojDbLunaServiceApp::open()
 	MojErrCheck(err);
 
 	// start message queue thread pool
-	err = m_dispatcher.start(NumThreads);
+	err = m_dispatcher.start();
 	MojErrCheck(err);
 
 	// open db env
@@ -20,14 +20,14 @@
 
 #include "db-luna/leveldb/MojDbLevelContainerIterator.h"
 
-MojDbLevelContainerIterator::MojDbLevelContainerIterator (std::map<std::string, std::string>& database)
+MojDbLevelContainerIterator::MojDbLevelContainerIterator (MojDbLevelTxnBuffer& database)
     : m_container(database)
 {
     toFirst();
 }
 
-MojDbLevelContainerIterator::MojDbLevelContainerIterator(iterator_t iterator, std::map<std::string, std::string>& database)
-    : m_container(database), m_it(iterator)
+MojDbLevelContainerIterator::MojDbLevelContainerIterator(iterator_t iterator, MojDbLevelTxnBuffer& database)
+    : m_container(database), m_it(skipForward(iterator)), m_start(false)
 {
 }
 
@@ -44,50 +44,32 @@ MojDbLevelContainerIterator& MojDbLevelContainerIterator::operator++ ()
     }
     else
     {
-        ++m_it;
+        m_it = skipForward(m_it->next[0]);
     }
 
     return *this;
 }
 
-/*
-MojDbLevelContainerIterator MojDbLevelContainerIterator::operator++(int )
-{
-    MojDbLevelContainerIterator oldValue(*this);
-
-    ++(*this);
-
-    return oldValue;
-}*/
-
 MojDbLevelContainerIterator& MojDbLevelContainerIterator::operator-- ()
 {
     assert( !isBegin() );
-    if (m_it == m_container.begin())
+    iterator_t prev = (m_it == NULL) ? skipBackward(m_container.last())
+                                     : skipBackward(m_it->prev);
+    if (prev == NULL)
     {
         toBegin();
     }
     else
     {
-        --m_it;
+        m_it = prev;
     }
 
     return *this;
 }
 
-/*
-MojDbLevelContainerIterator MojDbLevelContainerIterator::operator-- (int)
-{
-    MojDbLevelContainerIterator oldValue(*this);
-
-    --(*this);
-
-    return oldValue;
-}*/
-
 MojDbLevelContainerIterator& MojDbLevelContainerIterator::operator= (iterator_t iterator)
 {
-    m_it = iterator;
+    m_it = skipForward(iterator);
     m_start = false;
 
     return *this;
@@ -100,17 +82,32 @@ void MojDbLevelContainerIterator::toBegin()
 
 void MojDbLevelContainerIterator::toEnd()
 {
-    m_it = m_container.end();
+    m_it = NULL;
 }
 
 void MojDbLevelContainerIterator::toFirst()
 {
-    m_it = m_container.begin();
+    m_it = skipForward(m_container.first());
     m_start = false;
 }
 
 void MojDbLevelContainerIterator::toLast()
 {
-    m_start = m_container.empty();
-    if (!m_start) m_it = --m_container.end();
+    iterator_t last = skipBackward(m_container.last());
+    m_start = (last == NULL);
+    if (!m_start) m_it = last;
+}
+
+MojDbLevelContainerIterator::iterator_t MojDbLevelContainerIterator::skipForward(iterator_t it)
+{
+    while (it && it->deleted)
+        it = it->next[0];
+    return it;
+}
+
+MojDbLevelContainerIterator::iterator_t MojDbLevelContainerIterator::skipBackward(iterator_t it)
+{
+    while (it && it->deleted)
+        it = it->prev;
+    return it;
 }
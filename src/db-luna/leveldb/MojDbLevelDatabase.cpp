@@ -92,6 +92,9 @@ MojErr MojDbLevelDatabase::close()
 
     MojErr err = MojErrNone;
     if (m_db) {
+        // sync anything a retired redo record still covers while we can
+        err = m_engine->redoCheckpoint();
+        MojErrCatchAll(err);
         err = closeImpl();
         m_primaryProps.clear();
         engine()->removeDatabase(this);
@@ -255,8 +258,12 @@ MojErr MojDbLevelDatabase::put(MojDbLevelItem& key, MojDbLevelItem& val, MojDbSt
     {
         leveldb_txn->tableTxn(*impl()).Put(*key.impl(), *val.impl());
     }
-    else
+    else {
+        // direct writes bypass the redo log, so retired records must not outlive them
+        err = m_engine->redoCheckpoint();
+        MojErrCheck(err);
         s = m_db->Put(MojDbLevelEngine::getWriteOptions(), *key.impl(), *val.impl());
+    }
 
 #if defined(MOJ_DEBUG)
     char str_buf[1024];
@@ -316,6 +323,8 @@ MojErr MojDbLevelDatabase::beginTxn(MojRefCountedPtr<MojDbStorageTxn>& txnOut)
     MojAssert( m_db );
    MojRefCountedPtr<MojDbLevelEnvTxn> txn(new MojDbLevelEnvTxn());
    MojAllocCheck(txn.get());
+   MojErr err = txn->begin(m_engine);
+   MojErrCheck(err);
 
    // force TableTxn for this database to start
    txn->tableTxn(*impl()).begin(*impl());
@@ -357,8 +366,11 @@ MojErr MojDbLevelDatabase::del(MojDbLevelItem& key, bool& foundOut, MojDbStorage
     {
         leveldb_txn->tableTxn(*impl()).Delete(*key.impl());
     }
-    else
+    else {
+        err = m_engine->redoCheckpoint();
+        MojErrCheck(err);
         st = m_db->Delete(MojDbLevelEngine::getWriteOptions(), *key.impl());
+    }
 
 #if defined(MOJ_DEBUG)
     char str_buf[1024];     // big enough for any key
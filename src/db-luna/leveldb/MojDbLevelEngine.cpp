@@ -27,6 +27,7 @@
 #include "db-luna/leveldb/MojDbLevelSeq.h"
 #include "db-luna/leveldb/MojDbLevelTxn.h"
 #include "db-luna/leveldb/MojDbLevelEnv.h"
+#include "db-luna/leveldb/defs.h"
 
 #include "db/MojDbObjectHeader.h"
 #include "db/MojDbQueryPlan.h"
@@ -37,12 +38,15 @@
 #include "core/MojTokenSet.h"
 
 #include <sys/statvfs.h>
+#include <memory>
 
 
 //const MojChar* const MojDbLevelEnv::LockFileName = _T("_lock");
 //db.ldb
 static const MojChar* const MojEnvIndexDbName = _T("indexes.ldb");
 static const MojChar* const MojEnvSeqDbName = _T("seq.ldb");
+static const MojChar* const MojEnvRedoDbName = _T("redo.ldb");
+static const MojSize MojRedoCheckpointInterval = 64;
 
 leveldb::ReadOptions MojDbLevelEngine::ReadOptions;
 leveldb::WriteOptions MojDbLevelEngine::WriteOptions;
@@ -52,7 +56,10 @@ leveldb::Options MojDbLevelEngine::OpenOptions;
 ////////////////////MojDbLevelEngine////////////////////////////////////////////
 
 MojDbLevelEngine::MojDbLevelEngine()
-: m_isOpen(false)
+: m_isOpen(false),
+  m_redoSeq(0),
+  m_redoPending(0),
+  m_redoRetiredCount(0)
 {
 }
 
@@ -162,6 +169,14 @@ MojErr MojDbLevelEngine::open(const MojChar* path, MojDbEnv* env)
     MojAllocCheck(m_indexDb.get());
     err = m_indexDb->open(MojEnvIndexDbName, this, created, NULL);
     MojErrCheck(err);
+
+    // open redo db and finish any multi-database commit interrupted by a crash
+    m_redoDb.reset(new MojDbLevelDatabase);
+    MojAllocCheck(m_redoDb.get());
+    err = m_redoDb->open(MojEnvRedoDbName, this, created, NULL);
+    MojErrCheck(err);
+    err = redoReplay();
+    MojErrCheck(err);
     m_isOpen = true;
 
     return MojErrNone;
@@ -173,6 +188,10 @@ MojErr MojDbLevelEngine::close()
     MojErr err = MojErrNone;
     MojErr errClose = MojErrNone;
 
+    // make retired redo records go away before their databases close
+    err = redoCheckpoint();
+    MojErrCatchAll(err);
+
     // close seqs before closing their databases
     m_seqs.clear();
 
@@ -187,6 +206,11 @@ MojErr MojDbLevelEngine::close()
         MojErrAccumulate(err, errClose);
         m_indexDb.reset();
     }
+    if (m_redoDb.get()) {
+        errClose = m_redoDb->close();
+        MojErrAccumulate(err, errClose);
+        m_redoDb.reset();
+    }
     m_env.reset();
     m_isOpen = false;
 
@@ -325,3 +349,202 @@ MojErr MojDbLevelEngine::removeSeq(MojDbLevelSeq* seq)
     }
     return MojErrNone;
 }
+
+MojErr MojDbLevelEngine::dbName(leveldb::DB* db, MojString& nameOut)
+{
+    MojAssert(db);
+    MojThreadGuard guard(m_dbMutex);
+
+    for (DatabaseVec::ConstIterator i = m_dbs.begin(); i != m_dbs.end(); ++i) {
+        if ((*i)->impl() == db) {
+            nameOut = (*i)->name();
+            return MojErrNone;
+        }
+    }
+    MojErrThrowMsg(MojErrDbFatal, _T("ldb: database not registered with engine"));
+}
+
+MojErr MojDbLevelEngine::redoBegin(const std::string& record, std::string& keyOut)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+    MojAssert(m_redoDb.get());
+
+    // big-endian sequence keeps records in commit order for replay
+    MojThreadGuard guard(m_redoMutex);
+    MojUInt64 seq = ++m_redoSeq;
+    ++m_redoPending;
+    guard.unlock();
+
+    keyOut.clear();
+    for (int shift = 56; shift >= 0; shift -= 8)
+        keyOut.push_back((char) ((seq >> shift) & 0xff));
+
+    // this is the only write of the txn that honours the configured sync
+    leveldb::Status s = m_redoDb->impl()->Put(getWriteOptions(), keyOut, record);
+    if (!s.ok()) {
+        guard.lock();
+        --m_redoPending;
+    }
+    MojLdbErrCheck(s, _T("redo.Put"));
+
+    return MojErrNone;
+}
+
+MojErr MojDbLevelEngine::redoEnd(const std::string& key)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+    MojAssert(m_redoDb.get());
+
+    // nothing is synced, so there is no durability to protect
+    if (!getWriteOptions().sync) {
+        leveldb::Status s = m_redoDb->impl()->Delete(getWriteOptions(), key);
+        MojThreadGuard guard(m_redoMutex);
+        --m_redoPending;
+        guard.unlock();
+        MojLdbErrCheck(s, _T("redo.Delete"));
+        return MojErrNone;
+    }
+
+    // the tables were written without sync, so the record has to outlive
+    // those writes until a checkpoint has synced them
+    MojThreadGuard guard(m_redoMutex);
+    m_redoRetired.Delete(key);
+    bool checkpoint = (++m_redoRetiredCount >= MojRedoCheckpointInterval);
+    guard.unlock();
+
+    if (checkpoint) {
+        MojErr err = redoCheckpoint();
+        MojErrCheck(err);
+    }
+
+    return MojErrNone;
+}
+
+MojErr MojDbLevelEngine::redoCheckpoint()
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+    // one checkpoint at a time, so a caller returning from here knows every
+    // record retired before it is gone
+    MojThreadGuard syncGuard(m_redoSyncMutex);
+    MojThreadGuard guard(m_redoMutex);
+    if (m_redoRetiredCount == 0 || !m_redoDb.get())
+        return MojErrNone;
+    leveldb::WriteBatch retired = m_redoRetired;
+    MojSize count = m_redoRetiredCount;
+    m_redoRetired.Clear();
+    m_redoRetiredCount = 0;
+    guard.unlock();
+
+    // an empty synced write flushes everything written to a database before it
+    leveldb::WriteOptions options = getWriteOptions();
+    options.sync = true;
+    {
+        MojThreadGuard dbGuard(m_dbMutex);
+        for (DatabaseVec::ConstIterator i = m_dbs.begin(); i != m_dbs.end(); ++i) {
+            if ((*i).get() == m_redoDb.get() || !(*i)->impl())
+                continue;
+            leveldb::WriteBatch empty;
+            leveldb::Status s = (*i)->impl()->Write(options, &empty);
+            MojLdbErrCheck(s, _T("redo.Sync"));
+        }
+    }
+
+    // only now may the records go; on failure they stay pending and are replayed on open
+    leveldb::Status s = m_redoDb->impl()->Write(options, &retired);
+    MojLdbErrCheck(s, _T("redo.Delete"));
+
+    guard.lock();
+    m_redoPending -= count;
+
+    return MojErrNone;
+}
+
+bool MojDbLevelEngine::redoPending()
+{
+    MojThreadGuard guard(m_redoMutex);
+
+    return m_redoPending > 0;
+}
+
+MojErr MojDbLevelEngine::redoReplay()
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+    MojAssert(m_redoDb.get());
+
+    std::unique_ptr<leveldb::Iterator> it(m_redoDb->impl()->NewIterator(getReadOptions()));
+    MojAllocCheck(it.get());
+
+    for (it->SeekToFirst(); it->Valid(); it->Next()) {
+        MojErr err = redoApply(it->value());
+        MojErrCheck(err);
+
+        leveldb::Status s = m_redoDb->impl()->Delete(getWriteOptions(), it->key());
+        MojLdbErrCheck(s, _T("redo.Delete"));
+
+        // keep new keys after anything left in the log
+        leveldb::Slice key = it->key();
+        MojUInt64 seq = 0;
+        for (size_t i = 0; i < key.size(); ++i)
+            seq = (seq << 8) | (MojUInt8) key[i];
+        m_redoSeq = MojMax(m_redoSeq, seq);
+    }
+    MojLdbErrCheck(it->status(), _T("redo.Iterate"));
+
+    return MojErrNone;
+}
+
+MojErr MojDbLevelEngine::redoApply(const leveldb::Slice& record)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+    leveldb::Slice rest = record;
+    uint32_t count = 0;
+    if (!MojDbLevelTableTxn::getFixed32(rest, count))
+        MojErrThrowMsg(MojErrDbFatal, _T("ldb: truncated redo record"));
+
+    for (uint32_t i = 0; i < count; ++i) {
+        leveldb::Slice name;
+        if (!MojDbLevelTableTxn::getBytes(rest, name))
+            MojErrThrowMsg(MojErrDbFatal, _T("ldb: truncated redo record"));
+        leveldb::WriteBatch batch;
+        MojErr err = MojDbLevelTableTxn::parseRedo(rest, batch);
+        MojErrCheck(err);
+        MojString dbName;
+        err = dbName.assign(name.data(), name.size());
+        MojErrCheck(err);
+
+        // write through an open database if we have one, otherwise open the file just for this
+        leveldb::DB* db = NULL;
+        {
+            MojThreadGuard guard(m_dbMutex);
+            for (DatabaseVec::ConstIterator j = m_dbs.begin(); j != m_dbs.end(); ++j) {
+                if ((*j)->name() == dbName) {
+                    db = (*j)->impl();
+                    break;
+                }
+            }
+        }
+        leveldb::Status s;
+        if (db) {
+            s = db->Write(getWriteOptions(), &batch);
+        } else {
+            // names are relative so a db directory that was moved replays in place; a table
+            // that is missing here was never ours to write, so don't create it
+            MojString file = dbName;
+            if (!m_path.empty()) {
+                err = file.format(_T("%s/%s"), m_path.data(), dbName.data());
+                MojErrCheck(err);
+            }
+            leveldb::Options options = getOpenOptions();
+            options.create_if_missing = false;
+            s = leveldb::DB::Open(options, file.data(), &db);
+            MojLdbErrCheck(s, _T("redo.Open"));
+            s = db->Write(getWriteOptions(), &batch);
+            delete db;
+        }
+        MojLdbErrCheck(s, _T("redo.Write"));
+    }
+
+    return MojErrNone;
+}
@@ -109,7 +109,7 @@ MojErr MojDbLevelQuery::getById(const MojObject& id, MojDbStorageItem*& itemOut,
     return MojErrNone;
 }
 
-MojErr MojDbLevelQuery::seekImpl(const ByteVec& key, bool desc, bool& foundOut)
+MojErr MojDbLevelQuery::seekImpl(const MojDbKey& key, bool desc, bool& foundOut)
 {
     if (key.empty()) {
         // if key is empty, seek to beginning (or end if desc)
@@ -117,7 +117,7 @@ MojErr MojDbLevelQuery::seekImpl(const ByteVec& key, bool desc, bool& foundOut)
         MojErrCheck(err);
     } else {
         // otherwise seek to the key
-        MojErr err = m_key.fromBytes(key.begin(), key.size());
+        MojErr err = m_key.fromBytes(key.data(), key.size());
         MojErrCheck(err);
         err = getKey(foundOut, SeekFlags);
         MojErrCheck(err);
@@ -70,10 +70,7 @@ void MojDbLevelTableTxn::Put(const leveldb::Slice& key,
                              const leveldb::Slice& val)
 {
     // populate local view
-    std::string keyStr = key.ToString();
-
-    m_pendingValues[keyStr] = val.ToString();
-    m_pendingDeletes.erase(keyStr); // if hidden before
+    m_pending.put(key, val);
 
     // notify all iterators
     for(std::set<MojDbLevelTxnIterator*>::const_iterator i = m_iterators.begin();
@@ -88,19 +85,15 @@ void MojDbLevelTableTxn::Put(const leveldb::Slice& key,
 leveldb::Status MojDbLevelTableTxn::Get(const leveldb::Slice& key,
                                         std::string& val)
 {
-    std::string keyStr = key.ToString();
-
-    // for keys deleted in this transaction
-    if (m_pendingDeletes.count(keyStr) > 0)
+    const MojDbLevelTxnBuffer::Node* node = m_pending.find(key);
+    if (node)
     {
-        return leveldb::Status::NotFound("Deleted inside transaction");
-    }
+        // for keys deleted in this transaction
+        if (node->deleted)
+            return leveldb::Status::NotFound("Deleted inside transaction");
 
-    // for keys added in this transaction
-    PendingValues::const_iterator it = m_pendingValues.find(key.ToString());
-    if (it != m_pendingValues.end())
-    {
-        val = it->second;
+        // for keys added in this transaction
+        val.assign(node->value.data(), node->value.size());
         return leveldb::Status::OK();
     }
 
@@ -119,10 +112,7 @@ void MojDbLevelTableTxn::Delete(const leveldb::Slice& key)
     }
 
     // populate local view
-    std::string keyStr = key.ToString();
-
-    m_pendingDeletes.insert(keyStr);
-    m_pendingValues.erase(keyStr); // if set before
+    m_pending.del(key);
 
     // XXX: work around for delete by query
     // make this delete visible to cursors
@@ -130,6 +120,11 @@ void MojDbLevelTableTxn::Delete(const leveldb::Slice& key)
 }
 
 MojErr MojDbLevelTableTxn::commitImpl()
+{
+    return commitImpl(MojDbLevelEngine::getWriteOptions());
+}
+
+MojErr MojDbLevelTableTxn::commitImpl(const leveldb::WriteOptions& options)
 {
     for(std::set<MojDbLevelTxnIterator*>::const_iterator i = m_iterators.begin();
         i != m_iterators.end();
@@ -138,20 +133,12 @@ MojErr MojDbLevelTableTxn::commitImpl()
         (*i)->save();
     }
 
-    leveldb::WriteBatch writeBatch;
-
-    for (PendingDeletes::iterator it = m_pendingDeletes.begin(); it != m_pendingDeletes.end(); ++it) {
-        writeBatch.Delete(*it);
-    }
-
-    for (PendingValues::iterator it = m_pendingValues.begin(); it != m_pendingValues.end(); ++it) {
-        writeBatch.Put(it->first, it->second);
-    }
-
-    if (!m_pendingDeletes.empty() || !m_pendingValues.empty())
+    if (!empty())
     {
         // Write to leveldb only if pending deletes/values.
-        leveldb::Status s = m_db->Write(MojDbLevelEngine::getWriteOptions(), &writeBatch);
+        leveldb::WriteBatch writeBatch;
+        fillBatch(writeBatch);
+        leveldb::Status s = m_db->Write(options, &writeBatch);
         MojLdbErrCheck(s, _T("db->Write"));
     }
 
@@ -167,11 +154,101 @@ MojErr MojDbLevelTableTxn::commitImpl()
     return MojErrNone;
 }
 
+void MojDbLevelTableTxn::fillBatch(leveldb::WriteBatch& writeBatch) const
+{
+    // key order, so leveldb gets a sorted batch
+    for (const MojDbLevelTxnBuffer::Node* node = m_pending.first(); node; node = node->next[0]) {
+        if (node->deleted)
+            writeBatch.Delete(node->key);
+        else
+            writeBatch.Put(node->key, node->value);
+    }
+}
+
+// redo format: deletes count, keys, then puts count, key/value pairs.
+// All lengths are fixed 32-bit little endian.
+void MojDbLevelTableTxn::appendRedo(std::string& record) const
+{
+    putFixed32(record, (uint32_t) m_pending.deletes());
+    for (const MojDbLevelTxnBuffer::Node* node = m_pending.first(); node; node = node->next[0]) {
+        if (node->deleted)
+            putBytes(record, node->key);
+    }
+
+    putFixed32(record, (uint32_t) m_pending.puts());
+    for (const MojDbLevelTxnBuffer::Node* node = m_pending.first(); node; node = node->next[0]) {
+        if (!node->deleted) {
+            putBytes(record, node->key);
+            putBytes(record, node->value);
+        }
+    }
+}
+
+MojErr MojDbLevelTableTxn::parseRedo(leveldb::Slice& record, leveldb::WriteBatch& batchOut)
+{
+    uint32_t count = 0;
+    if (!getFixed32(record, count))
+        MojErrThrowMsg(MojErrDbFatal, _T("ldb: truncated redo record"));
+    for (uint32_t i = 0; i < count; ++i) {
+        leveldb::Slice key;
+        if (!getBytes(record, key))
+            MojErrThrowMsg(MojErrDbFatal, _T("ldb: truncated redo record"));
+        batchOut.Delete(key);
+    }
+
+    if (!getFixed32(record, count))
+        MojErrThrowMsg(MojErrDbFatal, _T("ldb: truncated redo record"));
+    for (uint32_t i = 0; i < count; ++i) {
+        leveldb::Slice key;
+        leveldb::Slice val;
+        if (!getBytes(record, key) || !getBytes(record, val))
+            MojErrThrowMsg(MojErrDbFatal, _T("ldb: truncated redo record"));
+        batchOut.Put(key, val);
+    }
+
+    return MojErrNone;
+}
+
+void MojDbLevelTableTxn::putFixed32(std::string& dst, uint32_t val)
+{
+    char buf[4];
+    buf[0] = (char) (val & 0xff);
+    buf[1] = (char) ((val >> 8) & 0xff);
+    buf[2] = (char) ((val >> 16) & 0xff);
+    buf[3] = (char) ((val >> 24) & 0xff);
+    dst.append(buf, sizeof(buf));
+}
+
+bool MojDbLevelTableTxn::getFixed32(leveldb::Slice& src, uint32_t& valOut)
+{
+    if (src.size() < 4)
+        return false;
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(src.data());
+    valOut = ((uint32_t) p[0]) | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+    src.remove_prefix(4);
+    return true;
+}
+
+void MojDbLevelTableTxn::putBytes(std::string& dst, const leveldb::Slice& bytes)
+{
+    putFixed32(dst, (uint32_t) bytes.size());
+    dst.append(bytes.data(), bytes.size());
+}
+
+bool MojDbLevelTableTxn::getBytes(leveldb::Slice& src, leveldb::Slice& bytesOut)
+{
+    uint32_t len = 0;
+    if (!getFixed32(src, len) || src.size() < len)
+        return false;
+    bytesOut = leveldb::Slice(src.data(), len);
+    src.remove_prefix(len);
+    return true;
+}
+
 void MojDbLevelTableTxn::cleanup()
 {
     m_db = NULL;
-    m_pendingValues.clear();
-    m_pendingDeletes.clear();
+    m_pending.clear();
 
     for(std::set<MojDbLevelTxnIterator*>::const_iterator i = m_iterators.begin();
         i != m_iterators.end();
@@ -187,6 +264,7 @@ MojErr MojDbLevelEnvTxn::begin(MojDbLevelEngine* eng)
 {
     // TODO: mutex and lock-file serialization to implement strongest
     //       isolation level
+    m_engine = eng;
     return MojErrNone;
 }
 
@@ -216,6 +294,24 @@ MojDbLevelTableTxn &MojDbLevelEnvTxn::tableTxn(leveldb::DB &db)
 
 MojErr MojDbLevelEnvTxn::commitImpl()
 {
+    // an object put usually touches the object db and the index db; those
+    // writes must land together, so go through the redo log for them.
+    // While earlier records are still in the log a single-table txn goes
+    // through it too, or replaying them on open could overwrite its writes
+    TableTxns dirty;
+    for(TableTxns::iterator it = m_tableTxns.begin();
+                            it != m_tableTxns.end();
+                            ++it)
+    {
+        if (!(*it)->empty())
+            dirty.push_back(*it);
+    }
+    if (!dirty.empty() && m_engine && m_engine->redoDb() &&
+        (dirty.size() > 1 || m_engine->redoPending())) {
+        MojErr err = commitAtomic(dirty);
+        MojErrCheck(err);
+    }
+
     MojErr accErr = MojErrNone;
     for(TableTxns::iterator it = m_tableTxns.begin();
                             it != m_tableTxns.end();
@@ -226,3 +322,35 @@ MojErr MojDbLevelEnvTxn::commitImpl()
     }
     return accErr;
 }
+
+MojErr MojDbLevelEnvTxn::commitAtomic(const TableTxns& txns)
+{
+    MojAssert(m_engine);
+
+    // one synced write of the whole txn to the redo log...
+    std::string record;
+    MojDbLevelTableTxn::putFixed32(record, (uint32_t) txns.size());
+    for(TableTxns::const_iterator it = txns.begin(); it != txns.end(); ++it) {
+        MojString name;
+        MojErr err = m_engine->dbName((*it)->db(), name);
+        MojErrCheck(err);
+        MojDbLevelTableTxn::putBytes(record, leveldb::Slice(name.data(), name.length()));
+        (*it)->appendRedo(record);
+    }
+    std::string redoKey;
+    MojErr err = m_engine->redoBegin(record, redoKey);
+    MojErrCheck(err);
+
+    // ...lets each table be applied without paying for its own sync
+    leveldb::WriteOptions options = MojDbLevelEngine::getWriteOptions();
+    options.sync = false;
+    for(TableTxns::const_iterator it = txns.begin(); it != txns.end(); ++it) {
+        err = (*it)->commitImpl(options);
+        MojErrCheck(err);
+    }
+
+    err = m_engine->redoEnd(redoKey);
+    MojErrCheck(err);
+
+    return MojErrNone;
+}
@@ -0,0 +1,231 @@
+/* @@@LICENSE
+*
+* Copyright (c) 2014 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#include <string.h>
+#include <cassert>
+
+#include "db-luna/leveldb/MojDbLevelTxnBuffer.h"
+
+// class MojDbLevelArena
+MojDbLevelArena::MojDbLevelArena()
+    : m_ptr(NULL), m_remaining(0), m_memoryUsage(0)
+{
+}
+
+MojDbLevelArena::~MojDbLevelArena()
+{
+    clear();
+}
+
+char* MojDbLevelArena::allocate(size_t bytes)
+{
+    assert( bytes > 0 );
+    if (bytes <= m_remaining) {
+        char* result = m_ptr;
+        m_ptr += bytes;
+        m_remaining -= bytes;
+        return result;
+    }
+    return allocateFallback(bytes);
+}
+
+char* MojDbLevelArena::allocateAligned(size_t bytes)
+{
+    const size_t align = sizeof(void*);
+    size_t mod = reinterpret_cast<uintptr_t>(m_ptr) & (align - 1);
+    size_t slop = (mod == 0) ? 0 : align - mod;
+    size_t needed = bytes + slop;
+    if (needed <= m_remaining) {
+        char* result = m_ptr + slop;
+        m_ptr += needed;
+        m_remaining -= needed;
+        return result;
+    }
+    // blocks come from new[] and are always aligned
+    return allocateFallback(bytes);
+}
+
+leveldb::Slice MojDbLevelArena::copy(const leveldb::Slice& data)
+{
+    if (data.empty())
+        return leveldb::Slice();
+    char* buf = allocate(data.size());
+    memcpy(buf, data.data(), data.size());
+    return leveldb::Slice(buf, data.size());
+}
+
+void MojDbLevelArena::clear()
+{
+    for (std::vector<char*>::iterator i = m_blocks.begin(); i != m_blocks.end(); ++i)
+        delete[] *i;
+    m_blocks.clear();
+    m_ptr = NULL;
+    m_remaining = 0;
+    m_memoryUsage = 0;
+}
+
+char* MojDbLevelArena::allocateFallback(size_t bytes)
+{
+    if (bytes > BlockSize / 4) {
+        // big values get a block of their own so the current one isn't wasted
+        return allocateBlock(bytes);
+    }
+    m_ptr = allocateBlock(BlockSize);
+    m_remaining = BlockSize;
+
+    char* result = m_ptr;
+    m_ptr += bytes;
+    m_remaining -= bytes;
+    return result;
+}
+
+char* MojDbLevelArena::allocateBlock(size_t bytes)
+{
+    char* block = new char[bytes];
+    m_blocks.push_back(block);
+    m_memoryUsage += bytes;
+    return block;
+}
+
+// class MojDbLevelTxnBuffer
+MojDbLevelTxnBuffer::MojDbLevelTxnBuffer()
+    : m_head(NULL), m_tail(NULL), m_height(1), m_rnd(0xdeadbeef), m_puts(0), m_deletes(0)
+{
+    clear();
+}
+
+void MojDbLevelTxnBuffer::put(const leveldb::Slice& key, const leveldb::Slice& val)
+{
+    Node* node = insert(key);
+    if (node->deleted) {
+        node->deleted = false;
+        --m_deletes;
+        ++m_puts;
+    }
+    node->value = m_arena.copy(val);
+}
+
+void MojDbLevelTxnBuffer::del(const leveldb::Slice& key)
+{
+    Node* node = insert(key);
+    if (!node->deleted) {
+        node->deleted = true;
+        --m_puts;
+        ++m_deletes;
+    }
+    node->value = leveldb::Slice();
+}
+
+void MojDbLevelTxnBuffer::clear()
+{
+    m_arena.clear();
+    m_head = newNode(leveldb::Slice(), MaxHeight);
+    m_tail = NULL;
+    m_height = 1;
+    m_puts = 0;
+    m_deletes = 0;
+}
+
+const MojDbLevelTxnBuffer::Node* MojDbLevelTxnBuffer::find(const leveldb::Slice& key) const
+{
+    const Node* node = findGreaterOrEqual(key, NULL);
+    if (node && node->key == key)
+        return node;
+    return NULL;
+}
+
+const MojDbLevelTxnBuffer::Node* MojDbLevelTxnBuffer::lowerBound(const leveldb::Slice& key) const
+{
+    return findGreaterOrEqual(key, NULL);
+}
+
+MojDbLevelTxnBuffer::Node* MojDbLevelTxnBuffer::newNode(const leveldb::Slice& key, int height)
+{
+    char* mem = m_arena.allocateAligned(sizeof(Node) + sizeof(Node*) * (height - 1));
+    Node* node = reinterpret_cast<Node*>(mem);
+    node->key = m_arena.copy(key);
+    node->value = leveldb::Slice();
+    node->deleted = false;
+    node->prev = NULL;
+    for (int i = 0; i < height; ++i)
+        node->next[i] = NULL;
+    return node;
+}
+
+MojDbLevelTxnBuffer::Node* MojDbLevelTxnBuffer::findGreaterOrEqual(const leveldb::Slice& key, Node** prevOut) const
+{
+    Node* x = m_head;
+    int level = m_height - 1;
+    for (;;) {
+        Node* next = x->next[level];
+        if (next && next->key.compare(key) < 0) {
+            x = next;
+        } else {
+            if (prevOut)
+                prevOut[level] = x;
+            if (level == 0)
+                return next;
+            --level;
+        }
+    }
+}
+
+int MojDbLevelTxnBuffer::randomHeight()
+{
+    // branching factor 4
+    int height = 1;
+    for (;;) {
+        m_rnd ^= m_rnd << 13;
+        m_rnd ^= m_rnd >> 17;
+        m_rnd ^= m_rnd << 5;
+        if (height >= MaxHeight || (m_rnd & 3) != 0)
+            break;
+        ++height;
+    }
+    return height;
+}
+
+MojDbLevelTxnBuffer::Node* MojDbLevelTxnBuffer::insert(const leveldb::Slice& key)
+{
+    Node* prev[MaxHeight];
+    Node* node = findGreaterOrEqual(key, prev);
+    if (node && node->key == key)
+        return node;
+
+    int height = randomHeight();
+    if (height > m_height) {
+        for (int i = m_height; i < height; ++i)
+            prev[i] = m_head;
+        m_height = height;
+    }
+
+    node = newNode(key, height);
+    for (int i = 0; i < height; ++i) {
+        node->next[i] = prev[i]->next[i];
+        prev[i]->next[i] = node;
+    }
+    node->prev = (prev[0] == m_head) ? NULL : prev[0];
+    if (node->next[0])
+        node->next[0]->prev = node;
+    else
+        m_tail = node;
+
+    // new nodes start as puts; del() flips them
+    ++m_puts;
+    return node;
+}
@@ -38,7 +38,7 @@ namespace {
         if (xb || ye) return LT;
         if (xe || yb) return GT;
 
-        int r = x->key().ToString().compare(y->first);
+        int r = x->key().compare(y->key);
         return r < 0 ? LT :
                r > 0 ? GT :
                        EQ ;
@@ -62,11 +62,10 @@ std::string string_to_hex(const std::string& input)
 }
 
 MojDbLevelTxnIterator::MojDbLevelTxnIterator(MojDbLevelTableTxn *txn) :
-    inserts(txn->m_pendingValues),
-    deletes(txn->m_pendingDeletes),
+    pending(txn->m_pending),
     leveldb(txn->m_db),
     m_it(leveldb),
-    m_insertsItertor (inserts),
+    m_insertsItertor (pending),
     m_txn(txn)
 {
     MojAssert( txn );
@@ -90,8 +89,8 @@ void MojDbLevelTxnIterator::notifyPut(const leveldb::Slice &key)
     // Idea here is to re-align our transaction iterator if new key is in range
     // of keys where database iterator and transaction iterator points to.
     // Need to take care of next cases:
-    // 1) going forward: m_it->key() <= key < m_insertsItertor->first
-    // 2) going backward: m_insertIterator->first < key <= m_it->key()
+    // 1) going forward: m_it->key() <= key < m_insertsItertor->key
+    // 2) going backward: m_insertsItertor->key < key <= m_it->key()
 
     // lets see in which relations we are with leveldb iterator
     bool keyLtDb; // key < m_it->key()
@@ -111,8 +110,8 @@ void MojDbLevelTxnIterator::notifyPut(const leveldb::Slice &key)
     else if (m_insertsItertor.isEnd()) keyLtTxn = true, keyEqTxn = false;
     else
     {
-        keyLtTxn = key < m_insertsItertor->first;
-        keyEqTxn = key == m_insertsItertor->first;
+        keyLtTxn = key < m_insertsItertor->key;
+        keyEqTxn = key == m_insertsItertor->key;
     }
 
     if (m_fwd)
@@ -135,7 +134,7 @@ void MojDbLevelTxnIterator::notifyDelete(const leveldb::Slice &key)
 {
     // if no harm for txn iterator - nothing to do
     if (!m_insertsItertor.isValid()) return;
-    if (m_insertsItertor->first != key) return;
+    if (m_insertsItertor->key != key) return;
 
     if (m_fwd)
     {
@@ -177,11 +176,11 @@ void MojDbLevelTxnIterator::notifyDelete(const leveldb::Slice &key)
 void MojDbLevelTxnIterator::skipDeleted()
 {
     if (m_fwd) {
-        while (!m_it.isEnd() && isDeleted(m_it->key().ToString())) {
+        while (!m_it.isEnd() && isDeleted(m_it->key())) {
             ++m_it;
         }
     } else {
-        while (!m_it.isBegin() && isDeleted(m_it->key().ToString())) {
+        while (!m_it.isBegin() && isDeleted(m_it->key())) {
             --m_it;
         }
     }
@@ -204,7 +203,7 @@ bool MojDbLevelTxnIterator::inTransaction() const
 std::string MojDbLevelTxnIterator::getValue()
 {
     if (inTransaction())
-        return m_insertsItertor->second;
+        return m_insertsItertor->value.ToString();
     else
         return m_it->value().ToString();
 }
@@ -212,7 +211,7 @@ std::string MojDbLevelTxnIterator::getValue()
 const std::string MojDbLevelTxnIterator::getKey() const
 {
     if (inTransaction())
-        return m_insertsItertor->first;
+        return m_insertsItertor->key.ToString();
     else
         return m_it->key().ToString();
 }
@@ -254,9 +253,10 @@ bool MojDbLevelTxnIterator::isValid() const
     return  !m_invalid && (m_it.isValid() || m_insertsItertor.isValid());
 }
 
-bool MojDbLevelTxnIterator::isDeleted(const std::string& key) const
+bool MojDbLevelTxnIterator::isDeleted(const leveldb::Slice& key) const
 {
-    return ( deletes.find(key) != deletes.end() );
+    const MojDbLevelTxnBuffer::Node* node = pending.find(key);
+    return ( node && node->deleted );
 }
 
 
@@ -301,10 +301,10 @@ void MojDbLevelTxnIterator::prev()
     MojAssert( !m_it.isEnd() );
     MojAssert( !m_insertsItertor.isEnd() );
 
-    if (m_it->key().ToString() > m_insertsItertor->first) {
+    if (m_it->key() > m_insertsItertor->key) {
         --m_it;
         skipDeleted();
-    } else if (m_it->key().ToString() == m_insertsItertor->first) {
+    } else if (m_it->key() == m_insertsItertor->key) {
         // advance both iterators to the next key value
         --m_insertsItertor;
         --m_it;
@@ -357,10 +357,10 @@ void MojDbLevelTxnIterator::next()
     MojAssert( !m_it.isBegin() );
     MojAssert( !m_insertsItertor.isBegin() );
 
-    if (m_it->key().ToString() < m_insertsItertor->first) {
+    if (m_it->key() < m_insertsItertor->key) {
         ++m_it;
         skipDeleted();
-    } else if (m_it->key().ToString() == m_insertsItertor->first) {
+    } else if (m_it->key() == m_insertsItertor->key) {
         // advance both iterators to the next key value
         ++m_insertsItertor;
         ++m_it;
@@ -378,7 +378,7 @@ void MojDbLevelTxnIterator::seek(const std::string& key)
     m_it.seek(key);
     skipDeleted();
 
-    m_insertsItertor = inserts.lower_bound(key);
+    m_insertsItertor = pending.lowerBound(key);
 }
 
 leveldb::Status MojDbLevelTxnIterator::status() const
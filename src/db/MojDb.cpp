@@ -44,6 +44,7 @@ const MojChar* const MojDb::RevKey = _T("_rev");
 const MojChar* const MojDb::RevNumKey = _T("rev");
 const MojChar* const MojDb::RoleType = _T("db.role");
 const MojChar* const MojDb::SyncKey = _T("_sync");
+const MojChar* const MojDb::StatsInternalKey = _T("_internal");
 const MojChar* const MojDb::TimestampKey = _T("timestamp");
 const MojChar* const MojDb::LastPurgedRevKey = _T("lastPurgedRev");
 const MojChar* const MojDb::LocaleKey = _T("locale");
@@ -52,6 +53,7 @@ const MojChar* const MojDb::VersionFileName = _T("_version");
 const MojChar* const MojDb::KindIdPrefix = _T("_kinds/");
 const MojChar* const MojDb::QuotaIdPrefix = _T("_quotas/");
 const MojChar* const MojDb::PermissionIdPrefix = _T("_permissions/");
+const MojChar* const MojDb::SearchTempDirDefault = _T("/tmp");
 const MojUInt32 MojDb::AutoBatchSize = 1000;
 const MojUInt32 MojDb::AutoCompactSize = 5000;
 const MojUInt32 MojDb::TmpVersionFileLength = 32;
@@ -63,8 +65,15 @@ MojDb::MojDb()
 : m_quotaAlert(*this),
   m_spaceAlert(*this),
   m_shardEngine(*this),
+  m_indexBuilder(*this),
   m_purgeWindow(PurgeNumDaysDefault),
   m_loadStepSize(LoadStepSizeDefault),
+  m_bulkLoadStepSize(BulkLoadStepSizeDefault),
+  m_dumpFormat(MojDbDumpWriter::FormatJson),
+  m_dumpCompress(false),
+  m_dumpThreads(MojDbDumpWriter::ThreadsDefault),
+  m_searchRunBytes(SearchRunBytesDefault),
+  m_openedVersion(DatabaseVersion),
   m_isOpen(false)
 {
     if (!DefaultLocaleAlreadyInited) {
@@ -105,6 +114,36 @@ MojErr MojDb::configure(const MojObject& conf)
 		if (!found) {
 			m_loadStepSize = LoadStepSizeDefault;
 		}
+		found = dbConf.get(_T("bulkLoadStepSize"), m_bulkLoadStepSize);
+		if (!found) {
+			m_bulkLoadStepSize = BulkLoadStepSizeDefault;
+		}
+		MojString dumpFormat;
+		err = dbConf.get(MojDbDumpWriter::FormatKey, dumpFormat, found);
+		MojErrCheck(err);
+		m_dumpFormat = MojDbDumpWriter::FormatJson;
+		if (found) {
+			err = MojDbDumpWriter::parseFormat(dumpFormat, m_dumpFormat);
+			MojErrCheck(err);
+		}
+		m_dumpCompress = false;
+		dbConf.get(MojDbDumpWriter::CompressKey, m_dumpCompress);
+		found = dbConf.get(MojDbDumpWriter::ThreadsKey, m_dumpThreads);
+		if (!found || m_dumpThreads < 1) {
+			m_dumpThreads = MojDbDumpWriter::ThreadsDefault;
+		}
+		found = dbConf.get(_T("searchRunBytes"), m_searchRunBytes);
+		if (!found || m_searchRunBytes <= 0) {
+			m_searchRunBytes = SearchRunBytesDefault;
+		}
+		err = dbConf.get(_T("searchTempDir"), m_searchTempDir, found);
+		MojErrCheck(err);
+		err = m_indexBuilder.configure(dbConf);
+		MojErrCheck(err);
+		err = m_watchNotifier.configure(dbConf);
+		MojErrCheck(err);
+		err = m_searchCache.configure(dbConf);
+		MojErrCheck(err);
 		m_conf = dbConf;
 	}
 	return MojErrNone;
@@ -143,6 +182,8 @@ MojErr MojDb::open(const MojChar* path, MojDbStorageEngine* engine)
 
 	MojAutoCloser<MojDb> closer(this);
 	m_isOpen = true;
+	// a previous close left the notifier delivering inline
+	m_watchNotifier.start();
 
 	// check the database version number and bail if there's a mismatch
 	err = checkDbVersion(path);
@@ -222,10 +263,16 @@ MojErr MojDb::open(const MojChar* path, MojDbStorageEngine* engine)
 MojErr MojDb::close()
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
-	MojThreadWriteGuard guard(m_schemaLock);
 
+	// the builder takes the schema lock for each step, so stop it before we take it here
 	MojErr err = MojErrNone;
-	MojErr errClose = MojErrNone;
+	MojErr errClose = m_indexBuilder.stop();
+	MojErrAccumulate(err, errClose);
+	// pending fires still reach their watchers, which need the indexes to be open
+	errClose = m_watchNotifier.stop();
+	MojErrAccumulate(err, errClose);
+
+	MojThreadWriteGuard guard(m_schemaLock);
 
 	if (m_isOpen) {
         LOG_DEBUG("[db_mojodb] closing...");
@@ -798,7 +845,7 @@ MojErr MojDb::putObj(const MojObject& id, MojObject& obj, const MojObject* oldOb
 
 	// update revision
 	MojInt64 rev;
-	MojErr err = nextId(rev);
+	MojErr err = nextId(rev, req.txn());
 	MojErrCheck(err);
 	err = obj.put(RevKey, rev);
 	MojErrCheck(err);
@@ -841,11 +888,16 @@ MojErr MojDb::putObj(const MojObject& id, MojObject& obj, const MojObject* oldOb
 	MojErrCheck(err);
 
 	// store it in the db
+	MojDbKind* kind = NULL;
+	err = m_kindEngine.getKind(header.kindId().data(), kind);
+	MojErrCheck(err);
 	if (oldItem) {
-		err = m_objDb->update(putId, buf, oldItem, req.txn());
+		err = kind->compress() ? m_objDb->updateCompressed(putId, buf, oldItem, req.txn())
+							   : m_objDb->update(putId, buf, oldItem, req.txn());
 		MojErrCheck(err);
 	} else {
-		err = m_objDb->insert(putId, buf, req.txn());
+		err = kind->compress() ? m_objDb->insertCompressed(putId, buf, req.txn())
+							   : m_objDb->insert(putId, buf, req.txn());
 		MojErrCheck(err);
 	}
 
@@ -1211,11 +1263,11 @@ MojErr MojDb::attachShardId(MojString shardId, MojObject& id)
 	return MojErrNone;
 }
 
-MojErr MojDb::nextId(MojInt64& idOut)
+MojErr MojDb::nextId(MojInt64& idOut, MojDbStorageTxn* txn)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
-	MojErr err = m_idSeq->get(idOut);
+	MojErr err = m_idSeq->get(idOut, txn);
 	MojErrCheck(err);
 
 	return MojErrNone;
@@ -1280,9 +1332,12 @@ MojErr MojDb::checkDbVersion(const MojChar* path)
     LOG_TRACE("Entering function %s", __FUNCTION__);
     MojAssert(path);
 
+    m_openedVersion = DatabaseVersion;
+    MojErr err = m_path.assign(path);
+    MojErrCheck(err);
     MojString version;
     MojString versionFileName;
-    MojErr err = versionFileName.format(_T("%s/%s"), path, VersionFileName);
+    err = versionFileName.format(_T("%s/%s"), path, VersionFileName);
     MojErrCheck(err);
     err = MojFileToString(versionFileName, version);
     MojErrCatch(err, MojErrNotFound) {
@@ -1299,11 +1354,15 @@ MojErr MojDb::checkDbVersion(const MojChar* path)
             err = createVersionFile(path, versionFileName);
             MojErrCheck(err);
         } else {
-            if (versionObj != DatabaseVersion) {
+            MojInt64 versionVal = versionObj.intValue();
+            if (versionVal < MinDatabaseVersion || versionVal > DatabaseVersion) {
             MojErrThrowMsg(MojErrDbVersionMismatch,
                 _T("db: version mismatch: expected '%lld', got '%lld'"),
-                DatabaseVersion, versionObj.intValue());
+                DatabaseVersion, versionVal);
             }
+            // the old version stays on disk until retokenize rewrites the objects,
+            // otherwise a later open would never know the upgrade is still due
+            m_openedVersion = versionVal;
         }
     }
     return MojErrNone;
@@ -1332,6 +1391,22 @@ MojErr MojDb::createVersionFile(const MojChar* path, const MojString versionFile
     return MojErrNone;
 }
 
+MojErr MojDb::updateVersion()
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+    if (m_openedVersion >= DatabaseVersion)
+        return MojErrNone;
+
+    MojString versionFileName;
+    MojErr err = versionFileName.format(_T("%s/%s"), m_path.data(), VersionFileName);
+    MojErrCheck(err);
+    err = createVersionFile(m_path, versionFileName);
+    MojErrCheck(err);
+
+    return MojErrNone;
+}
+
 
 MojErr MojDb::beginReq(MojDbReq& req, bool lockSchema)
 {
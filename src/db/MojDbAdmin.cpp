@@ -23,6 +23,7 @@
 #include "core/MojJson.h"
 #include "core/MojTime.h"
 #include "core/MojObjectBuilder.h"
+#include "db/MojDbObjectHeader.h"
 
 MojErr MojDb::stats(MojObject& objOut, MojDbReqRef req, bool verify, MojString *pKind)
 {
@@ -32,6 +33,29 @@ MojErr MojDb::stats(MojObject& objOut, MojDbReqRef req, bool verify, MojString *
 	MojErrCheck(err);
 	err = m_kindEngine.stats(objOut, req, verify, pKind);
 	MojErrCheck(err);
+	if (pKind == NULL) {
+		// kept apart from the kinds so that clients can walk everything else as kind stats
+		MojObject internal;
+		MojObject cacheStats;
+		err = m_searchCache.stats(cacheStats);
+		MojErrCheck(err);
+		err = internal.put(MojDbSearchCache::StatsKey, cacheStats);
+		MojErrCheck(err);
+		MojObject notifierStats;
+		err = m_watchNotifier.stats(notifierStats);
+		MojErrCheck(err);
+		err = internal.put(MojDbWatchNotifier::StatsKey, notifierStats);
+		MojErrCheck(err);
+		MojObject engineStats;
+		err = m_storageEngine->stats(engineStats);
+		MojErrCheck(err);
+		if (!engineStats.empty()) {
+			err = internal.put(MojDbStorageEngine::StatsKey, engineStats);
+			MojErrCheck(err);
+		}
+		err = objOut.put(StatsInternalKey, internal);
+		MojErrCheck(err);
+	}
 	err = req->end();
 	MojErrCheck(err);
 
@@ -143,7 +167,7 @@ MojErr MojDb::purge(MojUInt32& countOut, MojInt64 numDays, MojDbReqRef req)
 	// store the revision number to current timestamp mapping
 	MojObject revTimeMapping;
 	MojInt64 rev;
-	err = nextId(rev);
+	err = nextId(rev, req->txn());
 	MojErrCheck(err);
 	err = revTimeMapping.put(RevNumKey, rev);
 	MojErrCheck(err);
@@ -227,12 +251,11 @@ MojErr MojDb::dump(const MojChar* path, MojUInt32& countOut, bool incDel, MojDbR
 		MojErrThrow(MojErrDbAccessDenied);
 	}
 
-	MojFile file;
-	err = file.open(path, MOJ_O_WRONLY | MOJ_O_CREAT | MOJ_O_TRUNC, MOJ_S_IRUSR | MOJ_S_IWUSR);
+	MojDbDumpWriter writer;
+	err = writer.open(path, m_dumpFormat, m_dumpCompress);
 	MojErrCheck(err);
 
 	// write out kinds first, then existing objects, then deleted objects
-	MojSize bytesWritten = 0;
 	MojSize totalwarns = 0;
 	MojSize newwarns = 0;
 	MojDbQuery objQuery;
@@ -284,24 +307,33 @@ MojErr MojDb::dump(const MojChar* path, MojUInt32& countOut, bool incDel, MojDbR
 		err = i->getRequired(RevKey, kindRev);
 		MojErrCheck(err);
 		if ((deleted && kindRev > delRevParam) || (!deleted && kindRev > revParam)) {
-			err = dumpObj(file, (*i), bytesWritten, maxBytes);
+			err = dumpObj(writer, (*i), maxBytes);
 			MojErrCheck(err);
 			countOut++;
 		}
 	}
 
-	// dump all the non-deleted objects
-	err = dumpImpl(file, backup, false, revParam, delRevParam, true, countOut, req, backupResponse, MojDbServiceDefs::RevKey, bytesWritten, newwarns, maxBytes);
-	MojErrCheck(err);
+	// dump all the non-deleted objects. A plain dump takes every object and has no size limit
+	// at which to stop in rev order, so kinds are dumped side by side. Backups select objects
+	// through the _sync/_rev index, which a scan per kind cannot use.
+	if (!backup && maxBytes == 0 && m_dumpThreads > 1) {
+		err = dumpKinds(writer, countOut, newwarns);
+		MojErrCheck(err);
+	} else {
+		err = dumpImpl(writer, backup, false, revParam, delRevParam, true, countOut, req, backupResponse, MojDbServiceDefs::RevKey, newwarns, maxBytes);
+		MojErrCheck(err);
+	}
 	totalwarns += newwarns;
 	// If we're supposed to include deleted objects, dump the deleted objects now.
 	// There's a chance that we may have run out of space in our backup.  If that's the case,
 	// we don't want to try to dump deleted objects - we can detect this by looking for the HasMoreKey
 	if (incDel && backupResponse && !backupResponse->contains(MojDbServiceDefs::HasMoreKey)) {
-		err = dumpImpl(file, backup, true, revParam, delRevParam, false, countOut, req, backupResponse, MojDbServiceDefs::DeletedRevKey, bytesWritten, newwarns, maxBytes);
+		err = dumpImpl(writer, backup, true, revParam, delRevParam, false, countOut, req, backupResponse, MojDbServiceDefs::DeletedRevKey, newwarns, maxBytes);
 		MojErrCheck(err);
 	}
 	totalwarns += newwarns;
+	err = writer.close();
+	MojErrCheck(err);
 
 	// Add the Full and Version keys
 	if (backup && backupResponse) {
@@ -337,14 +369,16 @@ MojErr MojDb::load(const MojChar* path, MojUInt32& countOut, MojUInt32 flags, Mo
 	MojErr err = beginReq(req, true);
 	MojErrCheck(err);
 
-	MojFile file;
-	err = file.open(path, MOJ_O_RDONLY);
-	MojErrCheck(err);
+	// a bulk load leaves index keys in the txn until it commits, so every index gets a
+	// whole step's worth of keys written in order, and it commits less often
+	bool bulk = MojFlagGet(flags, FlagBulk);
+	MojFlagSet(flags, FlagBulk, false);
+	MojInt64 stepSize = bulk ? m_bulkLoadStepSize : m_loadStepSize;
+	req->txn()->deferIndexKeys(bulk);
 
-	MojJsonParser parser;
-	parser.begin();
-	MojSize bytesRead = 0;
-	MojObjectBuilder visitor;
+	MojDbDumpReader reader;
+	err = reader.open(path);
+	MojErrCheck(err);
 
 	int total_mutexes, mutexes_free, mutexes_used, mutexes_used_highwater, mutex_regionsize;
 	m_objDb->mutexStats(&total_mutexes, &mutexes_free, &mutexes_used, &mutexes_used_highwater, &mutex_regionsize);
@@ -363,78 +397,62 @@ MojErr MojDb::load(const MojChar* path, MojUInt32& countOut, MojUInt32 flags, Mo
 	int total = 0;
 	int transactions = 0;
 
-	do {
-		MojChar buf[MojFile::MojFileBufSize];
-		err = file.read(buf, sizeof(buf), bytesRead);
+	for (;;) {
+		bool found = false;
+		err = reader.next(found);
 		MojErrCheck(err);
+		if (!found)
+			break;
 
-		const MojChar* parseEnd = buf;
-		while (parseEnd < (buf + bytesRead)) {
-			err = parser.parseChunk(visitor, parseEnd, bytesRead - (parseEnd - buf), parseEnd);
-			MojErrCheck(err);
-			if (parser.finished()) {
-				//store the object
-				err = loadImpl(visitor.object(), flags, req);
-				MojErrCheck(err);
-				countOut++;
-				parser.begin();
-				visitor.reset();
+		//store the object
+		err = loadImpl(reader.object(), flags, req);
+		MojErrCheck(err);
+		countOut++;
 
-				total++;
+		total++;
 
-				if ((total % 10) == 0) {
-					// For debugging mutex consumption during load operations, we periodically retrieve the mutex stats.
-					m_objDb->mutexStats(&total_mutexes, &mutexes_free, &mutexes_used, &mutexes_used_highwater, &mutex_regionsize);
+		if (!bulk && (total % 10) == 0) {
+			// For debugging mutex consumption during load operations, we periodically retrieve the mutex stats.
+			m_objDb->mutexStats(&total_mutexes, &mutexes_free, &mutexes_used, &mutexes_used_highwater, &mutex_regionsize);
 
-					LOG_DEBUG("[db_mojodb] Loading %s record %d, total_mutexes: %d, mutexes_free: %d, mutexes_used: %d, mutexes_used_highwater: %d, &mutex_regionsize: %d\n",
-						path, total, total_mutexes, mutexes_free, mutexes_used, mutexes_used_highwater, mutex_regionsize);
-				}
+			LOG_DEBUG("[db_mojodb] Loading %s record %d, total_mutexes: %d, mutexes_free: %d, mutexes_used: %d, mutexes_used_highwater: %d, &mutex_regionsize: %d\n",
+				path, total, total_mutexes, mutexes_free, mutexes_used, mutexes_used_highwater, mutex_regionsize);
+		}
 
-				// If a loadStepSize is configured, then break up the load into separate transactions.
-				// This is intended to prevent run-away mutex consumption in some particular scenarios.
-				// The transactions do not reverse or prevent mutex consumption, but seem to reduce the
-				// growth and eventually cause it to level off.
+		// If a loadStepSize is configured, then break up the load into separate transactions.
+		// This is intended to prevent run-away mutex consumption in some particular scenarios.
+		// The transactions do not reverse or prevent mutex consumption, but seem to reduce the
+		// growth and eventually cause it to level off.
 
-				if ((m_loadStepSize > 0) && ((total % m_loadStepSize) == 0)) {
-					// Close and reopen transaction, to prevent a very large transaction from building up.
-					LOG_DEBUG("[db_mojodb] Loading %s record %d, closing and reopening transaction.\n", path, total);
+		if ((stepSize > 0) && ((total % stepSize) == 0)) {
+			// Close and reopen transaction, to prevent a very large transaction from building up.
+			LOG_DEBUG("[db_mojodb] Loading %s record %d, closing and reopening transaction.\n", path, total);
 
-					struct timeval transactionStartTime = {0,0}, transactionStopTime = {0,0};
+			struct timeval transactionStartTime = {0,0}, transactionStopTime = {0,0};
 
-					gettimeofday(&transactionStartTime, NULL);
+			gettimeofday(&transactionStartTime, NULL);
 
-					err = req->end();
-					MojErrCheck(err);
+			err = req->end();
+			MojErrCheck(err);
 
-					err = req->endBatch();
-					MojErrCheck(err);
+			err = req->endBatch();
+			MojErrCheck(err);
 
-					req->beginBatch(); // beginBatch() invocation for first transaction happened in MojDbServiceHandlerBase::invokeImpl
+			req->beginBatch(); // beginBatch() invocation for first transaction happened in MojDbServiceHandlerBase::invokeImpl
 
-					err = beginReq(req, true);
-					MojErrCheck(err);
+			err = beginReq(req, true);
+			MojErrCheck(err);
+			req->txn()->deferIndexKeys(bulk);
 
-					gettimeofday(&transactionStopTime, NULL);
+			gettimeofday(&transactionStopTime, NULL);
 
-					long int elapsedTransactionTimeMS = (transactionStopTime.tv_sec - transactionStartTime.tv_sec) * 1000 +
-								(transactionStopTime.tv_usec - transactionStartTime.tv_usec) / 1000;
+			long int elapsedTransactionTimeMS = (transactionStopTime.tv_sec - transactionStartTime.tv_sec) * 1000 +
+						(transactionStopTime.tv_usec - transactionStartTime.tv_usec) / 1000;
 
-					total_transaction_time += (int)elapsedTransactionTimeMS;
+			total_transaction_time += (int)elapsedTransactionTimeMS;
 
-					transactions++;
-				}
-			}
+			transactions++;
 		}
-	} while (bytesRead > 0);
-
-	err = parser.end(visitor);
-	MojErrCheck(err);
-	if (parser.finished()) {
-		err = loadImpl(visitor.object(), flags, req);
-		MojErrCheck(err);
-		countOut++;
-	} else if (bytesRead > 0) {
-		MojErrThrow(MojErrJsonParseEof);
 	}
 
 	err = req->end();
@@ -457,6 +475,38 @@ MojErr MojDb::load(const MojChar* path, MojUInt32& countOut, MojUInt32 flags, Mo
 	return MojErrNone;
 }
 
+MojErr MojDb::retokenize(MojUInt32& countOut, MojDbReqRef req)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	countOut = 0;
+	MojErr err = beginReq(req);
+	MojErrCheck(err);
+
+	if (!req->admin()) {
+        LOG_ERROR(MSGID_DB_ADMIN_ERROR, 1,
+        		PMLOGKS("data", req->domain().data()),
+        		"access denied: 'data' cannot retokenize db");
+		MojErrThrow(MojErrDbAccessDenied);
+	}
+
+	// rewrite existing objects, then deleted objects
+	err = retokenizeImpl(false, countOut, req);
+	MojErrCheck(err);
+	err = retokenizeImpl(true, countOut, req);
+	MojErrCheck(err);
+
+	err = req->end();
+	MojErrCheck(err);
+	// every object is in the current format now, so keep older builds out
+	err = updateVersion();
+	MojErrCheck(err);
+
+    LOG_DEBUG("[db_mojodb] retokenized %u objects", countOut);
+
+	return MojErrNone;
+}
+
 MojErr MojDb::updateLocaleImpl(const MojString& oldLocale, const MojString& newLocale, MojDbReq& req)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
@@ -473,8 +523,8 @@ MojErr MojDb::updateLocaleImpl(const MojString& oldLocale, const MojString& newL
 	return MojErrNone;
 }
 
-MojErr MojDb::dumpImpl(MojFile& file, bool backup, bool incDel, const MojObject& revParam, const MojObject& delRevParam, bool skipKinds, MojUInt32& countOut, MojDbReq& req,
-		MojObject* response, const MojChar* keyName, MojSize& bytesWritten, MojSize& warns, MojUInt32 maxBytes)
+MojErr MojDb::dumpImpl(MojDbDumpWriter& writer, bool backup, bool incDel, const MojObject& revParam, const MojObject& delRevParam, bool skipKinds, MojUInt32& countOut, MojDbReq& req,
+		MojObject* response, const MojChar* keyName, MojSize& warns, MojUInt32 maxBytes)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
@@ -526,7 +576,7 @@ MojErr MojDb::dumpImpl(MojFile& file, bool backup, bool incDel, const MojObject&
 		}
 
 		// write out each object, if the backup is full, insert the appropriate incremental key
-		err = dumpObj(file, obj, bytesWritten, maxBytes);
+		err = dumpObj(writer, obj, maxBytes);
 		MojErrCatch(err, MojErrDbBackupFull) {
 			if (response) {
 				MojErr errBackup = MojErrNone;
@@ -566,26 +616,176 @@ MojErr MojDb::dumpImpl(MojFile& file, bool backup, bool incDel, const MojObject&
 	return MojErrNone;
 }
 
-MojErr MojDb::dumpObj(MojFile& file, MojObject obj, MojSize& bytesWrittenOut, MojUInt32 maxBytes)
+struct MojDb::DumpState
+{
+	DumpState(MojDb& db, MojDbDumpWriter& writer)
+	: m_db(db), m_writer(writer), m_next(0), m_count(0), m_warns(0), m_err(MojErrNone) {}
+
+	MojDb& m_db;
+	MojDbDumpWriter& m_writer;
+	MojThreadMutex m_mutex;
+	MojVector<MojString> m_kinds;
+	MojSize m_next;
+	MojUInt32 m_count;
+	MojSize m_warns;
+	MojErr m_err;
+};
+
+MojErr MojDb::dumpKinds(MojDbDumpWriter& writer, MojUInt32& countOut, MojSize& warns)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
-	// remove the rev key before dumping the object
-	bool found = false;
-	MojErr err = obj.del(RevKey, found);
+	// every object belongs to exactly one kind. The root kind holds none of its own, and
+	// kind objects were written out ahead of everything else.
+	DumpState state(*this, writer);
+	MojDbKindEngine::KindMap& kinds = m_kindEngine.kindMap();
+	for (MojDbKindEngine::KindMap::ConstIterator i = kinds.begin(); i != kinds.end(); ++i) {
+		if (i.key() == MojDbKindEngine::RootKindId || i.key() == MojDbKindEngine::KindKindId)
+			continue;
+		MojErr err = state.m_kinds.push(i.key());
+		MojErrCheck(err);
+	}
+
+	// the threads take the next kind as they finish one, so a few big kinds do not leave the others idle
+	MojSize numThreads = (MojSize) m_dumpThreads;
+	if (numThreads > state.m_kinds.size())
+		numThreads = state.m_kinds.size();
+	MojVector<MojThreadT> threads;
+	MojErr err = threads.reserve(numThreads);
+	MojErrCheck(err);
+	for (MojSize i = 0; i < numThreads; ++i) {
+		MojThreadT thread = MojInvalidThread;
+		err = MojThreadCreate(thread, &dumpThread, &state);
+		if (err != MojErrNone) {
+			// keep the threads that did start from picking up any more kinds
+			MojThreadGuard guard(state.m_mutex);
+			if (state.m_err == MojErrNone)
+				state.m_err = err;
+			break;
+		}
+		// reserved above, so this cannot fail and leave a thread behind
+		err = threads.push(thread);
+		MojAssert(err == MojErrNone);
+	}
+	for (MojVector<MojThreadT>::ConstIterator i = threads.begin(); i != threads.end(); ++i) {
+		MojErr threadErr = MojErrNone;
+		err = MojThreadJoin(*i, threadErr);
+		MojErrAccumulate(state.m_err, err);
+		MojErrAccumulate(state.m_err, threadErr);
+	}
+	MojErrCheck(state.m_err);
+
+	countOut += state.m_count;
+	warns = state.m_warns;
+    if (warns > 0) {
+        LOG_WARNING(MSGID_MOJ_DB_ADMIN_WARNING, 1,
+            PMLOGKFV("warn", "%d", (int)warns),
+            "Finished Backup with 'warn' warnings");
+    } else {
+        LOG_DEBUG("[db_mojodb] Finished Backup with no warnings \n");
+    }
+	return MojErrNone;
+}
+
+MojErr MojDb::dumpKind(const MojString& kindId, DumpState& state, MojDbDumpWriter::Chunk& chunk, MojUInt32& countOut, MojSize& warnsOut)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	MojDbReq req;
+	MojErr err = beginReq(req);
 	MojErrCheck(err);
 
-	MojString str;
-	err = obj.toJson(str);
+	MojDbQuery query;
+	err = query.from(kindId);
 	MojErrCheck(err);
-	err = str.append(_T("\n"));
+	MojDbCursor cursor;
+	err = findImpl(query, cursor, NULL, req, OpRead);
 	MojErrCheck(err);
-	MojSize len = str.length() * sizeof(MojChar);
-	// if writing this object will put us over the max length, throw an error
-	if (maxBytes && bytesWrittenOut + len > maxBytes) {
-		MojErrThrow(MojErrDbBackupFull);
+
+	for (;;) {
+		bool found = false;
+		MojObject obj;
+		err = cursor.get(obj, found);
+		// skip ghost keys, as dumpImpl does
+		if (err == MojErrInternalIndexOnFind) {
+			warnsOut++;
+			continue;
+		}
+		MojErrCheck(err);
+		if (!found)
+			break;
+
+		// a kind's indexes also hold the objects of the kinds that extend it
+		MojString kind;
+		err = obj.getRequired(KindKey, kind);
+		MojErrCheck(err);
+		if (kind != kindId)
+			continue;
+
+		bool deleted = false;
+		err = obj.del(RevKey, deleted);
+		MojErrCheck(err);
+		err = chunk.append(obj);
+		MojErrCheck(err);
+		if (chunk.size() >= state.m_writer.chunkSize()) {
+			err = state.m_writer.writeChunk(chunk);
+			MojErrCheck(err);
+		}
+		countOut++;
 	}
-	err = file.writeString(str, bytesWrittenOut);
+	err = cursor.close();
+	MojErrCheck(err);
+	err = req.end();
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDb::dumpThread(void* arg)
+{
+	DumpState* state = (DumpState*) arg;
+	MojAssert(state);
+
+	MojDbDumpWriter::Chunk chunk(state->m_writer.format());
+	MojErr err = MojErrNone;
+	for (;;) {
+		MojThreadGuard guard(state->m_mutex);
+		if (state->m_err != MojErrNone || state->m_next == state->m_kinds.size())
+			break;
+		const MojString& kindId = state->m_kinds.at(state->m_next++);
+		guard.unlock();
+
+		MojUInt32 count = 0;
+		MojSize warns = 0;
+		err = state->m_db.dumpKind(kindId, *state, chunk, count, warns);
+
+		guard.lock();
+		state->m_count += count;
+		state->m_warns += warns;
+		if (err != MojErrNone) {
+			if (state->m_err == MojErrNone)
+				state->m_err = err;
+			return MojErrNone;
+		}
+	}
+	// objects of the last kinds may still sit in our chunk
+	err = state->m_writer.writeChunk(chunk);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDb::dumpObj(MojDbDumpWriter& writer, MojObject obj, MojUInt32 maxBytes)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	// remove the rev key before dumping the object
+	bool found = false;
+	MojErr err = obj.del(RevKey, found);
+	MojErrCheck(err);
+
+	// if writing this object will put us over the max length, the writer throws MojErrDbBackupFull
+	err = writer.write(obj, maxBytes);
 	MojErrCheck(err);
 
 	return MojErrNone;
@@ -648,6 +848,15 @@ MojErr MojDb::loadImpl(MojObject& obj, MojUInt32 flags, MojDbReq& req)
 	bool deleted = false;
 	obj.get(MojDb::DelKey, deleted);
 
+	// kind and permission changes can drop or rebuild indexes, so keys a bulk load
+	// is still holding back have to be written first
+	bool schemaObj = kindName.startsWith(MojDbKindEngine::KindKindIdPrefix) ||
+		kindName.startsWith(MojDbKindEngine::PermissionIdPrefix);
+	if (schemaObj && req.txn()) {
+		err = req.txn()->flushIndexKeys();
+		MojErrCheck(err);
+	}
+
 	// when loading objects, if the object is deleted, call delKind/del
 	// otherwise, call putKind, putPermissions or put depending on the kind
 	if (deleted) {
@@ -753,5 +962,93 @@ MojErr MojDb::purgeImpl(MojObject& obj, MojUInt32& countOut, MojDbReq& req)
 	MojErrCheck(err);
 
 
+	return MojErrNone;
+}
+
+MojErr MojDb::retokenizeImpl(bool incDel, MojUInt32& countOut, MojDbReq& req)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	MojDbQuery query;
+	MojErr err = query.from(MojDbKindEngine::RootKindId);
+	MojErrCheck(err);
+	err = query.where(DelKey, MojDbQuery::OpEq, incDel);
+	MojErrCheck(err);
+	query.limit(AutoBatchSize);
+
+	for (;;) {
+		// read a page, then rewrite it with the cursor closed so that the batch can be committed
+		MojVector<MojObject> objs;
+		MojDbQuery::Page page;
+		MojDbCursor cursor;
+		err = findImpl(query, cursor, NULL, req, OpRead);
+		MojErrCheck(err);
+		for (;;) {
+			bool found = false;
+			MojObject obj;
+			err = cursor.get(obj, found);
+			// skip ghost keys, as dump does
+			if (err == MojErrInternalIndexOnFind)
+				continue;
+			MojErrCheck(err);
+			if (!found)
+				break;
+			err = objs.push(obj);
+			MojErrCheck(err);
+		}
+		err = cursor.nextPage(page);
+		MojErrCheck(err);
+		err = cursor.close();
+		MojErrCheck(err);
+
+		for (MojVector<MojObject>::ConstIterator i = objs.begin(); i != objs.end(); ++i) {
+			MojObject obj(*i);
+			err = retokenizeObj(obj, req);
+			MojErrCheck(err);
+		}
+		countOut += (MojUInt32) objs.size();
+
+		if (page.empty())
+			break;
+		query.page(page);
+		err = commitBatch(req);
+		MojErrCheck(err);
+	}
+	return MojErrNone;
+}
+
+MojErr MojDb::retokenizeObj(MojObject& obj, MojDbReq& req)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	MojObject id;
+	MojErr err = obj.getRequired(IdKey, id);
+	MojErrCheck(err);
+	MojRefCountedPtr<MojDbStorageItem> item;
+	err = m_objDb->get(id, req.txn(), true, item);
+	MojErrCheck(err);
+	if (!item.get())
+		return MojErrNone;
+
+	// same serialization as putObj, but the rev and indexes are left as they are
+	MojDbObjectHeader header(id);
+	err = header.extractFrom(obj);
+	MojErrCheck(err);
+	MojTokenSet tokenSet;
+	err = m_kindEngine.tokenSet(header.kindId(), tokenSet);
+	MojErrCheck(err);
+	MojBuffer buf;
+	err = header.write(buf, m_kindEngine);
+	MojErrCheck(err);
+	MojObjectWriter writer(buf, &tokenSet);
+	err = obj.visit(writer);
+	MojErrCheck(err);
+	MojDbKind* kind = NULL;
+	err = m_kindEngine.getKind(header.kindId().data(), kind);
+	MojErrCheck(err);
+	err = kind->compress() ? m_objDb->updateCompressed(id, buf, item.get(), req.txn())
+						   : m_objDb->update(id, buf, item.get(), req.txn());
+	MojErrCheck(err);
+
 	return MojErrNone;
 }
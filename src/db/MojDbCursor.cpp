@@ -22,11 +22,15 @@
 #include "db/MojDb.h"
 #include "db/MojDbIndex.h"
 
+const MojChar* const MojDbCursor::EstimatedKeysKey = _T("estimatedKeys");
+const MojChar* const MojDbCursor::ScannedKeysKey = _T("scannedKeys");
+
 MojDbCursor::MojDbCursor()
 : m_ownTxn(true),
   m_lastErr(MojErrNone),
   m_kindEngine(NULL),
-  m_dbIndex(NULL)
+  m_dbIndex(NULL),
+  m_estimate(MojInvalidSize)
 {
 }
 
@@ -69,9 +73,11 @@ MojErr MojDbCursor::close()
     m_txn.reset();
 
 	m_objectFilter.reset();
+	m_selectProps.clear();
 	m_watcher.reset();
 	m_query.clear();
     m_dbIndex = NULL;
+	m_estimate = MojInvalidSize;
 
 	return err;
 }
@@ -143,13 +149,40 @@ MojErr MojDbCursor::count(MojUInt32& countOut)
 	if (!m_storageQuery.get())
 		MojErrThrow(MojErrNotOpen);
 
-	MojErr err = m_storageQuery->count(countOut);
-	MojErrAccumulate(m_lastErr, err);
-	MojErrCheck(err);
+	// a query for the whole kind is answered from the count its index keeps
+	bool counted = false;
+	MojErr err = MojErrNone;
+	if (countsWholeIndex()) {
+		err = m_dbIndex->liveCount(m_txn.get(), countOut, counted);
+		MojErrAccumulate(m_lastErr, err);
+		MojErrCheck(err);
+	}
+	if (!counted) {
+		err = m_storageQuery->count(countOut);
+		MojErrAccumulate(m_lastErr, err);
+		MojErrCheck(err);
+	}
 
 	return MojErrNone;
 }
 
+bool MojDbCursor::countsWholeIndex()
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	if (!m_dbIndex || !m_kindEngine || !m_txn.get())
+		return false;
+	if (!m_query.where().empty() || !m_query.filter().empty() ||
+		!m_query.distinct().empty() || !m_query.page().empty())
+		return false;
+	if (!m_storageQuery->excludeKinds().empty())
+		return false;
+	// the count includes objects on every shard
+	if (m_query.ignoreInactiveShards() && m_kindEngine->db()->shardEngine()->hasInactiveShards())
+		return false;
+	return true;
+}
+
 MojErr MojDbCursor::nextPage(MojDbQuery::Page& pageOut)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
@@ -164,6 +197,28 @@ MojErr MojDbCursor::nextPage(MojDbQuery::Page& pageOut)
 	return MojErrNone;
 }
 
+MojErr MojDbCursor::explain(MojObject& objOut)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	if (!m_storageQuery.get() || !m_dbIndex)
+		MojErrThrow(MojErrNotOpen);
+
+	MojErr err = m_dbIndex->explain(m_query, objOut);
+	MojErrCheck(err);
+	if (m_estimate == MojInvalidSize) {
+		// only one index could answer the query, so no estimate was made when choosing it
+		err = m_dbIndex->estimate(m_query, m_txn.get(), m_estimate);
+		MojErrCheck(err);
+	}
+	err = objOut.put(EstimatedKeysKey, (MojInt64) m_estimate);
+	MojErrCheck(err);
+	err = objOut.put(ScannedKeysKey, (MojInt64) m_storageQuery->keysScanned());
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
 MojErr MojDbCursor::init(const MojDbQuery& query)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
@@ -185,6 +240,12 @@ MojErr MojDbCursor::initImpl(const MojDbQuery& query)
 		MojAllocCheck(m_objectFilter.get());
 		MojErr err = m_objectFilter->init(query.select());
 		MojErrCheck(err);
+		// only the roots of selected props need to be read from storage
+		m_selectProps.clear();
+		for (MojDbQuery::StringSet::ConstIterator i = query.select().begin(); i != query.select().end(); ++i) {
+			err = addRootProp(*i, m_selectProps);
+			MojErrCheck(err);
+		}
 	}
 	if (!query.filter().empty()) {
 		m_queryFilter.reset(new MojDbQueryFilter);
@@ -209,7 +270,7 @@ MojErr MojDbCursor::visitObject(MojObjectVisitor& visitor, bool& foundOut)
 	if (foundOut) {
 		if (m_objectFilter.get() != NULL) {
 			m_objectFilter->setVisitor(&visitor);
-			err = item->visit(*(m_objectFilter.get()), *m_kindEngine);
+			err = item->visitProps(*(m_objectFilter.get()), *m_kindEngine, m_selectProps);
 			MojErrAccumulate(m_lastErr, err);
 			MojErrCheck(err);
 		} else {
@@ -223,6 +284,22 @@ MojErr MojDbCursor::visitObject(MojObjectVisitor& visitor, bool& foundOut)
 	return MojErrNone;
 }
 
+MojErr MojDbCursor::addRootProp(const MojString& path, MojDbStorageItem::PropSet& propsOut)
+{
+	MojSize dot = path.find(_T('.'));
+	if (dot == MojInvalidIndex) {
+		MojErr err = propsOut.put(path);
+		MojErrCheck(err);
+	} else {
+		MojString root;
+		MojErr err = path.substring(0, dot, root);
+		MojErrCheck(err);
+		err = propsOut.put(root);
+		MojErrCheck(err);
+	}
+	return MojErrNone;
+}
+
 void MojDbCursor::txn(MojDbStorageTxn* txn, bool ownTxn)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
@@ -0,0 +1,418 @@
+/* @@@LICENSE
+*
+*  Copyright (c) 2014 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+#include "db/MojDbDump.h"
+#include "core/MojLogDb8.h"
+#include <boost/crc.hpp>
+#ifdef MOJ_USE_SNAPPY
+#include <snappy.h>
+#endif
+
+const MojChar* const MojDbDumpWriter::FormatKey = _T("dumpFormat");
+const MojChar* const MojDbDumpWriter::CompressKey = _T("dumpCompress");
+const MojChar* const MojDbDumpWriter::ThreadsKey = _T("dumpThreads");
+const MojChar* const MojDbDumpWriter::FormatJsonName = _T("json");
+const MojChar* const MojDbDumpWriter::FormatBinaryName = _T("binary");
+// starts with a byte that can never begin a json dump
+const MojByte MojDbDumpWriter::Magic[] = { 0x89, 'M', 'O', 'J', 'D', 'U', 'M', 'P' };
+
+static void putUInt32(MojByte* dest, MojUInt32 val)
+{
+	val = MojUInt32ToBigEndian(val);
+	MojMemCpy(dest, &val, sizeof(val));
+}
+
+static MojUInt32 checksum(const MojByte* data, MojSize size)
+{
+	boost::crc_32_type crc;
+	crc.process_bytes(data, size);
+	return crc.checksum();
+}
+
+MojErr MojDbDumpWriter::Chunk::append(const MojObject& obj)
+{
+	if (m_format == FormatJson) {
+		MojErr err = m_jsonWriter.reset();
+		MojErrCheck(err);
+		err = obj.visit(m_jsonWriter);
+		MojErrCheck(err);
+		const MojString& json = m_jsonWriter.json();
+		err = m_data.append((const MojByte*) json.begin(), (const MojByte*) json.end());
+		MojErrCheck(err);
+		err = m_data.push('\n');
+		MojErrCheck(err);
+	} else {
+		MojErr err = m_writer.reset();
+		MojErrCheck(err);
+		err = obj.visit(m_writer);
+		MojErrCheck(err);
+		const MojByte* bytes = NULL;
+		MojSize size = 0;
+		err = m_writer.buf().data(bytes, size);
+		MojErrCheck(err);
+		MojByte len[sizeof(MojUInt32)];
+		putUInt32(len, (MojUInt32) size);
+		err = m_data.append(len, len + sizeof(len));
+		MojErrCheck(err);
+		err = m_data.append(bytes, bytes + size);
+		MojErrCheck(err);
+	}
+	return MojErrNone;
+}
+
+MojDbDumpWriter::MojDbDumpWriter()
+: m_format(FormatJson),
+  m_compress(false),
+  m_chunkSize(ChunkSizeDefault),
+  m_bytesWritten(0),
+  m_chunk(FormatJson)
+{
+}
+
+MojErr MojDbDumpWriter::open(const MojChar* path, Format format, bool compress, MojSize chunkSize)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(path);
+
+	m_format = format;
+	m_compress = compress;
+	m_chunkSize = chunkSize;
+	m_bytesWritten = 0;
+	m_chunk.m_format = format;
+	m_chunk.clear();
+
+	MojErr err = m_file.open(path, MOJ_O_WRONLY | MOJ_O_CREAT | MOJ_O_TRUNC, MOJ_S_IRUSR | MOJ_S_IWUSR);
+	MojErrCheck(err);
+	if (format == FormatBinary) {
+		err = writeBytes(Magic, MagicSize);
+		MojErrCheck(err);
+		MojByte version = Version;
+		err = writeBytes(&version, sizeof(version));
+		MojErrCheck(err);
+	}
+	return MojErrNone;
+}
+
+MojErr MojDbDumpWriter::close()
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	MojErr err = writeChunk(m_chunk);
+	MojErrCheck(err);
+	err = m_file.close();
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbDumpWriter::write(const MojObject& obj, MojUInt32 maxBytes)
+{
+	MojSize prevSize = m_chunk.size();
+	MojErr err = m_chunk.append(obj);
+	MojErrCheck(err);
+	// count a binary chunk as stored uncompressed, so we never go over
+	MojSize pending = m_chunk.size() + (m_format == FormatBinary ? ChunkHeaderSize : 0);
+	if (maxBytes && m_bytesWritten + pending > maxBytes) {
+		err = m_chunk.truncate(prevSize);
+		MojErrCheck(err);
+		MojErrThrow(MojErrDbBackupFull);
+	}
+	if (m_chunk.size() >= m_chunkSize) {
+		err = writeChunk(m_chunk);
+		MojErrCheck(err);
+	}
+	return MojErrNone;
+}
+
+MojErr MojDbDumpWriter::writeChunk(Chunk& chunk)
+{
+	if (chunk.empty())
+		return MojErrNone;
+
+	// compress and checksum before taking the lock so that threads only queue up for the write itself
+	MojByte header[ChunkHeaderSize];
+	const MojByte* stored = NULL;
+	MojSize storedSize = 0;
+	MojErr err = encode(chunk, header, stored, storedSize);
+	MojErrCheck(err);
+
+	MojThreadGuard guard(m_mutex);
+	if (m_format == FormatBinary) {
+		err = writeBytes(header, ChunkHeaderSize);
+		MojErrCheck(err);
+	}
+	err = writeBytes(stored, storedSize);
+	MojErrCheck(err);
+	guard.unlock();
+	chunk.clear();
+
+	return MojErrNone;
+}
+
+MojErr MojDbDumpWriter::parseFormat(const MojString& name, Format& formatOut)
+{
+	if (name == FormatJsonName) {
+		formatOut = FormatJson;
+	} else if (name == FormatBinaryName) {
+		formatOut = FormatBinary;
+	} else {
+		MojErrThrowMsg(MojErrInvalidArg, _T("db: unknown dump format '%s'"), name.data());
+	}
+	return MojErrNone;
+}
+
+MojErr MojDbDumpWriter::encode(Chunk& chunk, MojByte* header, const MojByte*& storedOut, MojSize& storedSizeOut)
+{
+	storedOut = chunk.m_data.begin();
+	storedSizeOut = chunk.m_data.size();
+	if (m_format == FormatJson)
+		return MojErrNone;
+
+	MojByte flags = 0;
+#ifdef MOJ_USE_SNAPPY
+	if (m_compress) {
+		MojErr err = chunk.m_compressed.resize(snappy::MaxCompressedLength(storedSizeOut));
+		MojErrCheck(err);
+		MojVector<MojByte>::Iterator begin;
+		err = chunk.m_compressed.begin(begin);
+		MojErrCheck(err);
+		size_t compressedSize = 0;
+		snappy::RawCompress((const char*) storedOut, storedSizeOut, (char*) begin, &compressedSize);
+		if (compressedSize < storedSizeOut) {
+			storedOut = begin;
+			storedSizeOut = compressedSize;
+			flags |= FlagCompressed;
+		}
+	}
+#endif
+	putUInt32(header, (MojUInt32) chunk.m_data.size());
+	putUInt32(header + 4, (MojUInt32) storedSizeOut);
+	putUInt32(header + 8, checksum(storedOut, storedSizeOut));
+	header[12] = flags;
+
+	return MojErrNone;
+}
+
+MojErr MojDbDumpWriter::writeBytes(const MojByte* data, MojSize size)
+{
+	while (size > 0) {
+		MojSize written = 0;
+		MojErr err = m_file.write(data, size, written);
+		MojErrCheck(err);
+		size -= written;
+		data += written;
+		m_bytesWritten += written;
+	}
+	return MojErrNone;
+}
+
+MojDbDumpReader::MojDbDumpReader()
+: m_format(MojDbDumpWriter::FormatJson),
+  m_bufBegin(NULL),
+  m_pos(NULL),
+  m_end(NULL),
+  m_eof(false)
+{
+}
+
+MojErr MojDbDumpReader::open(const MojChar* path)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(path);
+
+	MojErr err = m_file.open(path, MOJ_O_RDONLY);
+	MojErrCheck(err);
+	err = m_buf.resize(ReadBufSize);
+	MojErrCheck(err);
+	err = m_buf.begin(m_bufBegin);
+	MojErrCheck(err);
+	m_parser.begin();
+
+	// anything that does not start with the magic is a json dump, and what we read is its first bytes
+	MojSize headerSize = MojDbDumpWriter::MagicSize + sizeof(MojDbDumpWriter::Version);
+	MojSize size = 0;
+	err = readFully((MojByte*) m_bufBegin, headerSize, size);
+	MojErrCheck(err);
+	if (size == headerSize && MojMemCmp(m_bufBegin, MojDbDumpWriter::Magic, MojDbDumpWriter::MagicSize) == 0) {
+		MojByte version = (MojByte) m_bufBegin[MojDbDumpWriter::MagicSize];
+		if (version != MojDbDumpWriter::Version)
+			MojErrThrowMsg(MojErrDbVersionMismatch, _T("db: unsupported dump version %u"), (MojUInt32) version);
+		m_format = MojDbDumpWriter::FormatBinary;
+	} else {
+		m_format = MojDbDumpWriter::FormatJson;
+		m_pos = m_bufBegin;
+		m_end = m_pos + size;
+	}
+	return MojErrNone;
+}
+
+MojErr MojDbDumpReader::next(bool& foundOut)
+{
+	foundOut = false;
+	// we only ever stop between objects, so the last one can go
+	MojErr err = m_builder.reset();
+	MojErrCheck(err);
+
+	if (m_format == MojDbDumpWriter::FormatBinary) {
+		err = nextBinary(foundOut);
+		MojErrCheck(err);
+	} else {
+		err = nextJson(foundOut);
+		MojErrCheck(err);
+	}
+	return MojErrNone;
+}
+
+MojErr MojDbDumpReader::fill()
+{
+	MojSize size = 0;
+	MojErr err = m_file.read(m_bufBegin, m_buf.size(), size);
+	MojErrCheck(err);
+	m_pos = m_bufBegin;
+	m_end = m_pos + size;
+	m_eof = (size == 0);
+
+	return MojErrNone;
+}
+
+MojErr MojDbDumpReader::nextJson(bool& foundOut)
+{
+	for (;;) {
+		while (m_pos < m_end) {
+			MojErr err = m_parser.parseChunk(m_builder, m_pos, m_end - m_pos, m_pos);
+			MojErrCheck(err);
+			if (m_parser.finished()) {
+				m_parser.begin();
+				foundOut = true;
+				return MojErrNone;
+			}
+		}
+		if (m_eof)
+			return MojErrNone;
+		MojErr err = fill();
+		MojErrCheck(err);
+		if (m_eof) {
+			err = m_parser.end(m_builder);
+			MojErrCheck(err);
+			foundOut = m_parser.finished();
+			return MojErrNone;
+		}
+	}
+}
+
+MojErr MojDbDumpReader::nextBinary(bool& foundOut)
+{
+	while (m_reader.available() == 0) {
+		bool found = false;
+		MojErr err = readChunk(found);
+		MojErrCheck(err);
+		if (!found)
+			return MojErrNone;
+	}
+	MojUInt32 size = 0;
+	MojErr err = m_reader.readUInt32(size);
+	MojErrCheck(err);
+	if (m_reader.available() < size)
+		MojErrThrowMsg(MojErrDbCorruptDatabase, _T("db: dump record runs past the end of its chunk"));
+	err = MojObjectReader::read(m_builder, m_reader.pos(), size);
+	MojErrCheck(err);
+	err = m_reader.skip(size);
+	MojErrCheck(err);
+	foundOut = true;
+
+	return MojErrNone;
+}
+
+MojErr MojDbDumpReader::readChunk(bool& foundOut)
+{
+	foundOut = false;
+	MojByte header[MojDbDumpWriter::ChunkHeaderSize];
+	MojSize size = 0;
+	MojErr err = readFully(header, sizeof(header), size);
+	MojErrCheck(err);
+	if (size == 0)
+		return MojErrNone;
+	if (size < sizeof(header))
+		MojErrThrowMsg(MojErrDbCorruptDatabase, _T("db: truncated dump chunk header"));
+
+	MojDataReader headerReader(header, sizeof(header));
+	MojUInt32 rawSize = 0;
+	MojUInt32 storedSize = 0;
+	MojUInt32 crc = 0;
+	MojByte flags = 0;
+	err = headerReader.readUInt32(rawSize);
+	MojErrCheck(err);
+	err = headerReader.readUInt32(storedSize);
+	MojErrCheck(err);
+	err = headerReader.readUInt32(crc);
+	MojErrCheck(err);
+	err = headerReader.readUInt8(flags);
+	MojErrCheck(err);
+
+	err = m_stored.resize(storedSize);
+	MojErrCheck(err);
+	MojVector<MojByte>::Iterator stored;
+	err = m_stored.begin(stored);
+	MojErrCheck(err);
+	err = readFully(stored, storedSize, size);
+	MojErrCheck(err);
+	if (size < storedSize)
+		MojErrThrowMsg(MojErrDbCorruptDatabase, _T("db: truncated dump chunk"));
+	if (checksum(stored, storedSize) != crc)
+		MojErrThrowMsg(MojErrDbCorruptDatabase, _T("db: dump chunk checksum mismatch"));
+
+	if (flags & MojDbDumpWriter::FlagCompressed) {
+#ifdef MOJ_USE_SNAPPY
+		size_t len = 0;
+		if (!snappy::GetUncompressedLength((const char*) stored, storedSize, &len) || len != rawSize)
+			MojErrThrowMsg(MojErrDbCorruptDatabase, _T("db: corrupt compressed dump chunk"));
+		err = m_chunk.resize(rawSize);
+		MojErrCheck(err);
+		MojVector<MojByte>::Iterator raw;
+		err = m_chunk.begin(raw);
+		MojErrCheck(err);
+		if (!snappy::RawUncompress((const char*) stored, storedSize, (char*) raw))
+			MojErrThrowMsg(MojErrDbCorruptDatabase, _T("db: corrupt compressed dump chunk"));
+		m_reader.data(raw, rawSize);
+#else
+		MojErrThrowMsg(MojErrNotImplemented, _T("db: compressed dump, but built without snappy"));
+#endif
+	} else {
+		if (rawSize != storedSize)
+			MojErrThrowMsg(MojErrDbCorruptDatabase, _T("db: dump chunk size mismatch"));
+		m_reader.data(stored, storedSize);
+	}
+	foundOut = true;
+
+	return MojErrNone;
+}
+
+MojErr MojDbDumpReader::readFully(MojByte* buf, MojSize size, MojSize& sizeOut)
+{
+	sizeOut = 0;
+	while (sizeOut < size) {
+		MojSize read = 0;
+		MojErr err = m_file.read(buf + sizeOut, size - sizeOut, read);
+		MojErrCheck(err);
+		if (read == 0)
+			break;
+		sizeOut += read;
+	}
+	return MojErrNone;
+}
@@ -0,0 +1,481 @@
+/* @@@LICENSE
+*
+*  Copyright (c) 2014 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#include "db/MojDbExternalSorter.h"
+#include "core/MojLogDb8.h"
+#include "core/MojOs.h"
+
+int MojDbExternalSorter::RecordComp::operator()(const Record& r1, const Record& r2) const
+{
+	int res = r1.m_key.compare(r2.m_key);
+	if (res != 0)
+		return m_descKeys ? -res : res;
+	res = r1.m_id.compare(r2.m_id);
+	return m_descIds ? -res : res;
+}
+
+MojErr MojDbExternalSorter::Run::open(const MojChar* path)
+{
+	MojAssert(path);
+
+	MojErr err = m_file.open(path, MOJ_O_RDONLY);
+	MojErrCheck(err);
+	// the open descriptor keeps the data alive, so nothing is left behind if we fail later
+	err = MojUnlink(path);
+	MojErrCheck(err);
+	err = next();
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbExternalSorter::Run::next()
+{
+	bool eof = false;
+	MojErr err = readKey(m_rec.m_key, eof);
+	MojErrCheck(err);
+	if (eof) {
+		m_eof = true;
+		return MojErrNone;
+	}
+	err = readKey(m_rec.m_id, eof);
+	MojErrCheck(err);
+	if (eof)
+		MojErrThrowMsg(MojErrDbCorruptDatabase, _T("db: truncated sort run"));
+
+	return MojErrNone;
+}
+
+MojErr MojDbExternalSorter::Run::read(MojByte* dest, MojSize len, MojSize& readOut)
+{
+	readOut = 0;
+	while (len > 0) {
+		if (m_pos == m_end) {
+			MojErr err = m_file.read(m_buf, sizeof(m_buf), m_end);
+			MojErrCheck(err);
+			m_pos = 0;
+			if (m_end == 0)
+				return MojErrNone;
+		}
+		MojSize chunk = MojMin(len, m_end - m_pos);
+		MojMemCpy(dest, m_buf + m_pos, chunk);
+		m_pos += chunk;
+		dest += chunk;
+		len -= chunk;
+		readOut += chunk;
+	}
+	return MojErrNone;
+}
+
+MojErr MojDbExternalSorter::Run::readKey(MojDbKey& keyOut, bool& eofOut)
+{
+	// the run may only end between records; anything short of that was truncated
+	eofOut = false;
+	MojUInt32 len = 0;
+	MojSize got = 0;
+	MojErr err = read((MojByte*) &len, sizeof(len), got);
+	MojErrCheck(err);
+	if (got == 0) {
+		eofOut = true;
+		return MojErrNone;
+	}
+	if (got != sizeof(len))
+		MojErrThrowMsg(MojErrDbCorruptDatabase, _T("db: truncated sort run"));
+
+	if (len <= MojDbKey::InlineSize) {
+		MojByte buf[MojDbKey::InlineSize];
+		err = read(buf, len, got);
+		MojErrCheck(err);
+		if (got != len)
+			MojErrThrowMsg(MojErrDbCorruptDatabase, _T("db: truncated sort run"));
+		err = keyOut.assign(buf, len);
+		MojErrCheck(err);
+		return MojErrNone;
+	}
+	MojDbKey::ByteVec vec;
+	err = vec.resize(len);
+	MojErrCheck(err);
+	MojDbKey::ByteVec::Iterator begin;
+	err = vec.begin(begin);
+	MojErrCheck(err);
+	err = read(begin, len, got);
+	MojErrCheck(err);
+	if (got != len)
+		MojErrThrowMsg(MojErrDbCorruptDatabase, _T("db: truncated sort run"));
+	// the key shares the vector rather than copying it
+	keyOut = vec;
+
+	return MojErrNone;
+}
+
+MojDbExternalSorter::MojDbExternalSorter()
+: m_runBytes(RunBytesDefault),
+  m_bytes(0),
+  m_count(0),
+  m_runCount(0),
+  m_mergeCount(0),
+  m_memPos(0),
+  m_writeLen(0),
+  m_finished(false)
+{
+}
+
+MojDbExternalSorter::~MojDbExternalSorter()
+{
+	MojErr err = close();
+	MojErrCatchAll(err);
+}
+
+MojErr MojDbExternalSorter::open(const MojChar* tmpDir, MojSize runBytes, bool descKeys, bool descIds)
+{
+	LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(tmpDir);
+
+	MojErr err = close();
+	MojErrCheck(err);
+	err = m_tmpDir.assign(tmpDir);
+	MojErrCheck(err);
+	m_runBytes = runBytes;
+	m_comp = RecordComp(descKeys, descIds);
+
+	return MojErrNone;
+}
+
+MojErr MojDbExternalSorter::close()
+{
+	MojErr err = MojErrNone;
+	for (RunVec::ConstIterator i = m_runs.begin(); i != m_runs.end(); ++i) {
+		delete *i;
+	}
+	// runs that were never opened are still on disk
+	for (PathVec::ConstIterator i = m_paths.begin(); i != m_paths.end(); ++i) {
+		MojErr errUnlink = MojUnlink(*i);
+		MojErrAccumulate(err, errUnlink);
+	}
+	m_runs.clear();
+	m_paths.clear();
+	m_records.clear();
+	m_bytes = 0;
+	m_count = 0;
+	m_runCount = 0;
+	m_mergeCount = 0;
+	m_memPos = 0;
+	m_writeLen = 0;
+	m_finished = false;
+
+	return err;
+}
+
+MojErr MojDbExternalSorter::put(const MojDbKey& key, const MojDbKey& id)
+{
+	MojAssert(!m_finished);
+
+	Record rec;
+	rec.m_key = key;
+	rec.m_id = id;
+	MojErr err = m_records.push(rec);
+	MojErrCheck(err);
+	m_bytes += sizeof(Record) + key.size() + id.size();
+	++m_count;
+
+	if (m_bytes >= m_runBytes) {
+		err = spill();
+		MojErrCheck(err);
+	}
+	return MojErrNone;
+}
+
+MojErr MojDbExternalSorter::finish()
+{
+	LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(!m_finished);
+
+	m_finished = true;
+	if (m_runCount == 0) {
+		// everything fit in one run, so serve it straight from memory
+		RecordVec::Iterator begin;
+		MojErr err = m_records.begin(begin);
+		MojErrCheck(err);
+		MojQuickSort<Record, RecordComp>(begin, m_records.size(), m_comp);
+		m_memPos = 0;
+		return MojErrNone;
+	}
+
+	MojErr err = MojErrNone;
+	if (!m_records.empty()) {
+		err = spill();
+		MojErrCheck(err);
+	}
+	// each open run holds a descriptor and a read buffer, so fold the oldest runs
+	// together until the rest can be merged in a single pass
+	while (m_paths.size() > MaxOpenRuns) {
+		err = mergeRuns(MaxOpenRuns);
+		MojErrCheck(err);
+	}
+	err = openRuns(m_paths.size());
+	MojErrCheck(err);
+	heapify();
+
+	return MojErrNone;
+}
+
+MojErr MojDbExternalSorter::next(MojDbKey& keyOut, MojDbKey& idOut, bool& foundOut)
+{
+	MojAssert(m_finished);
+
+	foundOut = false;
+	if (m_runCount == 0) {
+		if (m_memPos < m_records.size()) {
+			const Record& rec = m_records.at(m_memPos++);
+			keyOut = rec.m_key;
+			idOut = rec.m_id;
+			foundOut = true;
+		}
+		return MojErrNone;
+	}
+
+	MojErr err = pop(keyOut, idOut, foundOut);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbExternalSorter::spill()
+{
+	LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	RecordVec::Iterator begin;
+	MojErr err = m_records.begin(begin);
+	MojErrCheck(err);
+	MojQuickSort<Record, RecordComp>(begin, m_records.size(), m_comp);
+
+	MojFile file;
+	MojString path;
+	err = beginRun(file, path);
+	MojErrCheck(err);
+	for (RecordVec::ConstIterator i = m_records.begin(); i != m_records.end() && err == MojErrNone; ++i) {
+		err = writeKey(file, i->m_key);
+		if (err == MojErrNone)
+			err = writeKey(file, i->m_id);
+	}
+	if (err == MojErrNone)
+		err = endRun(file, path);
+	if (err != MojErrNone) {
+		abandonRun(file, path);
+		MojErrThrow(err);
+	}
+
+	m_records.clear();
+	m_bytes = 0;
+	++m_runCount;
+
+	return MojErrNone;
+}
+
+MojErr MojDbExternalSorter::mergeRuns(MojSize numRuns)
+{
+	LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(m_runs.empty());
+
+	MojErr err = openRuns(numRuns);
+	MojErrCheck(err);
+	heapify();
+
+	MojFile file;
+	MojString path;
+	err = beginRun(file, path);
+	MojErrCheck(err);
+	MojDbKey key;
+	MojDbKey id;
+	for (;;) {
+		bool found = false;
+		err = pop(key, id, found);
+		if (err != MojErrNone || !found)
+			break;
+		err = writeKey(file, key);
+		if (err == MojErrNone)
+			err = writeKey(file, id);
+		if (err != MojErrNone)
+			break;
+	}
+	if (err == MojErrNone)
+		err = endRun(file, path);
+	if (err != MojErrNone) {
+		abandonRun(file, path);
+		MojErrThrow(err);
+	}
+	MojAssert(m_runs.empty());
+	++m_mergeCount;
+
+	return MojErrNone;
+}
+
+MojErr MojDbExternalSorter::openRuns(MojSize numRuns)
+{
+	MojAssert(numRuns <= m_paths.size());
+
+	MojErr err = MojErrNone;
+	MojSize opened = 0;
+	for (; opened < numRuns; ++opened) {
+		MojAutoPtr<Run> run(new Run);
+		MojAllocCheck(run.get());
+		err = run->open(m_paths.at(opened));
+		if (err != MojErrNone)
+			break;
+		// an empty run has nothing to merge
+		if (run->eof())
+			continue;
+		err = m_runs.push(run.get());
+		if (err != MojErrNone)
+			break;
+		run.release();
+	}
+	// opened runs are already unlinked, so they must not be unlinked again by close()
+	MojErr errErase = m_paths.erase(0, opened);
+	MojErrAccumulate(err, errErase);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbExternalSorter::beginRun(MojFile& file, MojString& pathOut)
+{
+	MojChar nameTemplate[] = _T("_dbsort_XXXXXX");
+	MojErr err = pathOut.format(_T("%s/%s"), m_tmpDir.data(), MojMkTemp(nameTemplate));
+	MojErrCheck(err);
+	err = file.open(pathOut, MOJ_O_WRONLY | MOJ_O_CREAT | MOJ_O_TRUNC, MOJ_S_IRUSR | MOJ_S_IWUSR);
+	MojErrCheck(err);
+	m_writeLen = 0;
+
+	return MojErrNone;
+}
+
+MojErr MojDbExternalSorter::endRun(MojFile& file, const MojString& path)
+{
+	MojErr err = flush(file);
+	MojErrCheck(err);
+	err = file.close();
+	MojErrCheck(err);
+	err = m_paths.push(path);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+void MojDbExternalSorter::abandonRun(MojFile& file, const MojString& path)
+{
+	// a half-written run is useless and nothing else knows it exists
+	MojErr err = file.close();
+	MojErrCatchAll(err);
+	err = MojUnlink(path);
+	MojErrCatchAll(err);
+	m_writeLen = 0;
+}
+
+MojErr MojDbExternalSorter::pop(MojDbKey& keyOut, MojDbKey& idOut, bool& foundOut)
+{
+	foundOut = false;
+	if (m_runs.empty())
+		return MojErrNone;
+
+	Run* top = m_runs.front();
+	keyOut = top->rec().m_key;
+	idOut = top->rec().m_id;
+	foundOut = true;
+
+	MojErr err = top->next();
+	MojErrCheck(err);
+	if (top->eof()) {
+		// replace the exhausted run with the last one and sift it down
+		err = m_runs.setAt(0, m_runs.back());
+		MojErrCheck(err);
+		err = m_runs.pop();
+		MojErrCheck(err);
+		delete top;
+	}
+	heapDown(0);
+
+	return MojErrNone;
+}
+
+void MojDbExternalSorter::heapify()
+{
+	for (MojSize i = m_runs.size() / 2; i > 0; --i) {
+		heapDown(i - 1);
+	}
+}
+
+MojErr MojDbExternalSorter::write(MojFile& file, const MojByte* data, MojSize len)
+{
+	while (len > 0) {
+		if (m_writeLen == sizeof(m_writeBuf)) {
+			MojErr err = flush(file);
+			MojErrCheck(err);
+		}
+		MojSize chunk = MojMin(len, sizeof(m_writeBuf) - m_writeLen);
+		MojMemCpy(m_writeBuf + m_writeLen, data, chunk);
+		m_writeLen += chunk;
+		data += chunk;
+		len -= chunk;
+	}
+	return MojErrNone;
+}
+
+MojErr MojDbExternalSorter::writeKey(MojFile& file, const MojDbKey& key)
+{
+	MojUInt32 len = (MojUInt32) key.size();
+	MojErr err = write(file, (const MojByte*) &len, sizeof(len));
+	MojErrCheck(err);
+	err = write(file, key.data(), key.size());
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbExternalSorter::flush(MojFile& file)
+{
+	const MojByte* data = m_writeBuf;
+	while (m_writeLen > 0) {
+		MojSize written = 0;
+		MojErr err = file.write(data, m_writeLen, written);
+		MojErrCheck(err);
+		data += written;
+		m_writeLen -= written;
+	}
+	return MojErrNone;
+}
+
+void MojDbExternalSorter::heapDown(MojSize idx)
+{
+	MojSize size = m_runs.size();
+	RunVec::Iterator runs;
+	if (m_runs.begin(runs) != MojErrNone)
+		return;
+	for (;;) {
+		MojSize left = idx * 2 + 1;
+		if (left >= size)
+			break;
+		MojSize child = left;
+		if (left + 1 < size && less(runs[left + 1], runs[left]))
+			child = left + 1;
+		if (!less(runs[child], runs[idx]))
+			break;
+		MojSwap(runs[child], runs[idx]);
+		idx = child;
+	}
+}
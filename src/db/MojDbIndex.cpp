@@ -25,29 +25,43 @@
 #include "core/MojObject.h"
 #include "core/MojObjectSerialization.h"
 
+const MojChar* const MojDbIndex::BuildingKey = _T("building");
+const MojChar* const MojDbIndex::BuiltKey = _T("built");
 const MojChar* const MojDbIndex::CountKey = _T("count");
 const MojChar* const MojDbIndex::DelMissesKey = _T("delmisses");
 const MojChar* const MojDbIndex::DefaultKey = _T("default");
+const MojChar* const MojDbIndex::IndexKey = _T("index");
 const MojChar* const MojDbIndex::IncludeDeletedKey = _T("incDel");
+const MojChar* const MojDbIndex::LiveCountKey = _T("liveCount");
+const MojChar* const MojDbIndex::LowerKey = _T("lower");
 const MojChar* const MojDbIndex::MultiKey = _T("multi");
 const MojChar* const MojDbIndex::NameKey = _T("name");
 const MojChar* const MojDbIndex::PropsKey = _T("props");
+const MojChar* const MojDbIndex::RangesKey = _T("ranges");
 const MojChar* const MojDbIndex::SizeKey = _T("size");
 const MojChar* const MojDbIndex::TypeKey = _T("type");
+const MojChar* const MojDbIndex::UpperKey = _T("upper");
 const MojChar* const MojDbIndex::WatchesKey = _T("watches");
 
 //db.index
 
 MojDbIndex::MojDbIndex(MojDbKind* kind, MojDbKindEngine* kindEngine)
-: m_preCommitSlot(this, &MojDbIndex::handlePreCommit),
+: m_cachedCount(0),
+  m_countCached(false),
+  m_preCommitSlot(this, &MojDbIndex::handlePreCommit),
   m_postCommitSlot(this, &MojDbIndex::handlePostCommit),
+  m_builtSlot(this, &MojDbIndex::handleBuilt),
   m_kind(kind),
   m_kindEngine(kindEngine),
   m_collection(NULL),
   m_idIndex(MojInvalidSize),
   m_includeDeleted(false),
   m_ready(false),
-  m_delMisses(0)
+  m_building(false),
+  m_countPending(false),
+  m_delMisses(0),
+  m_buildCount(0),
+  m_keyCount(-1)
 {
 }
 
@@ -124,7 +138,7 @@ MojErr MojDbIndex::addProp(const MojObject& propObj, bool pushFront)
 	return MojErrNone;
 }
 
-MojErr MojDbIndex::open(MojDbStorageIndex* index, const MojObject& id, MojDbReq& req, bool created)
+MojErr MojDbIndex::open(MojDbStorageIndex* index, const MojObject& id, MojDbReq& req, bool created, bool building)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 	MojAssert(!isOpen() && !m_props.empty());
@@ -142,7 +156,16 @@ MojErr MojDbIndex::open(MojDbStorageIndex* index, const MojObject& id, MojDbReq&
 	err = addBuiltinProps();
 	MojErrCheck(err);
 
-	if (created && !isIdIndex()) {
+	// a new index starts empty, so commits keep its key count from here on
+	if (created)
+		m_keyCount.set(0);
+	if (building && !isIdIndex()) {
+		// the index builder fills this index in batches once the creating txn has committed
+		m_building = true;
+		m_buildPage.clear();
+		m_buildCount = 0;
+		req.txn()->notifyPostCommit(m_postCommitSlot);
+	} else if (created && !isIdIndex()) {
 		// if this index was just created, we need to re-index before committing the transaction
 		MojDbStorageTxn* txn = req.txn();
 		txn->notifyPreCommit(m_preCommitSlot);
@@ -155,6 +178,11 @@ MojErr MojDbIndex::open(MojDbStorageIndex* index, const MojObject& id, MojDbReq&
 	m_index.reset(index);
 	m_collection = m_index.get();
 
+	if (!m_building) {
+		err = initCount(created, req);
+		MojErrCheck(err);
+	}
+
 	return MojErrNone;
 }
 
@@ -168,8 +196,9 @@ MojErr MojDbIndex::close()
 			MojErrCheck(err);
 			m_index.reset();
 		}
-		m_watcherVec.clear();
+		m_watchers.clear();
 		m_collection = NULL;
+		m_building = false;
 	}
 	return MojErrNone;
 }
@@ -195,6 +224,20 @@ MojErr MojDbIndex::stats(MojObject& objOut, MojSize& usageOut, MojDbReq& req)
 	MojErrCheck(err);
 	err = objOut.put(DelMissesKey, (MojInt64) m_delMisses); // cumulative since start
 	MojErrCheck(err);
+	MojUInt32 liveCount = 0;
+	bool haveCount = false;
+	err = this->liveCount(req.txn(), liveCount, haveCount);
+	MojErrCheck(err);
+	if (haveCount) {
+		err = objOut.put(LiveCountKey, (MojInt64) liveCount);
+		MojErrCheck(err);
+	}
+	if (m_building) {
+		err = objOut.put(BuildingKey, true);
+		MojErrCheck(err);
+		err = objOut.put(BuiltKey, (MojInt64) m_buildCount); // objects indexed so far
+		MojErrCheck(err);
+	}
 
 	MojThreadReadGuard guard(m_lock);
 	if (!m_watcherMap.empty()) {
@@ -216,6 +259,16 @@ MojErr MojDbIndex::drop(MojDbReq& req)
 
 	MojErr err = m_index->drop(req.txn());
 	MojErrCheck(err);
+	err = delCount(req.txn());
+	MojErrCheck(err);
+	err = req.txn()->dropCounts(this);
+	MojErrCheck(err);
+	{
+		MojThreadGuard guard(m_countLock);
+		m_countCached = false;
+	}
+	m_building = false;
+	m_keyCount.set(-1);
 
 	return MojErrNone;
 }
@@ -238,6 +291,8 @@ MojErr MojDbIndex::updateLocale(const MojChar* locale, MojDbReq& req)
 		// drop and reindex
 		MojErr err = drop(req);
 		MojErrCheck(err);
+		err = putCount(0, NULL, req.txn());
+		MojErrCheck(err);
 		err = build(req.txn());
 		MojErrCheck(err);
 	}
@@ -252,6 +307,9 @@ MojErr MojDbIndex::update(const MojObject* newObj, const MojObject* oldObj, MojD
 	MojAssert(isOpen());
 	MojAssert(newObj || oldObj);
 
+	// while building, the old object may not have been indexed yet
+	forcedel = forcedel || m_building;
+
 	// figure out which versions we include
 	bool includeOld = includeObj(oldObj);
 	bool includeNew = includeObj(newObj);
@@ -264,6 +322,8 @@ MojErr MojDbIndex::update(const MojObject* newObj, const MojObject* oldObj, MojD
 		MojErrCheck(err);
 		err = insertKeys(newKeys, txn);
 		MojErrCheck(err);
+		err = offsetLiveCount(txn, newObj, newKeys.size(), NULL, 0);
+		MojErrCheck(err);
 		err = notifyWatches(newKeys, txn);
 		MojErrCheck(err);
         LOG_DEBUG("[db_mojodb] IndexAdd: %s; Keys= %zu \n", this->m_name.data(), newKeys.size());
@@ -275,6 +335,8 @@ MojErr MojDbIndex::update(const MojObject* newObj, const MojObject* oldObj, MojD
 		MojErrCheck(err);
 		err = delKeys(oldKeys, txn, forcedel);
 		MojErrCheck(err);
+		err = offsetLiveCount(txn, NULL, 0, oldObj, oldKeys.size());
+		MojErrCheck(err);
 		err = notifyWatches(oldKeys, txn);
 		MojErrCheck(err);
         LOG_DEBUG("[db_mojodb] IndexDel: %s; Keys= %zu \n", this->name().data(), oldKeys.size());
@@ -302,6 +364,8 @@ MojErr MojDbIndex::update(const MojObject* newObj, const MojObject* oldObj, MojD
         LOG_DEBUG("[db_mojodb] IndexMerge: %s; OldKeys= %zu; NewKeys= %zu; Dropped= %zu; Added= %zu ; err = %d\n",
 			this->name().data(), oldKeys.size(), newKeys.size(), keysToDel.size(), keysToPut.size(), (int)err);
 
+		MojErrCheck(err);
+		err = offsetLiveCount(txn, newObj, newKeys.size(), oldObj, oldKeys.size());
 		MojErrCheck(err);
 		// notify on union of old and new keys
 		err = newKeys.put(oldKeys);
@@ -328,6 +392,23 @@ MojErr MojDbIndex::find(MojDbCursor& cursor, MojDbWatcher* watcher, MojDbReq& re
 		err = addWatch(*plan, cursor, watcher, req);
 		MojErrCheck(err);
 	}
+	err = beginTxn(cursor, req);
+	MojErrCheck(err);
+	cursor.m_dbIndex = this;	// for debugging
+	err = cursor.txn()->flushIndexKeys();
+	MojErrCheck(err);
+	err = m_collection->find(plan, cursor.txn(), cursor.m_storageQuery);
+	MojErrCheck(err);
+	cursor.m_watcher = watcher;
+	
+	return MojErrNone;
+}
+
+MojErr MojDbIndex::beginTxn(MojDbCursor& cursor, MojDbReq& req)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(isOpen());
+
 	if (!cursor.txn()) {
 		MojDbStorageTxn* txn = req.txn();
 		bool cursorOwnsTxn = !(req.batch() || txn);
@@ -335,17 +416,12 @@ MojErr MojDbIndex::find(MojDbCursor& cursor, MojDbWatcher* watcher, MojDbReq& re
 			cursor.txn(txn, cursorOwnsTxn);
 		} else {
 			MojRefCountedPtr<MojDbStorageTxn> localTxn;
-			err = m_collection->beginTxn(localTxn);
+			MojErr err = m_collection->beginTxn(localTxn);
 			MojErrCheck(err);
 			cursor.txn(localTxn.get(), cursorOwnsTxn);
 			req.txn(localTxn.get());
 		}
 	}
-	cursor.m_dbIndex = this;	// for debugging
-	err = m_collection->find(plan, cursor.txn(), cursor.m_storageQuery);
-	MojErrCheck(err);
-	cursor.m_watcher = watcher;
-	
 	return MojErrNone;
 }
 
@@ -417,40 +493,100 @@ bool MojDbIndex::canAnswer(const MojDbQuery& query) const
 	return false;
 }
 
-MojErr MojDbIndex::cancelWatch(MojDbWatcher* watcher)
+MojErr MojDbIndex::estimate(const MojDbQuery& query, MojDbStorageTxn* txn, MojSize& keysOut)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 	MojAssert(isOpen());
+
+	MojSize count = 0;
+	bool counted = keyCount(count);
+	bool complete = false;
+	if (!txn) {
+		keysOut = counted ? count : MojInvalidSize;
+	} else {
+		// sample in the txn the find reads with, so we see its uncommitted writes
+		MojSize sampled = 0;
+		MojErr err = sampleKeys(query, txn, sampled, complete);
+		MojErrCheck(err);
+		if (complete || !counted) {
+			keysOut = sampled;
+		} else {
+			// the range is bigger than our sample, so charge for the whole index
+			keysOut = MojMax(count, sampled);
+		}
+	}
+	LOG_DEBUG("[db_mojodb] IndexEstimate: %s - %s; keys= %zu; complete= %d\n",
+		m_kind->id().data(), m_name.data(), keysOut, (int) complete);
+
+	return MojErrNone;
+}
+
+MojErr MojDbIndex::explain(const MojDbQuery& query, MojObject& objOut)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(isOpen());
+
+	MojDbQueryPlan plan(*m_kindEngine);
+	MojErr err = plan.init(query, *this);
+	MojErrCheck(err);
+
+	MojObject ranges(MojObject::TypeArray);
+	MojVector<MojChar> buf;
+	for (MojDbQueryPlan::RangeVec::ConstIterator i = plan.ranges().begin(); i != plan.ranges().end(); ++i) {
+		MojObject range;
+		for (MojSize idx = MojDbKeyRange::IdxLower; idx <= MojDbKeyRange::IdxUpper; ++idx) {
+			const MojDbKey& key = i->key(idx);
+			err = buf.resize(key.size() * 2 + 1);
+			MojErrCheck(err);
+			MojVector<MojChar>::Iterator hex;
+			err = buf.begin(hex);
+			MojErrCheck(err);
+			err = MojByteArrayToHex(key.data(), key.size(), hex);
+			MojErrCheck(err);
+			err = range.putString(idx == MojDbKeyRange::IdxLower ? LowerKey : UpperKey, hex);
+			MojErrCheck(err);
+		}
+		err = ranges.push(range);
+		MojErrCheck(err);
+	}
+	err = objOut.putString(IndexKey, m_name);
+	MojErrCheck(err);
+	err = objOut.put(RangesKey, ranges);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbIndex::cancelWatch(MojDbWatcher* watcher)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
 	MojAssert(watcher);
 
+	// a fire queued before the index was closed can arrive after close dropped its watchers
+	if (!isOpen())
+		return MojErrNone;
+
     LOG_DEBUG("[db_mojodb] Index_cancelWatch: index name = %s; domain = %s\n",
 		this->name().data(), watcher->domain().data());
 
 	MojThreadWriteGuard guard(m_lock);
-	MojSize idx;
-	MojSize size = m_watcherVec.size();
-	for (idx = 0; idx < size; ++idx) {
-		if (m_watcherVec.at(idx).get() == watcher) {
-			MojErr err = m_watcherVec.erase(idx);
-			MojErrCheck(err);
-			WatcherMap::Iterator iter;
-			err = m_watcherMap.find(watcher->domain(), iter);
-			MojErrCheck(err);
-			if (iter != m_watcherMap.end()) {
-				iter.value() -= 1;
-				if (iter.value() == 0) {
-					bool found = false;
-					m_watcherMap.del(iter.key(), found);
-					MojAssert(found);
-					LOG_DEBUG("[db_mojodb] Index_cancelwatch: Domain Del found = %d; index name = %s; domain = %s\n",
- 						(int)found, this->name().data(), watcher->domain().data());
-				}
-			}
-			break;
+	bool found = false;
+	MojErr err = m_watchers.del(watcher, found);
+	MojErrCheck(err);
+	if (!found)
+		MojErrThrow(MojErrDbWatcherNotRegistered);
+	WatcherMap::Iterator iter;
+	err = m_watcherMap.find(watcher->domain(), iter);
+	MojErrCheck(err);
+	if (iter != m_watcherMap.end()) {
+		iter.value() -= 1;
+		if (iter.value() == 0) {
+			m_watcherMap.del(iter.key(), found);
+			MojAssert(found);
+			LOG_DEBUG("[db_mojodb] Index_cancelwatch: Domain Del found = %d; index name = %s; domain = %s\n",
+ 				(int)found, this->name().data(), watcher->domain().data());
 		}
 	}
-	if (idx == size)
-		MojErrThrow(MojErrDbWatcherNotRegistered);
 
 	return MojErrNone;
 }
@@ -536,9 +672,8 @@ MojErr MojDbIndex::addWatch(const MojDbQueryPlan& plan, MojDbCursor& cursor, Moj
     LOG_TRACE("Entering function %s", __FUNCTION__);
 	MojAssert(watcher);
 
-	// TODO: use interval tree instead of vector for watches
 	MojThreadWriteGuard guard(m_lock);
-	MojErr err = m_watcherVec.push(watcher);
+	MojErr err = m_watchers.put(watcher, plan.ranges());
 	MojErrCheck(err);
 	// update count map
 	watcher->domain(req.domain());
@@ -586,18 +721,19 @@ MojErr MojDbIndex::notifyWatches(const MojDbKey& key, MojDbStorageTxn* txn)
     LOG_TRACE("Entering function %s", __FUNCTION__);
 	MojAssert(txn);
 
-	// TODO: this will be much more efficient with an interval tree
-	for (WatcherVec::ConstIterator i = m_watcherVec.begin(); i != m_watcherVec.end(); ++i) {
-		const RangeVec& ranges = (*i)->ranges();
-		for (RangeVec::ConstIterator j = ranges.begin(); j != ranges.end(); ++j) {
-			if (j->contains(key)) {
-				LOG_DEBUG("[db_mojodb] DbIndex_notifywatches adding to txn - kind: %s; index %s;\n",
-					((m_kind) ? m_kind->id().data() :NULL), ((m_name) ? m_name.data() : NULL));
-				MojErr err = txn->addWatcher(i->get(), key);
-				MojErrCheck(err);
-				break;
-			}
-		}
+	MojDbWatcherTree::WatcherVec watchers;
+	MojErr err = m_watchers.find(key, watchers);
+	MojErrCheck(err);
+	if (!watchers.empty()) {
+		MojDbWatchNotifier* notifier = m_kindEngine->db()->watchNotifier();
+		if (notifier->enabled())
+			txn->watchNotifier(notifier);
+	}
+	for (MojDbWatcherTree::WatcherVec::ConstIterator i = watchers.begin(); i != watchers.end(); ++i) {
+		LOG_DEBUG("[db_mojodb] DbIndex_notifywatches adding to txn - kind: %s; index %s;\n",
+			((m_kind) ? m_kind->id().data() :NULL), ((m_name) ? m_name.data() : NULL));
+		err = txn->addWatcher(this, *i, key);
+		MojErrCheck(err);
 	}
 	return MojErrNone;
 }
@@ -606,10 +742,15 @@ MojErr MojDbIndex::delKeys(const KeySet& keys, MojDbStorageTxn* txn, bool forced
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
+	// a deferred insert of one of these keys has to land before its delete
+	MojErr err = txn->flushIndexKeys();
+	MojErrCheck(err);
+
 	int count = 0;
+	int misses = 0;
 	for (KeySet::ConstIterator i = keys.begin(); i != keys.end(); ++i) {
 
-		MojErr err = m_index->del(*i, txn);
+		err = m_index->del(*i, txn);
 #if defined(MOJ_DEBUG_LOGGING)
 		char s[1024];
 		char *s2 = NULL;
@@ -626,6 +767,7 @@ MojErr MojDbIndex::delKeys(const KeySet& keys, MojDbStorageTxn* txn, bool forced
 		// This has some potential risk
 		if (err == MojErrInternalIndexOnDel) {
 			m_delMisses++;
+			misses++;
 #if defined(MOJ_DEBUG_LOGGING)
             LOG_DEBUG("[db_mojodb] delKey %d for: %s - %s; key= %s; err = %d \n", count+1, s2, this->m_name.data(), s, err);
 #endif
@@ -635,6 +777,8 @@ MojErr MojDbIndex::delKeys(const KeySet& keys, MojDbStorageTxn* txn, bool forced
 		MojErrCheck(err);
 		count++;
 	}
+	err = txn->offsetKeyCount(this, misses - count);
+	MojErrCheck(err);
 
 	return MojErrNone;
 }
@@ -643,6 +787,15 @@ MojErr MojDbIndex::insertKeys(const KeySet& keys, MojDbStorageTxn* txn)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
+	if (txn->deferringIndexKeys()) {
+		// written in key order, together with the rest of the txn's keys for this index
+		for (KeySet::ConstIterator i = keys.begin(); i != keys.end(); ++i) {
+			MojErr err = txn->deferIndexKey(this, *i);
+			MojErrCheck(err);
+		}
+		return MojErrNone;
+	}
+
 	int count = 0;
 	for (KeySet::ConstIterator i = keys.begin(); i != keys.end(); ++i) {
 
@@ -659,6 +812,26 @@ MojErr MojDbIndex::insertKeys(const KeySet& keys, MojDbStorageTxn* txn)
 		MojErrCheck(err);
 		count ++;
 	}
+	MojErr err = txn->offsetKeyCount(this, count);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbIndex::insertSorted(MojDbStorageTxn::KeyVec& keys, MojDbStorageTxn* txn)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(isOpen());
+
+	MojErr err = keys.sort();
+	MojErrCheck(err);
+	for (MojDbStorageTxn::KeyVec::ConstIterator i = keys.begin(); i != keys.end(); ++i) {
+		err = m_index->insert(*i, txn);
+		MojErrCheck(err);
+	}
+	err = txn->offsetKeyCount(this, (MojInt64) keys.size());
+	MojErrCheck(err);
+    LOG_DEBUG("[db_mojodb] IndexBulkAdd: %s; Keys= %zu \n", m_name.data(), keys.size());
 
 	return MojErrNone;
 }
@@ -687,6 +860,288 @@ MojErr MojDbIndex::getKeys(const MojObject& obj, KeySet& keysOut) const
 	return MojErrNone;
 }
 
+bool MojDbIndex::keyCount(MojSize& countOut) const
+{
+	// walking the index to count it would cost more than the find we are planning,
+	// so only indexes we have tracked from creation have a count
+	MojInt32 count = m_keyCount.value();
+	if (count < 0)
+		return false;
+	countOut = (MojSize) count;
+
+	return true;
+}
+
+MojErr MojDbIndex::liveCount(MojDbStorageTxn* txn, MojUInt32& countOut, bool& foundOut)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(txn);
+
+	countOut = 0;
+	foundOut = false;
+	if (m_building)
+		return MojErrNone;
+
+	MojInt64 count = 0;
+	bool found = false;
+	{
+		MojThreadGuard guard(m_countLock);
+		if (m_countCached) {
+			count = m_cachedCount;
+			found = true;
+		}
+	}
+	if (!found) {
+		MojRefCountedPtr<MojDbStorageItem> item;
+		MojErr err = getCount(txn, false, count, item);
+		MojErrCheck(err);
+		found = (item.get() != NULL);
+	}
+	if (found) {
+		// the count only moves at commit, so add what this txn has changed so far
+		count += txn->countOffset(this);
+		countOut = (MojUInt32) MojMax(count, (MojInt64) 0);
+		foundOut = true;
+	}
+	return MojErrNone;
+}
+
+MojErr MojDbIndex::applyCount(MojInt64 offset, MojDbStorageTxn* txn)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(txn);
+
+	MojRefCountedPtr<MojDbStorageItem> item;
+	MojInt64 count = 0;
+	MojErr err = getCount(txn, true, count, item);
+	MojErrCheck(err);
+	// indexes waiting on the index builder for a count have nothing to offset yet
+	if (item.get()) {
+		// a commit ordered before ours may not have reached storage yet, so build on
+		// the count it left here rather than on the stored one
+		if (m_countCached)
+			count = m_cachedCount;
+		count += offset;
+		MojAssert(count >= 0);
+		count = MojMax(count, (MojInt64) 0);
+		err = putCount(count, item.get(), txn);
+		MojErrCheck(err);
+		m_cachedCount = count;
+		m_countCached = true;
+	}
+	return MojErrNone;
+}
+
+MojErr MojDbIndex::resetCount()
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	// a failed commit left counts that later commits have built on, so drop the
+	// stored count and have the index builder take it again from the index
+	MojThreadGuard guard(m_countLock);
+	m_countCached = false;
+	MojRefCountedPtr<MojDbStorageTxn> txn;
+	MojErr err = m_kindEngine->indexCountDb()->beginTxn(txn);
+	MojErrCheck(err);
+	err = delCount(txn.get());
+	MojErrCheck(err);
+	err = txn->commit();
+	MojErrCheck(err);
+	LOG_WARNING(MSGID_MOJ_DB_INDEX_WARNING, 1,
+		PMLOGKS("index", m_name.data()),
+		"db: live count of 'index' dropped after a failed commit");
+	err = m_kind->kindEngine()->db()->indexBuilder()->schedule(this);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbIndex::initCount(bool created, MojDbReq& req)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(isOpen());
+
+	MojRefCountedPtr<MojDbStorageItem> item;
+	MojInt64 count = 0;
+	MojErr err = getCount(req.txn(), false, count, item);
+	MojErrCheck(err);
+	if (item.get()) {
+		// we hold the schema lock, so no commit can have moved the count past what is stored
+		MojThreadGuard guard(m_countLock);
+		m_cachedCount = count;
+		m_countCached = true;
+		return MojErrNone;
+	}
+
+	if (!created) {
+		// an index from before counts were kept: counting it here would hold up the open
+		// for as long as the index is big, so leave it to the index builder
+		m_countPending = true;
+		req.txn()->notifyPostCommit(m_postCommitSlot);
+		return MojErrNone;
+	}
+	// a new index starts at zero and counts whatever build or later updates add
+	err = putCount(0, NULL, req.txn());
+	MojErrCheck(err);
+	MojThreadGuard guard(m_countLock);
+	m_countCached = false;
+
+	return MojErrNone;
+}
+
+MojErr MojDbIndex::buildCount(MojDbReq& req)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(m_kind);
+
+	// nothing to do if the index was dropped or closed while the builder waited for the lock
+	if (!isOpen() || m_building)
+		return MojErrNone;
+
+	MojRefCountedPtr<MojDbStorageItem> item;
+	MojInt64 count = 0;
+	MojErr err = getCount(req.txn(), true, count, item);
+	MojErrCheck(err);
+	if (item.get())
+		return MojErrNone;
+
+	// the builder holds the schema lock, so no put can commit while we count what a query
+	// for the whole kind would see, shards that are not mounted included
+	MojDbQuery query;
+	err = query.from(m_kind->id());
+	MojErrCheck(err);
+	query.setIgnoreInactiveShards(false);
+	MojAutoPtr<MojDbQueryPlan> plan(new MojDbQueryPlan(*m_kindEngine));
+	MojAllocCheck(plan.get());
+	err = plan->init(query, *this);
+	MojErrCheck(err);
+	MojRefCountedPtr<MojDbStorageQuery> storageQuery;
+	err = m_collection->find(plan, req.txn(), storageQuery);
+	MojErrCheck(err);
+	MojUInt32 keys = 0;
+	err = storageQuery->count(keys);
+	MojErrCheck(err);
+	err = storageQuery->close();
+	MojErrCheck(err);
+	err = putCount(keys, NULL, req.txn());
+	MojErrCheck(err);
+	MojThreadGuard guard(m_countLock);
+	m_countCached = false;
+
+	return MojErrNone;
+}
+
+MojErr MojDbIndex::offsetLiveCount(MojDbStorageTxn* txn, const MojObject* newObj, MojSize newKeys,
+								   const MojObject* oldObj, MojSize oldKeys)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(txn);
+
+	// while building, updates race with the builder, so the count is taken once it is done
+	if (m_building)
+		return MojErrNone;
+
+	// queries never see deleted objects, even in indexes that include them
+	bool deleted = false;
+	MojInt64 offset = 0;
+	if (newObj && !(newObj->get(MojDb::DelKey, deleted) && deleted))
+		offset += (MojInt64) newKeys;
+	deleted = false;
+	if (oldObj && !(oldObj->get(MojDb::DelKey, deleted) && deleted))
+		offset -= (MojInt64) oldKeys;
+	if (offset != 0) {
+		MojErr err = txn->offsetCount(this, offset);
+		MojErrCheck(err);
+	}
+	return MojErrNone;
+}
+
+MojErr MojDbIndex::getCount(MojDbStorageTxn* txn, bool forUpdate, MojInt64& countOut, MojRefCountedPtr<MojDbStorageItem>& itemOut)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	countOut = 0;
+	MojErr err = m_kindEngine->indexCountDb()->get(m_id, txn, forUpdate, itemOut);
+	MojErrCheck(err);
+	if (itemOut.get()) {
+		MojObject val;
+		err = itemOut->toObject(val, *m_kindEngine, false);
+		MojErrCheck(err);
+		countOut = val.intValue();
+	}
+	return MojErrNone;
+}
+
+MojErr MojDbIndex::putCount(MojInt64 count, MojDbStorageItem* oldItem, MojDbStorageTxn* txn)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(txn);
+
+	MojObject val(count);
+	MojBuffer buf;
+	MojErr err = val.toBytes(buf);
+	MojErrCheck(err);
+	// counts are bookkeeping, not data, so they don't go against the kind's quota
+	MojDbStorageDatabase* db = m_kindEngine->indexCountDb();
+	txn->quotaEnabled(false);
+	if (oldItem) {
+		err = db->update(m_id, buf, oldItem, txn);
+	} else {
+		err = db->insert(m_id, buf, txn);
+	}
+	txn->quotaEnabled(true);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbIndex::delCount(MojDbStorageTxn* txn)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	bool found = false;
+	MojErr err = m_kindEngine->indexCountDb()->del(m_id, txn, found);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbIndex::sampleKeys(const MojDbQuery& query, MojDbStorageTxn* txn, MojSize& keysOut, bool& completeOut)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(txn);
+
+	MojAutoPtr<MojDbQueryPlan> plan(new MojDbQueryPlan(*m_kindEngine));
+	MojAllocCheck(plan.get());
+	MojErr err = plan->init(query, *this);
+	MojErrCheck(err);
+	err = txn->flushIndexKeys();
+	MojErrCheck(err);
+	MojRefCountedPtr<MojDbStorageQuery> storageQuery;
+	err = m_collection->find(plan, txn, storageQuery);
+	MojErrCheck(err);
+
+	// walk at most EstimateSampleSize keys in the query ranges
+	keysOut = 0;
+	completeOut = false;
+	while (keysOut < EstimateSampleSize) {
+		MojObject id;
+		MojUInt32 group = 0;
+		bool found = false;
+		err = storageQuery->getId(id, group, found);
+		MojErrCheck(err);
+		if (!found) {
+			completeOut = true;
+			break;
+		}
+		++keysOut;
+	}
+	err = storageQuery->close();
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
 MojErr MojDbIndex::handlePreCommit(MojDbStorageTxn* txn)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
@@ -703,7 +1158,90 @@ MojErr MojDbIndex::handlePostCommit(MojDbStorageTxn* txn)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
+	if (m_building || m_countPending) {
+		m_countPending = false;
+		MojErr err = m_kind->kindEngine()->db()->indexBuilder()->schedule(this);
+		MojErrCheck(err);
+	}
+	if (!m_building)
+		m_ready = true;
+
+	return MojErrNone;
+}
+
+MojErr MojDbIndex::handleBuilt(MojDbStorageTxn* txn)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	m_building = false;
 	m_ready = true;
+	// updates were not counted while building, so the builder takes the count next
+	MojErr err = m_kind->kindEngine()->db()->indexBuilder()->schedule(this);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbIndex::buildStep(MojUInt32 stepSize, MojDbReq& req, bool& doneOut)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(isOpen() && m_building);
+	MojAssert(m_kind && m_kindEngine);
+	MojAssert(stepSize > 0);
+
+	doneOut = false;
+	MojDbStorageTxn* txn = req.txn();
+	MojErr err = m_kind->kindEngine()->db()->quotaEngine()->curKind(m_kind, txn);
+	MojErrCheck(err);
+
+	// objects come back in id order, so the page key marks how far we have got
+	MojDbQuery query;
+	err = query.from(m_kind->id());
+	MojErrCheck(err);
+	if (m_includeDeleted) {
+		err = query.includeDeleted();
+		MojErrCheck(err);
+	}
+	query.limit(stepSize);
+	query.page(m_buildPage);
+
+	MojDbCursor cursor;
+	MojDbReq adminRequest(true);
+	adminRequest.txn(txn);
+	err = m_kindEngine->find(query, cursor, NULL, adminRequest, OpRead);
+	MojErrCheck(err);
+
+	MojUInt32 count = 0;
+	for (;;) {
+		MojObject obj;
+		bool found = false;
+		err = cursor.get(obj, found);
+		MojErrCheck(err);
+		if (!found)
+			break;
+		err = update(&obj, NULL, txn, false);
+		MojErrCheck(err);
+		++count;
+	}
+	MojDbQuery::Page page;
+	err = cursor.nextPage(page);
+	MojErrCheck(err);
+	err = cursor.close();
+	MojErrCheck(err);
+
+	m_buildPage = page;
+	m_buildCount += count;
+	LOG_DEBUG("[db_mojodb] IndexBuildStep: %s - %s; indexed= %u; total= %u\n",
+		m_kind->id().data(), m_name.data(), count, m_buildCount);
+
+	if (page.empty()) {
+		// last batch - the index can answer queries once this txn commits,
+		// and stays building if it aborts
+		err = m_kind->indexBuilt(m_name, req);
+		MojErrCheck(err);
+		txn->notifyPostCommit(m_builtSlot);
+		doneOut = true;
+	}
 	return MojErrNone;
 }
 
@@ -0,0 +1,187 @@
+/* @@@LICENSE
+*
+*  Copyright (c) 2014 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#include "db/MojDbIndexBuilder.h"
+#include "db/MojDb.h"
+#include "db/MojDbReq.h"
+
+const MojChar* const MojDbIndexBuilder::BackgroundKey = _T("backgroundIndexBuild");
+const MojChar* const MojDbIndexBuilder::StepSizeKey = _T("indexBuildStepSize");
+
+MojDbIndexBuilder::MojDbIndexBuilder(MojDb& db)
+: m_db(db),
+  m_thread(MojInvalidThread),
+  m_stepSize(StepSizeDefault),
+  m_enabled(false),
+  m_stop(false)
+{
+}
+
+MojDbIndexBuilder::~MojDbIndexBuilder()
+{
+	MojErr err = stop();
+	MojErrCatchAll(err);
+}
+
+MojErr MojDbIndexBuilder::configure(const MojObject& conf)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	bool enabled = false;
+	conf.get(BackgroundKey, enabled);
+	m_enabled = enabled;
+
+	MojInt64 stepSize = StepSizeDefault;
+	if (conf.get(StepSizeKey, stepSize) && stepSize > 0 && stepSize <= MojUInt32Max) {
+		m_stepSize = (MojUInt32) stepSize;
+	} else {
+		m_stepSize = StepSizeDefault;
+	}
+	return MojErrNone;
+}
+
+MojErr MojDbIndexBuilder::schedule(MojDbIndex* index)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(index);
+
+	MojThreadGuard guard(m_mutex);
+	MojErr err = m_queue.push(index);
+	MojErrCheck(err);
+	if (m_thread == MojInvalidThread) {
+		m_stop = false;
+		err = MojThreadCreate(m_thread, &threadMain, this);
+		MojErrCheck(err);
+	}
+	err = m_cond.signal();
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbIndexBuilder::stop()
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	MojThreadGuard guard(m_mutex);
+	if (m_thread == MojInvalidThread)
+		return MojErrNone;
+
+	// pending builds are persisted in the kind state and resume on the next open
+	m_stop = true;
+	m_queue.clear();
+	MojErr err = m_cond.signal();
+	MojErrCheck(err);
+	guard.unlock();
+
+	MojErr threadErr = MojErrNone;
+	err = MojThreadJoin(m_thread, threadErr);
+	MojErrAccumulate(err, threadErr);
+
+	guard.lock();
+	m_thread = MojInvalidThread;
+	m_stop = false;
+
+	return err;
+}
+
+MojErr MojDbIndexBuilder::threadMain(void* arg)
+{
+	MojDbIndexBuilder* builder = (MojDbIndexBuilder*) arg;
+	MojAssert(builder);
+
+	return builder->run();
+}
+
+MojErr MojDbIndexBuilder::run()
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	MojThreadGuard guard(m_mutex);
+	for (;;) {
+		while (m_queue.empty() && !m_stop) {
+			MojErr err = m_cond.wait(m_mutex);
+			MojErrCheck(err);
+		}
+		if (m_stop)
+			break;
+
+		MojRefCountedPtr<MojDbIndex> index = m_queue.front();
+		MojErr err = m_queue.erase(0);
+		MojErrCheck(err);
+		guard.unlock();
+
+		err = buildIndex(index.get());
+		if (err != MojErrNone) {
+			// leave the index unready; the build is retried the next time the db is opened
+			LOG_WARNING(MSGID_MOJ_DB_INDEX_WARNING, 2,
+				PMLOGKS("index", index->name().data()),
+				PMLOGKFV("error", "%d", (int) err),
+				"db: background build of index 'index' failed with 'error'");
+		}
+		index.reset();
+		guard.lock();
+	}
+	return MojErrNone;
+}
+
+MojErr MojDbIndexBuilder::buildIndex(MojDbIndex* index)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(index);
+
+	bool done = false;
+	while (!done && !stopping()) {
+		MojErr err = step(index, done);
+		MojErrCheck(err);
+	}
+	return MojErrNone;
+}
+
+bool MojDbIndexBuilder::stopping()
+{
+	MojThreadGuard guard(m_mutex);
+	return m_stop;
+}
+
+MojErr MojDbIndexBuilder::step(MojDbIndex* index, bool& doneOut)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(index);
+
+	doneOut = false;
+
+	// lock the schema so that no put can commit between reading a batch and indexing it
+	MojDbReq req;
+	MojErr err = req.begin(&m_db, true);
+	MojErrCheck(err);
+
+	if (index->building()) {
+		err = index->buildStep(m_stepSize, req, doneOut);
+		MojErrCheck(err);
+	} else {
+		// built, or opened without a live count: count it now that no put can commit
+		err = index->buildCount(req);
+		MojErrCheck(err);
+		doneOut = true;
+	}
+	err = req.end();
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
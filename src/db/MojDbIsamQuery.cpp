@@ -114,23 +114,29 @@ MojErr MojDbIsamQuery::count(MojUInt32& countOut)
 	countOut = 0;
 	MojInt32 warns = 0;
 	m_plan->limit(MojUInt32Max);
-	bool found = false;
-	do {
-		// Iterate over all the db results but only count
-		// the ones that would not be excluded.  If we're not
-		// excluding any kinds, getImpl does not need to get the
-		// storage item.
-		MojDbStorageItem* item = NULL;
-		//MojErr err = getImpl(item, found, !m_excludeKinds.empty());  // orig
-		//to ensure that we do not count ghost keys, me need to always try to get the item as well
-		MojErr err = getImpl(item, found, true);
-		if (err == MojErrInternalIndexOnFind) {
-			found = true;			// to continue with counting
-			warns++;
-			continue;			// we ignore such keys; it is not counted in getImpl either
-		}
+	if (m_distinct.empty() && m_excludeKinds.empty()) {
+		// nothing needs the objects themselves, so only check that they exist
+		MojErr err = countKeys(warns);
 		MojErrCheck(err);
-	} while (found);
+	} else {
+		bool found = false;
+		do {
+			// Iterate over all the db results but only count
+			// the ones that would not be excluded.  If we're not
+			// excluding any kinds, getImpl does not need to get the
+			// storage item.
+			MojDbStorageItem* item = NULL;
+			//MojErr err = getImpl(item, found, !m_excludeKinds.empty());  // orig
+			//to ensure that we do not count ghost keys, me need to always try to get the item as well
+			MojErr err = getImpl(item, found, true);
+			if (err == MojErrInternalIndexOnFind) {
+				found = true;			// to continue with counting
+				warns++;
+				continue;			// we ignore such keys; it is not counted in getImpl either
+			}
+			MojErrCheck(err);
+		} while (found);
+	}
 	countOut = m_count;
 	if (warns > 0) {
 		const MojChar * from = m_plan->query().from().data();
@@ -140,6 +146,55 @@ MojErr MojDbIsamQuery::count(MojUInt32& countOut)
 	return MojErrNone;
 }
 
+MojErr MojDbIsamQuery::countKeys(MojInt32& missesOut)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	// ids are checked in batches so that engines can look them up in key order
+	ObjectVec ids;
+	bool found = false;
+	do {
+		MojUInt32 group = 0;
+		MojErr err = getKey(group, found);
+		MojErrCheck(err);
+		if (found) {
+			MojObject id;
+			err = parseId(id);
+			MojErrCheck(err);
+			err = ids.push(id);
+			MojErrCheck(err);
+		}
+		if (ids.size() == CountBatchSize || (!found && !ids.empty())) {
+			MojUInt32 existing = 0;
+			err = countIds(ids, existing);
+			MojErrCheck(err);
+			m_count += existing;
+			missesOut += (MojInt32) (ids.size() - existing);
+			ids.clear();
+		}
+	} while (found);
+
+	return MojErrNone;
+}
+
+MojErr MojDbIsamQuery::countIds(const ObjectVec& ids, MojUInt32& countOut)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	countOut = 0;
+	for (ObjectVec::ConstIterator i = ids.begin(); i != ids.end(); ++i) {
+		MojDbStorageItem* item = NULL;
+		bool found = false;
+		MojErr err = getById(*i, item, found);
+		if (err == MojErrInternalIndexOnFind)
+			continue;
+		MojErrCheck(err);
+		if (found)
+			++countOut;
+	}
+	return MojErrNone;
+}
+
 MojErr MojDbIsamQuery::nextPage(MojDbQuery::Page& pageOut)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
@@ -242,6 +297,7 @@ void MojDbIsamQuery::init()
 {
 	m_isOpen = false;
 	m_count = 0;
+	m_keysScanned = 0;
 	m_state = StateInvalid;
 	m_iter = NULL;
 	m_txn = NULL;
@@ -256,7 +312,7 @@ bool MojDbIsamQuery::match()
 
 	// compare against lower key when descending, upper otherwise
 	bool desc = m_plan->desc();
-	const ByteVec& key = m_iter->key(!desc).byteVec();
+	const MojDbKey& key = m_iter->key(!desc);
 	if (key.empty())
 		return true;
 	// test for >= when descending, < otherwise
@@ -264,11 +320,11 @@ bool MojDbIsamQuery::match()
 	return (comp >= 0) == desc;
 }
 
-int MojDbIsamQuery::compareKey(const ByteVec& key)
+int MojDbIsamQuery::compareKey(const MojDbKey& key)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
-	return MojLexicalCompare(m_keyData, m_keySize, key.begin(), key.size());
+	return MojLexicalCompare(m_keyData, m_keySize, key.data(), key.size());
 }
 
 MojErr MojDbIsamQuery::incrementCount()
@@ -292,7 +348,7 @@ MojErr MojDbIsamQuery::seek(bool& foundOut)
 
 	// if descending, seek to upper bound, lower otherwise
 	bool desc = m_plan->desc();
-	const ByteVec& key = m_iter->key(desc).byteVec();
+	const MojDbKey& key = m_iter->key(desc);
 	m_state = StateNext;
 
 	// if the last key returned while iterating over the previous range is >=
@@ -338,6 +394,7 @@ MojErr MojDbIsamQuery::getKey(MojUInt32& groupOut, bool& foundOut)
 			m_iter = end;
 			break;
 		}
+		++m_keysScanned;
 
 		// check to see if we're still in the range
 		if (match()) {
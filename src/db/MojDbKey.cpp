@@ -22,6 +22,42 @@
 #include "core/MojObjectSerialization.h"
 #include "core/MojLogDb8.h"
 
+MojErr MojDbKey::assign(const MojByte* data, MojSize size)
+{
+	if (size <= InlineSize) {
+		// data may point into this key
+		if (size > 0)
+			MojMemMove(m_inline, data, size);
+		m_vec.clear();
+		m_size = size;
+		m_heap = false;
+	} else {
+		MojErr err = m_vec.assign(data, data + size);
+		MojErrCheck(err);
+		m_heap = true;
+	}
+	return MojErrNone;
+}
+
+MojErr MojDbKey::assign(const MojBuffer& buf)
+{
+	// serialized keys almost always fit in a single chunk
+	MojIoVecT vec[2];
+	MojSize vecSize = 0;
+	buf.iovec(vec, 2, vecSize);
+	if (vecSize == 0) {
+		clear();
+	} else if (vecSize == 1) {
+		MojErr err = assign((const MojByte*) vec[0].iov_base, vec[0].iov_len);
+		MojErrCheck(err);
+	} else {
+		MojErr err = buf.toByteVec(m_vec);
+		MojErrCheck(err);
+		m_heap = true;
+	}
+	return MojErrNone;
+}
+
 MojErr MojDbKey::assign(const MojObject& obj, MojDbTextCollator* coll)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
@@ -33,9 +69,42 @@ MojErr MojDbKey::assign(const MojObject& obj, MojDbTextCollator* coll)
 		err = coll->sortKey(text, *this);
 		MojErrCheck(err);
 	} else {
-		MojErr err = obj.toBytes(m_vec);
+		MojObjectWriter writer;
+		MojErr err = obj.visit(writer);
 		MojErrCheck(err);
+		err = assign(writer.buf());
+		MojErrCheck(err);
+	}
+	return MojErrNone;
+}
+
+MojErr MojDbKey::append(const MojByte* data, MojSize size)
+{
+	if (!m_heap && m_size + size <= InlineSize) {
+		if (size > 0)
+			MojMemCpy(m_inline + m_size, data, size);
+		m_size += size;
+		return MojErrNone;
 	}
+	MojErr err = spill();
+	MojErrCheck(err);
+	err = m_vec.append(data, data + size);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbKey::truncate(MojSize size)
+{
+	MojAssert(size <= this->size());
+
+	if (!m_heap) {
+		m_size = size;
+		return MojErrNone;
+	}
+	MojErr err = m_vec.resize(size);
+	MojErrCheck(err);
+
 	return MojErrNone;
 }
 
@@ -43,6 +112,16 @@ MojErr MojDbKey::increment()
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
+	if (!m_heap) {
+		while (m_size > 0) {
+			if (m_inline[m_size - 1] < MojUInt8Max) {
+				++m_inline[m_size - 1];
+				break;
+			}
+			--m_size;
+		}
+		return MojErrNone;
+	}
 	ByteVec::Iterator iter;
 	MojErr err = m_vec.end(iter);
 	MojErrCheck(err);
@@ -60,8 +139,27 @@ MojErr MojDbKey::prepend(const MojDbKey& key)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
-	MojErr err = m_vec.insert(0, key.m_vec.begin(), key.m_vec.end());
+	MojSize oldSize = size();
+	if (!m_heap && oldSize + key.size() <= InlineSize) {
+		MojMemMove(m_inline + key.size(), m_inline, oldSize);
+		MojMemCpy(m_inline, key.data(), key.size());
+		m_size += key.size();
+		return MojErrNone;
+	}
+	MojErr err = spill();
+	MojErrCheck(err);
+	err = m_vec.insert(0, key.data(), key.data() + key.size());
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbKey::byteVec(ByteVec*& vecOut)
+{
+	vecOut = NULL;
+	MojErr err = spill();
 	MojErrCheck(err);
+	vecOut = &m_vec;
 
 	return MojErrNone;
 }
@@ -81,6 +179,32 @@ bool MojDbKey::stringPrefixOf(const MojDbKey& key) const
 	return (key.size() >= size() && MojMemCmp(data(), key.data(), size() - 1) == 0);
 }
 
+void MojDbKey::assignKey(const MojDbKey& key)
+{
+	if (key.m_heap) {
+		// the vector is shared, not copied
+		m_vec = key.m_vec;
+		m_heap = true;
+	} else {
+		MojMemCpy(m_inline, key.m_inline, key.m_size);
+		m_vec.clear();
+		m_size = key.m_size;
+		m_heap = false;
+	}
+}
+
+MojErr MojDbKey::spill()
+{
+	if (m_heap)
+		return MojErrNone;
+	// the key stays inline if this fails
+	MojErr err = m_vec.assign(m_inline, m_inline + m_size);
+	MojErrCheck(err);
+	m_heap = true;
+
+	return MojErrNone;
+}
+
 MojDbKeyRange::MojDbKeyRange(const MojDbKey& lowerKey, const MojDbKey& upperKey, MojUInt32 group)
 : m_group(group)
 {
@@ -127,9 +251,17 @@ MojErr MojDbKeyBuilder::push(const KeySet& vals)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
-	MojErr err = m_stack.push(PropRec(vals));
+	MojErr err = m_props.push(m_vals.size());
 	MojErrCheck(err);
-
+	for (KeySet::ConstIterator i = vals.begin(); i != vals.end(); ++i) {
+		Val val;
+		val.m_offset = m_arena.size();
+		val.m_size = i->size();
+		err = m_arena.append(i->data(), i->data() + i->size());
+		MojErrCheck(err);
+		err = m_vals.push(val);
+		MojErrCheck(err);
+	}
 	return MojErrNone;
 }
 
@@ -138,49 +270,45 @@ MojErr MojDbKeyBuilder::keys(KeySet& keysOut)
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
 	keysOut.clear();
-	if (m_stack.empty())
+	MojSize numProps = m_props.size();
+	if (numProps == 0)
 		return MojErrNone;
 
-	// reset iters
-	PropStack::Iterator pos;
-	MojErr err = m_stack.begin(pos);
-	MojErrCheck(err);
-	for (PropStack::Iterator i = pos; i != m_stack.end(); ++i)
-		i->reset();
 	// create set of all combinations containing one value from each property.
-	// we do this iteratively, using our vector of values as a stack.
-	PropStack::Iterator last = pos + m_stack.size() - 1;
-	for(;;) {
-		if (pos->m_iter == pos->m_vals.end()) {
-			// if we reached the end of the first rec, we're done
-			if (pos == m_stack.begin())
-				break;
-			// reset iter on current rec
-			pos->reset();
-			// pop back up one rec
-			--pos;
-			// advance the iter in the now-current rec
-			++(pos->m_iter);
-		} else if (pos == last) {
-			// walk up the stack and create a key
-			MojDbKey key;
-			MojDbKey::ByteVec& vec = key.byteVec();
-			for (PropStack::ConstIterator i = m_stack.begin();
-				 i != m_stack.end();
-				 ++i) {
-				const MojDbKey::ByteVec& stackVec = i->m_iter->byteVec();
-				err = vec.append(stackVec.begin(), stackVec.end());
-				MojErrCheck(err);
-			}
-			// add key to output set
-			err = keysOut.put(key);
+	// pos[i] is the index in m_vals of the current value of property i, and
+	// property i's values end where property i + 1's begin.
+	SizeVec pos;
+	MojErr err = pos.assign(m_props.begin(), m_props.end());
+	MojErrCheck(err);
+	SizeVec::Iterator cur;
+	err = pos.begin(cur);
+	MojErrCheck(err);
+	for (MojSize i = 0; i < numProps; ++i) {
+		if (cur[i] == propEnd(i))
+			return MojErrNone;
+	}
+
+	const MojByte* arena = m_arena.begin();
+	const Val* vals = m_vals.begin();
+	for (;;) {
+		MojDbKey key;
+		for (MojSize i = 0; i < numProps; ++i) {
+			const Val& val = vals[cur[i]];
+			err = key.append(arena + val.m_offset, val.m_size);
 			MojErrCheck(err);
-			// advance iter in current rec
-			++(pos->m_iter);
-		} else {
-			// push
-			++pos;
+		}
+		err = keysOut.put(key);
+		MojErrCheck(err);
+
+		// advance like an odometer, last property fastest
+		MojSize i = numProps;
+		for (;;) {
+			--i;
+			if (++cur[i] != propEnd(i))
+				break;
+			if (i == 0)
+				return MojErrNone;
+			cur[i] = m_props.at(i);
 		}
 	}
-	return MojErrNone;
 }
@@ -23,6 +23,7 @@
 #include "db/MojDbIsamQuery.h"
 #include "db/MojDbIndex.h"
 
+const MojChar* const MojDbKind::CompressKey = _T("compress");
 const MojChar* const MojDbKind::CountKey = _T("count");
 const MojChar* const MojDbKind::DelCountKey = _T("delCount");
 const MojChar* const MojDbKind::DelSizeKey = _T("delSize");
@@ -52,6 +53,7 @@ MojDbKind::MojDbKind(MojDbStorageDatabase* db, MojDbKindEngine* kindEngine, bool
   m_kindEngine(kindEngine),
   m_backup(false),
   m_builtin(builtIn),
+  m_compress(false),
   m_updateRev(0)
 {
 }
@@ -321,6 +323,9 @@ MojErr MojDbKind::configure(const MojObject& obj, const KindMap& map, const MojS
 	bool backup = false;
 	if (obj.get(SyncKey, backup))
 		m_backup = backup;
+	// compression - only applies to objects written from now on
+	m_compress = false;
+	obj.get(CompressKey, m_compress);
 	bool updating = !m_obj.undefined();
 
 	// load state
@@ -491,11 +496,15 @@ MojErr MojDbKind::find(MojDbCursor& cursor, MojDbWatcher* watcher, MojDbReq& req
 	MojErr err = checkPermission(op, req);
 	MojErrCheck(err);
 	const MojDbQuery& query = cursor.query();
-	MojDbIndex* index = indexForQuery(query);
+	MojDbIndex* index = NULL;
+	MojSize estimate = MojInvalidSize;
+	err = chooseIndex(query, cursor, watcher, req, index, estimate);
+	MojErrCheck(err);
 	if (index == NULL)
 		MojErrThrow(MojErrDbNoIndexForQuery);
 
 	cursor.m_dbIndex = index;
+	cursor.m_estimate = estimate;
     LOG_DEBUG("[db_mojodb] Dbkind_find: Kind: %s, UsingIndex: %s, order: %s, limit: %d \n", m_id.data(), index->name().data(),
         query.order().data(), (int)query.limit());
 	err = index->find(cursor, watcher, req);
@@ -706,8 +715,12 @@ MojErr MojDbKind::preUpdate(MojObject* newObj, const MojObject* oldObj, MojDbReq
 		}
 	}
 
-    // increment update revision
+    // increment update revision; cached search results of older revisions are now stale
     incUpdateRevision();
+    if (m_kindEngine && m_kindEngine->db()) {
+        MojErr err = m_kindEngine->db()->searchCache()->invalidate(m_id, m_updateRev);
+        MojErrCheck(err);
+    }
 
 	return MojErrNone;
 }
@@ -835,7 +848,7 @@ MojDbIndex* MojDbKind::indexForQuery(const MojDbQuery& query) const
 	// check our indexes
 	for (IndexVec::ConstIterator i = m_indexes.begin();
 		 i != m_indexes.end(); ++i) {
-		if ((*i)->canAnswer(query)) {		// will this always find the best index?
+		if ((*i)->canAnswer(query)) {		// find() ranks the candidates with chooseIndex
 			return i->get();
 		}
 	}
@@ -843,6 +856,56 @@ MojDbIndex* MojDbKind::indexForQuery(const MojDbQuery& query) const
 	return NULL;
 }
 
+MojErr MojDbKind::chooseIndex(const MojDbQuery& query, MojDbCursor& cursor, MojDbWatcher* watcher, MojDbReq& req,
+							  MojDbIndex*& indexOut, MojSize& estimateOut)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	indexOut = NULL;
+	estimateOut = MojInvalidSize;
+	if (query.m_forceIndex) {
+		indexOut = query.m_forceIndex;
+		return MojErrNone;
+	}
+	// collect every index that can answer the query
+	MojVector<MojDbIndex*> candidates;
+	for (IndexVec::ConstIterator i = m_indexes.begin();
+		 i != m_indexes.end(); ++i) {
+		if ((*i)->canAnswer(query)) {
+			MojErr err = candidates.push(i->get());
+			MojErrCheck(err);
+		}
+	}
+	if (candidates.size() <= 1) {
+		// nothing to choose between, so don't pay for an estimate
+		if (!candidates.empty())
+			indexOut = candidates.front();
+		return MojErrNone;
+	}
+	// sample through the txn the find will read with rather than one per candidate. A watched
+	// find has to add its watch before that txn begins, so without a txn of its own it is
+	// ranked on tracked key counts alone.
+	if (!watcher) {
+		MojErr err = candidates.front()->beginTxn(cursor, req);
+		MojErrCheck(err);
+	}
+	MojDbStorageTxn* txn = cursor.txn() ? cursor.txn() : req.txn();
+	// pick the one that scans the fewest keys, keeping sort order on ties
+	for (MojVector<MojDbIndex*>::ConstIterator i = candidates.begin(); i != candidates.end(); ++i) {
+		MojSize keys = 0;
+		MojErr err = (*i)->estimate(query, txn, keys);
+		MojErrCheck(err);
+		if (indexOut == NULL || keys < estimateOut) {
+			indexOut = *i;
+			estimateOut = keys;
+		}
+	}
+	LOG_DEBUG("[db_mojodb] Kind_chooseIndex: %s; candidates: %zu; chose: %s; estimate: %zu \n",
+		m_id.data(), candidates.size(), indexOut->name().data(), estimateOut);
+
+	return MojErrNone;
+}
+
 MojErr MojDbKind::updateSupers(const KindMap& map, const StringVec& superIds, bool updating, MojDbReq& req)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
@@ -974,7 +1037,32 @@ MojErr MojDbKind::openIndex(MojDbIndex* index, MojDbReq& req)
 	MojRefCountedPtr<MojDbStorageIndex> storageIndex;
 	err = m_db->openIndex(id, req.txn(), storageIndex);
 	MojErrCheck(err);
-	err = index->open(storageIndex.get(), id, req, created);
+	// decide whether the index is filled inline or by the background builder
+	bool building = false;
+	if (index->isIdIndex()) {
+		// the id index is the primary store and is never built
+	} else if (created) {
+		if (m_kindEngine->db()->indexBuilder()->enabled()) {
+			err = m_state->setIndexBuilding(index->name(), true, req);
+			MojErrCheck(err);
+			building = true;
+		}
+	} else {
+		// resume a build that was interrupted by a close or a crash
+		err = m_state->indexBuilding(index->name(), req, building);
+		MojErrCheck(err);
+	}
+	err = index->open(storageIndex.get(), id, req, created, building);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbKind::indexBuilt(const MojString& indexName, MojDbReq& req)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	MojErr err = m_state->setIndexBuilding(indexName, false, req);
 	MojErrCheck(err);
 
 	return MojErrNone;
@@ -28,6 +28,7 @@ const MojChar* const MojDbKindEngine::KindIdPrefix = _T("_kinds/");
 // db names
 const MojChar* const MojDbKindEngine::KindsDbName = _T("kinds.db");
 const MojChar* const MojDbKindEngine::IndexIdsDbName = _T("indexIds.db");
+const MojChar* const MojDbKindEngine::IndexCountsDbName = _T("indexCounts.db");
 const MojChar* const MojDbKindEngine::IndexIdsSeqName = _T("indexId");
 // Kind built-in
 const MojChar* const MojDbKindEngine::KindKindId = _T("Kind:1");
@@ -85,10 +86,14 @@ MojErr MojDbKindEngine::open(MojDb* db, MojDbReq& req)
 	MojDbStorageEngine* engine = db->storageEngine();
 	MojDbStorageTxn* txn = req.txn();
 	MojAssert(engine);
-	MojErr err = engine->openDatabase(KindsDbName, txn, m_kindDb);
+	MojErr err = initHeaderNames();
+	MojErrCheck(err);
+	err = engine->openDatabase(KindsDbName, txn, m_kindDb);
 	MojErrCheck(err);
 	err = engine->openDatabase(IndexIdsDbName, txn, m_indexIdDb);
 	MojErrCheck(err);
+	err = engine->openDatabase(IndexCountsDbName, txn, m_indexCountDb);
+	MojErrCheck(err);
 	err = engine->openSequence(IndexIdsSeqName, txn, m_indexIdSeq);
 	MojErrCheck(err);
 	// built-in kinds
@@ -137,6 +142,9 @@ MojErr MojDbKindEngine::close()
 		errClose = m_indexIdDb->close();
 		MojErrAccumulate(err, errClose);
 		m_indexIdDb.reset();
+		errClose = m_indexCountDb->close();
+		MojErrAccumulate(err, errClose);
+		m_indexCountDb.reset();
 		// close kind db
 		errClose = m_kindDb->close();
 		MojErrAccumulate(err, errClose);
@@ -408,6 +416,20 @@ MojErr MojDbKindEngine::setupRootKind()
 	return MojErrNone;
 }
 
+MojErr MojDbKindEngine::initHeaderNames()
+{
+	MojErr err = m_headerNames.m_id.assign(MojDb::IdKey);
+	MojErrCheck(err);
+	err = m_headerNames.m_kind.assign(MojDb::KindKey);
+	MojErrCheck(err);
+	err = m_headerNames.m_rev.assign(MojDb::RevKey);
+	MojErrCheck(err);
+	err = m_headerNames.m_del.assign(MojDb::DelKey);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
 MojErr MojDbKindEngine::addBuiltin(const MojChar* json, MojDbReq& req)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
@@ -23,6 +23,7 @@
 #include "core/MojObjectSerialization.h"
 #include "core/MojLogDb8.h"
 
+const MojChar* const MojDbKindState::BuildingIndexesKey = _T("buildingIndexes");
 const MojChar* const MojDbKindState::IndexIdsKey = _T("indexIds");
 const MojChar* const MojDbKindState::KindTokensKey = _T("kindTokens");
 const MojChar* const MojDbKindState::TokensKey = _T("tokens");
@@ -82,6 +83,59 @@ MojErr MojDbKindState::delIndex(const MojChar* indexName, MojDbReq& req)
 	err = writeIds(IndexIdsKey, obj, req, item);
 	MojErrCheck(err);
 
+	// forget about any build that was still in progress
+	MojObject buildingObj;
+	err = readIds(BuildingIndexesKey, req, buildingObj, item);
+	MojErrCheck(err);
+	err = buildingObj.del(indexName, found);
+	MojErrCheck(err);
+	if (found) {
+		err = writeIds(BuildingIndexesKey, buildingObj, req, item);
+		MojErrCheck(err);
+	}
+
+	return MojErrNone;
+}
+
+MojErr MojDbKindState::indexBuilding(const MojChar* indexName, MojDbReq& req, bool& buildingOut)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(indexName);
+	MojThreadGuard guard(m_lock);
+
+	buildingOut = false;
+	MojObject obj;
+	MojRefCountedPtr<MojDbStorageItem> item;
+	MojErr err = readIds(BuildingIndexesKey, req, obj, item);
+	MojErrCheck(err);
+	obj.get(indexName, buildingOut);
+
+	return MojErrNone;
+}
+
+MojErr MojDbKindState::setIndexBuilding(const MojChar* indexName, bool building, MojDbReq& req)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(indexName);
+	MojThreadGuard guard(m_lock);
+
+	MojObject obj;
+	MojRefCountedPtr<MojDbStorageItem> item;
+	MojErr err = readIds(BuildingIndexesKey, req, obj, item);
+	MojErrCheck(err);
+	if (building) {
+		err = obj.putBool(indexName, true);
+		MojErrCheck(err);
+	} else {
+		bool found = false;
+		err = obj.del(indexName, found);
+		MojErrCheck(err);
+		if (!found)
+			return MojErrNone;
+	}
+	err = writeIds(BuildingIndexesKey, obj, req, item);
+	MojErrCheck(err);
+
 	return MojErrNone;
 }
 
@@ -96,7 +150,7 @@ MojErr MojDbKindState::tokenSet(TokenVec& vecOut, MojObject& tokensObjOut) const
 	return MojErrNone;
 }
 
-MojErr MojDbKindState::addToken(const MojChar* propName, MojUInt8& tokenOut, TokenVec& vecOut, MojObject& tokenObjOut)
+MojErr MojDbKindState::addToken(const MojChar* propName, MojUInt32& tokenOut, TokenVec& vecOut, MojObject& tokenObjOut)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 	MojAssert(propName);
@@ -109,7 +163,7 @@ MojErr MojDbKindState::addToken(const MojChar* propName, MojUInt8& tokenOut, Tok
 	return MojErrNone;
 }
 
-MojErr MojDbKindState::addPropImpl(const MojChar* propName, bool write, MojUInt8& tokenOut, TokenVec& vecOut, MojObject& tokenObjOut)
+MojErr MojDbKindState::addPropImpl(const MojChar* propName, bool write, MojUInt32& tokenOut, TokenVec& vecOut, MojObject& tokenObjOut)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 	MojAssert(propName);
@@ -123,12 +177,12 @@ MojErr MojDbKindState::addPropImpl(const MojChar* propName, bool write, MojUInt8
 	MojErr err = m_tokensObj.get(propName, token, found);
 	MojErrCheck(err);
 	if (found) {
-		MojAssert(token <= MojUInt8Max);
-		tokenOut = (MojUInt8) token;
+		MojAssert(token <= MaxToken);
+		tokenOut = token;
 		return MojErrNone;
 	}
 	// update the db and our in-memory state
-	if (m_nextToken < MojUInt8Max) {
+	if (m_nextToken <= MaxToken) {
 		// update copies of obj and vec
 		MojObject obj(m_tokensObj);
 		TokenVec tokenVec(m_tokenVec);
@@ -182,24 +236,24 @@ MojErr MojDbKindState::initTokens(MojDbReq& req, const StringSet& strings)
 	MojErrCheck(err);
 
 	// populate token vec
-	MojUInt8 maxToken = 0;
+	MojUInt32 maxToken = 0;
 	err = m_tokenVec.resize(m_tokensObj.size());
 	MojErrCheck(err);
 	for (MojObject::ConstIterator i = m_tokensObj.begin(); i != m_tokensObj.end(); ++i) {
 		MojString key = i.key();
 		MojInt64 value = i.value().intValue();
 		MojSize idx = (MojSize) (value - MojObjectWriter::TokenStartMarker);
-		if (value < MojObjectWriter::TokenStartMarker || value >= MojUInt8Max || idx >= m_tokenVec.size()) {
+		if (value < MojObjectWriter::TokenStartMarker || value > MaxToken || idx >= m_tokenVec.size()) {
 			MojErrThrow(MojErrDbInvalidToken);
 		}
 		if (value > maxToken) {
-			maxToken = (MojUInt8) value;
+			maxToken = (MojUInt32) value;
 		}
 		err = m_tokenVec.setAt(idx, key);
 		MojErrCheck(err);
 	}
 	if (maxToken > 0) {
-		m_nextToken = (MojUInt8) (maxToken + 1);
+		m_nextToken = maxToken + 1;
 	}
 
 	// add strings
@@ -207,7 +261,7 @@ MojErr MojDbKindState::initTokens(MojDbReq& req, const StringSet& strings)
 	for (StringSet::ConstIterator i = strings.begin(); i != strings.end(); ++i) {
 		if (!m_tokensObj.contains(*i)) {
 			updated = true;
-			MojUInt8 token = 0;
+			MojUInt32 token = 0;
 			TokenVec tokenVec;
 			MojObject tokenObj;
 			err = addPropImpl(*i, false, token, tokenVec, tokenObj);
@@ -240,7 +294,7 @@ MojErr MojDbKindState::id(const MojChar* name, const MojChar* objKey, MojDbReq&
 		MojDbStorageSeq* seq = m_kindEngine->indexSeq();
 		MojAssert(seq);
 		MojInt64 id = 0;
-		MojErr err = seq->get(id);
+		MojErr err = seq->get(id, req.txn());
 		MojErrCheck(err);
 		// update copy of id map and write it out
 		err = obj.put(name, id);
@@ -94,7 +94,7 @@ MojErr MojDbObjectHeader::read(MojDbKindEngine& kindEngine)
 	MojDataReader& dataReader = m_reader.dataReader();
 	MojErr err = dataReader.readUInt8(version);
 	MojErrCheck(err);
-	if (version != Version)
+	if (version < MinVersion || version > Version)
 		MojErrThrow(MojErrDbHeaderVersionMismatch);
 	// kindId
 	MojObjectBuilder builder;
@@ -164,21 +164,33 @@ MojErr MojDbObjectHeader::visit(MojObjectVisitor& visitor, MojDbKindEngine& kind
 	MojErr err = read(kindEngine);
 	MojErrCheck(err);
 
+	// names come from the kind engine and the kind id from its token map,
+	// so visitors that keep them can share rather than copy the strings
+	const MojDbKindEngine::HeaderNames& names = kindEngine.headerNames();
+	MojAssert(!names.m_id.empty());
 	m_reader.skipBeginObj();
 	err = visitor.beginObject();
 	MojErrCheck(err);
 	// id
-	err = visitor.objectProp(MojDb::IdKey, m_id);
+	err = visitor.sharedPropName(names.m_id);
+	MojErrCheck(err);
+	err = m_id.visit(visitor);
 	MojErrCheck(err);
 	// kind
-	err = visitor.stringProp(MojDb::KindKey, m_kindId);
+	err = visitor.sharedPropName(names.m_kind);
+	MojErrCheck(err);
+	err = visitor.sharedStringValue(m_kindId);
 	MojErrCheck(err);
 	// rev
-	err = visitor.intProp(MojDb::RevKey, m_rev);
+	err = visitor.sharedPropName(names.m_rev);
+	MojErrCheck(err);
+	err = visitor.intValue(m_rev);
 	MojErrCheck(err);
 	// del
 	if (m_del) {
-		err = visitor.boolProp(MojDb::DelKey, m_del);
+		err = visitor.sharedPropName(names.m_del);
+		MojErrCheck(err);
+		err = visitor.boolValue(m_del);
 		MojErrCheck(err);
 	}
 	return MojErrNone;
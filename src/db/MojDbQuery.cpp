@@ -107,8 +107,10 @@ MojErr MojDbQuery::Page::fromObject(const MojObject& obj)
 	MojString str;
 	MojErr err = obj.stringValue(str);
 	MojErrCheck(err);
-	err = str.base64Decode(m_key.byteVec());
+	MojDbKey::ByteVec vec;
+	err = str.base64Decode(vec);
 	MojErrCheck(err);
+	m_key = vec;
 
 	return MojErrNone;
 }
@@ -117,8 +119,11 @@ MojErr MojDbQuery::Page::toObject(MojObject& objOut) const
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
+	MojDbKey::ByteVec vec;
+	MojErr err = vec.assign(m_key.data(), m_key.data() + m_key.size());
+	MojErrCheck(err);
 	MojString str;
-	MojErr err = str.base64Encode(m_key.byteVec(), false);
+	err = str.base64Encode(vec, false);
 	MojErrCheck(err);
 	objOut = str;
 
@@ -213,8 +213,8 @@ MojErr MojDbQueryPlan::rangesFromKeys(MojDbKey lowerKey, MojDbKey upperKey, MojD
 	case MojDbQuery::OpPrefix:
 		// remove null terminator
 		MojAssert(!prefix.empty());
-		if (prefix.byteVec().back() == 0) {
-			err = prefix.byteVec().pop();
+		if (prefix.data()[prefix.size() - 1] == 0) {
+			err = prefix.truncate(prefix.size() - 1);
 			MojErrCheck(err);
 		}
 		// no break. fall through to OpEq case
@@ -19,7 +19,9 @@
 #include "db/MojDbKind.h"
 #include "db/MojDbQuery.h"
 #include "db/MojDbSearchCache.h"
-#include <vector>
+
+const MojChar* const MojDbSearchCache::MaxBytesKey = _T("searchCacheMaxBytes");
+const MojChar* const MojDbSearchCache::StatsKey = _T("_searchCache");
 
 MojErr MojDbSearchCache::QueryKey::setQuery(const MojDbQuery& query)
 {
@@ -44,9 +46,11 @@ MojErr MojDbSearchCache::QueryKey::fromQuery(const MojDbQuery& query, MojUInt32
     return setQuery(query);
 }
 
-bool MojDbSearchCache::contain(const QueryKey& a_key) const
+MojSize MojDbSearchCache::QueryKey::hash() const
 {
-    return (m_container.find(a_key) != m_container.end());
+    MojSize h = MojHash(m_kind.data(), m_kind.length());
+    h = h * 31 + MojHash(m_query.data(), m_query.length());
+    return h * 31 + m_rev;
 }
 
 bool MojDbSearchCache::QueryKey::operator==(const QueryKey& a_rhsKey) const
@@ -61,78 +65,289 @@ bool MojDbSearchCache::QueryKey::operator==(const QueryKey& a_rhsKey) const
 bool MojDbSearchCache::QueryKey::operator<(const QueryKey& a_rhsKey) const
 {
     int eqKind = m_kind.compare(a_rhsKey.m_kind);
-    if (eqKind < 0)
-        return true;
+    if (eqKind != 0)
+        return eqKind < 0;
 
-    int eqQuery = strncmp(m_query.data(), a_rhsKey.m_query.data(),
-                m_query.length());
-    if (eqKind == 0 && eqQuery < 0)
-        return true;
+    int eqQuery = m_query.compare(a_rhsKey.m_query);
+    if (eqQuery != 0)
+        return eqQuery < 0;
 
-    if (eqKind == 0 && eqQuery == 0 && m_rev < a_rhsKey.getRev())
-        return true;
+    return m_rev < a_rhsKey.getRev();
+}
 
-    return false;
+MojDbSearchCache::MojDbSearchCache()
+: m_bytes(0),
+  m_maxBytes(MaxBytesDefault),
+  m_hits(0),
+  m_misses(0),
+  m_evictions(0),
+  m_invalidations(0)
+{
+}
+
+MojDbSearchCache::~MojDbSearchCache()
+{
+    clear();
+}
+
+MojErr MojDbSearchCache::configure(const MojObject& conf)
+{
+    MojThreadGuard guard(m_mutex);
+
+    MojInt64 maxBytes = MaxBytesDefault;
+    if (conf.get(MaxBytesKey, maxBytes) && maxBytes >= 0) {
+        m_maxBytes = (MojSize) maxBytes;
+    } else {
+        m_maxBytes = MaxBytesDefault;
+    }
+    MojErr err = evict(0);
+    MojErrCheck(err);
+
+    return MojErrNone;
+}
+
+bool MojDbSearchCache::contain(const QueryKey& a_key) const
+{
+    MojThreadGuard guard(m_mutex);
+    return m_entries.contains(a_key);
+}
+
+MojSize MojDbSearchCache::size() const
+{
+    MojThreadGuard guard(m_mutex);
+    return m_entries.size();
+}
+
+MojSize MojDbSearchCache::bytes() const
+{
+    MojThreadGuard guard(m_mutex);
+    return m_bytes;
 }
 
 MojErr MojDbSearchCache::createCache(const QueryKey& a_key, const IdSet& a_ids)
 {
-    m_container.insert(Container::value_type(a_key, a_ids));
+    MojThreadGuard guard(m_mutex);
+    if (m_entries.contains(a_key))
+        return MojErrNone;
+
+    MojErr err = insert(a_key, a_ids);
+    MojErrCheck(err);
+
     return MojErrNone;
 }
 
 MojErr MojDbSearchCache::destroyCache(const QueryKey& a_key)
 {
-    m_container.erase(a_key);
+    MojThreadGuard guard(m_mutex);
+
+    Entry* entry = NULL;
+    if (m_entries.get(a_key, entry)) {
+        MojErr err = erase(entry);
+        MojErrCheck(err);
+    }
     return MojErrNone;
 }
 
 MojErr MojDbSearchCache::destroyCache(const MojString& a_kind)
 {
-    // TODO: Change this to use map::lower_bound or upper_bound.
-    //
-    std::vector<Container::key_type> keys;
-    for(Container::const_iterator i = m_container.begin(); i != m_container.end(); ++i)
-    {
-        if(i->first.m_kind == a_kind)
-            keys.push_back(i->first);
-    }
+    MojThreadGuard guard(m_mutex);
+
+    MojInt64 count = 0;
+    MojErr err = eraseKind(a_kind, MojUInt32Max, count);
+    MojErrCheck(err);
 
-    // TODO: Change this to use post-increment for iterator.
-    //
-    for (unsigned i=0; i<keys.size(); ++i)
-    {
-        m_container.erase(keys[i]);
-    }
     return MojErrNone;
 }
 
 MojErr MojDbSearchCache::updateCache(const QueryKey& a_key, const IdSet& a_ids)
 {
+    MojThreadGuard guard(m_mutex);
+
     // Skip updating the cache ONLY if up-to-date cache is available.
     //
-    if (contain(a_key) == true)
+    if (m_entries.contains(a_key))
         return MojErrNone;
 
-    // Delete any cache for this query/kind here.
+    // Entries of this kind built from older revisions can never be hit again.
     //
-    MojErr err = destroyCache(a_key.getKind());
+    MojInt64 count = 0;
+    MojErr err = eraseKind(a_key.getKind(), a_key.getRev(), count);
     MojErrCheck(err);
+    m_invalidations += count;
 
-    // Add new cache.
-    //
-    err = createCache(a_key, a_ids);
+    err = insert(a_key, a_ids);
     MojErrCheck(err);
 
     return MojErrNone;
 }
 
-MojErr MojDbSearchCache::getIdSet(const QueryKey& a_key, IdSet& a_ids) const
+MojErr MojDbSearchCache::getIdSet(const QueryKey& a_key, IdSet& a_ids)
+{
+    bool found = false;
+    return getIdSet(a_key, a_ids, found);
+}
+
+MojErr MojDbSearchCache::getIdSet(const QueryKey& a_key, IdSet& a_ids, bool& foundOut)
 {
-    Container::const_iterator citer = m_container.find(a_key);
-    if (citer != m_container.end())
-        a_ids = citer->second;
+    MojThreadGuard guard(m_mutex);
 
+    Entry* entry = NULL;
+    foundOut = m_entries.get(a_key, entry);
+    if (foundOut) {
+        ++m_hits;
+        a_ids = entry->m_ids;
+        // move to the most recently used end
+        m_lru.erase(entry);
+        m_lru.pushFront(entry);
+    } else {
+        ++m_misses;
+    }
     return MojErrNone;
 }
 
+MojErr MojDbSearchCache::invalidate(const MojString& a_kind, MojUInt32 a_revision)
+{
+    MojThreadGuard guard(m_mutex);
+
+    // cheap check first; this runs on every update of every kind
+    MojUInt32 kindCount = 0;
+    if (!m_kindCounts.get(a_kind, kindCount) || kindCount == 0)
+        return MojErrNone;
+
+    MojInt64 count = 0;
+    MojErr err = eraseKind(a_kind, a_revision, count);
+    MojErrCheck(err);
+    m_invalidations += count;
+
+    return MojErrNone;
+}
+
+MojErr MojDbSearchCache::stats(MojObject& objOut) const
+{
+    MojThreadGuard guard(m_mutex);
+
+    MojErr err = objOut.put(_T("entries"), (MojInt64) m_entries.size());
+    MojErrCheck(err);
+    err = objOut.put(_T("bytes"), (MojInt64) m_bytes);
+    MojErrCheck(err);
+    err = objOut.put(_T("maxBytes"), (MojInt64) m_maxBytes);
+    MojErrCheck(err);
+    err = objOut.put(_T("hits"), m_hits);
+    MojErrCheck(err);
+    err = objOut.put(_T("misses"), m_misses);
+    MojErrCheck(err);
+    err = objOut.put(_T("evictions"), m_evictions);
+    MojErrCheck(err);
+    err = objOut.put(_T("invalidations"), m_invalidations);
+    MojErrCheck(err);
+
+    return MojErrNone;
+}
+
+MojSize MojDbSearchCache::idSetBytes(const QueryKey& key, const IdSet& ids)
+{
+    MojSize bytes = sizeof(Entry) + key.m_kind.length() + key.m_query.length();
+    for (IdSet::ConstIterator i = ids.begin(); i != ids.end(); ++i) {
+        bytes += sizeof(MojObject);
+        if (i->type() == MojObject::TypeString) {
+            MojString str;
+            if (i->stringValue(str) == MojErrNone)
+                bytes += str.length();
+        }
+    }
+    return bytes;
+}
+
+MojErr MojDbSearchCache::insert(const QueryKey& key, const IdSet& ids)
+{
+    MojSize bytes = idSetBytes(key, ids);
+    if (bytes > m_maxBytes) {
+        // would evict everything else and still not fit
+        return MojErrNone;
+    }
+    MojErr err = evict(bytes);
+    MojErrCheck(err);
+
+    MojAutoPtr<Entry> entry(new Entry);
+    MojAllocCheck(entry.get());
+    entry->m_key = key;
+    entry->m_ids = ids;
+    entry->m_bytes = bytes;
+
+    MojUInt32 kindCount = 0;
+    m_kindCounts.get(key.getKind(), kindCount);
+    err = m_kindCounts.put(key.getKind(), kindCount + 1);
+    MojErrCheck(err);
+    err = m_entries.put(key, entry.get());
+    MojErrCheck(err);
+
+    m_bytes += bytes;
+    m_lru.pushFront(entry.release());
+
+    return MojErrNone;
+}
+
+MojErr MojDbSearchCache::erase(Entry* entry)
+{
+    MojAssert(entry);
+
+    bool found = false;
+    MojErr err = m_entries.del(entry->m_key, found);
+    MojErrCheck(err);
+    MojAssert(found);
+
+    MojUInt32 kindCount = 0;
+    if (m_kindCounts.get(entry->m_key.getKind(), kindCount)) {
+        if (kindCount <= 1) {
+            err = m_kindCounts.del(entry->m_key.getKind(), found);
+            MojErrCheck(err);
+        } else {
+            err = m_kindCounts.put(entry->m_key.getKind(), kindCount - 1);
+            MojErrCheck(err);
+        }
+    }
+
+    MojAssert(m_bytes >= entry->m_bytes);
+    m_bytes -= entry->m_bytes;
+    m_lru.erase(entry);
+    delete entry;
+
+    return MojErrNone;
+}
+
+MojErr MojDbSearchCache::eraseKind(const MojString& kind, MojUInt32 belowRev, MojInt64& countOut)
+{
+    countOut = 0;
+    EntryList::Iterator i = m_lru.begin();
+    while (i != m_lru.end()) {
+        Entry* entry = *i;
+        ++i;
+        if (entry->m_key.getKind() == kind && entry->m_key.getRev() < belowRev) {
+            MojErr err = erase(entry);
+            MojErrCheck(err);
+            ++countOut;
+        }
+    }
+    return MojErrNone;
+}
+
+MojErr MojDbSearchCache::evict(MojSize needed)
+{
+    while (!m_lru.empty() && m_bytes + needed > m_maxBytes) {
+        MojErr err = erase(m_lru.back());
+        MojErrCheck(err);
+        ++m_evictions;
+    }
+    return MojErrNone;
+}
+
+void MojDbSearchCache::clear()
+{
+    while (!m_lru.empty()) {
+        Entry* entry = m_lru.popFront();
+        delete entry;
+    }
+    m_entries.clear();
+    m_kindCounts.clear();
+    m_bytes = 0;
+}
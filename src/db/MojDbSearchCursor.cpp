@@ -18,6 +18,7 @@
 
 
 #include "db/MojDbSearchCursor.h"
+#include "db/MojDbTextCollator.h"
 #include "db/MojDbExtractor.h"
 #include "db/MojDbIndex.h"
 #include "db/MojDbKind.h"
@@ -26,7 +27,9 @@
 MojDbSearchCursor::MojDbSearchCursor(MojString localeStr)
 : m_limit(0),
   m_pos(NULL),
-  m_locale(localeStr)
+  m_locale(localeStr),
+  m_count(0),
+  m_inPage(true)
 {
 }
 
@@ -46,6 +49,7 @@ MojErr MojDbSearchCursor::close()
 	m_pos = NULL;
 	m_limitPos = NULL;
 	m_items.clear();
+	m_sortProps.clear();
 
 	return err;
 }
@@ -78,55 +82,6 @@ MojErr MojDbSearchCursor::count(MojUInt32& countOut)
 	return MojErrNone;
 }
 
-/***********************************************************************
- * setPagePosition
- *
- * Move cursor position to page id provided in query.
- *   1. Find item "_id" which is equal to page id iteratively.
- *   2. If found, set begin/last position and next page.
- ***********************************************************************/
-MojErr MojDbSearchCursor::setPagePosition()
-{
-    LOG_TRACE("Entering function %s", __FUNCTION__);
-
-    MojErr err;
-    MojDbStorageItem* item;
-    m_pos = m_items.begin();
-    ItemVec::ConstIterator last = m_items.end();
-    m_limitPos = last;
-    // retrieve page id from query
-    MojObject pageKey;
-    err = m_page.toObject(pageKey);
-    MojErrCheck(err);
-    while (m_pos != last) {
-        // retrieve id from query
-        item = m_pos->get();
-        const MojObject id = item->id();
-        // If match, set begin/last position and next page
-        if(pageKey.compare(id) == 0) {
-            if (m_limit >= (last-m_pos)) {
-                m_limitPos = m_items.end();
-                m_page.clear();
-            } else {
-                m_limitPos = m_pos + m_limit;
-                // set next page
-                MojDbStorageItem* nextItem = m_limitPos->get();
-                const MojObject nextId = nextItem->id();
-                m_page.fromObject(nextId);
-                // print log for nextId
-                MojString strOut;
-                err = nextId.toJson(strOut);
-                MojErrCheck(err);
-                LOG_DEBUG("[db_mojodb] nextId : %s \n", strOut.data());
-            }
-            break;
-        }
-        ++m_pos;
-    }
-
-    return MojErrNone;
-}
-
 /***********************************************************************
  * nextPage
  *
@@ -159,6 +114,16 @@ MojErr MojDbSearchCursor::init(const MojDbQuery& query)
 	} else {
 		m_orderProp = query.order();
 	}
+	// sorting and filtering only look at these props, so nothing else is decoded
+	m_sortProps.clear();
+	if (!m_orderProp.empty()) {
+		err = addRootProp(m_orderProp, m_sortProps);
+		MojErrCheck(err);
+	}
+	for (MojDbQuery::WhereMap::ConstIterator i = query.filter().begin(); i != query.filter().end(); ++i) {
+		err = addRootProp(i.key(), m_sortProps);
+		MojErrCheck(err);
+	}
     // retrieve page info from query.
     MojDbQuery::Page page;
     page = m_query.page();
@@ -167,7 +132,8 @@ MojErr MojDbSearchCursor::init(const MojDbQuery& query)
         MojErrCheck(err);
         m_page.fromObject(m_pageObject);
     }
-	m_query.limit(MaxResults);
+	// the sorter has no result cap, so neither does the storage query
+	m_query.limit(MojUInt32Max);
 
     MojObject obj;
     err = m_query.toObject(obj);
@@ -232,303 +198,358 @@ MojErr MojDbSearchCursor::begin()
         err = m_queryKey.fromQuery(m_cacheQuery, kind->getUpdateRevision());
         MojErrCheck(err);
 
+        // fetch the ids in one step; the entry may be evicted at any time
+        MojDbSearchCache::IdSet cachedIds;
         bool fromCache = false;
-        if(cache->contain(m_queryKey)) {
-            fromCache = true;
-        }
+        err = cache->getIdSet(m_queryKey, cachedIds, fromCache);
+        MojErrCheck(err);
 
-        err = load(fromCache);
+        err = load(fromCache, cachedIds);
         MojErrCheck(err);
     }
 
     return MojErrNone;
 }
 
-MojErr MojDbSearchCursor::load(bool fromCache)
+MojErr MojDbSearchCursor::load(bool fromCache, const MojDbSearchCache::IdSet& cachedIds)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
-    if(fromCache) {
-        MojDb* db = m_kindEngine->db();
-        MojAssert(db);
-
-        MojDbSearchCache* cache = db->searchCache();
-        MojAssert(cache);
+    // results are streamed past the page window: only the items of the requested page
+    // are kept, the rest are just counted and the first one beyond it becomes the next page
+    bool hasPage = !m_page.empty();
+    m_inPage = !hasPage;
+    m_count = 0;
+    m_page.clear();
 
-        MojErr err = loadFromCache(cache);
+    if(fromCache) {
+        // Here we don't need to sort, because we get the data with same query.
+        MojErr err = loadFromCache(cachedIds);
         MojErrCheck(err);
-
-        // Here we don't need sort(), distinct() and reverse(),
-        // because we get the data with same query.
-        //
     } else {
-        // pull unique ids from index
-        ObjectSet ids;
-        MojErr err = loadIds(ids);
+        MojErr err = loadSorted();
         MojErrCheck(err);
-
-        // load objects into memory
-        err = loadObjects(ids);
-        MojErrCheck(err);
-        // sort results
-        if (!m_orderProp.empty()) {
-        	err = sort();
-        	MojErrCheck(err);
-        }
-        // distinct
-        if (!m_distinct.empty()) {
-        	distinct();
-        }
-        // reverse for desc
-        if (m_query.desc()) {
-        	err = m_items.reverse();
-        	MojErrCheck(err);
-        }
     }
-    // next page
-    if (!m_page.empty()) {
-        MojErr err = setPagePosition();
-        MojErrCheck(err);
-    } else {
-        // set begin/last position.
-        m_pos = m_items.begin();
-        if (m_limit >= m_items.size()) {
-            m_limitPos = m_items.end();
-        } else {
-            // if item size is bigger than limit, set next page.
-            m_limitPos = m_items.begin() + m_limit;
-            MojDbStorageItem* nextItem = m_limitPos->get();
-            const MojObject nextId = nextItem->id();
-            m_page.fromObject(nextId);
-
-            // Update cache only if all followings are met;
-            //    - 'page' is not specified in given query.
-            //    - item size is bigger than limit.
-            //
-            MojDb *db = m_kindEngine->db();
-            MojAssert(db);
-            MojDbSearchCache* cache = db->searchCache();
-            MojAssert(cache);
-
-            MojDbSearchCache::IdSet ids;
-            MojErr err = getIds(ids);
-            MojErrCheck(err);
-
-            err = cache->updateCache(m_queryKey, ids);
-            MojErrCheck(err);
-        }
+    if (!m_inPage) {
+        // page id not found, hand the requested page back
+        m_page.fromObject(m_pageObject);
     }
 
-    // set remainder count
-    m_count = m_items.end() - m_pos;
+    // set begin/last position.
+    m_pos = m_items.begin();
+    m_limitPos = m_items.end();
 
 	return MojErrNone;
 }
 
-MojErr MojDbSearchCursor::loadIds(ObjectSet& idsOut)
+/***********************************************************************
+ * loadIds
+ *
+ * Feed every (id, group) pair the index produces to the id sorter, so the
+ * groups of an id come out next to each other. An id matches if it shows up
+ * in every group; matchOut is false when some group has no ids at all.
+ ***********************************************************************/
+MojErr MojDbSearchCursor::loadIds(MojDbExternalSorter& idSorter, bool& matchOut)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
-	MojUInt32 groupNum = 0;
-	bool found = false;
-	MojSharedPtr<ObjectSet> group;
-	GroupMap groupMap;
-
-	for(;;) {
-		// get current id
+	matchOut = false;
+	GroupSet groups;
+	MojDbKey idKey;
+	MojDbKey groupKey;
+	for (;;) {
 		MojObject id;
-		MojUInt32 idGroupNum = 0;
-		MojErr err = m_storageQuery->getId(id, idGroupNum, found);
+		MojUInt32 groupNum = 0;
+		bool found = false;
+		MojErr err = m_storageQuery->getId(id, groupNum, found);
 		MojErrCheck(err);
 		if (!found)
 			break;
 
-		// if it is in a new group, create a new set
-		if (!group.get() || idGroupNum != groupNum) {
-			// find/create new group
-			GroupMap::Iterator iter;
-			err = groupMap.find(idGroupNum, iter);
-			MojErrCheck(err);
-			if (iter != groupMap.end()) {
-				group = iter.value();
-			} else {
-				err = group.resetChecked(new ObjectSet);
-				MojErrCheck(err);
-				err = groupMap.put(idGroupNum, group);
-				MojErrCheck(err);
-			}
-			groupNum = idGroupNum;
+		err = groups.put(groupNum);
+		MojErrCheck(err);
+		err = idKey.assign(id);
+		MojErrCheck(err);
+		// big-endian, so the groups of an id sort numerically
+		MojByte groupBytes[sizeof(MojUInt32)];
+		for (MojSize i = 0; i < sizeof(groupBytes); ++i) {
+			groupBytes[i] = (MojByte) (groupNum >> (8 * (sizeof(groupBytes) - 1 - i)));
 		}
-		// add id to current set
-		err = group->put(id);
+		err = groupKey.assign(groupBytes, sizeof(groupBytes));
+		MojErrCheck(err);
+		err = idSorter.put(idKey, groupKey);
 		MojErrCheck(err);
 	}
 
 	// no matches unless all groups are accounted for
 	MojUInt32 groupCount = m_storageQuery->groupCount();
 	for (MojUInt32 i = 0; i < groupCount; ++i) {
-		if (!groupMap.contains(i))
+		if (!groups.contains(i))
 			return MojErrNone;
 	}
+	matchOut = true;
 
-	// find intersection of all groups
-	GroupMap::ConstIterator begin = groupMap.begin();
-	for (GroupMap::ConstIterator i = begin; i != groupMap.end(); ++i) {
-		if (i == begin) {
-			// special handling for first group
-			idsOut = *(i.value());
-		} else {
-			MojErr err = idsOut.intersect(*(i.value()));
-			MojErrCheck(err);
-		}
-	}
 	return MojErrNone;
 }
 
-MojErr MojDbSearchCursor::loadObjects(const ObjectSet& ids)
+MojErr MojDbSearchCursor::loadSorted()
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
-	MojInt32 warns = 0;
-	for (ObjectSet::ConstIterator i = ids.begin(); i != ids.end(); ++i) {
-		// get item by id
-		MojObject obj;
-		MojDbStorageItem* item = NULL;
-		bool found = false;
-		MojErr err = m_storageQuery->getById(*i, item, found);
-		if (err == MojErrInternalIndexOnFind) {
-			warns++;
-			continue;
-		}
-
-		MojErrCheck(err);
-		if (found) {
-			// get object from item
-			err = item->toObject(obj, *m_kindEngine);
-			MojErrCheck(err);
-			// filter results
-            if (m_queryFilter.get()) {
-                bool isFound;
-                err = m_queryFilter->test(obj, isFound);
-                MojErrCheck(err);
-                if (!isFound)
-                    continue;
-            }
-			// create object item
-			MojRefCountedPtr<MojDbObjectItem> item(new MojDbObjectItem(obj));
-			MojAllocCheck(item.get());
-			// add to vec
-			err = m_items.push(item);
-			MojErrCheck(err);
-		}
-	}
-	if (warns > 0)
-        LOG_DEBUG("[db_mojodb] Search warnings: %d \n", warns);
-	return MojErrNone;
-}
-
-MojErr MojDbSearchCursor::loadFromCache(const MojDbSearchCache* cache)
-{
-    LOG_TRACE("Entering function %s", __FUNCTION__);
+    MojDb* db = m_kindEngine->db();
+    MojAssert(db);
+    MojDbSearchCache* cache = db->searchCache();
+    MojAssert(cache);
 
-    MojInt32 warns = 0;
-    MojDbSearchCache::IdSet ids;
-    MojErr err = cache->getIdSet(m_queryKey, ids);
+    // pull ids from index
+    MojDbExternalSorter idSorter;
+    MojErr err = idSorter.open(db->searchTempDir(), db->searchRunBytes());
+    MojErrCheck(err);
+    bool match = false;
+    err = loadIds(idSorter, match);
+    MojErrCheck(err);
+    if (!match)
+        return MojErrNone;
+    err = idSorter.finish();
     MojErrCheck(err);
 
-    MojDbSearchCache::IdSet::Iterator it;
-    MojUInt32 count=0;
+    // with distinct, the first id of each group wins, so keep ids ascending within a key
+    bool desc = m_query.desc();
+    MojDbExternalSorter sorter;
+    err = sorter.open(db->searchTempDir(), db->searchRunBytes(), desc, desc && m_distinct.empty());
+    MojErrCheck(err);
+    err = sort(idSorter, sorter);
+    MojErrCheck(err);
+    err = idSorter.close();
+    MojErrCheck(err);
+    err = sorter.finish();
+    MojErrCheck(err);
 
-    bool foundStart=false;
-    if (m_page.empty())
-        foundStart=true;
+    // Update cache only if 'page' is not specified in given query, the result
+    // spans more than one page and the ids fit in the cache.
+    bool cacheIds = m_inPage;
+    MojSize cacheBytes = 0;
+    MojDbSearchCache::IdSet cachedIds;
 
-    MojDbSearchCache::IdSet::ConstIterator citer = ids.begin();
-    for ( ; citer != ids.end(); ++citer) {
-        // get item by id
-        MojObject obj;
-        MojDbStorageItem* item = NULL;
+    MojDbKey key;
+    MojDbKey prevKey;
+    MojDbKey idKey;
+    for (MojSize i = 0; ; ++i) {
         bool found = false;
-        MojErr err = m_storageQuery->getById(*citer, item, found);
-        if (err == MojErrInternalIndexOnFind) {
-            ++warns;
-            continue;
+        err = sorter.next(key, idKey, found);
+        MojErrCheck(err);
+        if (!found)
+            break;
+        if (!m_distinct.empty()) {
+            if (i > 0 && key == prevKey)
+                continue;
+            prevKey = key;
         }
+
+        MojObject id;
+        err = id.fromBytes(idKey.data(), idKey.size());
+        MojErrCheck(err);
+        err = addResult(id);
         MojErrCheck(err);
 
-        // Start to load if 'page' is available, and only if it matches id.
-        //
-        if (foundStart==false && m_pageObject.compare(*citer))
-            continue;
-        foundStart=true;
+        if (cacheIds) {
+            cacheBytes += sizeof(MojObject) + idKey.size();
+            if (cacheBytes > cache->maxBytes()) {
+                cacheIds = false;
+                cachedIds.clear();
+            } else {
+                err = cachedIds.push(id);
+                MojErrCheck(err);
+            }
+        }
+    }
+    if (sorter.runCount() > 0) {
+        LOG_DEBUG("[db_mojodb] search sorted %zu ids in %zu runs, %zu merges \n", sorter.count(), sorter.runCount(), sorter.mergeCount());
+    }
 
-        // Intensionally, load next object.
-        if ((m_limit+1) <= count)
-            break;
+    if (cacheIds && m_count > m_limit) {
+        err = cache->updateCache(m_queryKey, cachedIds);
+        MojErrCheck(err);
+    }
 
-        if (found) {
-            // get object from item
-            err = item->toObject(obj, *m_kindEngine);
-            MojErrCheck(err);
-        }
+    return MojErrNone;
+}
 
-        // create object item
-        MojRefCountedPtr<MojDbObjectItem> items(new MojDbObjectItem(obj));
-        MojAllocCheck(items.get());
-        // add to vec
-        err = m_items.push(items);
+MojErr MojDbSearchCursor::loadFromCache(const MojDbSearchCache::IdSet& ids)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+    for (MojDbSearchCache::IdSet::ConstIterator i = ids.begin(); i != ids.end(); ++i) {
+        MojErr err = addResult(*i);
         MojErrCheck(err);
+    }
+
+    return MojErrNone;
+}
 
-        ++count;
+/***********************************************************************
+ * addResult
+ *
+ * Feed the next id of the sorted result set through the page window.
+ *   1. Skip ids until the page id provided in the query is found.
+ *   2. Load objects until the page is full.
+ *   3. Remember the first id beyond the page as the next page.
+ ***********************************************************************/
+MojErr MojDbSearchCursor::addResult(const MojObject& id)
+{
+    if (!m_inPage) {
+        if (m_pageObject.compare(id) != 0)
+            return MojErrNone;
+        m_inPage = true;
     }
 
-    // Assign dummy object item for compatability.
-    // TODO: Remove below code.
-    //
-    for (; citer != ids.end(); ++citer) {
-        MojObject obj = *citer;
+    if (m_items.size() < m_limit) {
+        // get item by id
+        MojDbStorageItem* item = NULL;
+        bool found = false;
+        MojErr err = m_storageQuery->getById(id, item, found);
+        if (err == MojErrInternalIndexOnFind)
+            return MojErrNone;
+        MojErrCheck(err);
+        if (!found)
+            return MojErrNone;
 
+        // get object from item
+        MojObject obj;
+        err = item->toObject(obj, *m_kindEngine);
+        MojErrCheck(err);
         // create object item
-        MojRefCountedPtr<MojDbObjectItem> items(new MojDbObjectItem(obj));
-        MojAllocCheck(items.get());
+        MojRefCountedPtr<MojDbObjectItem> objItem(new MojDbObjectItem(obj));
+        MojAllocCheck(objItem.get());
         // add to vec
-        err = m_items.push(items);
+        err = m_items.push(objItem);
         MojErrCheck(err);
+    } else if (m_count == m_limit) {
+        // set next page
+        m_page.fromObject(id);
     }
-
-    if (warns > 0)
-        LOG_DEBUG("[db_mojodb] Search from cache warnings: %d \n", warns);
+    ++m_count;
 
     return MojErrNone;
 }
 
-//extract ids from m_items and copy it to IdSet for cache
-MojErr MojDbSearchCursor::getIds(MojDbSearchCache::IdSet& sortedId)
+/***********************************************************************
+ * sort
+ *
+ * Walk the sorted (id, group) pairs and pass every id found in all groups
+ * to sortId. Duplicates of a pair within a group are counted once.
+ ***********************************************************************/
+MojErr MojDbSearchCursor::sort(MojDbExternalSorter& idSorter, MojDbExternalSorter& sorter)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
-    for (ItemVec::ConstIterator i = m_items.begin(); i != m_items.end(); ++i) {
-        MojDbStorageItem* item = i->get();
-        const MojObject& id = item->id();
-        MojErr err = sortedId.push(id);
-        MojErrCheck(err);
-    }
+	MojDbPropExtractor extractor;
+	MojRefCountedPtr<MojDbTextCollator> collator;
+	if (!m_orderProp.empty()) {
+		MojErr err = initExtractor(extractor, collator);
+		MojErrCheck(err);
+	}
 
-    return MojErrNone;
+	MojSize groupCount = MojMax((MojSize) m_storageQuery->groupCount(), (MojSize) 1);
+	MojInt32 warns = 0;
+	MojDbKey idKey;
+	MojDbKey groupKey;
+	MojDbKey curId;
+	MojDbKey curGroup;
+	MojSize groups = 0;
+	for (;;) {
+		bool found = false;
+		MojErr err = idSorter.next(idKey, groupKey, found);
+		MojErrCheck(err);
+		if (found && groups > 0 && idKey == curId) {
+			if (groupKey != curGroup) {
+				curGroup = groupKey;
+				++groups;
+			}
+			continue;
+		}
+		// the previous id is complete
+		if (groups == groupCount) {
+			bool warn = false;
+			err = sortId(curId, extractor, sorter, warn);
+			MojErrCheck(err);
+			if (warn)
+				warns++;
+		}
+		if (!found)
+			break;
+		curId = idKey;
+		curGroup = groupKey;
+		groups = 1;
+	}
+	if (warns > 0)
+        LOG_DEBUG("[db_mojodb] Search warnings: %d \n", warns);
+
+	return MojErrNone;
 }
 
-MojErr MojDbSearchCursor::sort()
+/***********************************************************************
+ * sortId
+ *
+ * Load the sort and filter props of a matching object, filter it and hand
+ * its sort key and id to the sorter. Other props are skipped in storage and
+ * the object is dropped as soon as its key is extracted.
+ ***********************************************************************/
+MojErr MojDbSearchCursor::sortId(const MojDbKey& idKey, MojDbPropExtractor& extractor, MojDbExternalSorter& sorter, bool& warnOut)
+{
+	warnOut = false;
+	MojObject id;
+	MojErr err = id.fromBytes(idKey.data(), idKey.size());
+	MojErrCheck(err);
+
+	// get item by id
+	MojDbStorageItem* item = NULL;
+	bool found = false;
+	err = m_storageQuery->getById(id, item, found);
+	if (err == MojErrInternalIndexOnFind) {
+		warnOut = true;
+		return MojErrNone;
+	}
+	MojErrCheck(err);
+	if (!found)
+		return MojErrNone;
+
+	// get the props we need from item
+	MojObject obj;
+	err = item->toObject(obj, *m_kindEngine, m_sortProps);
+	MojErrCheck(err);
+	// filter results
+	if (m_queryFilter.get()) {
+		bool isFound;
+		err = m_queryFilter->test(obj, isFound);
+		MojErrCheck(err);
+		if (!isFound)
+			return MojErrNone;
+	}
+	// create sort key
+	MojDbKey sortKey;
+	if (!m_orderProp.empty()) {
+		KeySet keys;
+		err = extractor.vals(obj, keys);
+		MojErrCheck(err);
+		err = encodeSortKey(keys, sortKey);
+		MojErrCheck(err);
+	}
+	err = sorter.put(sortKey, idKey);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbSearchCursor::initExtractor(MojDbPropExtractor& extractor, MojRefCountedPtr<MojDbTextCollator>& collatorOut)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 	MojAssert(!m_orderProp.empty());
 
 	// TODO: instead of parsing all objects, find the serialized field in the object and compare it directly
 	// create extractor for sort prop
-	MojRefCountedPtr<MojDbTextCollator> collator(new MojDbTextCollator);
-	MojAllocCheck(collator.get());
-	// TODO: use real locale
-	//MojErr err = collator->init(_T(""), MojDbCollationPrimary);
-    MojErr err = MojErrNone;
+	collatorOut.reset(new MojDbTextCollator);
+	MojAllocCheck(collatorOut.get());
 
     // set locale
     MojString locale = m_locale;
@@ -541,49 +562,46 @@ MojErr MojDbSearchCursor::sort()
         // default setting is primary
         coll = MojDbCollationPrimary;
     }
-    err = collator->init(locale, coll);
+    MojErr err = collatorOut->init(locale, coll);
     MojErrCheck(err);
 
-	MojDbPropExtractor extractor;
-	extractor.collator(collator.get());
+	extractor.collator(collatorOut.get());
 	err = extractor.prop(m_orderProp);
 	MojErrCheck(err);
 
-	// create sort keys
-	MojDbKeyBuilder builder;
-	ItemVec::Iterator begin;
-	err = m_items.begin(begin);
-	MojErrCheck(err);
-	for (ItemVec::Iterator i = begin; i != m_items.end(); ++i) {
-		KeySet keys;
-		err = extractor.vals((*i)->obj(), keys);
-		MojErrCheck(err);
-		(*i)->sortKeys(keys);
-	}
-
-	// sort
-	err = m_items.sort();
-	MojErrCheck(err);
-
 	return MojErrNone;
 }
 
-MojErr MojDbSearchCursor::distinct()
+/***********************************************************************
+ * encodeSortKey
+ *
+ * Flatten a set of sort keys into one key whose bytes compare the same way
+ * the sets do. Each key is written with 0x00 escaped as 0x00 0xFF and is
+ * terminated by 0x00 0x01, so a key sorts before any key it is a prefix of.
+ ***********************************************************************/
+MojErr MojDbSearchCursor::encodeSortKey(const KeySet& keys, MojDbKey& keyOut)
 {
-    LOG_TRACE("Entering function %s", __FUNCTION__);
-	MojAssert(!m_items.empty());
-
-	ItemComp itemComp;
-	int idx = 0;
-	int itemSize = m_items.size();
-	while(idx < itemSize-1) {
-		if(itemComp(m_items[idx],m_items[idx+1]) == 0) {
-			m_items.erase(idx+1);
-			itemSize = m_items.size();
-		} else {
-			idx++;
+	static const MojByte Escape = 0xFF;
+	static const MojByte Terminator[] = {0, 1};
+
+	keyOut.clear();
+	for (KeySet::ConstIterator i = keys.begin(); i != keys.end(); ++i) {
+		// copy runs of bytes up to and including each 0x00, then escape it
+		const MojByte* run = i->data();
+		const MojByte* end = run + i->size();
+		for (const MojByte* j = run; j != end; ++j) {
+			if (*j == 0) {
+				MojErr err = keyOut.append(run, j + 1 - run);
+				MojErrCheck(err);
+				err = keyOut.append(&Escape, 1);
+				MojErrCheck(err);
+				run = j + 1;
+			}
 		}
+		MojErr err = keyOut.append(run, end - run);
+		MojErrCheck(err);
+		err = keyOut.append(Terminator, sizeof(Terminator));
+		MojErrCheck(err);
 	}
-
 	return MojErrNone;
 }
@@ -31,6 +31,7 @@ const MojChar* const MojDbServiceDefs::DeletedRevKey = _T("deletedRev");
 const MojChar* const MojDbServiceDefs::DevicesKey = _T("devices");
 const MojChar* const MojDbServiceDefs::DescriptionKey = _T("description");
 const MojChar* const MojDbServiceDefs::DirKey = _T("tempDir");
+const MojChar* const MojDbServiceDefs::ExplainKey = _T("explain");
 const MojChar* const MojDbServiceDefs::ExtendKey = _T("extend");
 const MojChar* const MojDbServiceDefs::FilesKey = _T("files");
 const MojChar* const MojDbServiceDefs::FiredKey = _T("fired");
@@ -24,6 +24,7 @@
 #include "db/MojDbReq.h"
 #include "db/MojDbIndex.h"
 #include "core/MojJson.h"
+#include "core/MojMessageDispatcher.h"
 #include <list>
 
 const MojDbServiceHandler::SchemaMethod MojDbServiceHandler::s_pubMethods[] = {
@@ -630,6 +631,21 @@ MojErr MojDbServiceHandler::handleStats(MojServiceMessage* msg, MojObject& paylo
 	MojObject results;
 	err = m_db.stats(results, req, verify, pKind);
 	MojErrCheck(err);
+	// requests of this service are queued per sender, so their latencies show who is waiting
+	MojMessageDispatcher* dispatcher = msg->service() ? msg->service()->dispatcher() : NULL;
+	if (pKind == NULL && dispatcher) {
+		MojObject dispatcherStats;
+		err = dispatcher->stats(dispatcherStats);
+		MojErrCheck(err);
+		if (!dispatcherStats.empty()) {
+			MojObject internal;
+			results.get(MojDb::StatsInternalKey, internal);
+			err = internal.put(MojMessageDispatcher::StatsKey, dispatcherStats);
+			MojErrCheck(err);
+			err = results.put(MojDb::StatsInternalKey, internal);
+			MojErrCheck(err);
+		}
+	}
 
 	MojObjectVisitor& writer = msg->writer();
 	err = writer.beginObject();
@@ -1157,6 +1173,8 @@ MojErr MojDbServiceHandler::findImpl(MojServiceMessage* msg, MojObject& payload,
 	MojErrCheck(err);
 	bool doWatch = false;
 	payload.get(MojDbServiceDefs::WatchKey, doWatch);
+	bool doExplain = false;
+	payload.get(MojDbServiceDefs::ExplainKey, doExplain);
 
 	MojDbQuery query;
 	err = query.fromObject(queryObj);
@@ -1193,6 +1211,13 @@ MojErr MojDbServiceHandler::findImpl(MojServiceMessage* msg, MojObject& payload,
 	err = writer.endArray();
 	MojErrCheck(err);
 
+	// explain before counting so that scanned keys reflect only the page we returned
+	MojObject explainObj;
+	if (doExplain) {
+		err = cursor.explain(explainObj);
+		MojErrCheck(err);
+	}
+
 	// append next page
 	MojDbQuery::Page page;
 	err = cursor.nextPage(page);
@@ -1218,6 +1243,11 @@ MojErr MojDbServiceHandler::findImpl(MojServiceMessage* msg, MojObject& payload,
 		MojErrCheck(err);
 	}
 
+	if (doExplain) {
+		err = writer.objectProp(MojDbServiceDefs::ExplainKey, explainObj);
+		MojErrCheck(err);
+	}
+
 	err = writer.endObject();
 	MojErrCheck(err);
 
@@ -1248,17 +1278,20 @@ MojDbServiceHandler::Watcher::Watcher(MojServiceMessage* msg)
 MojErr MojDbServiceHandler::Watcher::handleWatch()
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
-	MojAssert(m_msg.get());
+	// whichever of fire and cancel takes the message first wins
+	MojThreadGuard guard(m_mutex);
+	MojRefCountedPtr<MojServiceMessage> msg = m_msg;
+	m_msg.reset();
+	guard.unlock();
+	if (!msg.get())
+		return MojErrNone;
 
 	// release all references before doing anything that can fail
 	m_cancelSlot.cancel();
-	MojRefCountedPtr<MojServiceMessage> msg = m_msg;
 
     LOG_DEBUG("[db_mojodb] Watcher_handleWatch: %s, - sender= %s; appId= %s; subscribed= %d; replies= %zu;\n response= %s\n",
         msg->method(), msg->senderName(), msg->appId(), (int)msg->subscribed(), msg->numReplies(), ((MojJsonWriter&)(msg->writer())).json().data());
 
-	m_msg.reset();
-
 	MojObjectVisitor& writer = msg->writer();
 	MojErr err = writer.beginObject();
 	MojErrCheck(err);
@@ -1279,10 +1312,16 @@ MojErr MojDbServiceHandler::Watcher::handleWatch()
 MojErr MojDbServiceHandler::Watcher::handleCancel(MojServiceMessage* msg)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
-	MojAssert(msg == m_msg.get());
+	MojThreadGuard guard(m_mutex);
+	MojRefCountedPtr<MojServiceMessage> watchMsg = m_msg;
+	m_msg.reset();
+	guard.unlock();
+	if (!watchMsg.get())
+		return MojErrNone;
+	MojAssert(msg == watchMsg.get());
 
+	// not under our mutex: a fire in progress holds the db watcher's mutex while it waits for ours
 	m_watchSlot.cancel();
-	m_msg.reset();
 
 	return MojErrNone;
 }
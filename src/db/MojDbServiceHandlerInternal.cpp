@@ -155,7 +155,8 @@ MojErr MojDbServiceHandlerInternal::handlePreBackup(MojServiceMessage* msg, MojO
 	err = MojGetCurrentTime(curTime);
 	MojErrCheck(err);
 	MojString backupFileName;
-	err = backupFileName.format(_T("%s-%llu.%s"), _T("backup"), curTime.microsecs(), _T("json"));
+	const MojChar* ext = (m_db.dumpFormat() == MojDbDumpWriter::FormatBinary) ? _T("bin") : _T("json");
+	err = backupFileName.format(_T("%s-%llu.%s"), _T("backup"), curTime.microsecs(), ext);
 	MojErrCheck(err);
 
 	MojUInt32 count = 0;
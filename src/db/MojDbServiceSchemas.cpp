@@ -64,6 +64,7 @@
 	 _T("\"properties\":{") \
 		 _T("\"query\":") MOJ_QUERY_SCHEMA _T(",") \
 		 _T("\"count\":{\"type\":\"boolean\",\"optional\":true},") \
+		 _T("\"explain\":{\"type\":\"boolean\",\"optional\":true},") \
 		 _T("\"watch\":{\"type\":\"boolean\",\"optional\":true},") \
 		 _T("\"subscribe\":{\"type\":\"boolean\",\"optional\":true}},") \
 	 _T("\"additionalProperties\":false}")
@@ -152,6 +153,7 @@ const MojChar* const MojDbServiceHandler::PutKindSchema =
 		 _T("\"id\":{\"type\":\"string\",\"minimum\":3},")
 		 _T("\"owner\":{\"type\":\"string\",\"minimum\":1},")
 		 _T("\"sync\":{\"type\":\"boolean\",\"optional\":true},")
+		 _T("\"compress\":{\"type\":\"boolean\",\"optional\":true},")
 		 _T("\"extends\":{\"type\":\"array\",\"optional\":true,\"items\":{\"type\":\"string\",\"minimum\":1}},")
 		 _T("\"schema\":{\"type\":\"object\",\"optional\":true},")
 		 _T("\"indexes\":{\"type\":\"array\",\"optional\":true,\"items\":{")
@@ -18,6 +18,7 @@
 
 #include "db/MojDbShardIdCache.h"
 #include "db/MojDb.h"
+#include "db/MojDbIdGenerator.h"
 
 using namespace std;
 
@@ -38,6 +39,25 @@ bool MojDbShardIdCache::isExist (const MojUInt32 id) const
     return ( m_map.find(id) != m_map.end() );
 }
 
+bool MojDbShardIdCache::hasInactive (void) const
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+    std::map<MojUInt32, MojObject>::const_iterator it;
+    for (it = m_map.begin(); it != m_map.end(); ++it)
+    {
+        // main shard is always active
+        if (it->first == MojDbIdGenerator::MainShardId)
+            continue;
+
+        bool active = false;
+        if (!it->second.get(_T("active"), active) || !active)
+            return true;
+    }
+
+    return false;
+}
+
 void MojDbShardIdCache::put (const MojUInt32 id, const MojObject& obj)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
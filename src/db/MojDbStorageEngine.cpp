@@ -20,12 +20,15 @@
 #include <cstdlib>
 
 #include "db/MojDbStorageEngine.h"
+#include "db/MojDbIndex.h"
+#include "db/MojDbWatchNotifier.h"
 #include "core/MojObjectBuilder.h"
 #include "core/MojJson.h"
 #include "core/MojLogDb8.h"
 
 MojDbStorageEngine::Factory MojDbStorageEngine::m_factory;
 MojDbStorageEngine::Factories MojDbStorageEngine::m_factories;
+const MojChar* const MojDbStorageEngine::StatsKey = _T("_storageEngine");
 
 MojErr MojDbStorageItem::toObject(MojObject& objOut, MojDbKindEngine& kindEngine, bool headerExpected) const
 {
@@ -38,6 +41,26 @@ MojErr MojDbStorageItem::toObject(MojObject& objOut, MojDbKindEngine& kindEngine
 	return MojErrNone;
 }
 
+MojErr MojDbStorageItem::toObject(MojObject& objOut, MojDbKindEngine& kindEngine, const PropSet& props) const
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	MojObjectBuilder builder;
+	MojErr err = visitProps(builder, kindEngine, props);
+	MojErrCheck(err);
+	objOut = builder.object();
+	return MojErrNone;
+}
+
+MojErr MojDbStorageItem::visitProps(MojObjectVisitor& visitor, MojDbKindEngine& kindEngine, const PropSet& props) const
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	MojErr err = visit(visitor, kindEngine);
+	MojErrCheck(err);
+	return MojErrNone;
+}
+
 MojErr MojDbStorageItem::toJson(MojString& strOut, MojDbKindEngine& kindEngine) const
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
@@ -164,16 +187,75 @@ MojDbStorageEngine::MojDbStorageEngine()
 {
 }
 
+MojDbStorageTxn::WatcherInfo::WatcherInfo(MojDbIndex* index, MojDbWatcher* watcher, const MojDbKey& key)
+: m_index(index),
+  m_watcher(watcher),
+  m_key(key)
+{
+}
+
+MojDbStorageTxn::WatcherInfo::WatcherInfo(const WatcherInfo& other)
+: m_index(other.m_index),
+  m_watcher(other.m_watcher),
+  m_key(other.m_key)
+{
+}
+
+MojDbStorageTxn::WatcherInfo::~WatcherInfo()
+{
+}
+
+MojDbStorageTxn::WatcherInfo& MojDbStorageTxn::WatcherInfo::operator=(const WatcherInfo& rhs)
+{
+	m_index = rhs.m_index;
+	m_watcher = rhs.m_watcher;
+	m_key = rhs.m_key;
+
+	return *this;
+}
+
+MojDbStorageTxn::CountOffset::CountOffset()
+: m_offset(0)
+{
+}
+
+MojDbStorageTxn::CountOffset::CountOffset(const CountOffset& other)
+: m_index(other.m_index),
+  m_offset(other.m_offset)
+{
+}
+
+MojDbStorageTxn::CountOffset::~CountOffset()
+{
+}
+
+MojDbStorageTxn::CountOffset& MojDbStorageTxn::CountOffset::operator=(const CountOffset& rhs)
+{
+	m_index = rhs.m_index;
+	m_offset = rhs.m_offset;
+
+	return *this;
+}
+
 MojDbStorageTxn::MojDbStorageTxn()
 : m_quotaEnabled(true),
   m_refreshQuotas(false),
+  m_deferIndexKeys(false),
+  m_countsLocked(false),
+  m_countsOrdered(false),
   m_quotaEngine(NULL),
+  m_watchNotifier(NULL),
   m_preCommit(this),
   m_postCommit(this)
 {
 }
 
-MojErr MojDbStorageTxn::addWatcher(MojDbWatcher* watcher, const MojDbKey& key)
+MojDbStorageTxn::~MojDbStorageTxn()
+{
+	unlockCounts();
+}
+
+MojErr MojDbStorageTxn::addWatcher(MojDbIndex* index, MojDbWatcher* watcher, const MojDbKey& key)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
@@ -190,7 +272,7 @@ MojErr MojDbStorageTxn::addWatcher(MojDbWatcher* watcher, const MojDbKey& key)
 		}
 	}
 	if (i == m_watchers.end()) {
-		MojErr err = m_watchers.push(WatcherInfo(watcher, key));
+		MojErr err = m_watchers.push(WatcherInfo(index, watcher, key));
 		MojErrCheck(err);
 	}
 	return MojErrNone;
@@ -207,6 +289,135 @@ MojErr MojDbStorageTxn::offsetQuota(MojInt64 offset)
 	return MojErrNone;
 }
 
+MojErr MojDbStorageTxn::offsetCount(MojDbIndex* index, MojInt64 offset)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	MojErr err = addOffset(m_countOffsets, index, offset);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbStorageTxn::offsetKeyCount(MojDbIndex* index, MojInt64 offset)
+{
+	MojErr err = addOffset(m_keyCountOffsets, index, offset);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbStorageTxn::addOffset(CountMap& map, MojDbIndex* index, MojInt64 offset)
+{
+	MojAssert(index);
+
+	CountMap::Iterator i;
+	MojErr err = map.find(index, i);
+	MojErrCheck(err);
+	if (i == map.end()) {
+		CountOffset count;
+		count.m_index.reset(index);
+		count.m_offset = offset;
+		err = map.put(index, count);
+		MojErrCheck(err);
+	} else {
+		i.value().m_offset += offset;
+	}
+	return MojErrNone;
+}
+
+MojErr MojDbStorageTxn::dropCounts(MojDbIndex* index)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(index && !m_countsLocked);
+
+	bool found = false;
+	MojErr err = m_countOffsets.del(index, found);
+	MojErrCheck(err);
+	err = m_keyCountOffsets.del(index, found);
+	MojErrCheck(err);
+	err = m_deferredKeys.del(index, found);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbStorageTxn::deferIndexKey(MojDbIndex* index, const MojDbKey& key)
+{
+	MojAssert(index && m_deferIndexKeys);
+
+	DeferredKeyMap::Iterator i;
+	MojErr err = m_deferredKeys.find(index, i);
+	MojErrCheck(err);
+	if (i == m_deferredKeys.end()) {
+		err = m_deferredKeys.put(index, DeferredKeysVec());
+		MojErrCheck(err);
+		err = m_deferredKeys.find(index, i);
+		MojErrCheck(err);
+		MojAssert(i != m_deferredKeys.end());
+	}
+
+	// the quota offset has moved on by the time the keys are written, so remember it now
+	DeferredKeysVec& groups = i.value();
+	DeferredKeysVec::Iterator group;
+	err = groups.begin(group);
+	MojErrCheck(err);
+	for (; group != groups.end(); ++group) {
+		if (group->m_quotaOffset.get() == m_curQuotaOffset.get())
+			break;
+	}
+	if (group == groups.end()) {
+		DeferredKeys keys;
+		keys.m_quotaOffset = m_curQuotaOffset;
+		err = groups.push(keys);
+		MojErrCheck(err);
+		err = groups.begin(group);
+		MojErrCheck(err);
+		group += groups.size() - 1;
+	}
+	err = group->m_keys.push(key);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbStorageTxn::flushIndexKeys()
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	if (m_deferredKeys.empty())
+		return MojErrNone;
+
+	// take the keys first so reads made while writing them do not flush again
+	DeferredKeyMap keys;
+	m_deferredKeys.swap(keys);
+	MojRefCountedPtr<MojDbQuotaEngine::Offset> curQuotaOffset = m_curQuotaOffset;
+	DeferredKeyMap::Iterator i;
+	MojErr err = keys.begin(i);
+	MojErrCheck(err);
+	for (; i != keys.end(); ++i) {
+		DeferredKeysVec::Iterator group;
+		err = i.value().begin(group);
+		MojErrCheck(err);
+		for (; group != i.value().end(); ++group) {
+			m_curQuotaOffset = group->m_quotaOffset;
+			err = i.key()->insertSorted(group->m_keys, this);
+			if (err != MojErrNone)
+				m_curQuotaOffset = curQuotaOffset;
+			MojErrCheck(err);
+		}
+	}
+	m_curQuotaOffset = curQuotaOffset;
+
+	return MojErrNone;
+}
+
+MojInt64 MojDbStorageTxn::countOffset(MojDbIndex* index) const
+{
+	CountMap::ConstIterator i = m_countOffsets.find(index);
+	return i == m_countOffsets.end() ? 0 : i.value().m_offset;
+}
+
 void MojDbStorageTxn::notifyPreCommit(CommitSignal::SlotRef slot)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
@@ -225,16 +436,43 @@ MojErr MojDbStorageTxn::commit()
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
-	MojErr err = m_preCommit.fire(this);
+	MojErr err = flushIndexKeys();
+	MojErrCheck(err);
+	err = m_preCommit.fire(this);
 	MojErrCheck(err);
 	if (m_quotaEngine) {
 		err = m_quotaEngine->applyUsage(this);
 		MojErrCheck(err);
 	}
 
-	err = commitImpl();
+	// counts are read and rewritten here, so hold their locks until the engine has fixed
+	// our place in the commit order (commitOrdered), or failing that until we are durable.
+	lockCounts();
+	err = applyCounts();
+	if (err == MojErrNone)
+		err = commitImpl();
+	bool ordered = m_countsOrdered;
+	if (err != MojErrNone && !ordered) {
+		// nobody has seen the counts we cached, so just forget them
+		for (CountMap::ConstIterator i = m_countOffsets.begin(); i != m_countOffsets.end(); ++i) {
+			i.value().m_index->uncacheCount();
+		}
+	}
+	unlockCounts();
+	if (err != MojErrNone && ordered) {
+		// commits ordered after us have built on our counts already
+		for (CountMap::ConstIterator i = m_countOffsets.begin(); i != m_countOffsets.end(); ++i) {
+			MojErr errReset = i.value().m_index->resetCount();
+			MojErrCatchAll(errReset);
+		}
+	}
 	MojErrCheck(err);
 
+	for (CountMap::ConstIterator i = m_keyCountOffsets.begin(); i != m_keyCountOffsets.end(); ++i) {
+		i.value().m_index->applyKeyCount(i.value().m_offset);
+	}
+	m_keyCountOffsets.clear();
+
 	err = m_postCommit.fire(this);
 	MojErrCheck(err);
 	if (m_quotaEngine) {
@@ -246,11 +484,56 @@ MojErr MojDbStorageTxn::commit()
 		}
 	}
 
+	m_countOffsets.clear();
+
 	WatcherVec vec;
 	m_watchers.swap(vec);
 	for (WatcherVec::ConstIterator i = vec.begin(); i != vec.end(); ++i) {
-		MojErr err = i->m_watcher->fire(i->m_key);
+		MojErr err = m_watchNotifier ? m_watchNotifier->post(i->m_index.get(), i->m_watcher.get(), i->m_key) : i->m_watcher->fire(i->m_key);
 		MojErrCheck(err);
 	}
 	return MojErrNone;
 }
+
+MojErr MojDbStorageTxn::applyCounts()
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	for (CountMap::ConstIterator i = m_countOffsets.begin(); i != m_countOffsets.end(); ++i) {
+		if (i.value().m_offset != 0) {
+			MojErr err = i.value().m_index->applyCount(i.value().m_offset, this);
+			MojErrCheck(err);
+		}
+	}
+	return MojErrNone;
+}
+
+void MojDbStorageTxn::lockCounts()
+{
+	MojAssert(!m_countsLocked);
+
+	// the map is ordered, which keeps concurrent commits from locking in different orders
+	for (CountMap::ConstIterator i = m_countOffsets.begin(); i != m_countOffsets.end(); ++i) {
+		i.value().m_index->countLock().lock();
+	}
+	m_countsLocked = true;
+	m_countsOrdered = false;
+}
+
+void MojDbStorageTxn::unlockCounts()
+{
+	if (!m_countsLocked)
+		return;
+	for (CountMap::ConstIterator i = m_countOffsets.begin(); i != m_countOffsets.end(); ++i) {
+		i.value().m_index->countLock().unlock();
+	}
+	m_countsLocked = false;
+}
+
+void MojDbStorageTxn::commitOrdered()
+{
+	if (m_countsLocked) {
+		m_countsOrdered = true;
+		unlockCounts();
+	}
+}
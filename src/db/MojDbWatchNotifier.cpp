@@ -0,0 +1,312 @@
+/* @@@LICENSE
+*
+*  Copyright (c) 2014 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+#include "db/MojDbWatchNotifier.h"
+#include "db/MojDbIndex.h"
+#include "core/MojLogDb8.h"
+
+const MojChar* const MojDbWatchNotifier::AsyncKey = _T("asyncWatchDelivery");
+const MojChar* const MojDbWatchNotifier::WindowKey = _T("watchCoalesceMs");
+const MojChar* const MojDbWatchNotifier::StatsKey = _T("_watchNotifier");
+
+MojDbWatchNotifier::MojDbWatchNotifier()
+: m_thread(MojInvalidThread),
+  m_window(MojMillisecs(WindowDefault)),
+  m_flushes(0),
+  m_enabled(false),
+  m_delivering(false),
+  m_stop(false),
+  m_stopped(false),
+  m_exited(false),
+  m_posts(0),
+  m_coalesced(0),
+  m_delivered(0),
+  m_totalLatency(0),
+  m_maxLatency(0)
+{
+}
+
+MojDbWatchNotifier::~MojDbWatchNotifier()
+{
+	MojErr err = stop();
+	MojErrCatchAll(err);
+}
+
+MojErr MojDbWatchNotifier::configure(const MojObject& conf)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	bool enabled = false;
+	conf.get(AsyncKey, enabled);
+	m_enabled = enabled;
+
+	MojInt64 window = WindowDefault;
+	if (conf.get(WindowKey, window) && window >= 0) {
+		m_window = MojMillisecs(window);
+	} else {
+		m_window = MojMillisecs(WindowDefault);
+	}
+	return MojErrNone;
+}
+
+void MojDbWatchNotifier::start()
+{
+	MojThreadGuard guard(m_mutex);
+	m_stopped = false;
+}
+
+MojErr MojDbWatchNotifier::post(MojDbIndex* index, MojDbWatcher* watcher, const MojDbKey& key)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+	MojAssert(index && watcher);
+
+	MojTime now;
+	MojErr err = MojGetCurrentTime(now);
+	MojErrCheck(err);
+
+	MojThreadGuard guard(m_mutex);
+	if (m_stopped) {
+		// no thread may start once the db has closed, so deliver this one ourselves
+		guard.unlock();
+		err = watcher->fire(key);
+		MojErrCheck(err);
+		return MojErrNone;
+	}
+	++m_posts;
+	PendingMap::Iterator iter;
+	err = m_pending.find(watcher, iter);
+	MojErrCheck(err);
+	if (iter != m_pending.end()) {
+		// same rule as a txn that touches a watcher twice: keep the min key
+		++m_coalesced;
+		if (key < iter.value().m_key)
+			iter.value().m_key = key;
+		return MojErrNone;
+	}
+
+	Pending pending;
+	pending.m_index.reset(index);
+	pending.m_watcher.reset(watcher);
+	pending.m_key = key;
+	pending.m_posted = now;
+	if (m_pending.empty())
+		m_oldest = now;
+	err = m_pending.put(watcher, pending);
+	MojErrCheck(err);
+	err = startThread();
+	MojErrCheck(err);
+	err = m_cond.signal();
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbWatchNotifier::flush()
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	MojThreadGuard guard(m_mutex);
+	if (m_thread == MojInvalidThread)
+		return MojErrNone;
+
+	// cut the current window short and wait for everything posted so far to go out
+	++m_flushes;
+	MojErr err = MojErrNone;
+	while (err == MojErrNone && (!m_pending.empty() || m_delivering)) {
+		// a thread that quit on an error leaves its work behind, so start another for it
+		err = startThread();
+		if (err == MojErrNone)
+			err = m_cond.signal();
+		if (err == MojErrNone)
+			err = m_idleCond.wait(m_mutex);
+	}
+	--m_flushes;
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbWatchNotifier::stop()
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	MojThreadGuard guard(m_mutex);
+	m_stopped = true;
+	if (m_thread == MojInvalidThread)
+		return MojErrNone;
+
+	// the thread delivers whatever is pending before it exits
+	m_stop = true;
+	MojErr err = m_cond.signal();
+	MojErrCheck(err);
+	guard.unlock();
+
+	MojErr threadErr = MojErrNone;
+	err = MojThreadJoin(m_thread, threadErr);
+	MojErrAccumulate(err, threadErr);
+
+	guard.lock();
+	m_thread = MojInvalidThread;
+	m_stop = false;
+	m_exited = false;
+
+	return err;
+}
+
+MojErr MojDbWatchNotifier::stats(MojObject& objOut)
+{
+	MojThreadGuard guard(m_mutex);
+
+	MojErr err = objOut.put(_T("posts"), m_posts);
+	MojErrCheck(err);
+	err = objOut.put(_T("coalesced"), m_coalesced);
+	MojErrCheck(err);
+	err = objOut.put(_T("delivered"), m_delivered);
+	MojErrCheck(err);
+	err = objOut.put(_T("pending"), (MojInt64) m_pending.size());
+	MojErrCheck(err);
+	err = objOut.put(_T("avgLatencyUs"), m_delivered ? m_totalLatency / m_delivered : 0);
+	MojErrCheck(err);
+	err = objOut.put(_T("maxLatencyUs"), m_maxLatency);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbWatchNotifier::threadMain(void* arg)
+{
+	MojDbWatchNotifier* notifier = (MojDbWatchNotifier*) arg;
+	MojAssert(notifier);
+
+	return notifier->run();
+}
+
+MojErr MojDbWatchNotifier::startThread()
+{
+	MojAssertMutexLocked(m_mutex);
+
+	// stop joins the thread itself
+	if (m_stop)
+		return MojErrNone;
+	if (m_thread != MojInvalidThread) {
+		if (!m_exited)
+			return MojErrNone;
+		// it has already given up the mutex for good, so this cannot block on us
+		MojErr threadErr = MojErrNone;
+		MojErr err = MojThreadJoin(m_thread, threadErr);
+		m_thread = MojInvalidThread;
+		MojErrCheck(err);
+		LOG_WARNING(MSGID_MOJ_DB_WARNING, 1,
+			PMLOGKFV("error", "%d", (int) threadErr),
+			"db: watch notifier thread quit with 'error', restarting it");
+	}
+	m_stop = false;
+	m_exited = false;
+	MojErr err = MojThreadCreate(m_thread, &threadMain, this);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbWatchNotifier::run()
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	MojThreadGuard guard(m_mutex);
+	MojErr err = runLoop(guard);
+
+	// however the loop ended, nothing more gets delivered by this thread: say so, and wake
+	// flush so it can start another one rather than wait for us
+	m_exited = true;
+	MojErr errBroadcast = m_idleCond.broadcast();
+	MojErrAccumulate(err, errBroadcast);
+
+	return err;
+}
+
+MojErr MojDbWatchNotifier::runLoop(MojThreadGuard& guard)
+{
+	for (;;) {
+		while (m_pending.empty() && !m_stop) {
+			MojErr err = m_cond.wait(m_mutex);
+			MojErrCheck(err);
+		}
+		if (m_pending.empty())
+			break;
+
+		// let later commits land on the same watchers until the oldest fire has waited a full window
+		while (!m_stop && m_flushes == 0) {
+			MojTime now;
+			MojErr err = MojGetCurrentTime(now);
+			MojErrCheck(err);
+			MojTime remaining = m_oldest + m_window - now;
+			if (remaining <= 0)
+				break;
+			err = m_cond.wait(m_mutex, remaining);
+			if (err != MojErrTimedOut)
+				MojErrCheck(err);
+		}
+
+		PendingMap pending;
+		pending.swap(m_pending);
+		m_delivering = true;
+		guard.unlock();
+
+		MojInt64 totalLatency = 0;
+		MojInt64 maxLatency = 0;
+		MojErr err = deliver(pending, totalLatency, maxLatency);
+		if (err != MojErrNone) {
+			LOG_WARNING(MSGID_MOJ_DB_WARNING, 1,
+				PMLOGKFV("error", "%d", (int) err),
+				"db: watch delivery failed with 'error'");
+		}
+		MojInt64 numDelivered = (MojInt64) pending.size();
+		pending.clear();
+
+		guard.lock();
+		m_delivering = false;
+		m_delivered += numDelivered;
+		m_totalLatency += totalLatency;
+		if (maxLatency > m_maxLatency)
+			m_maxLatency = maxLatency;
+		err = m_idleCond.broadcast();
+		MojErrCheck(err);
+	}
+	return MojErrNone;
+}
+
+MojErr MojDbWatchNotifier::deliver(const PendingMap& pending, MojInt64& totalLatencyOut, MojInt64& maxLatencyOut)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+	MojErr errAcc = MojErrNone;
+	for (PendingMap::ConstIterator i = pending.begin(); i != pending.end(); ++i) {
+		MojTime now;
+		MojErr err = MojGetCurrentTime(now);
+		MojErrCheck(err);
+		MojInt64 latency = (now - i.value().m_posted).microsecs();
+		totalLatencyOut += latency;
+		if (latency > maxLatencyOut)
+			maxLatencyOut = latency;
+		// one failing subscriber should not keep the others from hearing about the change
+		err = i.value().m_watcher->fire(i.value().m_key);
+		MojErrAccumulate(errAcc, err);
+	}
+	return errAcc;
+}
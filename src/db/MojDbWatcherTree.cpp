@@ -0,0 +1,266 @@
+/* @@@LICENSE
+*
+*  Copyright (c) 2014 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+#include "db/MojDbWatcherTree.h"
+
+MojDbWatcherTree::Node::Node(const MojDbKeyRange& range, MojDbWatcher* watcher, MojUInt64 seq)
+: m_range(range),
+  m_watcher(watcher),
+  m_seq(seq),
+  m_left(NULL),
+  m_right(NULL),
+  m_maxUpper(NULL),
+  m_height(1)
+{
+}
+
+MojDbWatcherTree::MojDbWatcherTree()
+: m_root(NULL),
+  m_seq(0)
+{
+}
+
+MojDbWatcherTree::~MojDbWatcherTree()
+{
+	clear();
+}
+
+MojErr MojDbWatcherTree::put(MojDbWatcher* watcher, const RangeVec& ranges)
+{
+	MojAssert(watcher);
+	MojAssert(!m_watchers.contains(watcher));
+
+	Entry entry;
+	entry.m_watcher.reset(watcher);
+	MojErr err = m_watchers.put(watcher, entry);
+	MojErrCheck(err);
+	WatcherMap::Iterator iter;
+	err = m_watchers.find(watcher, iter);
+	MojErrCheck(err);
+	MojAssert(iter != m_watchers.end());
+
+	for (RangeVec::ConstIterator i = ranges.begin(); i != ranges.end(); ++i) {
+		Node* node = new Node(*i, watcher, m_seq++);
+		MojAllocCheck(node);
+		err = iter.value().m_nodes.push(node);
+		if (err != MojErrNone) {
+			delete node;
+			MojErrThrow(err);
+		}
+		m_root = insert(m_root, node);
+	}
+	return MojErrNone;
+}
+
+MojErr MojDbWatcherTree::del(MojDbWatcher* watcher, bool& foundOut)
+{
+	foundOut = false;
+	WatcherMap::Iterator iter;
+	MojErr err = m_watchers.find(watcher, iter);
+	MojErrCheck(err);
+	if (iter == m_watchers.end())
+		return MojErrNone;
+
+	// hold a ref until we are done with the map entry
+	MojRefCountedPtr<MojDbWatcher> ref(iter.value().m_watcher);
+	const NodeVec& nodes = iter.value().m_nodes;
+	for (NodeVec::ConstIterator i = nodes.begin(); i != nodes.end(); ++i) {
+		m_root = remove(m_root, *i);
+		delete *i;
+	}
+	err = m_watchers.del(watcher, foundOut);
+	MojErrCheck(err);
+	MojAssert(foundOut);
+
+	return MojErrNone;
+}
+
+MojErr MojDbWatcherTree::find(const MojDbKey& key, WatcherVec& watchersOut) const
+{
+	MojErr err = find(m_root, key, watchersOut);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+void MojDbWatcherTree::clear()
+{
+	destroy(m_root);
+	m_root = NULL;
+	m_watchers.clear();
+}
+
+int MojDbWatcherTree::compare(const Node* node1, const Node* node2)
+{
+	int comp = node1->m_range.lowerKey().compare(node2->m_range.lowerKey());
+	if (comp != 0)
+		return comp;
+	if (node1->m_seq < node2->m_seq)
+		return -1;
+	if (node1->m_seq > node2->m_seq)
+		return 1;
+	return 0;
+}
+
+void MojDbWatcherTree::update(Node* node)
+{
+	MojAssert(node);
+
+	int leftHeight = height(node->m_left);
+	int rightHeight = height(node->m_right);
+	node->m_height = 1 + (leftHeight > rightHeight ? leftHeight : rightHeight);
+
+	// an empty upper key means the range is unbounded above
+	bool unbounded = node->m_range.upperKey().empty();
+	const MojDbKey* maxUpper = &node->m_range.upperKey();
+	const Node* children[] = { node->m_left, node->m_right };
+	for (MojSize i = 0; i < 2 && !unbounded; ++i) {
+		if (children[i]) {
+			if (children[i]->m_maxUpper == NULL)
+				unbounded = true;
+			else if (*children[i]->m_maxUpper > *maxUpper)
+				maxUpper = children[i]->m_maxUpper;
+		}
+	}
+	node->m_maxUpper = unbounded ? NULL : maxUpper;
+}
+
+MojDbWatcherTree::Node* MojDbWatcherTree::rotateLeft(Node* node)
+{
+	Node* right = node->m_right;
+	node->m_right = right->m_left;
+	right->m_left = node;
+	update(node);
+	update(right);
+
+	return right;
+}
+
+MojDbWatcherTree::Node* MojDbWatcherTree::rotateRight(Node* node)
+{
+	Node* left = node->m_left;
+	node->m_left = left->m_right;
+	left->m_right = node;
+	update(node);
+	update(left);
+
+	return left;
+}
+
+MojDbWatcherTree::Node* MojDbWatcherTree::balance(Node* node)
+{
+	update(node);
+	int diff = height(node->m_left) - height(node->m_right);
+	if (diff > 1) {
+		if (height(node->m_left->m_left) < height(node->m_left->m_right))
+			node->m_left = rotateLeft(node->m_left);
+		return rotateRight(node);
+	}
+	if (diff < -1) {
+		if (height(node->m_right->m_right) < height(node->m_right->m_left))
+			node->m_right = rotateRight(node->m_right);
+		return rotateLeft(node);
+	}
+	return node;
+}
+
+MojDbWatcherTree::Node* MojDbWatcherTree::insert(Node* root, Node* node)
+{
+	if (root == NULL) {
+		update(node);
+		return node;
+	}
+	if (compare(node, root) < 0)
+		root->m_left = insert(root->m_left, node);
+	else
+		root->m_right = insert(root->m_right, node);
+
+	return balance(root);
+}
+
+MojDbWatcherTree::Node* MojDbWatcherTree::remove(Node* root, const Node* node)
+{
+	MojAssert(root);
+
+	int comp = compare(node, root);
+	if (comp < 0) {
+		root->m_left = remove(root->m_left, node);
+	} else if (comp > 0) {
+		root->m_right = remove(root->m_right, node);
+	} else {
+		MojAssert(root == node);
+		Node* left = root->m_left;
+		Node* right = root->m_right;
+		root->m_left = NULL;
+		root->m_right = NULL;
+		if (right == NULL)
+			return left;
+		Node* min = NULL;
+		right = removeMin(right, min);
+		min->m_left = left;
+		min->m_right = right;
+		return balance(min);
+	}
+	return balance(root);
+}
+
+MojDbWatcherTree::Node* MojDbWatcherTree::removeMin(Node* root, Node*& minOut)
+{
+	if (root->m_left == NULL) {
+		minOut = root;
+		Node* right = root->m_right;
+		root->m_right = NULL;
+		return right;
+	}
+	root->m_left = removeMin(root->m_left, minOut);
+
+	return balance(root);
+}
+
+void MojDbWatcherTree::destroy(Node* root)
+{
+	if (root) {
+		destroy(root->m_left);
+		destroy(root->m_right);
+		delete root;
+	}
+}
+
+MojErr MojDbWatcherTree::find(const Node* root, const MojDbKey& key, WatcherVec& watchersOut)
+{
+	if (root == NULL)
+		return MojErrNone;
+	// every range in this subtree ends at or before the key
+	if (root->m_maxUpper && key >= *root->m_maxUpper)
+		return MojErrNone;
+
+	MojErr err = find(root->m_left, key, watchersOut);
+	MojErrCheck(err);
+	// this range and everything to the right of it start after the key
+	if (key < root->m_range.lowerKey())
+		return MojErrNone;
+	if (root->m_range.contains(key)) {
+		err = watchersOut.push(root->m_watcher);
+		MojErrCheck(err);
+	}
+	err = find(root->m_right, key, watchersOut);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
@@ -139,6 +139,31 @@ MojErr MojDbSandwichDatabase::update(const MojObject& id, MojBuffer& val, MojDbS
     return MojErrNone;
 }
 
+MojErr MojDbSandwichDatabase::insertCompressed(const MojObject& id, MojBuffer& val, MojDbStorageTxn* txn)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+    MojAssert(txn);
+
+    MojErr err = put(id, val, txn, true, true);
+    MojErrCheck(err);
+
+    return MojErrNone;
+}
+
+MojErr MojDbSandwichDatabase::updateCompressed(const MojObject& id, MojBuffer& val, MojDbStorageItem* oldVal, MojDbStorageTxn* txn)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+    MojAssert(oldVal && txn);
+
+    MojErr err = txn->offsetQuota(-(MojInt64) oldVal->size());
+    MojErrCheck(err);
+
+    err = put(id, val, txn, false, true);
+    MojErrCheck(err);
+
+    return MojErrNone;
+}
+
 MojErr MojDbSandwichDatabase::del(const MojObject& id, MojDbStorageTxn* txn, bool& foundOut)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
@@ -166,7 +191,8 @@ MojErr MojDbSandwichDatabase::get(const MojObject& id, MojDbStorageTxn* txn, boo
     err = get(idItem, txn, forUpdate, *valItem, found);
     MojErrCheck(err);
     if (found) {
-        valItem->id(id);
+        err = valItem->id(id);
+        MojErrCheck(err);
         itemOut = valItem;
     }
     return MojErrNone;
@@ -186,7 +212,7 @@ MojErr MojDbSandwichDatabase::find(MojAutoPtr<MojDbQueryPlan> plan, MojDbStorage
     return MojErrNone;
 }
 
-MojErr MojDbSandwichDatabase::put(const MojObject& id, MojBuffer& val, MojDbStorageTxn* txn, bool updateIdQuota)
+MojErr MojDbSandwichDatabase::put(const MojObject& id, MojBuffer& val, MojDbStorageTxn* txn, bool updateIdQuota, bool compress)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
@@ -196,6 +222,10 @@ MojErr MojDbSandwichDatabase::put(const MojObject& id, MojBuffer& val, MojDbStor
     MojDbSandwichItem valItem;
     err = valItem.fromBuffer(val);
     MojErrCheck(err);
+    if (compress) {
+        err = valItem.compress();
+        MojErrCheck(err);
+    }
     err = put(idItem, valItem, txn, updateIdQuota);
     MojErrCheck(err);
 
@@ -227,7 +257,16 @@ MojErr MojDbSandwichDatabase::put(MojDbSandwichItem& key, MojDbSandwichItem& val
         s = leveldb_txn->ref(impl()).Put(*key.impl(), *val.impl());
     }
     else
+    {
+        // the backend writes unsynced under group commit, so sync this one ourselves
+        MojThreadGuard guard(m_engine->writeMutex());
         s = m_db.Put(*key.impl(), *val.impl());
+        guard.unlock();
+        if (s.ok() && m_engine->groupCommit()) {
+            err = m_engine->syncWrites();
+            MojErrCheck(err);
+        }
+    }
 
 #if defined(MOJ_DEBUG)
     char str_buf[1024];
@@ -327,7 +366,15 @@ MojErr MojDbSandwichDatabase::del(MojDbSandwichItem& key, bool& foundOut, MojDbS
         leveldb_txn->ref(impl()).Delete(*key.impl());
     }
     else
+    {
+        MojThreadGuard guard(m_engine->writeMutex());
         st = m_db.Delete(*key.impl());
+        guard.unlock();
+        if (st.ok() && m_engine->groupCommit()) {
+            err = m_engine->syncWrites();
+            MojErrCheck(err);
+        }
+    }
 
 #if defined(MOJ_DEBUG)
     char str_buf[1024];     // big enough for any key
@@ -425,10 +472,10 @@ void MojDbSandwichDatabase::postUpdate(MojDbStorageTxn* txn, MojSize size)
 {
     if (txn) {
         // TODO: implement quotas
-        // XXX: static_cast<MojDbSandwichTxn*>(txn)->didUpdate(size);
+        static_cast<MojDbSandwichEnvTxn*>(txn)->didUpdate(size);
     } else {
         if (engine()->lazySync())
-            engine()->getUpdater()->sendEvent( getDb() );
+            engine()->getUpdater()->sendEvent( getDb(), size );
     }
 }
 
@@ -40,6 +40,8 @@ public:
     MojErr stats(MojDbStorageTxn* txn, MojSize& countOut, MojSize& sizeOut) override;
     MojErr insert(const MojObject& id, MojBuffer& val, MojDbStorageTxn* txn) override;
     MojErr update(const MojObject& id, MojBuffer& val, MojDbStorageItem* oldVal, MojDbStorageTxn* txn) override;
+    MojErr insertCompressed(const MojObject& id, MojBuffer& val, MojDbStorageTxn* txn) override;
+    MojErr updateCompressed(const MojObject& id, MojBuffer& val, MojDbStorageItem* oldVal, MojDbStorageTxn* txn) override;
     MojErr del(const MojObject& id, MojDbStorageTxn* txn, bool& foundOut) override;
     MojErr get(const MojObject& id, MojDbStorageTxn* txn, bool forUpdate, MojRefCountedPtr<MojDbStorageItem>& itemOut) override;
     MojErr find(MojAutoPtr<MojDbQueryPlan> plan, MojDbStorageTxn* txn, MojRefCountedPtr<MojDbStorageQuery>& queryOut) override;
@@ -49,7 +51,7 @@ public:
 //hack:
     MojErr mutexStats(int* total_mutexes, int* mutexes_free, int* mutexes_used, int* mutexes_used_highwater, int* mutex_regionsize) override;
 
-    MojErr put(const MojObject& id, MojBuffer& val, MojDbStorageTxn* txn, bool updateIdQuota);
+    MojErr put(const MojObject& id, MojBuffer& val, MojDbStorageTxn* txn, bool updateIdQuota, bool compress = false);
     MojErr put(MojDbSandwichItem& key, MojDbSandwichItem& val, MojDbStorageTxn* txn, bool updateIdQuota);
     MojErr del(MojDbSandwichItem& key, bool& foundOut, MojDbStorageTxn* txn);
     MojErr get(MojDbSandwichItem& key, MojDbStorageTxn* txn, bool forUpdate, MojDbSandwichItem& valOut, bool& foundOut);
@@ -46,6 +46,12 @@
 static const MojChar* const MojEnvIndexDbName = _T("indexes.ldb");
 static const MojChar* const MojEnvSeqDbName = _T("seq.ldb");
 
+const MojChar* const MojDbSandwichEngine::GroupCommitWindowKey = _T("groupCommitWindow");
+const MojChar* const MojDbSandwichEngine::LazySyncKey = _T("lazySync");
+const MojChar* const MojDbSandwichEngine::LazyUpdaterKey = _T("lazyUpdater");
+const MojChar* const MojDbSandwichEngine::GroupCommitsKey = _T("groupCommits");
+const MojChar* const MojDbSandwichEngine::GroupedTxnsKey = _T("groupedTxns");
+
 leveldb::ReadOptions MojDbSandwichEngine::ReadOptions;
 leveldb::WriteOptions MojDbSandwichEngine::WriteOptions;
 leveldb::Options MojDbSandwichEngine::OpenOptions;
@@ -54,7 +60,8 @@ leveldb::Options MojDbSandwichEngine::OpenOptions;
 ////////////////////MojDbSandwichEngine////////////////////////////////////////////
 
 MojDbSandwichEngine::MojDbSandwichEngine()
-: m_isOpen(false), m_lazySync(false), m_updater(NULL)
+: m_isOpen(false), m_lazySync(false), m_updater(NULL),
+  m_groupWindowMsec(0), m_lastGroupSize(0), m_groupCount(0), m_groupedTxnCount(0)
 {
     m_updater = new MojDbSandwichLazyUpdater;
 }
@@ -107,6 +114,16 @@ MojErr MojDbSandwichEngine::configure(const MojObject& config)
 
     OpenOptions.create_if_missing = true;
 
+    MojInt64 window = 0;
+    if (config.get(GroupCommitWindowKey, window) && window > 0 && window <= MojUInt32Max) {
+        m_groupWindowMsec = (MojUInt32) window;
+    } else {
+        m_groupWindowMsec = 0;
+    }
+
+    err = m_updater->configure(config);
+    MojErrCheck(err);
+
     return MojErrNone;
 }
 
@@ -171,6 +188,9 @@ MojErr MojDbSandwichEngine::open(const MojChar* path, MojDbEnv* env)
     // TODO: consider moving to configure
     m_db->options = MojDbSandwichEngine::getOpenOptions();
     m_db->writeOptions = MojDbSandwichEngine::getWriteOptions();
+    // a group is made durable by one synced write of its own, see syncWrites
+    if (groupCommit())
+        m_db->writeOptions.sync = false;
     m_db->readOptions = MojDbSandwichEngine::getReadOptions();
     leveldb::Status status = m_db->Open(path);
 
@@ -295,6 +315,29 @@ MojErr MojDbSandwichEngine::compact()
     return MojErrNone;
 }
 
+MojErr MojDbSandwichEngine::stats(MojObject& objOut)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+    MojErr err = objOut.put(LazySyncKey, m_lazySync);
+    MojErrCheck(err);
+    if (m_lazySync) {
+        MojObject updaterStats;
+        err = m_updater->stats(updaterStats);
+        MojErrCheck(err);
+        err = objOut.put(LazyUpdaterKey, updaterStats);
+        MojErrCheck(err);
+    }
+
+    MojThreadGuard guard(m_commitMutex);
+    err = objOut.put(GroupCommitsKey, m_groupCount);
+    MojErrCheck(err);
+    err = objOut.put(GroupedTxnsKey, m_groupedTxnCount);
+    MojErrCheck(err);
+
+    return MojErrNone;
+}
+
 MojErr MojDbSandwichEngine::addSeq(MojDbSandwichSeq* seq)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
@@ -322,3 +365,132 @@ MojErr MojDbSandwichEngine::removeSeq(MojDbSandwichSeq* seq)
     }
     return MojErrNone;
 }
+
+MojErr MojDbSandwichEngine::commit(MojDbSandwichEnvTxn& txn)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+    // nothing to amortize without per-commit syncs
+    if (!groupCommit()) {
+        leveldb::Status s = txn.apply();
+        txn.commitOrdered();
+        MojLdbErrCheck(s, _T("txn->commit"));
+        return MojErrNone;
+    }
+
+    // the committer at the head of the queue leads the next group;
+    // everyone else sleeps until a leader has written them
+    Committer self(txn);
+    MojThreadGuard guard(m_commitMutex);
+    MojErr err = m_commitQueue.push(&self);
+    MojErrCheck(err);
+    // groups are written in queue order, so nobody has to wait on our sync to build on our counts
+    txn.commitOrdered();
+    while (!self.done && m_commitQueue.front() != &self) {
+        err = m_commitCond.wait(m_commitMutex);
+        if (err != MojErrNone) {
+            // a leader holding us in its group writes our txn, so we cannot go before it is done.
+            // It broadcasts once it has; a failed wait just waits again.
+            while (self.grouped && !self.done) {
+                MojErr errWait = m_commitCond.wait(m_commitMutex);
+                MojErrCatchAll(errWait);
+            }
+            if (self.done)
+                return self.err;
+            MojErr errLeave = leaveQueue(self);
+            MojErrAccumulate(err, errLeave);
+            MojErrThrow(err);
+        }
+    }
+    if (self.done)
+        return self.err;
+
+    // only hold the leader back when the last group showed concurrent writers
+    if (m_lastGroupSize > 1) {
+        guard.unlock();
+        MojSleep(m_groupWindowMsec * 1000);
+        guard.lock();
+    }
+
+    // a fixed array, so nothing can fail between taking the group and handing it back
+    Committer* group[MaxGroupSize];
+    MojSize groupSize = MojMin((MojSize) MaxGroupSize, m_commitQueue.size());
+    for (MojSize i = 0; i < groupSize; ++i) {
+        group[i] = m_commitQueue.at(i);
+        group[i]->grouped = true;
+    }
+    guard.unlock();
+
+    MojErr groupErr = commitGroup(group, groupSize);
+
+    guard.lock();
+    err = m_commitQueue.erase(0, groupSize);
+    MojErrAccumulate(groupErr, err);
+    for (MojSize i = 0; i < groupSize; ++i) {
+        if (group[i]->err == MojErrNone)
+            group[i]->err = groupErr;
+        group[i]->done = true;
+    }
+    m_lastGroupSize = groupSize;
+    ++m_groupCount;
+    m_groupedTxnCount += groupSize;
+    err = m_commitCond.broadcast();
+    MojErrAccumulate(groupErr, err);
+
+    return self.err;
+}
+
+MojErr MojDbSandwichEngine::leaveQueue(Committer& self)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+    MojAssertMutexLocked(m_commitMutex);
+
+    for (MojSize i = 0; i < m_commitQueue.size(); ++i) {
+        if (m_commitQueue.at(i) == &self) {
+            MojErr err = m_commitQueue.erase(i);
+            MojErrCheck(err);
+            break;
+        }
+    }
+    // we may have been the front, so somebody else may lead now
+    MojErr err = m_commitCond.broadcast();
+    MojErrCheck(err);
+
+    return MojErrNone;
+}
+
+MojErr MojDbSandwichEngine::commitGroup(Committer* const* group, MojSize groupSize)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+    // the backend writes the whole group to the log unsynced, then one synced write makes it durable
+    MojThreadGuard guard(m_writeMutex);
+    for (MojSize i = 0; i < groupSize; ++i) {
+        leveldb::Status s = group[i]->txn.apply();
+        if (!s.ok()) {
+            LOG_WARNING(MSGID_LEVEL_DB_ENGINE_ERROR, 1,
+                PMLOGKS("error", s.ToString().c_str()),
+                "sandwich: group commit member failed");
+            group[i]->err = LdbToMojErr(s);
+        }
+    }
+    guard.unlock();
+
+    MojErr err = syncWrites();
+    MojErrCheck(err);
+
+    return MojErrNone;
+}
+
+MojErr MojDbSandwichEngine::syncWrites()
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+    leveldb::WriteOptions syncOptions = WriteOptions;
+    syncOptions.sync = true;
+    leveldb::WriteBatch emptyBatch;
+    leveldb::Status s = (*m_db)->Write(syncOptions, &emptyBatch);
+    MojLdbErrCheck(s, _T("group sync"));
+
+    return MojErrNone;
+}
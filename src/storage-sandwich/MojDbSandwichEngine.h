@@ -30,6 +30,7 @@
 
 class MojDbSandwichDatabase;
 class MojDbSandwichEnv;
+class MojDbSandwichEnvTxn;
 class MojDbSandwichSeq;
 class MojDbSandwichLazyUpdater;
 
@@ -37,6 +38,14 @@ class MojDbSandwichEngine : public MojDbStorageEngine
 {
 public:
     typedef leveldb::SandwichDB<leveldb::BottomDB> BackendDb;
+
+    static const MojChar* const GroupCommitWindowKey;
+    static const MojChar* const LazySyncKey;
+    static const MojChar* const LazyUpdaterKey;
+    static const MojChar* const GroupCommitsKey;
+    static const MojChar* const GroupedTxnsKey;
+    static const MojUInt32 MaxGroupSize = 64;
+
     MojDbSandwichEngine();
     ~MojDbSandwichEngine();
 
@@ -49,6 +58,7 @@ public:
     virtual MojErr beginTxn(MojRefCountedPtr<MojDbStorageTxn>& txnOut);
     virtual MojErr openDatabase(const MojChar* name, MojDbStorageTxn* txn, MojRefCountedPtr<MojDbStorageDatabase>& dbOut) ;
     virtual MojErr openSequence(const MojChar* name, MojDbStorageTxn* txn, MojRefCountedPtr<MojDbStorageSeq>& seqOut) ;
+    virtual MojErr stats(MojObject& objOut);
 
     const MojString& path() const { return m_path; }
     MojDbSandwichEnv* env() { return m_env.get(); }
@@ -65,7 +75,31 @@ public:
     MojDbSandwichLazyUpdater* getUpdater() const { return m_updater; }
     bool lazySync() const { return m_lazySync; }
 
+    // group commit: txns committing within the window share one sync
+    MojErr commit(MojDbSandwichEnvTxn& txn);
+    // with group commit the backend writes unsynced; writes outside a txn sync through this
+    MojErr syncWrites();
+    MojThreadMutex& writeMutex() { return m_writeMutex; }
+    bool groupCommit() const { return m_groupWindowMsec > 0 && WriteOptions.sync; }
+    MojUInt32 groupCommitWindow() const { return m_groupWindowMsec; }
+    MojInt64 groupCount() const { return m_groupCount; }
+    MojInt64 groupedTxnCount() const { return m_groupedTxnCount; }
+
 private:
+    struct Committer
+    {
+        Committer(MojDbSandwichEnvTxn& t) : txn(t), err(MojErrNone), grouped(false), done(false) {}
+
+        MojDbSandwichEnvTxn& txn;
+        MojErr err;
+        bool grouped;
+        bool done;
+    };
+    typedef MojVector<Committer*> CommitQueue;
+
+    MojErr commitGroup(Committer* const* group, MojSize groupSize);
+    MojErr leaveQueue(Committer& self);
+
     typedef MojVector<MojRefCountedPtr<MojDbSandwichDatabase> > DatabaseVec;
     typedef MojVector<MojRefCountedPtr<MojDbSandwichSeq> > SequenceVec;
 
@@ -84,6 +118,15 @@ private:
 
     bool m_lazySync;
     MojDbSandwichLazyUpdater* m_updater;
+
+    MojThreadMutex m_commitMutex;
+    MojThreadCond m_commitCond;
+    MojThreadMutex m_writeMutex;
+    CommitQueue m_commitQueue;
+    MojUInt32 m_groupWindowMsec;
+    MojSize m_lastGroupSize;
+    MojInt64 m_groupCount;
+    MojInt64 m_groupedTxnCount;
 };
 
 #endif /* MOJDBLEVELENGINE_H_ */
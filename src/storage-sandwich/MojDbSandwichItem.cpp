@@ -17,6 +17,9 @@
 * LICENSE@@@ */
 
 #include "MojDbSandwichItem.h"
+#ifdef MOJ_USE_SNAPPY
+#include <snappy.h>
+#endif
 #include "db/MojDbKindEngine.h"
 #include "core/MojObjectBuilder.h"
 #include "core/MojLogDb8.h"
@@ -61,12 +64,63 @@ MojErr MojDbSandwichItem::visit(MojObjectVisitor& visitor, MojDbKindEngine& kind
     return MojErrNone;
 }
 
-void MojDbSandwichItem::id(const MojObject& id)
+MojErr MojDbSandwichItem::visitProps(MojObjectVisitor& visitor, MojDbKindEngine& kindEngine, const PropSet& props) const
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+    MojErr err = m_header.visit(visitor, kindEngine);
+    MojErrCheck(err);
+    MojTokenSet tokenSet;
+    err = kindEngine.tokenSet(m_header.kindId(), tokenSet);
+    MojErrCheck(err);
+    // unselected props are skipped in place, so they are never decoded or copied
+    MojObjectReader& reader = m_header.reader();
+    reader.tokenSet(&tokenSet);
+    err = reader.select(&props);
+    MojErrCheck(err);
+    err = reader.read(visitor);
+    MojErr errSelect = reader.select(NULL);
+    MojErrAccumulate(err, errSelect);
+    MojErrCheck(err);
+
+    return MojErrNone;
+}
+
+MojErr MojDbSandwichItem::id(const MojObject& id)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
     m_header.reset();
     m_header.id(id);
-    m_header.reader().data(data(), size());
+    if (size() > 0 && data()[0] == CompressedMarker) {
+        MojErr err = uncompress();
+        MojErrCheck(err);
+        m_header.reader().data(m_uncompressed.begin(), m_uncompressed.size());
+    } else {
+        m_header.reader().data(data(), size());
+    }
+    return MojErrNone;
+}
+
+MojErr MojDbSandwichItem::compress()
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+#ifdef MOJ_USE_SNAPPY
+    if (size() == 0)
+        return MojErrNone;
+
+    MojSize maxSize = 1 + snappy::MaxCompressedLength(size());
+    MojByte* bytes = (MojByte*) MojMalloc(maxSize);
+    MojAllocCheck(bytes);
+    bytes[0] = CompressedMarker;
+    size_t compressedSize = 0;
+    snappy::RawCompress((const char*) data(), size(), (char*) bytes + 1, &compressedSize);
+    // small or incompressible values are cheaper to keep as they are
+    if (1 + compressedSize >= size()) {
+        MojFree(bytes);
+        return MojErrNone;
+    }
+    setData(bytes, 1 + compressedSize, MojFree);
+#endif
+    return MojErrNone;
 }
 
 void MojDbSandwichItem::clear()
@@ -198,6 +252,7 @@ void MojDbSandwichItem::freeData()
 
     // free m_chunk
     m_chunk.reset();
+    m_uncompressed.clear();
 }
 
 void MojDbSandwichItem::setData(MojByte* bytes, MojSize size, void (*free)(void*))
@@ -210,3 +265,26 @@ void MojDbSandwichItem::setData(MojByte* bytes, MojSize size, void (*free)(void*
     m_slice = leveldb::Slice( (const char *)bytes, size);
     m_header.reader().data(bytes, size);
 }
+
+MojErr MojDbSandwichItem::uncompress()
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+    MojAssert(size() > 0 && data()[0] == CompressedMarker);
+#ifdef MOJ_USE_SNAPPY
+    const char* compressed = (const char*) data() + 1;
+    size_t compressedSize = size() - 1;
+    size_t len = 0;
+    if (!snappy::GetUncompressedLength(compressed, compressedSize, &len))
+        MojErrThrowMsg(MojErrDbCorruptDatabase, _T("sandwich: corrupt compressed value"));
+    MojErr err = m_uncompressed.resize(len);
+    MojErrCheck(err);
+    MojVector<MojByte>::Iterator begin;
+    err = m_uncompressed.begin(begin);
+    MojErrCheck(err);
+    if (!snappy::RawUncompress(compressed, compressedSize, (char*) begin))
+        MojErrThrowMsg(MojErrDbCorruptDatabase, _T("sandwich: corrupt compressed value"));
+    return MojErrNone;
+#else
+    MojErrThrowMsg(MojErrNotImplemented, _T("sandwich: compressed value, but built without snappy"));
+#endif
+}
@@ -26,11 +26,16 @@
 class MojDbSandwichItem : public MojDbStorageItem
 {
 public:
+    // first byte of compressed values. object values start with the header
+    // version, so a stored value can never begin with it by accident.
+    static const MojByte CompressedMarker = 0xFF;
+
     MojDbSandwichItem();
     virtual ~MojDbSandwichItem() { freeData(); }
     virtual MojErr close() { return MojErrNone; }
     virtual MojErr kindId(MojString& kindIdOut, MojDbKindEngine& kindEngine);
     virtual MojErr visit(MojObjectVisitor& visitor, MojDbKindEngine& kindEngine, bool headerExpected = true) const;
+    virtual MojErr visitProps(MojObjectVisitor& visitor, MojDbKindEngine& kindEngine, const PropSet& props) const;
     virtual const MojObject& id() const { return m_header.id(); }
     virtual MojSize size() const { return m_slice.size(); }
 
@@ -40,7 +45,8 @@ public:
     MojErr toArray(MojObject& arrayOut) const;
     MojErr toObject(MojObject& objOut) const;
 
-    void id(const MojObject& id);
+    MojErr id(const MojObject& id);
+    MojErr compress();
     void fromBytesNoCopy(const MojByte* bytes, MojSize size);
     MojErr fromBuffer(MojBuffer& buf);
     MojErr fromBytes(const MojByte* bytes, MojSize size);
@@ -53,11 +59,13 @@ public:
 private:
     void freeData();
     void setData(MojByte* bytes, MojSize size, void (*free)(void*));
+    MojErr uncompress();
 
     // either points to m_chunk or to m_data
     leveldb::Slice m_slice;
     MojAutoPtr<MojBuffer::Chunk> m_chunk;
     MojByte *m_data;
+    MojVector<MojByte> m_uncompressed;
     mutable MojDbObjectHeader m_header;
     void (*m_free)(void*);
 };
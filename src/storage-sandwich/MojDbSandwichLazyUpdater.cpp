@@ -18,57 +18,86 @@
 
 #include "db/MojDb.h"
 #include "MojDbSandwichLazyUpdater.h"
-#include <time.h>
+#include <leveldb/write_batch.h>
+
+const MojChar* const MojDbSandwichLazyUpdater::MaxLatencyKey = _T("lazySyncMaxLatency");
+const MojChar* const MojDbSandwichLazyUpdater::MaxDirtyBytesKey = _T("lazySyncMaxDirtyBytes");
+const MojChar* const MojDbSandwichLazyUpdater::SyncsKey = _T("syncs");
+const MojChar* const MojDbSandwichLazyUpdater::BytesSyncedKey = _T("bytesSynced");
+const MojChar* const MojDbSandwichLazyUpdater::BytesPerSyncKey = _T("bytesPerSync");
+const MojChar* const MojDbSandwichLazyUpdater::SinceLastSyncKey = _T("msecSinceLastSync");
 
 ////////////////////MojDbSandwichLazyUpdater////////////////////////////////////////////
 
 MojDbSandwichLazyUpdater::MojDbSandwichLazyUpdater()
-    : m_thread(MojInvalidThread), m_stop(false)
+    : m_thread(MojInvalidThread),
+      m_stop(false),
+      m_maxLatencyMsec(MaxLatencyMsecDefault),
+      m_maxDirtyBytes(MaxDirtyBytesDefault),
+      m_dirtyBytes(0),
+      m_syncs(0),
+      m_bytesSynced(0)
 {
 }
 
 MojDbSandwichLazyUpdater::~MojDbSandwichLazyUpdater()
 {
-    deinit();
+    MojErr err = stop();
+    MojErrCatchAll(err);
 }
 
-MojErr MojDbSandwichLazyUpdater::start()
+MojErr MojDbSandwichLazyUpdater::configure(const MojObject& conf)
 {
-    MojErr err = MojErrNone;
+    MojInt64 val = 0;
+    if (conf.get(MaxLatencyKey, val) && val > 0 && val <= MojUInt32Max)
+        m_maxLatencyMsec = (MojUInt32) val;
+    else
+        m_maxLatencyMsec = MaxLatencyMsecDefault;
+
+    if (conf.get(MaxDirtyBytesKey, val) && val > 0)
+        m_maxDirtyBytes = (MojSize) val;
+    else
+        m_maxDirtyBytes = MaxDirtyBytesDefault;
+
+    return MojErrNone;
+}
 
+MojErr MojDbSandwichLazyUpdater::start()
+{
+    MojThreadGuard guard(m_mutex);
     if (MojInvalidThread == m_thread)
     {
+        m_stop = false;
+        MojErr err = MojGetCurrentTime(m_lastSync);
+        MojErrCheck(err);
         err = MojThreadCreate(m_thread, &threadMain, this);
         MojErrCheck(err);
     }
-    m_stop = false;
 
-    return (err);
+    return MojErrNone;
 }
 
 MojErr MojDbSandwichLazyUpdater::stop()
 {
-    MojErr err = MojErrNone;
+    MojThreadGuard guard(m_mutex);
+    if (MojInvalidThread == m_thread)
+        return MojErrNone;
 
+    // wake the flusher; it syncs whatever is dirty on the way out
     m_stop = true;
-    return (err);
-}
-
-MojErr MojDbSandwichLazyUpdater::deinit()
-{
-    MojErr err = MojErrNone;
+    MojErr err = m_cond.signal();
+    MojErrCheck(err);
+    MojThreadT thread = m_thread;
+    guard.unlock();
 
-    stop();
-    if (MojInvalidThread != m_thread)
-    {
-        MojErr threadErr = MojErrNone;
-        MojErr joinErr = MojThreadJoin(m_thread, threadErr);
+    MojErr threadErr = MojErrNone;
+    err = MojThreadJoin(thread, threadErr);
+    MojErrAccumulate(err, threadErr);
 
-        MojErrAccumulate(err, threadErr);
-        MojErrAccumulate(err, joinErr);
-    }
+    guard.lock();
+    m_thread = MojInvalidThread;
 
-    return (err);
+    return err;
 }
 
 MojErr MojDbSandwichLazyUpdater::threadMain(void* arg)
@@ -76,12 +105,26 @@ MojErr MojDbSandwichLazyUpdater::threadMain(void* arg)
     MojDbSandwichLazyUpdater* thiz_class = (MojDbSandwichLazyUpdater*) arg;
     MojAssert(thiz_class);
 
-    while (thiz_class->m_stop == false) {
-        thiz_class->sync();
-        MojSleep(UpdaterIntervalMsec * 1000);
+    return thiz_class->run();
+}
+
+MojErr MojDbSandwichLazyUpdater::run()
+{
+    MojThreadGuard guard(m_mutex);
+    while (!m_stop) {
+        if (m_dirtyBytes < m_maxDirtyBytes) {
+            MojErr err = m_cond.wait(m_mutex, MojMillisecs(m_maxLatencyMsec));
+            if (err != MojErrTimedOut)
+                MojErrCheck(err);
+        }
+        guard.unlock();
+        MojErr err = sync();
+        MojErrCatchAll(err);
+        guard.lock();
     }
+    guard.unlock();
 
-    return MojErrNone;
+    return sync();
 }
 
 MojErr MojDbSandwichLazyUpdater::open(leveldb::DB* pdb)
@@ -101,17 +144,23 @@ MojErr MojDbSandwichLazyUpdater::close(leveldb::DB* pdb)
 {
     MojThreadGuard guard(m_mutex);
     if(m_dbs.find(pdb) != m_dbs.end()) {
-        onesync(pdb);
+        MojErr err = onesync(pdb);
+        MojErrCatchAll(err);
         m_dbs.erase(pdb);
     }
 
     return MojErrNone;
 }
 
-MojErr MojDbSandwichLazyUpdater::sendEvent(leveldb::DB* pdb)
+MojErr MojDbSandwichLazyUpdater::sendEvent(leveldb::DB* pdb, MojSize bytes)
 {
     MojThreadGuard guard(m_mutex);
     m_dbs[pdb] = true;
+    m_dirtyBytes += bytes;
+    if (m_dirtyBytes >= m_maxDirtyBytes) {
+        MojErr err = m_cond.signal();
+        MojErrCheck(err);
+    }
 
     return MojErrNone;
 }
@@ -121,7 +170,6 @@ MojErr MojDbSandwichLazyUpdater::sync()
     Container dbs_copy;
 
     MojThreadGuard guard(m_mutex);
-    dbs_copy.clear();
     for (Container::iterator it = m_dbs.begin();
         it != m_dbs.end();
         ++it)
@@ -131,26 +179,59 @@ MojErr MojDbSandwichLazyUpdater::sync()
             dbs_copy[it->first] = true;
         }
     }
+    MojSize bytes = m_dirtyBytes;
+    m_dirtyBytes = 0;
     guard.unlock();
 
+    if (dbs_copy.empty())
+        return MojErrNone;
+
+    MojErr accErr = MojErrNone;
     for (Container::iterator it = dbs_copy.begin();
         it != dbs_copy.end();
         ++it) {
-        if(it->first && it->second == true) {
-            onesync(it->first);
-        }
+        MojErr err = onesync(it->first);
+        MojErrAccumulate(accErr, err);
     }
 
-    LOG_DEBUG("[db_ldb] do sync\n");
+    guard.lock();
+    ++m_syncs;
+    m_bytesSynced += bytes;
+    MojErr err = MojGetCurrentTime(m_lastSync);
+    MojErrAccumulate(accErr, err);
+
+    LOG_DEBUG("[db_ldb] do sync: %zu bytes\n", bytes);
+    return accErr;
+}
+
+MojErr MojDbSandwichLazyUpdater::stats(MojObject& objOut) const
+{
+    MojThreadGuard guard(m_mutex);
+
+    MojErr err = objOut.put(SyncsKey, m_syncs);
+    MojErrCheck(err);
+    err = objOut.put(BytesSyncedKey, m_bytesSynced);
+    MojErrCheck(err);
+    err = objOut.put(BytesPerSyncKey, m_syncs ? m_bytesSynced / m_syncs : (MojInt64) 0);
+    MojErrCheck(err);
+    MojTime now;
+    err = MojGetCurrentTime(now);
+    MojErrCheck(err);
+    err = objOut.put(SinceLastSyncKey, (now - m_lastSync).millisecs());
+    MojErrCheck(err);
+
     return MojErrNone;
 }
 
-void MojDbSandwichLazyUpdater::onesync(leveldb::DB* pdb)
+MojErr MojDbSandwichLazyUpdater::onesync(leveldb::DB* pdb)
 {
-    // Delete meaning less data for sync.
-    // TODO: Rationalize followings.
+    // an empty synced batch flushes the log without adding a record to the memtable
     leveldb::WriteOptions write_options;
     write_options.sync = true;
-    pdb->Delete(write_options, "_______dummy______");
-}
+    leveldb::WriteBatch batch;
+    leveldb::Status s = pdb->Write(write_options, &batch);
+    if (!s.ok())
+        MojErrThrowMsg(MojErrDbIO, _T("ldb: lazy sync - %s"), s.ToString().data());
 
+    return MojErrNone;
+}
@@ -24,38 +24,58 @@
 #include <leveldb/db.h>
 #include "db/MojDbDefs.h"
 #include "db/MojDbStorageEngine.h"
+#include "core/MojTime.h"
 
+// Syncs the leveldb log behind unsynced ("sync" : 2) writes. The flusher thread sleeps until
+// either maxLatency has passed since dirty data appeared or maxDirtyBytes have been written.
 class MojDbSandwichLazyUpdater
 {
 public:
-    static const MojUInt32 UpdaterIntervalMsec = 1000;
+    static const MojUInt32 MaxLatencyMsecDefault = 1000;
+    static const MojSize MaxDirtyBytesDefault = 1024 * 1024;
+    static const MojChar* const MaxLatencyKey;
+    static const MojChar* const MaxDirtyBytesKey;
+    static const MojChar* const SyncsKey;
+    static const MojChar* const BytesSyncedKey;
+    static const MojChar* const BytesPerSyncKey;
+    static const MojChar* const SinceLastSyncKey;
 
     MojDbSandwichLazyUpdater();
     ~MojDbSandwichLazyUpdater();
 
+    MojErr configure(const MojObject& conf);
     MojErr open(leveldb::DB* pdb);
     MojErr close(leveldb::DB* pdb);
-    MojErr sendEvent(leveldb::DB* pdb);
+    MojErr sendEvent(leveldb::DB* pdb, MojSize bytes = 0);
     MojErr sync();
+    MojErr stats(MojObject& objOut) const;
 
     MojErr start();
     MojErr stop();
 
 protected:
-    void onesync(leveldb::DB* pdb);
-    MojErr deinit();
+    MojErr onesync(leveldb::DB* pdb);
 
 private:
     typedef std::map<leveldb::DB*, bool> Container;
 
     static MojErr threadMain(void* arg);
+    MojErr run();
 
     MojThreadT m_thread;
     mutable MojThreadMutex m_mutex;
+    MojThreadCond m_cond;
     bool m_stop;
 
     Container m_dbs;
+    MojUInt32 m_maxLatencyMsec;
+    MojSize m_maxDirtyBytes;
+    MojSize m_dirtyBytes;
+
+    // counters
+    MojInt64 m_syncs;
+    MojInt64 m_bytesSynced;
+    MojTime m_lastSync;
 };
 
 #endif
-
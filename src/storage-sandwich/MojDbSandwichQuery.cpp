@@ -16,12 +16,17 @@
 *
 * LICENSE@@@ */
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
 #include "MojDbSandwichDatabase.h"
 #include "MojDbSandwichQuery.h"
 #include "MojDbSandwichEngine.h"
 #include "MojDbSandwichTxn.h"
 #include "db/MojDbQueryPlan.h"
 #include "core/MojObjectSerialization.h"
+#include "defs.h"
 
 MojDbSandwichQuery::MojDbSandwichQuery()
 {
@@ -96,7 +101,8 @@ MojErr MojDbSandwichQuery::getById(const MojObject& id, MojDbStorageItem*& itemO
         // return val from cursor
         item = &m_val;
     }
-    item->id(id);
+    err = item->id(id);
+    MojErrCheck(err);
 
     // check for exclusions
     bool exclude = false;
@@ -108,7 +114,7 @@ MojErr MojDbSandwichQuery::getById(const MojObject& id, MojDbStorageItem*& itemO
     return MojErrNone;
 }
 
-MojErr MojDbSandwichQuery::seekImpl(const ByteVec& key, bool desc, bool& foundOut)
+MojErr MojDbSandwichQuery::seekImpl(const MojDbKey& key, bool desc, bool& foundOut)
 {
     MojAssert( m_it );
 
@@ -120,7 +126,7 @@ MojErr MojDbSandwichQuery::seekImpl(const ByteVec& key, bool desc, bool& foundOu
         MojErrCheck(err);
     } else {
         // otherwise seek to the key
-        MojErr err = m_key.fromBytes(key.begin(), key.size());
+        MojErr err = m_key.fromBytes(key.data(), key.size());
         MojErrCheck(err);
         m_it->Seek(*m_key.impl());
         // if descending, skip the first result (which is outside the range)
@@ -171,6 +177,37 @@ MojErr MojDbSandwichQuery::getVal(MojDbStorageItem*& itemOut, bool& foundOut)
     return MojErrNone;
 }
 
+MojErr MojDbSandwichQuery::countIds(const ObjectVec& ids, MojUInt32& countOut)
+{
+    // without a join the values come from the scanned collection itself
+    if (!m_db)
+        return MojDbIsamQuery::countIds(ids, countOut);
+
+    std::vector<std::string> keys;
+    keys.reserve(ids.size());
+    for (ObjectVec::ConstIterator i = ids.begin(); i != ids.end(); ++i) {
+        MojDbSandwichItem key;
+        MojErr err = key.fromObject(*i);
+        MojErrCheck(err);
+        keys.emplace_back(reinterpret_cast<const char*>(key.data()), key.size());
+    }
+    // seeking in key order walks one iterator forward through the primary db,
+    // and only keys are compared so values are never copied or decompressed
+    std::sort(keys.begin(), keys.end());
+
+    auto txn = static_cast<MojDbSandwichEnvTxn *>(m_txn);
+    auto it = txn->ref(m_db->impl()).NewIterator();
+    countOut = 0;
+    for (const auto& key : keys) {
+        it->Seek(key);
+        if (it->Valid() && it->key() == leveldb::Slice(key))
+            ++countOut;
+    }
+    MojLdbErrCheck(it->status(), _T("db->count"));
+
+    return MojErrNone;
+}
+
 MojErr MojDbSandwichQuery::readEntry(bool& foundOut)
 {
     if (m_it->Valid())
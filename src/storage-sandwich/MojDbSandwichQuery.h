@@ -37,9 +37,10 @@ public:
 	MojErr close() override;
 
 private:
-	MojErr seekImpl(const ByteVec& key, bool desc, bool& foundOut) override;
+	MojErr seekImpl(const MojDbKey& key, bool desc, bool& foundOut) override;
 	MojErr next(bool& foundOut) override;
 	MojErr getVal(MojDbStorageItem*& itemOut, bool& foundOut) override;
+	MojErr countIds(const ObjectVec& ids, MojUInt32& countOut) override;
 	MojErr readEntry(bool &foundOut);;
 
 	std::unique_ptr<leveldb::Iterator> m_it;
@@ -19,8 +19,52 @@
 #include "MojDbSandwichSeq.h"
 #include "MojDbSandwichDatabase.h"
 #include "MojDbSandwichEngine.h"
+#include "MojDbSandwichTxn.h"
+#include "defs.h"
+
+const MojChar* const MojDbSandwichSeq::TxnKeySuffix = _T(".txn");
+
+// Raises the high mark once the txn that stored it commits. If the txn is
+// aborted instead, the signal drops us without firing and the next caller
+// tries again.
+class MojDbSandwichSeq::Reservation : public MojSignalHandler
+{
+public:
+    Reservation(MojDbSandwichSeq* seq, MojInt64 next)
+    : m_seq(seq), m_next(next), m_done(false), m_slot(this, &Reservation::handleCommit) {}
+
+    MojDbStorageTxn::CommitSignal::Slot<Reservation>& slot() { return m_slot; }
+
+private:
+    ~Reservation()
+    {
+        if (!m_done)
+            m_seq->reserved(m_next, false);
+    }
+
+    MojErr handleCommit(MojDbStorageTxn* txn)
+    {
+        m_done = true;
+        m_seq->reserved(m_next, true);
+        return MojErrNone;
+    }
+
+    MojRefCountedPtr<MojDbSandwichSeq> m_seq;
+    MojInt64 m_next;
+    bool m_done;
+    MojDbStorageTxn::CommitSignal::Slot<Reservation> m_slot;
+};
+
+MojDbSandwichSeq::MojDbSandwichSeq()
+: m_db(NULL),
+  m_next(0),
+  m_allocated(0),
+  m_lowWater(0),
+  m_pending(false),
+  m_reserve(MinReserve)
+{
+}
 
-// at this point it's just a placeholder
 MojDbSandwichSeq::~MojDbSandwichSeq()
 {
     if (m_db) {
@@ -34,31 +78,29 @@ MojErr MojDbSandwichSeq::open(const MojChar* name, MojDbSandwichDatabase* db)
     LOG_TRACE("Entering function %s", __FUNCTION__);
     MojAssert(db);
 
-    //MojAssert(!m_seq);
-    MojErr err;
-
     m_db = db;
-    err = m_key.fromBytes(reinterpret_cast<const MojByte  *>(name), strlen(name));
+    MojErr err = m_key.fromBytes(reinterpret_cast<const MojByte*>(name), MojStrLen(name));
     MojErrCheck(err);
-
-    MojDbSandwichItem val;
-    bool found = false;
-    err = m_db->get(m_key, NULL, false, val, found);
+    MojString txnKey;
+    err = txnKey.format(_T("%s%s"), name, TxnKeySuffix);
+    MojErrCheck(err);
+    err = m_txnKey.fromBytes(reinterpret_cast<const MojByte*>(txnKey.data()), txnKey.length());
     MojErrCheck(err);
 
-    if (found)
-    {
-        MojObject valObj;
-        err = val.toObject(valObj);
-        MojErrCheck(err);
-        m_next = valObj.intValue();
-    }
-    else
-    {
-        m_next = 0;
-    }
+    // either key may hold the highest mark, depending on which was written last
+    MojInt64 next = 0;
+    err = load(m_key, next);
+    MojErrCheck(err);
+    MojInt64 txnNext = 0;
+    err = load(m_txnKey, txnNext);
+    MojErrCheck(err);
 
-    m_allocated = m_next;
+    m_next = MojMax(next, txnNext);
+    m_allocated = m_next.load();
+    m_pending = false;
+    m_reserve = MinReserve;
+    m_reserveTime = 0;
+    updateLowWater();
 
     return MojErrNone;
 }
@@ -68,7 +110,12 @@ MojErr MojDbSandwichSeq::close()
     LOG_TRACE("Entering function %s", __FUNCTION__);
 
     if (m_db) {
-        MojErr err = store(m_next);
+        MojThreadGuard guard(m_mutex);
+        // give back the unused part of the reservation
+        MojInt64 next = m_next;
+        MojErr err = store(m_key, next, NULL);
+        MojErrCheck(err);
+        err = store(m_txnKey, next, NULL);
         MojErrCheck(err);
         m_db = NULL;
     }
@@ -76,57 +123,136 @@ MojErr MojDbSandwichSeq::close()
 }
 
 MojErr MojDbSandwichSeq::get(MojInt64& valOut)
+{
+    return get(valOut, NULL);
+}
+
+MojErr MojDbSandwichSeq::get(MojInt64& valOut, MojDbStorageTxn* txn)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
+    MojAssert(m_db);
 
-    if (m_next == m_allocated)
-    {
-        MojErr err = MojDbSandwichSeq::allocateMore();
+    MojInt64 val = m_next++;
+    MojErr err = MojErrNone;
+    if (val >= m_allocated) {
+        err = allocateMore(val + 1);
+        MojErrCheck(err);
+    } else if (txn && val >= m_lowWater && !m_pending) {
+        err = reserveAhead(txn);
         MojErrCheck(err);
-        MojAssert(m_allocated > m_next);
     }
-    valOut = m_next++;
+    valOut = val;
 
     return MojErrNone;
 }
 
-MojErr MojDbSandwichSeq::allocateMore()
+MojErr MojDbSandwichSeq::allocateMore(MojInt64 needed)
 {
-    return store(m_allocated + 100);
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+    MojThreadGuard guard(m_mutex);
+    while (m_allocated < needed) {
+        MojInt64 next = m_allocated + nextReserve();
+        MojErr err = store(m_key, next, NULL);
+        MojErrCheck(err);
+        m_allocated = next;
+    }
+    updateLowWater();
+
+    return MojErrNone;
 }
 
-MojErr MojDbSandwichSeq::store(MojInt64 next)
+MojErr MojDbSandwichSeq::reserveAhead(MojDbStorageTxn* txn)
 {
     LOG_TRACE("Entering function %s", __FUNCTION__);
-    MojAssert( next >= m_next );
-    MojErr err;
-    MojDbSandwichItem val;
+    MojAssert(txn);
 
-#ifdef MOJ_DEBUG
-    // ensure that our state is consistent with db
-    bool found = false;
-    err = m_db->get(m_key, NULL, false, val, found);
+    // declared ahead of the guard, since a reservation that is dropped
+    // unused reports back to us under the same mutex
+    MojRefCountedPtr<Reservation> res;
+    MojThreadGuard guard(m_mutex);
+    if (m_pending)
+        return MojErrNone;
+
+    // only one reservation is in flight at a time, so marks stored under
+    // m_txnKey always increase in commit order
+    MojInt64 next = m_allocated + nextReserve();
+    MojErr err = store(m_txnKey, next, txn);
     MojErrCheck(err);
+    res.reset(new Reservation(this, next));
+    MojAllocCheck(res.get());
+    m_pending = true;
+    txn->notifyPostCommit(res->slot());
 
-    if (found)
-    {
+    return MojErrNone;
+}
+
+void MojDbSandwichSeq::reserved(MojInt64 next, bool committed)
+{
+    MojThreadGuard guard(m_mutex);
+    if (committed && next > m_allocated)
+        m_allocated = next;
+    m_pending = false;
+    updateLowWater();
+}
+
+MojInt64 MojDbSandwichSeq::nextReserve()
+{
+    MojAssertMutexLocked(m_mutex);
+
+    MojTime now;
+    if (MojGetCurrentTime(now) == MojErrNone) {
+        MojInt64 secs = (now - m_reserveTime).secs();
+        if (m_reserveTime != 0 && secs < FastReserveSecs)
+            m_reserve = MojMin(m_reserve * 2, MaxReserve);
+        else if (secs > SlowReserveSecs)
+            m_reserve = MojMax(m_reserve / 2, MinReserve);
+        m_reserveTime = now;
+    }
+    return m_reserve;
+}
+
+void MojDbSandwichSeq::updateLowWater()
+{
+    // start reserving ahead once half of the current reservation is used
+    m_lowWater = m_allocated - m_reserve / 2;
+}
+
+MojErr MojDbSandwichSeq::load(const MojDbSandwichItem& key, MojInt64& valOut)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+
+    MojDbSandwichItem val;
+    bool found = false;
+    MojErr err = m_db->get(const_cast<MojDbSandwichItem&>(key), NULL, false, val, found);
+    MojErrCheck(err);
+    valOut = 0;
+    if (found) {
         MojObject valObj;
         err = val.toObject(valObj);
         MojErrCheck(err);
-        if (m_allocated != valObj.intValue()) return MojErrDbInconsistentIndex;
-    }
-    else
-    {
-        if (m_allocated != 0) return MojErrDbInconsistentIndex;
+        valOut = valObj.intValue();
     }
+    return MojErrNone;
+}
 
-#endif
+MojErr MojDbSandwichSeq::store(const MojDbSandwichItem& key, MojInt64 next, MojDbStorageTxn* txn)
+{
+    LOG_TRACE("Entering function %s", __FUNCTION__);
+    MojAssert(m_db);
 
-    err = val.fromObject(next);
-    MojErrCheck(err);
-    err = m_db->put(m_key, val, NULL, false);
+    MojDbSandwichItem val;
+    MojErr err = val.fromObject(next);
     MojErrCheck(err);
-    m_allocated = next;
-
+    MojDbSandwichItem& keyItem = const_cast<MojDbSandwichItem&>(key);
+    if (txn) {
+        // written straight into the txn, so that it is not counted against any quota
+        MojAssert(dynamic_cast<MojDbSandwichEnvTxn*>(txn));
+        leveldb::Status s = static_cast<MojDbSandwichEnvTxn*>(txn)->ref(m_db->impl()).Put(*keyItem.impl(), *val.impl());
+        MojLdbErrCheck(s, _T("seq put"));
+    } else {
+        err = m_db->put(keyItem, val, NULL, false);
+        MojErrCheck(err);
+    }
     return MojErrNone;
 }
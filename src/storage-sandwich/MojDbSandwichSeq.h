@@ -19,30 +19,59 @@
 #ifndef MOJDBLEVELSEQ_H_
 #define MOJDBLEVELSEQ_H_
 
+#include <atomic>
+#include "core/MojThread.h"
+#include "core/MojTime.h"
 #include "MojDbSandwichDatabase.h"
 #include "MojDbSandwichItem.h"
 
+// Hands out ids from an in-memory counter. Every id handed out is below a high
+// mark that has already been persisted, so ids are never reused after a crash.
+// The mark is raised ahead of time with the caller's txn when one is given, and
+// synchronously only when the counter catches up with it. The size of each
+// reservation adapts to how quickly ids are being used.
 class MojDbSandwichSeq : public MojDbStorageSeq
 {
 public:
-    MojDbSandwichSeq() : m_db(NULL), m_next(0), m_allocated(0) {}
+    static const MojInt64 MinReserve = 100;
+    static const MojInt64 MaxReserve = 100000;
+
+    MojDbSandwichSeq();
     ~MojDbSandwichSeq();
 
     MojErr open(const MojChar* name, MojDbSandwichDatabase* db);
     virtual MojErr close();
     virtual MojErr get(MojInt64& valOut);
-
+    virtual MojErr get(MojInt64& valOut, MojDbStorageTxn* txn);
 
 private:
     friend class MojDbSandwichEngine;
+    class Reservation;
+
+    // reservations that last less than FastReserveSecs grow, those that last
+    // more than SlowReserveSecs shrink
+    static const MojInt64 FastReserveSecs = 1;
+    static const MojInt64 SlowReserveSecs = 10;
+    static const MojChar* const TxnKeySuffix;
 
-    MojErr store(MojInt64 next);
-    MojErr allocateMore();
+    MojErr load(const MojDbSandwichItem& key, MojInt64& valOut);
+    MojErr store(const MojDbSandwichItem& key, MojInt64 next, MojDbStorageTxn* txn);
+    MojErr allocateMore(MojInt64 needed);
+    MojErr reserveAhead(MojDbStorageTxn* txn);
+    void reserved(MojInt64 next, bool committed);
+    MojInt64 nextReserve();
+    void updateLowWater();
 
     MojDbSandwichDatabase* m_db;
-    MojDbSandwichItem m_key;
-    MojInt64 m_next;
-    MojInt64 m_allocated;
+    MojDbSandwichItem m_key;        // stored synchronously
+    MojDbSandwichItem m_txnKey;     // stored with callers' txns
+    MojThreadMutex m_mutex;
+    std::atomic<MojInt64> m_next;
+    std::atomic<MojInt64> m_allocated;  // persisted high mark
+    std::atomic<MojInt64> m_lowWater;   // start reserving ahead from here
+    std::atomic<bool> m_pending;        // a reservation is waiting for its txn to commit
+    MojInt64 m_reserve;
+    MojTime m_reserveTime;
 };
 
 #endif
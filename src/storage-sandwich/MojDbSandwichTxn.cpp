@@ -26,15 +26,18 @@ MojErr MojDbSandwichEnvTxn::abort()
 {
     // Note creation of databases will not be rolled back
     m_txn->reset();
+    m_updateSize = 0;
     return MojErrNone;
 }
 
 MojErr MojDbSandwichEnvTxn::commitImpl()
 {
-    m_txn->commit();
+    MojErr err = m_engine.commit(*this);
+    MojErrCheck(err);
 
     if (m_engine.lazySync())
-        m_engine.getUpdater()->sendEvent( (*m_db).get() );
+        m_engine.getUpdater()->sendEvent( (*m_db).get(), m_updateSize );
+    m_updateSize = 0;
 
     return MojErrNone;
 }
@@ -40,7 +40,7 @@ public:
     typedef leveldb::SandwichDB<leveldb::TxnDB<leveldb::BottomDB>> BackendDb;
 
     MojDbSandwichEnvTxn(MojDbSandwichEngine::BackendDb& db, MojDbSandwichEngine& engine)
-        : m_txn(db.ref<leveldb::TxnDB>()), m_db(db), m_engine(engine)
+        : m_txn(db.ref<leveldb::TxnDB>()), m_db(db), m_engine(engine), m_updateSize(0)
     { }
 
     ~MojDbSandwichEnvTxn()
@@ -54,12 +54,20 @@ public:
     BackendDb::Part ref(MojDbSandwichEngine::BackendDb::Part &db)
     { return db.ref(m_txn); }
 
+    // writes pending changes to the backend; normally called by the engine's group commit
+    leveldb::Status apply()
+    { return m_txn->commit(); }
+
+    void didUpdate(MojSize size)
+    { m_updateSize += size; }
+
 private:
     MojErr commitImpl() override;
 
     BackendDb m_txn;
     MojDbSandwichEngine::BackendDb& m_db;
     MojDbSandwichEngine& m_engine;
+    MojSize m_updateSize;
 };
 
 #endif
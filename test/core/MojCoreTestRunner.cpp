@@ -30,6 +30,7 @@
 #include "MojDataSerializationTest.h"
 #include "MojDecimalTest.h"
 #include "MojErrTest.h"
+#include "MojFlatMapTest.h"
 #include "MojObjectFilterTest.h"
 #include "MojHashMapTest.h"
 #include "MojJsonTest.h"
@@ -70,6 +71,7 @@ void MojCoreTestRunner::runTests()
 	test(MojDataSerializationTest());
 	test(MojDecimalTest());
 	test(MojErrTest());
+	test(MojFlatMapTest());
 	test(MojHashMapTest());
 	test(MojJsonTest());
 	test(MojListTest());
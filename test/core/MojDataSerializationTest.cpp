@@ -83,6 +83,14 @@ MojErr MojDataSerializationTest::run()
 	MojTestErrCheck(err);
 	err = writer.writeDecimal(MojDecimal(-9999, 888888));
 	MojTestErrCheck(err);
+	err = writer.writeVarUInt32(0);
+	MojTestErrCheck(err);
+	err = writer.writeVarUInt32(0x7F);
+	MojTestErrCheck(err);
+	err = writer.writeVarUInt32(0x3FFF);
+	MojTestErrCheck(err);
+	err = writer.writeVarUInt32(0xFFFFFFFF);
+	MojTestErrCheck(err);
 
 	const MojByte* data = NULL;
 	MojSize size;
@@ -143,6 +151,20 @@ MojErr MojDataSerializationTest::run()
 	err = reader.readDecimal(decVal);
 	MojTestErrCheck(err);
 	MojTestAssert(decVal == MojDecimal(-9999, 888888));
+	err = reader.readVarUInt32(ui32val);
+	MojTestErrCheck(err);
+	MojTestAssert(ui32val == 0);
+	err = reader.readVarUInt32(ui32val);
+	MojTestErrCheck(err);
+	MojTestAssert(ui32val == 0x7F);
+	MojSize avail = reader.available();
+	err = reader.readVarUInt32(ui32val);
+	MojTestErrCheck(err);
+	MojTestAssert(ui32val == 0x3FFF);
+	MojTestAssert(avail - reader.available() == 2);
+	err = reader.readVarUInt32(ui32val);
+	MojTestErrCheck(err);
+	MojTestAssert(ui32val == 0xFFFFFFFF);
 
 
 	MojDataReader reader2(NULL, 0);
@@ -156,6 +178,14 @@ MojErr MojDataSerializationTest::run()
 	MojTestErrExpected(err, MojErrUnexpectedEof);
 	err = reader.readDecimal(decVal);
 	MojTestErrExpected(err, MojErrUnexpectedEof);
+	err = reader.readVarUInt32(ui32val);
+	MojTestErrExpected(err, MojErrUnexpectedEof);
+
+	// more than five bytes can't be a 32-bit value
+	const MojByte overlong[] = {0x80, 0x80, 0x80, 0x80, 0x80, 0x01};
+	MojDataReader reader3(overlong, sizeof(overlong));
+	err = reader3.readVarUInt32(ui32val);
+	MojTestErrExpected(err, MojErrValueOutOfRange);
 
 	return MojErrNone;
 }
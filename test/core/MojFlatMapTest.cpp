@@ -0,0 +1,219 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2014 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+/**
+****************************************************************************************************
+* Filename              : MojFlatMapTest.cpp
+* Description           : Source file for MojFlatMap test.
+****************************************************************************************************
+**/
+
+#include "MojFlatMapTest.h"
+#include "core/MojMap.h"
+#include "core/MojString.h"
+
+MojFlatMapTest::MojFlatMapTest()
+: MojTestCase(_T("MojFlatMap"))
+{
+}
+/**
+****************************************************************************************************
+* @run              MojFlatMap has the interface and ordering of MojMap but keeps its entries in
+                    a sorted copy-on-write vector.
+                    Checks put/get/del, iteration order, copy on write, lowerBound/upperBound
+                    and comparisons, and that iteration matches MojMap for the same input.
+* @param         :  None
+* @retval        :  MojErr
+****************************************************************************************************
+**/
+MojErr MojFlatMapTest::run()
+{
+	MojFlatMap<int, MojString> intMap1;
+	MojFlatMap<int, MojString> intMap2(intMap1);
+	MojString str;
+	MojFlatMap<int, MojString>::ConstIterator ci1;
+	MojFlatMap<int, MojString>::Iterator i1;
+	bool found = true;
+
+	// empty test
+	MojTestAssert(intMap1.empty());
+	MojTestAssert(intMap1.size() == 0);
+	MojTestAssert(intMap1.begin() == intMap1.end());
+	MojTestAssert(intMap1 == intMap2);
+	MojTestAssert(!intMap1.contains(5));
+	MojTestAssert(intMap1.find(49) == intMap1.end());
+	MojErr err = intMap1.find(8, i1);
+	MojTestErrCheck(err);
+	MojTestAssert(i1 == intMap1.end());
+	err = intMap1.begin(i1);
+	MojTestErrCheck(err);
+	MojTestAssert(i1 == intMap1.end());
+	MojTestAssert(intMap1.lowerBound(49) == intMap1.end());
+	MojTestAssert(intMap1.upperBound(49) == intMap1.end());
+	err = intMap1.del(52, found);
+	MojTestErrCheck(err);
+	MojTestAssert(!found);
+
+	// basic test
+	err = str.format(_T("%d"), 30);
+	MojTestErrCheck(err);
+	err = intMap1.put(30, str);
+	MojTestErrCheck(err);
+	MojTestAssert(intMap1.size() == 1);
+	ci1 = intMap1.begin();
+	MojTestAssert(ci1.key() == 30 && ci1.value() == str);
+	MojTestAssert(intMap1.find(30) == ci1);
+	++ci1;
+	MojTestAssert(ci1 == intMap1.end());
+	err = intMap1.find(30, i1);
+	MojTestErrCheck(err);
+	err = i1.value().append(_T('0'));
+	MojTestErrCheck(err);
+	MojTestAssert(*intMap1.find(30) == _T("300"));
+	err = intMap1.del(30, found);
+	MojTestErrCheck(err);
+	MojTestAssert(found && intMap1.empty());
+
+	// puts in both directions, replacement and deletion
+	for (int i = 0; i < 1000; ++i) {
+		err = str.format(_T("%d"), i);
+		MojTestErrCheck(err);
+		err = intMap1.put(i, str);
+		MojTestErrCheck(err);
+		err = intMap1.put(i, str);
+		MojTestErrCheck(err);
+		MojTestAssert(intMap1.size() == (MojSize) i + 1);
+	}
+	for (int i = 999; i >= 0; --i) {
+		err = str.format(_T("%d"), i);
+		MojTestErrCheck(err);
+		err = intMap2.put(i, str);
+		MojTestErrCheck(err);
+	}
+	MojTestAssert(count(intMap1) == 1000);
+	MojTestAssert(intMap1 == intMap2);
+	for (int i = 0; i < 1000; i += 2) {
+		err = intMap1.del(i, found);
+		MojTestErrCheck(err);
+		MojTestAssert(found);
+	}
+	MojTestAssert(intMap1.size() == 500);
+	int c = 1;
+	for (MojFlatMap<int, MojString>::ConstIterator i = intMap1.begin(); i != intMap1.end(); ++i) {
+		MojTestAssert(i.key() == c);
+		c += 2;
+	}
+
+	// copy on write
+	intMap1 = intMap2;
+	err = str.assign(_T("changed"));
+	MojTestErrCheck(err);
+	err = intMap1.put(500, str);
+	MojTestErrCheck(err);
+	MojTestAssert(*intMap1.find(500) == _T("changed"));
+	MojTestAssert(*intMap2.find(500) == _T("500"));
+	intMap1 = intMap2;
+	err = intMap1.find(10, i1);
+	MojTestErrCheck(err);
+	err = i1.value().append(_T('0'));
+	MojTestErrCheck(err);
+	MojTestAssert(*intMap1.find(10) == _T("100"));
+	MojTestAssert(*intMap2.find(10) == _T("10"));
+
+	// lower/upper bound
+	intMap1.clear();
+	for (int i = 1; i < 40; i += 2) {
+		err = str.format(_T("%d"), i);
+		MojTestErrCheck(err);
+		err = intMap1.put(i, str);
+		MojTestErrCheck(err);
+	}
+	for (int i = 0; i < 38; ++i) {
+		if (i % 2 == 1) {
+			MojTestAssert(intMap1.lowerBound(i).key() == i);
+			MojTestAssert(intMap1.upperBound(i).key() == i + 2);
+		} else {
+			MojTestAssert(intMap1.lowerBound(i).key() == i + 1);
+			MojTestAssert(intMap1.upperBound(i).key() == i + 1);
+		}
+	}
+	MojTestAssert(intMap1.upperBound(39) == intMap1.end());
+	MojTestAssert(intMap1.lowerBound(40) == intMap1.end());
+
+	// merge and comparisons
+	intMap2.clear();
+	for (int i = 0; i < 40; i += 2) {
+		err = str.format(_T("%d"), i);
+		MojTestErrCheck(err);
+		err = intMap2.put(i, str);
+		MojTestErrCheck(err);
+	}
+	err = intMap2.put(intMap1);
+	MojTestErrCheck(err);
+	MojTestAssert(intMap2.size() == 40);
+	MojTestAssert(count(intMap2) == 40);
+	MojTestAssert(intMap1.compare(intMap2) > 0);
+	MojTestAssert(intMap2 < intMap1);
+	intMap1 = intMap2;
+	err = intMap2.put(41, str);
+	MojTestErrCheck(err);
+	MojTestAssert(intMap1 < intMap2);
+	MojTestAssert(intMap2 >= intMap1);
+
+	err = orderTest();
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojFlatMapTest::orderTest()
+{
+	// string keys iterate exactly like MojMap, so either can back MojObject
+	MojFlatMap<MojString, int, const MojChar*> flatMap;
+	MojMap<MojString, int, const MojChar*> map;
+	MojString str;
+	for (int i = 0; i < 200; ++i) {
+		MojErr err = str.format(_T("prop%d"), (i * 7919) % 211);
+		MojTestErrCheck(err);
+		err = flatMap.put(str, i);
+		MojTestErrCheck(err);
+		err = map.put(str, i);
+		MojTestErrCheck(err);
+	}
+	MojTestAssert(flatMap.size() == map.size());
+	MojMap<MojString, int, const MojChar*>::ConstIterator mi = map.begin();
+	for (MojFlatMap<MojString, int, const MojChar*>::ConstIterator i = flatMap.begin(); i != flatMap.end(); ++i, ++mi) {
+		MojTestAssert(mi != map.end());
+		MojTestAssert(i.key() == mi.key() && i.value() == mi.value());
+		int val = 0;
+		MojTestAssert(flatMap.get(i.key(), val) && val == i.value());
+	}
+	MojTestAssert(mi == map.end());
+	MojTestAssert(!flatMap.contains(_T("prop211")));
+
+	return MojErrNone;
+}
+
+MojSize MojFlatMapTest::count(MojFlatMap<int, MojString>& map)
+{
+	MojSize size = 0;
+	for (MojFlatMap<int, MojString>::ConstIterator i = map.begin(); i != map.end(); ++i) {
+		++size;
+	}
+	return size;
+}
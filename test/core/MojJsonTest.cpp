@@ -88,6 +88,38 @@ MojErr MojJsonTest::run()
 	MojTestErrCheck(err);
 	err = test(negativeChars, negativeChars);
 	MojTestErrCheck(err);
+	err = intTest();
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojJsonTest::intTest()
+{
+	MojJsonWriter writer;
+	MojErr err = writer.beginArray();
+	MojTestErrCheck(err);
+	const MojInt64 vals[] = {0, 7, -7, 10, -100, 1234567890123LL, MojInt64Max, MojInt64Min};
+	for (MojSize i = 0; i < sizeof(vals) / sizeof(vals[0]); ++i) {
+		err = writer.intValue(vals[i]);
+		MojTestErrCheck(err);
+	}
+	err = writer.endArray();
+	MojTestErrCheck(err);
+	MojTestAssert(writer.json() ==
+		_T("[0,7,-7,10,-100,1234567890123,9223372036854775807,-9223372036854775808]"));
+
+	// a big reply is released on reset, a small one is kept for reuse
+	MojString big;
+	for (int i = 0; i < 128 * 1024; ++i) {
+		err = big.append(_T('a'));
+		MojTestErrCheck(err);
+	}
+	err = writer.stringValue(big, big.length());
+	MojTestErrCheck(err);
+	err = writer.reset();
+	MojTestErrCheck(err);
+	MojTestAssert(writer.json().empty() && writer.json().capacity() == 0);
 
 	return MojErrNone;
 }
@@ -36,6 +36,7 @@ public:
 
 private:
 	MojErr test(const MojChar* str, const MojChar* expected);
+	MojErr intTest();
 };
 
 #endif /* MOJJSONTEST_H_ */
@@ -56,6 +56,25 @@ public:
 	int m_i;
 };
 
+class MojTestOrderMessage : public MojMessage
+{
+public:
+	MojTestOrderMessage(const MojChar* queue, MojString& order) : m_queue(queue), m_order(order) {}
+
+	virtual const MojChar* queue() const
+	{
+		return m_queue;
+	}
+
+	virtual MojErr dispatch()
+	{
+		return m_order.append(m_queue);
+	}
+
+	const MojChar* m_queue;
+	MojString& m_order;
+};
+
 MojMessageDispatcherTest::MojMessageDispatcherTest()
 : MojTestCase(_T("MojMessageQueue"))
 {
@@ -100,5 +119,91 @@ MojErr MojMessageDispatcherTest::run()
 
 	MojTestAssert(s_messageCount == 0);
 
+	err = weightTest();
+	MojTestErrCheck(err);
+	err = statsLimitTest();
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojMessageDispatcherTest::weightTest()
+{
+	// with one thread, queue "a" of weight 3 gets three messages for every one of "b"
+	MojString order;
+	MojMessageDispatcher dispatcher;
+	dispatcher.enableStats(true);
+	MojErr err = dispatcher.setWeight(_T("a"), 3);
+	MojTestErrCheck(err);
+
+	for (int i = 0; i < 6; ++i) {
+		MojRefCountedPtr<MojTestOrderMessage> msgA(new MojTestOrderMessage(_T("a"), order));
+		MojAllocCheck(msgA.get());
+		err = dispatcher.schedule(msgA.get());
+		MojTestErrCheck(err);
+		MojRefCountedPtr<MojTestOrderMessage> msgB(new MojTestOrderMessage(_T("b"), order));
+		MojAllocCheck(msgB.get());
+		err = dispatcher.schedule(msgB.get());
+		MojTestErrCheck(err);
+	}
+
+	err = dispatcher.start(1);
+	MojTestErrCheck(err);
+	err = dispatcher.stop();
+	MojTestErrCheck(err);
+	err = dispatcher.wait();
+	MojTestErrCheck(err);
+
+	MojTestAssert(order == _T("aaabaaabbbbb"));
+
+	MojObject stats;
+	err = dispatcher.stats(stats);
+	MojTestErrCheck(err);
+	MojObject queueStats;
+	MojTestAssert(stats.get(_T("a"), queueStats));
+	MojInt64 count = 0;
+	MojTestAssert(queueStats.get(_T("count"), count) && count == 6);
+	MojTestAssert(stats.get(_T("b"), queueStats));
+	MojTestAssert(queueStats.get(_T("count"), count) && count == 6);
+
+	return MojErrNone;
+}
+
+MojErr MojMessageDispatcherTest::statsLimitTest()
+{
+	// every sender gets its own queue, so stats must not keep one entry per sender forever
+	const MojSize numQueues = MojMessageDispatcher::MaxStatsQueues + 10;
+	MojVector<MojString> names;
+	MojString order;
+	MojMessageDispatcher dispatcher;
+	dispatcher.enableStats(true);
+	for (MojSize i = 0; i < numQueues; ++i) {
+		MojString name;
+		MojErr err = name.format(_T("q%zu"), i);
+		MojTestErrCheck(err);
+		err = names.push(name);
+		MojTestErrCheck(err);
+	}
+	for (MojSize i = 0; i < numQueues; ++i) {
+		MojRefCountedPtr<MojTestOrderMessage> msg(new MojTestOrderMessage(names.at(i), order));
+		MojAllocCheck(msg.get());
+		MojErr err = dispatcher.schedule(msg.get());
+		MojTestErrCheck(err);
+	}
+
+	MojErr err = dispatcher.start(1);
+	MojTestErrCheck(err);
+	err = dispatcher.stop();
+	MojTestErrCheck(err);
+	err = dispatcher.wait();
+	MojTestErrCheck(err);
+
+	MojObject stats;
+	err = dispatcher.stats(stats);
+	MojTestErrCheck(err);
+	MojTestAssert(stats.size() == MojMessageDispatcher::MaxStatsQueues);
+	MojObject queueStats;
+	MojTestAssert(stats.get(names.back(), queueStats));
+
 	return MojErrNone;
 }
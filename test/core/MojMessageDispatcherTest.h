@@ -33,6 +33,10 @@ public:
 	MojMessageDispatcherTest();
 
 	virtual MojErr run();
+
+private:
+	MojErr weightTest();
+	MojErr statsLimitTest();
 };
 
 #endif /* MOJMESSAGEDISPATCHERTEST_H_ */
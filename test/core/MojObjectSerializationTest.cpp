@@ -27,6 +27,40 @@
 #include "core/MojObject.h"
 #include "core/MojObjectBuilder.h"
 #include "core/MojObjectSerialization.h"
+#include "core/MojTokenSet.h"
+
+// hands out tokens in order, like MojDbKindState but without a db behind it
+class MojTestTokenSet : public MojSharedTokenSet
+{
+public:
+	MojTestTokenSet() : m_nextToken(MojObjectWriter::TokenStartMarker) {}
+
+	virtual MojErr addToken(const MojChar* str, MojUInt32& tokenOut, TokenVec& vecOut, MojObject& tokenObjOut)
+	{
+		MojString name;
+		MojErr err = name.assign(str);
+		MojErrCheck(err);
+		err = m_vec.push(name);
+		MojErrCheck(err);
+		err = m_obj.put(str, (MojInt64) m_nextToken);
+		MojErrCheck(err);
+		tokenOut = m_nextToken++;
+		vecOut = m_vec;
+		tokenObjOut = m_obj;
+		return MojErrNone;
+	}
+	virtual MojErr tokenSet(TokenVec& vecOut, MojObject& tokenObjOut) const
+	{
+		vecOut = m_vec;
+		tokenObjOut = m_obj;
+		return MojErrNone;
+	}
+
+private:
+	TokenVec m_vec;
+	MojObject m_obj;
+	MojUInt32 m_nextToken;
+};
 
 MojObjectSerializationTest::MojObjectSerializationTest()
 : MojTestCase(_T("MojObjectSerialization"))
@@ -72,6 +106,13 @@ MojErr MojObjectSerializationTest::run()
 	MojTestErrCheck(err);
 	MojTestAssert(obj == builder.object());
 
+	err = selectTest(obj, data, size);
+	MojTestErrCheck(err);
+	err = sharedNameTest(obj, data, size);
+	MojTestErrCheck(err);
+	err = tokenTest();
+	MojTestErrCheck(err);
+
 	// comparisons
 	MojVector<MojObject> vec;
 	err = vec.push(MojObject());
@@ -122,6 +163,159 @@ MojErr MojObjectSerializationTest::run()
 	return MojErrNone;
 }
 
+MojErr MojObjectSerializationTest::selectTest(const MojObject& obj, const MojByte* data, MojSize size)
+{
+	// skipping the whole object consumes exactly its bytes
+	MojDataReader dataReader(data, size);
+	MojErr err = MojObjectReader::skip(dataReader);
+	MojTestErrCheck(err);
+	MojTestAssert(dataReader.available() == 0);
+
+	// selected props are read, everything else is skipped
+	const MojChar* const names[] = {_T("i3"), _T("o1"), _T("b2"), _T("missing")};
+	MojObjectReader::PropSet props;
+	for (MojSize i = 0; i < sizeof(names) / sizeof(names[0]); ++i) {
+		MojString name;
+		err = name.assign(names[i]);
+		MojTestErrCheck(err);
+		err = props.put(name);
+		MojTestErrCheck(err);
+	}
+
+	MojObjectReader reader(data, size);
+	err = reader.select(&props);
+	MojTestErrCheck(err);
+	MojObjectBuilder builder;
+	err = reader.read(builder);
+	MojTestErrCheck(err);
+
+	MojObject expected;
+	MojObject val;
+	MojTestAssert(obj.get(_T("i3"), val));
+	err = expected.put(_T("i3"), val);
+	MojTestErrCheck(err);
+	MojTestAssert(obj.get(_T("o1"), val));
+	err = expected.put(_T("o1"), val);
+	MojTestErrCheck(err);
+	MojTestAssert(obj.get(_T("b2"), val));
+	err = expected.put(_T("b2"), val);
+	MojTestErrCheck(err);
+	MojTestAssert(builder.object() == expected);
+
+	// an empty selection still yields the (empty) object
+	props.clear();
+	reader.data(data, size);
+	err = reader.select(&props);
+	MojTestErrCheck(err);
+	MojObjectBuilder emptyBuilder;
+	err = reader.read(emptyBuilder);
+	MojTestErrCheck(err);
+	MojTestAssert(emptyBuilder.object().type() == MojObject::TypeObject);
+	MojTestAssert(emptyBuilder.object().empty());
+
+	return MojErrNone;
+}
+
+MojErr MojObjectSerializationTest::sharedNameTest(const MojObject& obj, const MojByte* data, MojSize size)
+{
+	// names read as chars are copied
+	MojObjectBuilder reader;
+	MojErr err = MojObjectReader::read(reader, data, size);
+	MojTestErrCheck(err);
+	MojTestAssert(reader.sharedNameBytes() == 0);
+	MojTestAssert(reader.copiedNameBytes() > 0);
+
+	// names visited from an object are shared with it
+	MojObjectBuilder builder;
+	err = obj.visit(builder);
+	MojTestErrCheck(err);
+	MojTestAssert(builder.object() == obj);
+	MojTestAssert(builder.copiedNameBytes() == 0);
+	MojTestAssert(builder.sharedNameBytes() == reader.copiedNameBytes());
+	MojObject::ConstIterator j = builder.object().begin();
+	for (MojObject::ConstIterator i = obj.begin(); i != obj.end(); ++i, ++j) {
+		MojTestAssert(j != builder.object().end());
+		MojTestAssert(i.key().data() == j.key().data());
+	}
+	return MojErrNone;
+}
+
+MojErr MojObjectSerializationTest::tokenTest()
+{
+	// enough props that the later ones need extended tokens
+	MojObject obj;
+	MojString name;
+	for (int i = 0; i < 300; ++i) {
+		MojErr err = name.format(_T("prop%d"), i);
+		MojTestErrCheck(err);
+		err = obj.put(name, (MojInt64) i);
+		MojTestErrCheck(err);
+	}
+	// string values that match a token are written as the token
+	MojErr err = obj.putString(_T("val"), _T("prop299"));
+	MojTestErrCheck(err);
+
+	MojTokenSet tokenSet;
+	err = tokenSet.init(new MojTestTokenSet);
+	MojTestErrCheck(err);
+	MojBuffer buf;
+	MojObjectWriter writer(buf, &tokenSet);
+	err = obj.visit(writer);
+	MojTestErrCheck(err);
+	const MojByte* data = NULL;
+	MojSize size = 0;
+	err = buf.data(data, size);
+	MojTestErrCheck(err);
+
+	MojObjectReader reader(data, size);
+	reader.tokenSet(&tokenSet);
+	MojObjectBuilder builder;
+	err = reader.read(builder);
+	MojTestErrCheck(err);
+	MojTestAssert(builder.object() == obj);
+
+	MojDataReader dataReader(data, size);
+	err = MojObjectReader::skip(dataReader);
+	MojTestErrCheck(err);
+	MojTestAssert(dataReader.available() == 0);
+
+	// select one prop on each side of the extended token marker
+	MojObjectReader::PropSet props;
+	err = name.assign(_T("prop1"));
+	MojTestErrCheck(err);
+	err = props.put(name);
+	MojTestErrCheck(err);
+	err = name.assign(_T("prop299"));
+	MojTestErrCheck(err);
+	err = props.put(name);
+	MojTestErrCheck(err);
+	reader.data(data, size);
+	reader.tokenSet(&tokenSet);
+	err = reader.select(&props);
+	MojTestErrCheck(err);
+	MojObjectBuilder selBuilder;
+	err = reader.read(selBuilder);
+	MojTestErrCheck(err);
+	MojObject expected;
+	err = expected.put(_T("prop1"), (MojInt64) 1);
+	MojTestErrCheck(err);
+	err = expected.put(_T("prop299"), (MojInt64) 299);
+	MojTestErrCheck(err);
+	MojTestAssert(selBuilder.object() == expected);
+
+	// an extended marker must not encode a single-byte token
+	const MojByte bad[] = {MojObjectWriter::ExtendedTokenMarker, 0x20};
+	MojDataReader badReader(bad, sizeof(bad));
+	MojUInt32 token = 0;
+	MojByte marker = 0;
+	err = badReader.readUInt8(marker);
+	MojTestErrCheck(err);
+	err = MojObjectReader::readToken(badReader, marker, token);
+	MojTestErrExpected(err, MojErrDbInvalidToken);
+
+	return MojErrNone;
+}
+
 MojErr MojObjectSerializationTest::compTest(const MojObject& obj1, const MojObject& obj2)
 {
 	MojObjectWriter writer1;
@@ -36,6 +36,9 @@ public:
 	virtual MojErr run();
 
 private:
+	MojErr selectTest(const MojObject& obj, const MojByte* data, MojSize size);
+	MojErr sharedNameTest(const MojObject& obj, const MojByte* data, MojSize size);
+	MojErr tokenTest();
 	MojErr compTest(const MojObject& obj1, const MojObject& obj2);
 };
 
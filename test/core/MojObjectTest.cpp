@@ -142,6 +142,10 @@ MojErr MojObjectTest::run()
 	err = typeTest();
 	MojTestErrCheck(err);
 
+	// copies
+	err = copyTest();
+	MojTestErrCheck(err);
+
 	return MojErrNone;
 }
 
@@ -535,3 +539,48 @@ MojErr MojObjectTest::typeTest()
 
 	return MojErrNone;
 }
+
+/**
+****************************************************************************************************
+* @copyTest         Copies share their container payload until one side is modified, so a
+                    modified copy must leave the original (and every other copy) untouched.
+                    Allocation counts for these paths are in gtest_leveldb (TestObjectAlloc).
+* @param         :  None
+* @retval        :  MojErr
+****************************************************************************************************
+**/
+MojErr MojObjectTest::copyTest()
+{
+	const int numCopies = 1000;
+
+	MojObject obj;
+	MojErr err = obj.fromJson(_T("{\"str\":\"hello\",\"int\":5,\"array\":[1,2,3],\"obj\":{\"bool\":true}}"));
+	MojTestErrCheck(err);
+	MojObject::ObjectVec copies;
+	err = copies.reserve(numCopies);
+	MojTestErrCheck(err);
+	for (int i = 0; i < numCopies; ++i) {
+		MojObject copy(obj);
+		MojObject array;
+		MojTestAssert(copy.get(_T("array"), array));
+		err = copies.push(copy);
+		MojTestErrCheck(err);
+	}
+
+	// copy on write
+	MojObject copy = obj;
+	err = copy.put(_T("int"), 6);
+	MojTestErrCheck(err);
+	MojInt64 intVal = 0;
+	MojTestAssert(obj.get(_T("int"), intVal) && intVal == 5);
+	MojTestAssert(copy.get(_T("int"), intVal) && intVal == 6);
+	MojTestAssert(copies.back() == obj);
+
+	// self-assignment and assignment from a child
+	copy = copy;
+	MojTestAssert(copy.get(_T("int"), intVal) && intVal == 6);
+	MojTestAssert(copy.get(_T("obj"), copy));
+	MojTestAssert(copy.type() == MojObject::TypeObject && copy.size() == 1);
+
+	return MojErrNone;
+}
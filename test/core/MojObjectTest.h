@@ -42,6 +42,7 @@ protected:
 	MojErr putTest(MojObject& obj);
 	MojErr getTest(const MojObject& obj);
 	MojErr typeTest();
+	MojErr copyTest();
 };
 
 #endif /* MOJOBJECTTEST_H_ */
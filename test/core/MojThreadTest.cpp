@@ -120,6 +120,7 @@ MojThreadTest::MojThreadTest()
                           It includes two tests.
                            1.Basic test
                            2.err Test
+                           3.timed wait Test
 
 * @param                : None
 * @retval               : MojErr
@@ -131,6 +132,8 @@ MojErr MojThreadTest::run()
 	MojTestErrCheck(err);
 	err = errTest();
 	MojTestErrCheck(err);
+	err = timedWaitTest();
+	MojTestErrCheck(err);
 
 	return MojErrNone;
 }
@@ -224,3 +227,34 @@ MojErr MojThreadTest::errTest()
 
 	return MojErrNone;
 }
+
+/**
+***************************************************************************************************
+* @timedWaitTest          Waits on a condition that is never signalled and checks that the wait
+                          returns MojErrTimedOut after roughly the requested time.
+                          eg:err = cond.wait(mutex, MojMillisecs(100));
+
+* @param                : None
+* @retval               : MojErr
+***************************************************************************************************
+**/
+MojErr MojThreadTest::timedWaitTest()
+{
+	MojThreadMutex mutex;
+	MojThreadCond cond;
+	MojTime start;
+	MojErr err = MojGetCurrentTime(start);
+	MojTestErrCheck(err);
+
+	MojThreadGuard guard(mutex);
+	err = cond.wait(mutex, MojMillisecs(100));
+	MojTestErrExpected(err, MojErrTimedOut);
+	guard.unlock();
+
+	MojTime end;
+	err = MojGetCurrentTime(end);
+	MojTestErrCheck(err);
+	MojTestAssert((end - start).millisecs() >= 90);
+
+	return MojErrNone;
+}
@@ -38,6 +38,7 @@ public:
 private:
 	MojErr basicTest();
 	MojErr errTest();
+	MojErr timedWaitTest();
 };
 
 #endif /* MOJTHREADTEST_H_ */
@@ -0,0 +1,181 @@
+/****************************************************************
+ * @@@LICENSE
+ *
+ * Copyright (c) 2014 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * LICENSE@@@
+ ****************************************************************/
+
+/**
+ *  @file KeyTest.cpp
+ *  Verify MojDbKey behaves the same whether it is stored inline or on the
+ *  heap, and that MojDbKeyBuilder produces every combination of values.
+ */
+
+#include "Runner.h"
+
+#include <core/MojUtil.h>
+#include <db/MojDbKey.h>
+
+namespace {
+    void fillKey(MojDbKey& key, MojSize size, MojByte last)
+    {
+        MojByte bytes[MojDbKey::InlineSize * 2];
+        ASSERT_LE( size, sizeof(bytes) );
+        for (MojSize i = 0; i < size; ++i)
+            bytes[i] = 'a';
+        if (size > 0)
+            bytes[size - 1] = last;
+        MojAssertNoErr( key.assign(bytes, size) );
+    }
+}
+
+TEST(KeyTest, compareAcrossStorage)
+{
+    const MojSize sizes[] = { 0, 1, MojDbKey::InlineSize - 1, MojDbKey::InlineSize,
+                              MojDbKey::InlineSize + 1, MojDbKey::InlineSize * 2 };
+    const MojSize numSizes = sizeof(sizes) / sizeof(sizes[0]);
+
+    for (MojSize i = 0; i < numSizes; ++i) {
+        for (MojSize j = 0; j < numSizes; ++j) {
+            MojDbKey key1;
+            MojDbKey key2;
+            fillKey(key1, sizes[i], 'b');
+            fillKey(key2, sizes[j], 'b');
+
+            // compare against the byte vectors, which is how keys used to compare
+            MojDbKey::ByteVec vec1;
+            MojDbKey::ByteVec vec2;
+            MojAssertNoErr( vec1.assign(key1.data(), key1.data() + key1.size()) );
+            MojAssertNoErr( vec2.assign(key2.data(), key2.data() + key2.size()) );
+            int expected = vec1.compare(vec2);
+            int comp = key1.compare(key2);
+            EXPECT_EQ( expected < 0, comp < 0 );
+            EXPECT_EQ( expected == 0, comp == 0 );
+            EXPECT_EQ( expected == 0, key1 == key2 );
+        }
+    }
+}
+
+TEST(KeyTest, lexicalCompare)
+{
+    const MojByte lo[] = { 0x00, 0x01, 0x7F };
+    const MojByte hi[] = { 0x00, 0x01, 0x80 };
+
+    EXPECT_GT( 0, MojLexicalCompare(lo, sizeof(lo), hi, sizeof(hi)) );
+    EXPECT_LT( 0, MojLexicalCompare(hi, sizeof(hi), lo, sizeof(lo)) );
+    EXPECT_GT( 0, MojLexicalCompare(lo, 2, lo, 3) );
+    EXPECT_LT( 0, MojLexicalCompare(lo, 3, lo, 2) );
+    EXPECT_EQ( 0, MojLexicalCompare(lo, 3, lo, 3) );
+    EXPECT_EQ( 0, MojLexicalCompare(NULL, 0, NULL, 0) );
+
+    MojByte long1[40];
+    MojByte long2[40];
+    for (MojSize i = 0; i < sizeof(long1); ++i) {
+        long1[i] = long2[i] = 0x11;
+    }
+    for (MojSize i = 0; i < sizeof(long1); ++i) {
+        long2[i] = 0x12;
+        EXPECT_EQ( i, MojPrefixSize(long1, sizeof(long1), long2, sizeof(long2)) );
+        long2[i] = 0x11;
+    }
+    EXPECT_EQ( sizeof(long1), MojPrefixSize(long1, sizeof(long1), long2, sizeof(long2)) );
+    EXPECT_EQ( 17u, MojPrefixSize(long1, 17, long2, sizeof(long2)) );
+}
+
+TEST(KeyTest, modify)
+{
+    // grows past the inline buffer one byte at a time
+    MojDbKey key;
+    MojDbKey::ByteVec expected;
+    for (MojByte i = 0; i < MojDbKey::InlineSize * 2; ++i) {
+        MojAssertNoErr( key.append(&i, 1) );
+        MojAssertNoErr( expected.push(i) );
+        ASSERT_EQ( expected.size(), key.size() );
+        ASSERT_EQ( 0, MojMemCmp(expected.begin(), key.data(), key.size()) );
+    }
+
+    MojDbKey copy(key);
+    EXPECT_TRUE( copy == key );
+    MojAssertNoErr( key.truncate(2) );
+    EXPECT_EQ( 2u, key.size() );
+    EXPECT_EQ( MojDbKey::InlineSize * 2, copy.size() );
+
+    MojDbKey prefix;
+    const MojByte pre[] = { 0xAA, 0xBB };
+    MojAssertNoErr( prefix.assign(pre, sizeof(pre)) );
+    MojAssertNoErr( key.prepend(prefix) );
+    const MojByte prepended[] = { 0xAA, 0xBB, 0x00, 0x01 };
+    ASSERT_EQ( sizeof(prepended), key.size() );
+    EXPECT_EQ( 0, MojMemCmp(prepended, key.data(), key.size()) );
+    EXPECT_TRUE( prefix.prefixOf(key) );
+
+    // increment drops trailing 0xFF bytes
+    const MojByte ff[] = { 0x01, 0xFF, 0xFF };
+    MojAssertNoErr( key.assign(ff, sizeof(ff)) );
+    MojAssertNoErr( key.increment() );
+    ASSERT_EQ( 1u, key.size() );
+    EXPECT_EQ( 0x02, key.data()[0] );
+
+    // the byte vector stays in sync with the key once handed out
+    MojDbKey::ByteVec* vec = NULL;
+    MojAssertNoErr( key.byteVec(vec) );
+    MojAssertNoErr( vec->push(0x03) );
+    ASSERT_EQ( 2u, key.size() );
+    EXPECT_EQ( 0x03, key.data()[1] );
+
+    // copies of a const key are unaffected by edits through the vector
+    const MojDbKey shared(key);
+    MojAssertNoErr( vec->push(0x04) );
+    ASSERT_EQ( 2u, shared.size() );
+    ASSERT_EQ( 3u, key.size() );
+}
+
+TEST(KeyTest, builder)
+{
+    MojDbKeyBuilder::KeySet props[3];
+    const MojByte vals[] = { 'a', 'b', 'c', 'd', 'e' };
+    const MojSize numVals[] = { 2, 1, 3 };
+    MojSize numKeys = 1;
+    for (MojSize i = 0; i < 3; ++i) {
+        for (MojSize j = 0; j < numVals[i]; ++j) {
+            MojDbKey key;
+            MojAssertNoErr( key.assign(vals + j, 1) );
+            MojAssertNoErr( props[i].put(key) );
+        }
+        numKeys *= numVals[i];
+    }
+
+    MojDbKeyBuilder builder;
+    for (MojSize i = 0; i < 3; ++i) {
+        MojAssertNoErr( builder.push(props[i]) );
+    }
+    MojDbKeyBuilder::KeySet keys;
+    MojAssertNoErr( builder.keys(keys) );
+    ASSERT_EQ( numKeys, keys.size() );
+    for (MojDbKeyBuilder::KeySet::ConstIterator i = keys.begin(); i != keys.end(); ++i) {
+        ASSERT_EQ( 3u, i->size() );
+        EXPECT_GT( (MojByte) ('a' + numVals[0]), i->data()[0] );
+        EXPECT_EQ( 'a', i->data()[1] );
+        EXPECT_GT( (MojByte) ('a' + numVals[2]), i->data()[2] );
+    }
+
+    // a property without values yields no keys at all
+    builder.clear();
+    MojAssertNoErr( builder.push(props[0]) );
+    MojAssertNoErr( builder.push(MojDbKeyBuilder::KeySet()) );
+    MojAssertNoErr( builder.keys(keys) );
+    EXPECT_TRUE( keys.empty() );
+}
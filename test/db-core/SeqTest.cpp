@@ -0,0 +1,150 @@
+/****************************************************************
+ * @@@LICENSE
+ *
+ * Copyright (c) 2014 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * LICENSE@@@
+ ****************************************************************/
+
+/**
+ *  @file SeqTest.cpp
+ *  Verify that revisions handed out by the id sequence are never reused,
+ *  neither after a clean close nor after a crash.
+ */
+
+#include <string>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "db/MojDb.h"
+
+#include "Runner.h"
+
+namespace {
+    const MojChar* const MojKindStr =
+        _T("{\"id\":\"Test:1\", \"owner\":\"mojodb.admin\"}");
+    const MojUInt32 NumSinglePuts = 1000;
+    const MojUInt32 NumBatches = 20;
+    const MojUInt32 BatchSize = 50;
+}
+
+struct SeqTest : public ::testing::Test
+{
+    std::string path;
+
+    void SetUp()
+    {
+        const ::testing::TestInfo* const test_info =
+          ::testing::UnitTest::GetInstance()->current_test_info();
+
+        path = std::string(tempFolder) + '/'
+             + test_info->test_case_name() + '-' + test_info->name();
+    }
+
+    void putObj(MojDb& db, MojInt64& maxRev)
+    {
+        MojObject obj;
+        MojAssertNoErr( obj.putString(MojDb::KindKey, _T("Test:1")) );
+        MojAssertNoErr( db.put(obj) );
+        MojInt64 rev = 0;
+        ASSERT_TRUE( obj.get(MojDb::RevKey, rev) );
+        EXPECT_LT( maxRev, rev );
+        maxRev = rev;
+    }
+
+    void putBatch(MojDb& db, MojInt64& maxRev)
+    {
+        MojObject objs[BatchSize];
+        for (MojUInt32 i = 0; i < BatchSize; ++i) {
+            MojAssertNoErr( objs[i].putString(MojDb::KindKey, _T("Test:1")) );
+        }
+        MojAssertNoErr( db.put(objs, objs + BatchSize) );
+        for (MojUInt32 i = 0; i < BatchSize; ++i) {
+            MojInt64 rev = 0;
+            ASSERT_TRUE( objs[i].get(MojDb::RevKey, rev) );
+            EXPECT_LT( maxRev, rev );
+            maxRev = rev;
+        }
+    }
+
+    // puts enough objects to go through several reservations
+    void fill(MojDb& db, MojInt64& maxRev)
+    {
+        for (MojUInt32 i = 0; i < NumSinglePuts; ++i) {
+            putObj(db, maxRev);
+        }
+        for (MojUInt32 i = 0; i < NumBatches; ++i) {
+            putBatch(db, maxRev);
+        }
+    }
+};
+
+TEST_F(SeqTest, reopen)
+{
+    MojInt64 maxRev = 0;
+    {
+        MojDb db;
+        MojAssertNoErr( db.open(path.c_str()) );
+        MojObject kind;
+        MojAssertNoErr( kind.fromJson(MojKindStr) );
+        MojAssertNoErr( db.putKind(kind) );
+        fill(db, maxRev);
+        MojAssertNoErr( db.close() );
+    }
+
+    MojDb db;
+    MojAssertNoErr( db.open(path.c_str()) );
+    putObj(db, maxRev);
+    MojExpectNoErr( db.close() );
+}
+
+TEST_F(SeqTest, crash)
+{
+    int fds[2];
+    ASSERT_EQ( 0, pipe(fds) );
+
+    pid_t pid = fork();
+    ASSERT_LE( 0, pid );
+    if (pid == 0) {
+        // child: allocate revisions and die without closing anything
+        close(fds[0]);
+        MojInt64 maxRev = 0;
+        MojDb* db = new MojDb;
+        if (db->open(path.c_str()) == MojErrNone) {
+            MojObject kind;
+            if (kind.fromJson(MojKindStr) == MojErrNone && db->putKind(kind) == MojErrNone)
+                fill(*db, maxRev);
+        }
+        ssize_t written = write(fds[1], &maxRev, sizeof(maxRev));
+        _exit(written == sizeof(maxRev) && !HasFailure() ? 0 : 1);
+    }
+
+    close(fds[1]);
+    MojInt64 maxRev = 0;
+    ASSERT_EQ( (ssize_t) sizeof(maxRev), read(fds[0], &maxRev, sizeof(maxRev)) );
+    close(fds[0]);
+    int status = 0;
+    ASSERT_EQ( pid, waitpid(pid, &status, 0) );
+    ASSERT_TRUE( WIFEXITED(status) );
+    ASSERT_EQ( 0, WEXITSTATUS(status) );
+    ASSERT_LT( 0, maxRev );
+
+    // every revision the crashed process handed out must stay used
+    MojDb db;
+    MojAssertNoErr( db.open(path.c_str()) );
+    putObj(db, maxRev);
+    MojExpectNoErr( db.close() );
+}
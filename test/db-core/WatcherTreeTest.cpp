@@ -0,0 +1,177 @@
+/****************************************************************
+ * @@@LICENSE
+ *
+ * Copyright (c) 2014 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * LICENSE@@@
+ ****************************************************************/
+
+/**
+ *  @file WatcherTreeTest.cpp
+ *  Verify MojDbWatcherTree finds the same watchers as testing every range,
+ *  while watchers come and go.
+ */
+
+#include "Runner.h"
+
+#include <core/MojUtil.h>
+#include <db/MojDbWatcherTree.h>
+
+namespace {
+    class Handler : public MojSignalHandler
+    {
+    public:
+        Handler() : m_slot(this, &Handler::handleChange) {}
+
+        MojErr handleChange() { return MojErrNone; }
+
+        MojDbWatcher::Signal::Slot<Handler> m_slot;
+    };
+
+    // a slot connects to one signal only, so every watcher gets its own handler
+    MojRefCountedPtr<MojDbWatcher> newWatcher()
+    {
+        MojRefCountedPtr<Handler> handler(new Handler);
+        return MojRefCountedPtr<MojDbWatcher>(new MojDbWatcher(handler->m_slot));
+    }
+
+    typedef MojVector<MojRefCountedPtr<MojDbWatcher> > WatcherVec;
+    typedef MojVector<MojDbWatcher::RangeVec> RangesVec;
+
+    MojDbKey byteKey(int val)
+    {
+        MojDbKey key;
+        // -1 stands for an open bound
+        if (val >= 0) {
+            MojByte byte = (MojByte) val;
+            MojExpectNoErr( key.assign(&byte, 1) );
+        }
+        return key;
+    }
+
+    bool matches(const MojDbWatcher::RangeVec& ranges, const MojDbKey& key)
+    {
+        for (MojDbWatcher::RangeVec::ConstIterator i = ranges.begin(); i != ranges.end(); ++i) {
+            if (i->contains(key))
+                return true;
+        }
+        return false;
+    }
+
+    void checkAllKeys(const MojDbWatcherTree& tree, const WatcherVec& watchers, const RangesVec& ranges)
+    {
+        for (int val = 0; val < 256; ++val) {
+            MojDbKey key = byteKey(val);
+            MojDbWatcherTree::WatcherVec found;
+            MojAssertNoErr( tree.find(key, found) );
+            for (MojSize i = 0; i < watchers.size(); ++i) {
+                MojSize count = 0;
+                for (MojDbWatcherTree::WatcherVec::ConstIterator j = found.begin(); j != found.end(); ++j) {
+                    if (*j == watchers.at(i).get())
+                        ++count;
+                }
+                ASSERT_EQ( matches(ranges.at(i), key), count > 0 ) << "key " << val;
+            }
+        }
+    }
+}
+
+TEST(WatcherTreeTest, empty)
+{
+    MojDbWatcherTree tree;
+    MojDbWatcherTree::WatcherVec found;
+    MojAssertNoErr( tree.find(byteKey(7), found) );
+    EXPECT_TRUE( found.empty() );
+    EXPECT_TRUE( tree.empty() );
+
+    MojRefCountedPtr<MojDbWatcher> watcher(newWatcher());
+    bool deleted = true;
+    MojAssertNoErr( tree.del(watcher.get(), deleted) );
+    EXPECT_FALSE( deleted );
+}
+
+TEST(WatcherTreeTest, openBounds)
+{
+    MojRefCountedPtr<MojDbWatcher> below(newWatcher());
+    MojRefCountedPtr<MojDbWatcher> above(newWatcher());
+    MojDbWatcher::RangeVec belowRanges;
+    MojAssertNoErr( belowRanges.push(MojDbKeyRange(byteKey(-1), byteKey(10), 0)) );
+    MojDbWatcher::RangeVec aboveRanges;
+    MojAssertNoErr( aboveRanges.push(MojDbKeyRange(byteKey(10), byteKey(-1), 0)) );
+
+    MojDbWatcherTree tree;
+    MojAssertNoErr( tree.put(below.get(), belowRanges) );
+    MojAssertNoErr( tree.put(above.get(), aboveRanges) );
+    EXPECT_EQ( 2u, tree.size() );
+
+    MojDbWatcherTree::WatcherVec found;
+    MojAssertNoErr( tree.find(byteKey(9), found) );
+    ASSERT_EQ( 1u, found.size() );
+    EXPECT_EQ( below.get(), found.front() );
+
+    // upper bounds are exclusive
+    found.clear();
+    MojAssertNoErr( tree.find(byteKey(10), found) );
+    ASSERT_EQ( 1u, found.size() );
+    EXPECT_EQ( above.get(), found.front() );
+
+    bool deleted = false;
+    MojAssertNoErr( tree.del(above.get(), deleted) );
+    EXPECT_TRUE( deleted );
+    found.clear();
+    MojAssertNoErr( tree.find(byteKey(200), found) );
+    EXPECT_TRUE( found.empty() );
+}
+
+TEST(WatcherTreeTest, matchesLinearScan)
+{
+    MojDbWatcherTree tree;
+    WatcherVec watchers;
+    RangesVec watcherRanges;
+    unsigned int seed = 42;
+
+    for (int round = 0; round < 400; ++round) {
+        bool add = watchers.empty() || MojRand(&seed) % 3 != 0;
+        if (add) {
+            MojRefCountedPtr<MojDbWatcher> watcher(newWatcher());
+            MojDbWatcher::RangeVec ranges;
+            int numRanges = 1 + MojRand(&seed) % 3;
+            for (int i = 0; i < numRanges; ++i) {
+                int lower = (int) (MojRand(&seed) % 257) - 1;
+                int upper = (int) (MojRand(&seed) % 257) - 1;
+                if (upper >= 0 && upper < lower) {
+                    int tmp = lower;
+                    lower = upper;
+                    upper = tmp;
+                }
+                MojAssertNoErr( ranges.push(MojDbKeyRange(byteKey(lower), byteKey(upper), 0)) );
+            }
+            MojAssertNoErr( tree.put(watcher.get(), ranges) );
+            MojAssertNoErr( watchers.push(watcher) );
+            MojAssertNoErr( watcherRanges.push(ranges) );
+        } else {
+            MojSize idx = MojRand(&seed) % watchers.size();
+            bool deleted = false;
+            MojAssertNoErr( tree.del(watchers.at(idx).get(), deleted) );
+            ASSERT_TRUE( deleted );
+            MojAssertNoErr( watchers.erase(idx) );
+            MojAssertNoErr( watcherRanges.erase(idx) );
+        }
+        ASSERT_EQ( watchers.size(), tree.size() );
+        if (round % 20 == 0)
+            checkAllKeys(tree, watchers, watcherRanges);
+    }
+    checkAllKeys(tree, watchers, watcherRanges);
+}
@@ -98,6 +98,9 @@ MojErr MojDbCrudTest::run()
 	// persistence
 	err = persistenceTest();
 	MojTestErrCheck(err);
+	// version upgrade
+	err = upgradeTest();
+	MojTestErrCheck(err);
 
 	return MojErrNone;
 }
@@ -983,6 +986,59 @@ MojErr MojDbCrudTest::persistenceTest()
 	return MojErrNone;
 }
 
+MojErr MojDbCrudTest::upgradeTest()
+{
+	// mark the db left by persistenceTest as the last version before extended tokens
+	const MojInt64 oldVersion = 8;
+	MojString versionFile;
+	MojErr err = versionFile.format(_T("%s/_version"), MojDbTestDir);
+	MojTestErrCheck(err);
+	MojString version;
+	err = version.format(_T("%lld"), oldVersion);
+	MojTestErrCheck(err);
+	err = MojFileFromString(versionFile, version);
+	MojTestErrCheck(err);
+
+	// opening alone must not stamp the new version, or the upgrade is never run
+	MojDb db;
+	err = db.open(MojDbTestDir);
+	MojTestErrCheck(err);
+	MojTestAssert(db.openedVersion() == oldVersion);
+	err = db.close();
+	MojTestErrCheck(err);
+	err = db.open(MojDbTestDir);
+	MojTestErrCheck(err);
+	MojTestAssert(db.openedVersion() == oldVersion);
+
+	// retokenize rewrites the objects and only then stamps the version
+	MojUInt32 count = 0;
+	err = db.retokenize(count);
+	MojTestErrCheck(err);
+	MojTestAssert(count > 0);
+	err = db.close();
+	MojTestErrCheck(err);
+	err = db.open(MojDbTestDir);
+	MojTestErrCheck(err);
+	MojTestAssert(db.openedVersion() == db.version());
+
+	MojDbQuery query;
+	err = query.from(_T("Test:1"));
+	MojTestErrCheck(err);
+	MojDbCursor cursor;
+	err = db.find(query, cursor);
+	MojTestErrCheck(err);
+	MojUInt32 objCount = 0;
+	err = cursor.count(objCount);
+	MojTestErrCheck(err);
+	MojTestAssert(objCount == 1);
+	err = cursor.close();
+	MojTestErrCheck(err);
+	err = db.close();
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
 MojErr MojDbCrudTest::staleUpdateTest(MojDb& db)
 {
 	MojObject obj;
@@ -39,6 +39,7 @@ protected:
 	MojErr arrayTest(MojDb& db);
 	MojErr defaultValuesTest(MojDb& db);
 	MojErr persistenceTest();
+	MojErr upgradeTest();
 	MojErr staleUpdateTest(MojDb& db);
 	MojErr largeObjectTest(MojDb& db);
 	//MojErr objectWithNullCharTest(MojDb& db);
@@ -33,6 +33,7 @@ namespace {
 
 static const MojChar* const MojLoadTestFileName = _T("loadtest.json");
 static const MojChar* const MojDumpTestFileName = _T("dumptest.json");
+static const MojChar* const MojBinaryDumpTestFileName = _T("dumptest.bin");
 static const MojChar* const MojTestStr =
 	_T("{\"_id\":\"_kinds/LoadTest:1\",\"_kind\":\"Kind:1\",\"id\":\"LoadTest:1\",\"owner\":\"mojodb.admin\",")
 	_T("\"indexes\":[{\"name\":\"foo\",\"props\":[{\"name\":\"foo\"}]},{\"name\":\"barfoo\",\"props\":[{\"name\":\"bar\"},{\"name\":\"foo\"}]}]}")
@@ -98,14 +99,160 @@ MojErr MojDbDumpLoadTest::run()
 	MojObject analysis;
 	err = db.stats(analysis);
 	MojErrCheck(err);
+	// apart from the reserved key, every entry is a kind
+	MojTestAssert(analysis.contains(MojDb::StatsInternalKey));
+	for (MojObject::ConstIterator i = analysis.begin(); i != analysis.end(); ++i) {
+		if (i.key() == MojDb::StatsInternalKey)
+			continue;
+		MojDbKind* kind = NULL;
+		err = db.kindEngine()->getKind(i.key().data(), kind);
+		MojTestErrCheck(err);
+	}
 
 	err = db.close();
 	MojTestErrCheck(err);
 
+	err = binaryTest();
+	MojTestErrCheck(err);
+	err = bulkTest();
+	MojTestErrCheck(err);
+
 	return MojErrNone;
 }
 
+MojErr MojDbDumpLoadTest::binaryTest()
+{
+	(void) MojRmDirRecursive(MojDbTestDir);
+
+	MojObject dbConf;
+	MojErr err = dbConf.putString(MojDbDumpWriter::FormatKey, MojDbDumpWriter::FormatBinaryName);
+	MojTestErrCheck(err);
+	err = dbConf.put(MojDbDumpWriter::CompressKey, true);
+	MojTestErrCheck(err);
+	MojObject conf;
+	err = conf.put(_T("db"), dbConf);
+	MojTestErrCheck(err);
+
+	MojDb db;
+	err = db.configure(conf);
+	MojTestErrCheck(err);
+	err = db.open(MojDbTestDir);
+	MojTestErrCheck(err);
+
+	// load json, dump binary
+	err = MojFileFromString(sandboxFileName(MojLoadTestFileName), MojTestStr);
+	MojTestErrCheck(err);
+	MojUInt32 count = 0;
+	err = db.load(sandboxFileName(MojLoadTestFileName), count);
+	MojTestErrCheck(err);
+	MojTestAssert(count == 11);
+	count = 0;
+	err = db.dump(sandboxFileName(MojBinaryDumpTestFileName), count);
+	MojTestErrCheck(err);
+	MojTestAssert(count == 11);
+
+	MojFile file;
+	err = file.open(sandboxFileName(MojBinaryDumpTestFileName), MOJ_O_RDONLY);
+	MojTestErrCheck(err);
+	MojByte magic[MojDbDumpWriter::MagicSize];
+	MojSize size = 0;
+	err = file.read(magic, sizeof(magic), size);
+	MojTestErrCheck(err);
+	MojTestAssert(size == sizeof(magic) && MojMemCmp(magic, MojDbDumpWriter::Magic, sizeof(magic)) == 0);
+	err = file.close();
+	MojTestErrCheck(err);
+
+	// del and purge, then load the binary dump back
+	MojString id;
+	err = id.assign(_T("LoadTest:1"));
+	MojTestErrCheck(err);
+	bool found = false;
+	err = db.delKind(id, found);
+	MojTestErrCheck(err);
+	MojTestAssert(found);
+	err = db.purge(count, 0);
+	MojTestErrCheck(err);
+	count = 0;
+	err = db.load(sandboxFileName(MojBinaryDumpTestFileName), count);
+	MojTestErrCheck(err);
+	MojTestAssert(count == 11);
+	err = checkCount(db);
+	MojTestErrCheck(err);
+
+	err = db.close();
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
 
+MojErr MojDbDumpLoadTest::bulkTest()
+{
+	(void) MojRmDirRecursive(MojDbTestDir);
+
+	// small steps so the objects are spread over several txns
+	MojObject dbConf;
+	MojErr err = dbConf.put(_T("bulkLoadStepSize"), 4);
+	MojTestErrCheck(err);
+	MojObject conf;
+	err = conf.put(_T("db"), dbConf);
+	MojTestErrCheck(err);
+
+	MojDb db;
+	err = db.configure(conf);
+	MojTestErrCheck(err);
+	err = db.open(MojDbTestDir);
+	MojTestErrCheck(err);
+
+	err = MojFileFromString(sandboxFileName(MojLoadTestFileName), MojTestStr);
+	MojTestErrCheck(err);
+	MojUInt32 count = 0;
+	err = db.load(sandboxFileName(MojLoadTestFileName), count, MojDb::FlagBulk);
+	MojTestErrCheck(err);
+	MojTestAssert(count == 11);
+	err = checkCount(db);
+	MojTestErrCheck(err);
+
+	// every index has to have all the keys, not just the one the count goes through
+	MojString bar;
+	err = bar.assign(_T("world"));
+	MojTestErrCheck(err);
+	MojString foo;
+	err = foo.assign(_T("hello"));
+	MojTestErrCheck(err);
+	MojDbQuery query;
+	err = query.from(_T("LoadTest:1"));
+	MojTestErrCheck(err);
+	err = query.where(_T("bar"), MojDbQuery::OpEq, bar);
+	MojTestErrCheck(err);
+	err = query.where(_T("foo"), MojDbQuery::OpEq, foo);
+	MojTestErrCheck(err);
+	MojDbCursor cursor;
+	err = db.find(query, cursor);
+	MojTestErrCheck(err);
+	count = 0;
+	err = cursor.count(count);
+	MojTestErrCheck(err);
+	MojTestAssert(count == 10);
+	err = cursor.close();
+	MojTestErrCheck(err);
+
+	// loading a dump over the same objects updates them in place
+	count = 0;
+	err = db.dump(sandboxFileName(MojDumpTestFileName), count);
+	MojTestErrCheck(err);
+	MojTestAssert(count == 11);
+	count = 0;
+	err = db.load(sandboxFileName(MojDumpTestFileName), count, MojDb::FlagBulk);
+	MojTestErrCheck(err);
+	MojTestAssert(count == 11);
+	err = checkCount(db);
+	MojTestErrCheck(err);
+
+	err = db.close();
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
 
 MojErr MojDbDumpLoadTest::checkCount(MojDb& db)
 {
@@ -127,5 +274,6 @@ void MojDbDumpLoadTest::cleanup()
 {
 	(void) MojUnlink(sandboxFileName(MojLoadTestFileName));
 	(void) MojUnlink(sandboxFileName(MojDumpTestFileName));
+	(void) MojUnlink(sandboxFileName(MojBinaryDumpTestFileName));
 	(void) MojRmDirRecursive(MojDbTestDir);
 }
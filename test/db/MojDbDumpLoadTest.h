@@ -31,6 +31,8 @@ public:
 	virtual void cleanup();
 
 private:
+	MojErr binaryTest();
+	MojErr bulkTest();
 	MojErr checkCount(MojDb& db);
 };
 
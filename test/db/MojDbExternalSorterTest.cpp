@@ -0,0 +1,181 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2014 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+#include "MojDbExternalSorterTest.h"
+#include "db/MojDbExternalSorter.h"
+
+static const MojChar* const MojSorterTestDir = _T("/tmp/mojodb-sorter-test-dir");
+
+MojDbExternalSorterTest::MojDbExternalSorterTest()
+: MojTestCase(_T("MojDbExternalSorter"))
+{
+}
+
+MojErr MojDbExternalSorterTest::run()
+{
+	MojErr err = MojMkDir(MojSorterTestDir, MOJ_S_IRWXU);
+	MojTestErrCheck(err);
+
+	err = memoryTest();
+	MojTestErrCheck(err);
+	err = spillTest();
+	MojTestErrCheck(err);
+	err = mergeTest();
+	MojTestErrCheck(err);
+	err = descTest();
+	MojTestErrCheck(err);
+
+	// fails unless every run file was removed
+	err = MojRmDir(MojSorterTestDir);
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+void MojDbExternalSorterTest::cleanup()
+{
+	(void) MojRmDirRecursive(MojSorterTestDir);
+}
+
+MojErr MojDbExternalSorterTest::memoryTest()
+{
+	MojDbExternalSorter sorter;
+	MojErr err = sorter.open(MojSorterTestDir);
+	MojTestErrCheck(err);
+	err = sort(sorter, 100, 10);
+	MojTestErrCheck(err);
+	MojTestAssert(sorter.runCount() == 0);
+	err = checkSorted(sorter, 100, false, false);
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbExternalSorterTest::spillTest()
+{
+	MojDbExternalSorter sorter;
+	MojErr err = sorter.open(MojSorterTestDir, 1024);
+	MojTestErrCheck(err);
+	err = sort(sorter, 1000, 50);
+	MojTestErrCheck(err);
+	MojTestAssert(sorter.runCount() > 1);
+	MojTestAssert(sorter.runCount() <= MojDbExternalSorter::MaxOpenRuns);
+	MojTestAssert(sorter.mergeCount() == 0);
+	err = checkSorted(sorter, 1000, false, false);
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbExternalSorterTest::mergeTest()
+{
+	// one record per run, so the runs must be merged in several passes
+	const MojSize numRecords = MojDbExternalSorter::MaxOpenRuns * 4 + 3;
+	MojDbExternalSorter sorter;
+	MojErr err = sorter.open(MojSorterTestDir, 1);
+	MojTestErrCheck(err);
+	err = sort(sorter, numRecords, 20);
+	MojTestErrCheck(err);
+	MojTestAssert(sorter.runCount() == numRecords);
+	MojTestAssert(sorter.mergeCount() > 1);
+	err = checkSorted(sorter, numRecords, false, false);
+	MojTestErrCheck(err);
+
+	// closing before the end must not leave runs behind
+	err = sorter.open(MojSorterTestDir, 1);
+	MojTestErrCheck(err);
+	err = sort(sorter, numRecords, 20);
+	MojTestErrCheck(err);
+	err = sorter.close();
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbExternalSorterTest::descTest()
+{
+	MojDbExternalSorter sorter;
+	MojErr err = sorter.open(MojSorterTestDir, 1, true, true);
+	MojTestErrCheck(err);
+	err = sort(sorter, 500, 30);
+	MojTestErrCheck(err);
+	MojTestAssert(sorter.mergeCount() > 0);
+	err = checkSorted(sorter, 500, true, true);
+	MojTestErrCheck(err);
+
+	err = sorter.open(MojSorterTestDir, 1, true, false);
+	MojTestErrCheck(err);
+	err = sort(sorter, 500, 30);
+	MojTestErrCheck(err);
+	err = checkSorted(sorter, 500, true, false);
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbExternalSorterTest::sort(MojDbExternalSorter& sorter, MojSize numRecords, MojSize numKeys)
+{
+	MojDbKey key;
+	MojDbKey id;
+	for (MojSize i = 0; i < numRecords; ++i) {
+		// scatter the records so that no run comes in sorted
+		MojSize val = (i * 7919) % numRecords;
+		MojErr err = key.assign(MojObject((MojInt64) (val % numKeys)));
+		MojTestErrCheck(err);
+		err = id.assign(MojObject((MojInt64) val));
+		MojTestErrCheck(err);
+		err = sorter.put(key, id);
+		MojTestErrCheck(err);
+	}
+	MojTestAssert(sorter.count() == numRecords);
+	MojErr err = sorter.finish();
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbExternalSorterTest::checkSorted(MojDbExternalSorter& sorter, MojSize numRecords, bool descKeys, bool descIds)
+{
+	MojDbKey prevKey;
+	MojDbKey prevId;
+	MojDbKey key;
+	MojDbKey id;
+	MojSize count = 0;
+	for (;;) {
+		bool found = false;
+		MojErr err = sorter.next(key, id, found);
+		MojTestErrCheck(err);
+		if (!found)
+			break;
+		if (count > 0) {
+			int res = descKeys ? prevKey.compare(key) : key.compare(prevKey);
+			MojTestAssert(res >= 0);
+			if (res == 0) {
+				res = descIds ? prevId.compare(id) : id.compare(prevId);
+				MojTestAssert(res > 0);
+			}
+		}
+		prevKey = key;
+		prevId = id;
+		++count;
+	}
+	MojTestAssert(count == numRecords);
+
+	return MojErrNone;
+}
@@ -0,0 +1,45 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2014 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+#ifndef MOJDBEXTERNALSORTERTEST_H_
+#define MOJDBEXTERNALSORTERTEST_H_
+
+#include "MojDbTestRunner.h"
+
+class MojDbExternalSorter;
+
+class MojDbExternalSorterTest : public MojTestCase
+{
+public:
+	MojDbExternalSorterTest();
+
+	virtual MojErr run();
+	virtual void cleanup();
+
+private:
+	MojErr memoryTest();
+	MojErr spillTest();
+	MojErr mergeTest();
+	MojErr descTest();
+
+	MojErr sort(MojDbExternalSorter& sorter, MojSize numRecords, MojSize numKeys);
+	MojErr checkSorted(MojDbExternalSorter& sorter, MojSize numRecords, bool descKeys, bool descIds);
+};
+
+#endif /* MOJDBEXTERNALSORTERTEST_H_ */
@@ -946,12 +946,16 @@ MojErr MojDbIndexTest::assertContains(TestIndex& ti, MojObject id, const MojChar
 
 MojErr MojDbIndexTest::assertContains(TestIndex& ti, MojObject id, const MojDbKey& key)
 {
-	MojDbKey prefixedKey(key);
-	MojErr err = prefixedKey.byteVec().insert(0, 1, MojObjectWriter::MarkerZeroIntValue);
-	MojErrCheck(err);
+	MojDbKey::ByteVec vec;
+	MojErr err = vec.push(MojObjectWriter::MarkerZeroIntValue);
+	MojTestErrCheck(err);
+	err = vec.append(key.data(), key.data() + key.size());
+	MojTestErrCheck(err);
+	MojDbKey prefixedKey;
+	err = prefixedKey.assign(vec.begin(), vec.size());
+	MojTestErrCheck(err);
 	if (ti.m_incDel) {
-		MojDbKey::ByteVec vec = prefixedKey.byteVec();
-		MojErr err = vec.insert(1, 1, MojObjectWriter::MarkerTrueValue);
+		err = vec.insert(1, 1, MojObjectWriter::MarkerTrueValue);
 		MojTestErrCheck(err);
 		MojDbKey keyTrue;
 		err = keyTrue.assign(vec.begin(), vec.size());
@@ -989,7 +993,7 @@ MojErr MojDbIndexTest::assertContainsText(TestIndex& ti, MojObject id, const Moj
 	MojSize idSize = 0;
 	err = writer.buf().data(idData, idSize);
 	MojTestErrCheck(err);
-	err = key.byteVec().append(idData, idData + idSize);
+	err = key.append(idData, idSize);
 	MojTestErrCheck(err);
 	err = assertContains(ti, id, key);
 	MojTestErrCheck(err);
@@ -19,6 +19,7 @@
 
 #include "MojDbKindTest.h"
 #include "db/MojDb.h"
+#include "db/MojDbIndex.h"
 #include "db/MojDbKind.h"
 #include "db/MojDbReq.h"
 #include "db/MojDbStorageEngine.h"
@@ -56,6 +57,27 @@ static const MojChar* const MojTestIndexesFooBazStr =
 	_T("{\"id\":\"KindTest:1\",")
 	_T("\"owner\":\"mojodb.admin\",")
 	_T("\"indexes\":[{\"name\":\"foo\",\"props\":[{\"name\":\"foo\"}]},{\"name\":\"baz\",\"props\":[{\"name\":\"baz\"}]}]}");
+static const MojChar* const MojTestCompressKindStr =
+	_T("{\"id\":\"CompressTest:1\",")
+	_T("\"owner\":\"mojodb.admin\",")
+	_T("\"compress\":true,")
+	_T("\"indexes\":[{\"name\":\"foo\",\"props\":[{\"name\":\"foo\"}]}]}");
+static const MojChar* const MojTestUncompressKindStr =
+	_T("{\"id\":\"CompressTest:1\",")
+	_T("\"owner\":\"mojodb.admin\",")
+	_T("\"indexes\":[{\"name\":\"foo\",\"props\":[{\"name\":\"foo\"}]}]}");
+static const MojChar* const MojTestBuildKindStr =
+	_T("{\"id\":\"BuildTest:1\",")
+	_T("\"owner\":\"mojodb.admin\"}");
+static const MojChar* const MojTestBuildIndexesStr =
+	_T("{\"id\":\"BuildTest:1\",")
+	_T("\"owner\":\"mojodb.admin\",")
+	_T("\"indexes\":[{\"name\":\"foo\",\"props\":[{\"name\":\"foo\"}]}]}");
+static const MojChar* const MojTestChoiceKindStr =
+	_T("{\"id\":\"ChoiceTest:1\",")
+	_T("\"owner\":\"mojodb.admin\",")
+	_T("\"indexes\":[{\"name\":\"fooBar\",\"props\":[{\"name\":\"foo\"},{\"name\":\"bar\"}]},")
+	_T("{\"name\":\"fooZed\",\"props\":[{\"name\":\"foo\"},{\"name\":\"zed\"}]}]}");
 static const MojChar* const MojTestChildKindStr =
 	_T("{\"id\":\"ChildKindTest:1\",")
 	_T("\"owner\":\"mojodb.admin\",")
@@ -164,6 +186,12 @@ MojErr MojDbKindTest::run()
 	MojTestErrCheck(err);
 	err = testUpdateWithObjects();
 	MojTestErrCheck(err);
+	err = testCompress();
+	MojTestErrCheck(err);
+	err = testBackgroundIndexBuild();
+	MojTestErrCheck(err);
+	err = testIndexChoice();
+	MojTestErrCheck(err);
 	//err = testPermissions();
 	MojTestErrCheck(err);
 	err = testPutKind();
@@ -495,6 +523,320 @@ MojErr MojDbKindTest::testUpdateWithObjects()
 	return MojErrNone;
 }
 
+MojErr MojDbKindTest::testCompress()
+{
+	MojDb db;
+	MojErr err = db.open(MojDbTestDir);
+	MojTestErrCheck(err);
+
+	MojObject kind;
+	err = kind.fromJson(MojTestCompressKindStr);
+	MojTestErrCheck(err);
+	err = db.putKind(kind);
+	MojTestErrCheck(err);
+
+	// a repetitive value, so that it actually gets smaller
+	MojString text;
+	for (int i = 0; i < 50; ++i) {
+		err = text.append(_T("compressible "));
+		MojTestErrCheck(err);
+	}
+	MojObject obj;
+	err = obj.putString(MojDb::KindKey, _T("CompressTest:1"));
+	MojTestErrCheck(err);
+	err = obj.putInt(_T("foo"), 1);
+	MojTestErrCheck(err);
+	err = obj.put(_T("text"), text);
+	MojTestErrCheck(err);
+	err = db.put(obj);
+	MojTestErrCheck(err);
+	MojObject id;
+	MojTestAssert(obj.get(MojDb::IdKey, id));
+
+	// get and find see the original value
+	MojObject got;
+	bool found = false;
+	err = db.get(id, got, found);
+	MojTestErrCheck(err);
+	MojTestAssert(found);
+	MojString gotText;
+	err = got.getRequired(_T("text"), gotText);
+	MojTestErrCheck(err);
+	MojTestAssert(gotText == text);
+
+	MojDbQuery query;
+	err = query.from(_T("CompressTest:1"));
+	MojTestErrCheck(err);
+	err = query.where(_T("foo"), MojDbQuery::OpEq, 1);
+	MojTestErrCheck(err);
+	MojDbCursor cursor;
+	err = db.find(query, cursor);
+	MojTestErrCheck(err);
+	err = cursor.get(got, found);
+	MojTestErrCheck(err);
+	MojTestAssert(found);
+	err = got.getRequired(_T("text"), gotText);
+	MojTestErrCheck(err);
+	MojTestAssert(gotText == text);
+	err = cursor.close();
+	MojTestErrCheck(err);
+
+	// objects written before compression is turned off stay readable
+	err = kind.fromJson(MojTestUncompressKindStr);
+	MojTestErrCheck(err);
+	err = db.putKind(kind);
+	MojTestErrCheck(err);
+	err = db.get(id, got, found);
+	MojTestErrCheck(err);
+	MojTestAssert(found);
+	err = got.getRequired(_T("text"), gotText);
+	MojTestErrCheck(err);
+	MojTestAssert(gotText == text);
+	err = got.putInt(_T("foo"), 2);
+	MojTestErrCheck(err);
+	err = db.put(got);
+	MojTestErrCheck(err);
+	err = db.get(id, got, found);
+	MojTestErrCheck(err);
+	MojTestAssert(found);
+	MojInt64 foo = 0;
+	err = got.getRequired(_T("foo"), foo);
+	MojTestErrCheck(err);
+	MojTestAssert(foo == 2);
+
+	err = db.close();
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbKindTest::testBackgroundIndexBuild()
+{
+	// build in small steps so that the index takes several batches to fill
+	MojObject dbConf;
+	MojErr err = dbConf.put(MojDbIndexBuilder::BackgroundKey, true);
+	MojTestErrCheck(err);
+	err = dbConf.put(MojDbIndexBuilder::StepSizeKey, 3);
+	MojTestErrCheck(err);
+	MojObject conf;
+	err = conf.put(_T("db"), dbConf);
+	MojTestErrCheck(err);
+
+	MojDb db;
+	err = db.configure(conf);
+	MojTestErrCheck(err);
+	err = db.open(MojDbTestDir);
+	MojTestErrCheck(err);
+
+	MojObject kind;
+	err = kind.fromJson(MojTestBuildKindStr);
+	MojTestErrCheck(err);
+	err = db.putKind(kind);
+	MojTestErrCheck(err);
+	const int numObjects = 20;
+	for (int i = 0; i < numObjects; ++i) {
+		MojObject obj;
+		err = obj.putString(MojDb::KindKey, _T("BuildTest:1"));
+		MojTestErrCheck(err);
+		err = obj.putInt(_T("foo"), i);
+		MojTestErrCheck(err);
+		err = db.put(obj);
+		MojTestErrCheck(err);
+	}
+
+	// putKind returns before the index is filled
+	MojObject indexes;
+	err = indexes.fromJson(MojTestBuildIndexesStr);
+	MojTestErrCheck(err);
+	err = db.putKind(indexes);
+	MojTestErrCheck(err);
+
+	// puts made while the build is running must end up in the index too
+	MojObject obj;
+	err = obj.putString(MojDb::KindKey, _T("BuildTest:1"));
+	MojTestErrCheck(err);
+	err = obj.putInt(_T("foo"), numObjects);
+	MojTestErrCheck(err);
+	err = db.put(obj);
+	MojTestErrCheck(err);
+
+	MojDbQuery query;
+	err = query.from(_T("BuildTest:1"));
+	MojTestErrCheck(err);
+	err = query.where(_T("foo"), MojDbQuery::OpGreaterThanEq, 0);
+	MojTestErrCheck(err);
+	MojDbCursor cursor;
+	int tries = 0;
+	for (;;) {
+		err = db.find(query, cursor);
+		if (err != MojErrDbNoIndexForQuery)
+			break;
+		err = cursor.close();
+		MojTestErrCheck(err);
+		MojTestAssert(++tries < 500);
+		err = MojSleep(MojMillisecs(10));
+		MojTestErrCheck(err);
+	}
+	MojTestErrCheck(err);
+	int count = 0;
+	for (;;) {
+		bool found = false;
+		MojObject obj;
+		err = cursor.get(obj, found);
+		MojTestErrCheck(err);
+		if (!found)
+			break;
+		MojInt64 foo;
+		err = obj.getRequired(_T("foo"), foo);
+		MojTestErrCheck(err);
+		MojTestAssert(foo == count);
+		++count;
+	}
+	MojTestAssert(count == numObjects + 1);
+	err = cursor.close();
+	MojTestErrCheck(err);
+
+	err = db.close();
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbKindTest::testIndexChoice()
+{
+	MojDb db;
+	MojErr err = db.open(MojDbTestDir);
+	MojTestErrCheck(err);
+
+	MojObject kind;
+	err = kind.fromJson(MojTestChoiceKindStr);
+	MojTestErrCheck(err);
+	err = db.putKind(kind);
+	MojTestErrCheck(err);
+
+	// every object has ten bar values, so fooBar holds ten keys per object and fooZed one
+	const int numObjects = 20;
+	for (int i = 0; i < numObjects; ++i) {
+		MojObject obj;
+		err = obj.putString(MojDb::KindKey, _T("ChoiceTest:1"));
+		MojTestErrCheck(err);
+		err = obj.putInt(_T("foo"), 1);
+		MojTestErrCheck(err);
+		err = obj.putInt(_T("zed"), i);
+		MojTestErrCheck(err);
+		MojObject bar;
+		for (int j = 0; j < 10; ++j) {
+			err = bar.push(j);
+			MojTestErrCheck(err);
+		}
+		err = obj.put(_T("bar"), bar);
+		MojTestErrCheck(err);
+		err = db.put(obj);
+		MojTestErrCheck(err);
+	}
+
+	// both indexes can answer this; fooBar sorts first but fooZed scans fewer keys
+	MojDbQuery query;
+	err = query.from(_T("ChoiceTest:1"));
+	MojTestErrCheck(err);
+	err = query.where(_T("foo"), MojDbQuery::OpEq, 1);
+	MojTestErrCheck(err);
+	MojDbCursor cursor;
+	err = db.find(query, cursor);
+	MojTestErrCheck(err);
+	int count = 0;
+	for (;;) {
+		bool found = false;
+		MojObject obj;
+		err = cursor.get(obj, found);
+		MojTestErrCheck(err);
+		if (!found)
+			break;
+		++count;
+	}
+	MojTestAssert(count == numObjects);
+
+	MojObject explain;
+	err = cursor.explain(explain);
+	MojTestErrCheck(err);
+	MojString indexName;
+	err = explain.getRequired(MojDbIndex::IndexKey, indexName);
+	MojTestErrCheck(err);
+	MojTestAssert(indexName == _T("fooZed"));
+	MojInt64 estimated = 0;
+	err = explain.getRequired(MojDbCursor::EstimatedKeysKey, estimated);
+	MojTestErrCheck(err);
+	MojTestAssert(estimated == numObjects);
+	MojInt64 scanned = 0;
+	err = explain.getRequired(MojDbCursor::ScannedKeysKey, scanned);
+	MojTestErrCheck(err);
+	MojTestAssert(scanned >= numObjects);
+	MojObject ranges;
+	err = explain.getRequired(MojDbIndex::RangesKey, ranges);
+	MojTestErrCheck(err);
+	MojTestAssert(ranges.size() == 1);
+	err = cursor.close();
+	MojTestErrCheck(err);
+
+	// without a txn to sample through, fooBar's estimate is its tracked key count,
+	// which must only move once the keys are committed
+	MojDbQuery barQuery;
+	err = barQuery.from(_T("ChoiceTest:1"));
+	MojTestErrCheck(err);
+	err = barQuery.where(_T("foo"), MojDbQuery::OpEq, 1);
+	MojTestErrCheck(err);
+	err = barQuery.order(_T("bar"));
+	MojTestErrCheck(err);
+	MojDbKind* choiceKind = NULL;
+	err = db.kindEngine()->getKind(_T("ChoiceTest:1"), choiceKind);
+	MojTestErrCheck(err);
+	MojDbIndex* index = choiceKind->indexForCollation(barQuery);
+	MojTestAssert(index && index->name() == _T("fooBar"));
+	MojSize keysBefore = 0;
+	err = index->estimate(barQuery, NULL, keysBefore);
+	MojTestErrCheck(err);
+	MojTestAssert(keysBefore == numObjects * 10);
+
+	MojObject extra;
+	err = extra.putString(MojDb::KindKey, _T("ChoiceTest:1"));
+	MojTestErrCheck(err);
+	err = extra.putInt(_T("foo"), 1);
+	MojTestErrCheck(err);
+	err = extra.putInt(_T("zed"), numObjects);
+	MojTestErrCheck(err);
+	MojObject bar;
+	for (int j = 0; j < 10; ++j) {
+		err = bar.push(j);
+		MojTestErrCheck(err);
+	}
+	err = extra.put(_T("bar"), bar);
+	MojTestErrCheck(err);
+	MojDbReq req;
+	req.beginBatch();
+	err = db.put(extra, MojDb::FlagNone, req);
+	MojTestErrCheck(err);
+	err = req.abort();
+	MojTestErrCheck(err);
+	MojSize keysAfter = 0;
+	err = index->estimate(barQuery, NULL, keysAfter);
+	MojTestErrCheck(err);
+	MojTestAssert(keysAfter == keysBefore);
+
+	bool found = false;
+	err = extra.del(MojDb::IdKey, found);
+	MojTestErrCheck(err);
+	err = db.put(extra);
+	MojTestErrCheck(err);
+	err = index->estimate(barQuery, NULL, keysAfter);
+	MojTestErrCheck(err);
+	MojTestAssert(keysAfter == keysBefore + 10);
+
+	err = db.close();
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
 MojErr MojDbKindTest::testPermissions()
 {
 	/* create this scenario:
@@ -34,6 +34,9 @@ private:
 	MojErr testIds();
 	MojErr testUpdate();
 	MojErr testUpdateWithObjects();
+	MojErr testCompress();
+	MojErr testBackgroundIndexBuild();
+	MojErr testIndexChoice();
 	MojErr testPermissions();
 	MojErr testPutKind();
 	MojErr testDelKind();
@@ -0,0 +1,683 @@
+/* @@@LICENSE
+*
+*  Copyright (c) 2014 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+#include "MojDbPerfBenchmark.h"
+#include "db/MojDbSearchCursor.h"
+#include "core/MojUtil.h"
+
+#include <atomic>
+#include <new>
+#include <stdlib.h>
+
+// count every allocation made through operator new in this executable. Internal code
+// always ends up in the nothrow version (see MojNew.h). MojMalloc'd buffers such as
+// vectors and strings are not counted.
+static std::atomic<MojUInt64> s_allocCount(0);
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	s_allocCount.fetch_add(1, std::memory_order_relaxed);
+	return malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& nt) noexcept
+{
+	return operator new(size, nt);
+}
+
+void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	free(p);
+}
+
+namespace {
+	class BenchWatcher : public MojSignalHandler
+	{
+	public:
+		BenchWatcher() : m_slot(this, &BenchWatcher::handleChange), m_count(0) {}
+
+		MojErr handleChange()
+		{
+			++m_count;
+			return MojErrNone;
+		}
+
+		MojDb::WatchSignal::Slot<BenchWatcher> m_slot;
+		int m_count;
+	};
+}
+
+const MojChar* const MojDbPerfBenchmark::BenchKindId = _T("BenchKind:1");
+const MojUInt32 MojDbPerfBenchmark::NumOpenWatches[] = { 0, 100, 10000 };
+const MojChar* const MojDbPerfBenchmark::BenchKindStr =
+	_T("{\"id\":\"BenchKind:1\",")
+	_T("\"owner\":\"mojodb.admin\",")
+	_T("\"indexes\":[{\"name\":\"first\",\"props\":[{\"name\":\"first\"}]},")
+		_T("{\"name\":\"last\",\"props\":[{\"name\":\"last\",\"tokenize\":\"all\",\"collate\":\"primary\"}]}]}");
+const MojChar* const MojDbPerfBenchmark::BenchKindIndexedStr =
+	_T("{\"id\":\"BenchKind:1\",")
+	_T("\"owner\":\"mojodb.admin\",")
+	_T("\"indexes\":[{\"name\":\"first\",\"props\":[{\"name\":\"first\"}]},")
+		_T("{\"name\":\"last\",\"props\":[{\"name\":\"last\",\"tokenize\":\"all\",\"collate\":\"primary\"}]},")
+		_T("{\"name\":\"timestamp\",\"props\":[{\"name\":\"timestamp\"}]}]}");
+
+MojDbPerfBenchmark::MojDbPerfBenchmark(const MojDbPerfTestRunner::BenchmarkOptions& options, MojObject& results)
+: MojDbPerfTest(_T("MojDbPerfBenchmark")),
+  m_options(options),
+  m_results(results),
+  m_rand(options.m_seed),
+  m_startBytes(0),
+  m_startAllocs(0)
+{
+}
+
+MojUInt64 MojDbPerfBenchmark::allocCount()
+{
+	return s_allocCount.load(std::memory_order_relaxed);
+}
+
+MojErr MojDbPerfBenchmark::run()
+{
+	MojDb db;
+	MojErr err = db.open(MojDbTestDir);
+	MojTestErrCheck(err);
+	MojObject kind;
+	err = kind.fromJson(BenchKindStr);
+	MojTestErrCheck(err);
+	err = db.putKind(kind);
+	MojTestErrCheck(err);
+
+	// create fills the kind that the other scenarios work on, and delete empties it
+	err = benchCreate(db);
+	MojTestErrCheck(err);
+	err = benchRead(db);
+	MojTestErrCheck(err);
+	err = benchUpdate(db);
+	MojTestErrCheck(err);
+	err = benchSearch(db);
+	MojTestErrCheck(err);
+	err = benchWatch(db);
+	MojTestErrCheck(err);
+	for (MojSize i = 0; i < sizeof(NumOpenWatches) / sizeof(NumOpenWatches[0]); ++i) {
+		err = benchOpenWatches(db, NumOpenWatches[i]);
+		MojTestErrCheck(err);
+	}
+	err = benchIndex(db);
+	MojTestErrCheck(err);
+	// one thread takes the rev ordered path that backups with a size limit use
+	err = benchDump(db, _T("dump_json_seq"), MojDbDumpWriter::FormatJsonName, false, 1);
+	MojTestErrCheck(err);
+	err = benchDump(db, _T("dump_json"), MojDbDumpWriter::FormatJsonName, false, MojDbDumpWriter::ThreadsDefault);
+	MojTestErrCheck(err);
+	err = benchDump(db, _T("dump_binary"), MojDbDumpWriter::FormatBinaryName, false, MojDbDumpWriter::ThreadsDefault);
+	MojTestErrCheck(err);
+	err = benchDump(db, _T("dump_binary_compressed"), MojDbDumpWriter::FormatBinaryName, true, MojDbDumpWriter::ThreadsDefault);
+	MojTestErrCheck(err);
+	err = benchLoad(db, _T("load"), MojDb::FlagNone);
+	MojTestErrCheck(err);
+	err = benchLoad(db, _T("load_bulk"), MojDb::FlagBulk);
+	MojTestErrCheck(err);
+	err = benchDelete(db);
+	MojTestErrCheck(err);
+
+	err = db.close();
+	MojTestErrCheck(err);
+
+	err = writeResults();
+	MojTestErrCheck(err);
+	bool regressed = false;
+	err = checkBaseline(regressed);
+	MojTestErrCheck(err);
+	MojTestAssert(!regressed);
+
+	return MojErrNone;
+}
+
+void MojDbPerfBenchmark::cleanup()
+{
+	(void) MojRmDirRecursive(MojDbTestDir);
+}
+
+MojErr MojDbPerfBenchmark::benchCreate(MojDb& db)
+{
+	m_ids.clear();
+	MojErr err = beginScenario();
+	MojTestErrCheck(err);
+	for (MojUInt64 i = 0; i < m_options.m_count; ++i) {
+		MojObject obj;
+		err = createMedObj(obj, (MojUInt64) MojRand(&m_rand));
+		MojTestErrCheck(err);
+		err = obj.putString(MojDb::KindKey, BenchKindId);
+		MojTestErrCheck(err);
+
+		timespec start;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		err = db.put(obj);
+		MojTestErrCheck(err);
+		err = endOp(start);
+		MojTestErrCheck(err);
+
+		MojObject id;
+		MojTestAssert(obj.get(MojDb::IdKey, id));
+		err = m_ids.push(id);
+		MojTestErrCheck(err);
+	}
+	err = endScenario(_T("create"));
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbPerfBenchmark::benchRead(MojDb& db)
+{
+	ObjVec ids;
+	MojErr err = shuffledIds(ids);
+	MojTestErrCheck(err);
+	err = beginScenario();
+	MojTestErrCheck(err);
+	for (ObjVec::ConstIterator i = ids.begin(); i != ids.end(); ++i) {
+		timespec start;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		MojObject obj;
+		bool found = false;
+		err = db.get(*i, obj, found);
+		MojTestErrCheck(err);
+		err = endOp(start);
+		MojTestErrCheck(err);
+		MojTestAssert(found);
+	}
+	err = endScenario(_T("read"));
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbPerfBenchmark::benchUpdate(MojDb& db)
+{
+	ObjVec ids;
+	MojErr err = shuffledIds(ids);
+	MojTestErrCheck(err);
+	err = beginScenario();
+	MojTestErrCheck(err);
+	for (ObjVec::ConstIterator i = ids.begin(); i != ids.end(); ++i) {
+		// change an indexed property so that index maintenance is part of the cost
+		MojObject obj;
+		err = obj.put(MojDb::IdKey, *i);
+		MojTestErrCheck(err);
+		err = obj.putString(_T("first"), s_firstNames[MojRand(&m_rand) % 50]);
+		MojTestErrCheck(err);
+
+		timespec start;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		err = db.merge(obj);
+		MojTestErrCheck(err);
+		err = endOp(start);
+		MojTestErrCheck(err);
+	}
+	err = endScenario(_T("update"));
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbPerfBenchmark::benchSearch(MojDb& db)
+{
+	MojUInt64 numOps = m_options.m_count / 10 + 1;
+	MojErr err = beginScenario();
+	MojTestErrCheck(err);
+	for (MojUInt64 i = 0; i < numOps; ++i) {
+		// search for a prefix of one of the last names
+		MojString text;
+		err = text.assign(s_lastNames[MojRand(&m_rand) % 50], 3);
+		MojTestErrCheck(err);
+		MojDbQuery query;
+		err = query.from(BenchKindId);
+		MojTestErrCheck(err);
+		err = query.where(_T("last"), MojDbQuery::OpSearch, text, MojDbCollationPrimary);
+		MojTestErrCheck(err);
+		query.limit(50);
+
+		timespec start;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		MojString locale;
+		MojDbSearchCursor cursor(locale);
+		err = db.find(query, cursor);
+		MojTestErrCheck(err);
+		for (;;) {
+			MojObject obj;
+			bool found = false;
+			err = static_cast<MojDbCursor&>(cursor).get(obj, found);
+			MojTestErrCheck(err);
+			if (!found)
+				break;
+		}
+		err = cursor.close();
+		MojTestErrCheck(err);
+		err = endOp(start);
+		MojTestErrCheck(err);
+	}
+	err = endScenario(_T("search"));
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbPerfBenchmark::benchWatch(MojDb& db)
+{
+	// each op registers a watch and puts the object that fires it
+	MojUInt64 numOps = m_options.m_count / 10 + 1;
+	MojErr err = beginScenario();
+	MojTestErrCheck(err);
+	for (MojUInt64 i = 0; i < numOps; ++i) {
+		MojString name;
+		err = name.format(_T("watched%llu"), i);
+		MojTestErrCheck(err);
+		MojDbQuery query;
+		err = query.from(BenchKindId);
+		MojTestErrCheck(err);
+		err = query.where(_T("first"), MojDbQuery::OpEq, name);
+		MojTestErrCheck(err);
+		MojObject obj;
+		err = createSmallObj(obj, i);
+		MojTestErrCheck(err);
+		err = obj.putString(_T("first"), name);
+		MojTestErrCheck(err);
+		err = obj.putString(MojDb::KindKey, BenchKindId);
+		MojTestErrCheck(err);
+		MojRefCountedPtr<BenchWatcher> watcher(new BenchWatcher);
+		MojAllocCheck(watcher.get());
+
+		timespec start;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		MojDbCursor cursor;
+		err = db.find(query, cursor, watcher->m_slot);
+		MojTestErrCheck(err);
+		err = cursor.close();
+		MojTestErrCheck(err);
+		err = db.put(obj);
+		MojTestErrCheck(err);
+		err = endOp(start);
+		MojTestErrCheck(err);
+		MojTestAssert(watcher->m_count == 1);
+
+		MojObject id;
+		MojTestAssert(obj.get(MojDb::IdKey, id));
+		err = m_ids.push(id);
+		MojTestErrCheck(err);
+	}
+	err = endScenario(_T("watch"));
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbPerfBenchmark::benchOpenWatches(MojDb& db, MojUInt32 numWatches)
+{
+	// open watches that never fire, then time puts that every one of them has to be checked against
+	MojVector<MojRefCountedPtr<BenchWatcher> > watchers;
+	for (MojUInt32 i = 0; i < numWatches; ++i) {
+		MojString name;
+		MojErr err = name.format(_T("idle%u"), i);
+		MojTestErrCheck(err);
+		MojDbQuery query;
+		err = query.from(BenchKindId);
+		MojTestErrCheck(err);
+		err = query.where(_T("first"), MojDbQuery::OpEq, name);
+		MojTestErrCheck(err);
+		// one domain per watch keeps the index from warning about watch counts
+		MojString domain;
+		err = domain.format(_T("com.palm.bench.watch%u"), i);
+		MojTestErrCheck(err);
+		MojDbReq req;
+		err = req.domain(domain);
+		MojTestErrCheck(err);
+		MojRefCountedPtr<BenchWatcher> watcher(new BenchWatcher);
+		MojAllocCheck(watcher.get());
+		MojDbCursor cursor;
+		err = db.find(query, cursor, watcher->m_slot, req);
+		MojTestErrCheck(err);
+		err = cursor.close();
+		MojTestErrCheck(err);
+		err = watchers.push(watcher);
+		MojTestErrCheck(err);
+	}
+
+	MojUInt64 numOps = m_options.m_count / 10 + 1;
+	MojErr err = beginScenario();
+	MojTestErrCheck(err);
+	for (MojUInt64 i = 0; i < numOps; ++i) {
+		MojObject obj;
+		err = createSmallObj(obj, i);
+		MojTestErrCheck(err);
+		err = obj.putString(MojDb::KindKey, BenchKindId);
+		MojTestErrCheck(err);
+
+		timespec start;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		err = db.put(obj);
+		MojTestErrCheck(err);
+		err = endOp(start);
+		MojTestErrCheck(err);
+
+		MojObject id;
+		MojTestAssert(obj.get(MojDb::IdKey, id));
+		err = m_ids.push(id);
+		MojTestErrCheck(err);
+	}
+	MojString name;
+	err = name.format(_T("put_watches%u"), numWatches);
+	MojTestErrCheck(err);
+	err = endScenario(name);
+	MojTestErrCheck(err);
+
+	for (MojVector<MojRefCountedPtr<BenchWatcher> >::ConstIterator i = watchers.begin(); i != watchers.end(); ++i) {
+		MojTestAssert((*i)->m_count == 0);
+		(*i)->m_slot.cancel();
+	}
+	return MojErrNone;
+}
+
+MojErr MojDbPerfBenchmark::benchIndex(MojDb& db)
+{
+	// alternately add and drop an index, which rebuilds it over every object
+	MojErr err = beginScenario();
+	MojTestErrCheck(err);
+	for (MojUInt64 i = 0; i < NumIndexIterations; ++i) {
+		MojObject kind;
+		err = kind.fromJson(i % 2 == 0 ? BenchKindIndexedStr : BenchKindStr);
+		MojTestErrCheck(err);
+
+		timespec start;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		err = db.putKind(kind);
+		MojTestErrCheck(err);
+		err = endOp(start);
+		MojTestErrCheck(err);
+	}
+	err = endScenario(_T("index"));
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbPerfBenchmark::benchDump(MojDb& db, const MojChar* name, const MojChar* format, bool compress, MojInt64 threads)
+{
+	// dump settings are part of the db conf, so reopen with the ones we want
+	MojObject dbConf;
+	MojErr err = dbConf.putString(MojDbDumpWriter::FormatKey, format);
+	MojTestErrCheck(err);
+	err = dbConf.put(MojDbDumpWriter::CompressKey, compress);
+	MojTestErrCheck(err);
+	err = dbConf.put(MojDbDumpWriter::ThreadsKey, threads);
+	MojTestErrCheck(err);
+	MojObject conf;
+	err = conf.put(MojDb::ConfKey, dbConf);
+	MojTestErrCheck(err);
+	err = db.close();
+	MojTestErrCheck(err);
+	err = db.configure(conf);
+	MojTestErrCheck(err);
+	err = db.open(MojDbTestDir);
+	MojTestErrCheck(err);
+
+	MojString path;
+	err = path.format(_T("%s/bench.dump"), MojDbTestDir);
+	MojTestErrCheck(err);
+	err = beginScenario();
+	MojTestErrCheck(err);
+	for (MojUInt64 i = 0; i < NumDumpIterations; ++i) {
+		timespec start;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		MojUInt32 count = 0;
+		err = db.dump(path, count);
+		MojTestErrCheck(err);
+		err = endOp(start);
+		MojTestErrCheck(err);
+		MojTestAssert(count >= m_options.m_count);
+	}
+	MojStatT stat;
+	err = MojStat(path, &stat);
+	MojTestErrCheck(err);
+	err = endScenario(name, (MojInt64) stat.st_size);
+	MojTestErrCheck(err);
+	(void) MojUnlink(path);
+
+	return MojErrNone;
+}
+
+MojErr MojDbPerfBenchmark::benchLoad(MojDb& db, const MojChar* name, MojUInt32 flags)
+{
+	// restore a full dump into an empty db, the way a backup is restored
+	MojString path;
+	MojErr err = path.format(_T("%s/bench.dump"), MojDbTestDir);
+	MojTestErrCheck(err);
+	MojUInt32 count = 0;
+	err = db.dump(path, count);
+	MojTestErrCheck(err);
+	MojString restoreDir;
+	err = restoreDir.format(_T("%s-restore"), MojDbTestDir);
+	MojTestErrCheck(err);
+
+	err = beginScenario();
+	MojTestErrCheck(err);
+	for (MojUInt64 i = 0; i < NumDumpIterations; ++i) {
+		(void) MojRmDirRecursive(restoreDir);
+		MojDb restoreDb;
+		err = restoreDb.open(restoreDir);
+		MojTestErrCheck(err);
+
+		timespec start;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		MojUInt32 loaded = 0;
+		err = restoreDb.load(path, loaded, flags);
+		MojTestErrCheck(err);
+		err = endOp(start);
+		MojTestErrCheck(err);
+		MojTestAssert(loaded == count);
+
+		err = restoreDb.close();
+		MojTestErrCheck(err);
+	}
+	MojStatT stat;
+	err = MojStat(path, &stat);
+	MojTestErrCheck(err);
+	err = endScenario(name, (MojInt64) stat.st_size);
+	MojTestErrCheck(err);
+	(void) MojUnlink(path);
+	(void) MojRmDirRecursive(restoreDir);
+
+	return MojErrNone;
+}
+
+MojErr MojDbPerfBenchmark::benchDelete(MojDb& db)
+{
+	ObjVec ids;
+	MojErr err = shuffledIds(ids);
+	MojTestErrCheck(err);
+	err = beginScenario();
+	MojTestErrCheck(err);
+	for (ObjVec::ConstIterator i = ids.begin(); i != ids.end(); ++i) {
+		timespec start;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		bool found = false;
+		err = db.del(*i, found);
+		MojTestErrCheck(err);
+		err = endOp(start);
+		MojTestErrCheck(err);
+		MojTestAssert(found);
+	}
+	err = endScenario(_T("delete"));
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbPerfBenchmark::beginScenario()
+{
+	m_latencies.clear();
+	MojErr err = bytesWritten(m_startBytes);
+	MojTestErrCheck(err);
+	m_startAllocs = allocCount();
+
+	return MojErrNone;
+}
+
+MojErr MojDbPerfBenchmark::endOp(const timespec& start)
+{
+	timespec end;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	MojErr err = m_latencies.push(timeDiff(start, end));
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbPerfBenchmark::endScenario(const MojChar* name, MojInt64 bytesPerOp)
+{
+	MojUInt64 allocs = allocCount() - m_startAllocs;
+	MojInt64 bytes = 0;
+	MojErr err = bytesWritten(bytes);
+	MojTestErrCheck(err);
+	bytes -= m_startBytes;
+
+	MojTestAssert(!m_latencies.empty());
+	MojUInt64 total = 0;
+	for (LatencyVec::ConstIterator i = m_latencies.begin(); i != m_latencies.end(); ++i) {
+		total += *i;
+	}
+	MojObject result;
+	err = result.putInt(_T("opsPerSec"), total ? (MojInt64) (m_latencies.size() * 1000000000ULL / total) : 0);
+	MojTestErrCheck(err);
+	err = latencyStats(m_latencies, result);
+	MojTestErrCheck(err);
+	err = result.putInt(_T("bytesWritten"), bytes);
+	MojTestErrCheck(err);
+	err = result.putInt(_T("allocations"), (MojInt64) allocs);
+	MojTestErrCheck(err);
+	if (bytesPerOp > 0) {
+		// MB/s of output for scenarios that produce a file
+		double secs = (double) total / 1000000000.0;
+		double mb = (double) bytesPerOp * (double) m_latencies.size() / (1024.0 * 1024.0);
+		err = result.put(_T("fileBytes"), bytesPerOp);
+		MojTestErrCheck(err);
+		err = result.put(_T("mbPerSec"), MojDecimal(secs > 0 ? mb / secs : 0.0));
+		MojTestErrCheck(err);
+	}
+	err = m_scenarios.put(name, result);
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbPerfBenchmark::shuffledIds(ObjVec& idsOut)
+{
+	// Fisher-Yates with the seeded generator, so every run visits ids in the same order
+	MojErr err = idsOut.assign(m_ids.begin(), m_ids.end());
+	MojTestErrCheck(err);
+	ObjVec::Iterator ids;
+	err = idsOut.begin(ids);
+	MojTestErrCheck(err);
+	for (MojSize i = idsOut.size(); i > 1; --i) {
+		MojSwap(ids[i - 1], ids[MojRand(&m_rand) % i]);
+	}
+	return MojErrNone;
+}
+
+MojErr MojDbPerfBenchmark::writeResults()
+{
+	MojErr err = m_results.putInt(_T("seed"), m_options.m_seed);
+	MojTestErrCheck(err);
+	err = m_results.putInt(_T("count"), (MojInt64) m_options.m_count);
+	MojTestErrCheck(err);
+	err = m_results.put(_T("scenarios"), m_scenarios);
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbPerfBenchmark::checkBaseline(bool& regressedOut)
+{
+	regressedOut = false;
+	if (m_options.m_baselinePath.empty())
+		return MojErrNone;
+
+	MojString json;
+	MojErr err = MojFileToString(m_options.m_baselinePath, json);
+	MojTestErrCheck(err);
+	MojObject baseline;
+	err = baseline.fromJson(json);
+	MojTestErrCheck(err);
+	MojObject baseScenarios;
+	MojTestAssert(baseline.get(_T("scenarios"), baseScenarios));
+
+	// scenarios missing from either run are not compared
+	for (MojObject::ConstIterator i = m_scenarios.begin(); i != m_scenarios.end(); ++i) {
+		MojObject base;
+		if (!baseScenarios.get(i.key(), base))
+			continue;
+		err = checkMetric(i.key(), *i, base, _T("opsPerSec"), true, regressedOut);
+		MojTestErrCheck(err);
+		err = checkMetric(i.key(), *i, base, _T("p95Ns"), false, regressedOut);
+		MojTestErrCheck(err);
+		err = checkMetric(i.key(), *i, base, _T("allocations"), false, regressedOut);
+		MojTestErrCheck(err);
+	}
+	return MojErrNone;
+}
+
+MojErr MojDbPerfBenchmark::checkMetric(const MojChar* scenario, const MojObject& cur, const MojObject& base,
+									   const MojChar* metric, bool higherIsBetter, bool& regressedOut)
+{
+	MojInt64 curVal = 0;
+	MojInt64 baseVal = 0;
+	if (!cur.get(metric, curVal) || !base.get(metric, baseVal) || baseVal <= 0)
+		return MojErrNone;
+
+	MojInt64 threshold = m_options.m_threshold;
+	bool regressed = higherIsBetter ? (curVal * 100 < baseVal * (100 - threshold))
+									: (curVal * 100 > baseVal * (100 + threshold));
+	if (regressed) {
+		regressedOut = true;
+		MojErr err = MojPrintF(_T("REGRESSION %s.%s: baseline %lld, now %lld (threshold %lld%%)\n"),
+							   scenario, metric, baseVal, curVal, threshold);
+		MojTestErrCheck(err);
+	}
+	return MojErrNone;
+}
+
+MojErr MojDbPerfBenchmark::bytesWritten(MojInt64& bytesOut)
+{
+	// bytes this process has passed to write(), as accounted by the kernel
+	bytesOut = 0;
+	MojString io;
+	MojErr err = MojFileToString(_T("/proc/self/io"), io);
+	MojErrCatchAll(err) {
+		return MojErrNone;
+	}
+	const MojChar* wchar = MojStrStr(io.data(), _T("wchar:"));
+	if (wchar)
+		bytesOut = MojStrToInt64(wchar + 6, NULL, 10);
+
+	return MojErrNone;
+}
@@ -0,0 +1,79 @@
+/* @@@LICENSE
+*
+*  Copyright (c) 2014 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+#ifndef MOJDBPERFBENCHMARK_H_
+#define MOJDBPERFBENCHMARK_H_
+
+#include "MojDbPerfTest.h"
+#include "db/MojDb.h"
+
+// Runs a fixed set of workloads with seeded data and adds their results to the
+// runner's JSON report. When given a baseline produced by an earlier run, fails if
+// any scenario got slower or allocates more than the allowed threshold.
+class MojDbPerfBenchmark : public MojDbPerfTest {
+public:
+	MojDbPerfBenchmark(const MojDbPerfTestRunner::BenchmarkOptions& options, MojObject& results);
+
+	virtual MojErr run();
+	virtual void cleanup();
+
+	static MojUInt64 allocCount();
+
+private:
+	typedef MojVector<MojObject> ObjVec;
+
+	MojErr benchCreate(MojDb& db);
+	MojErr benchRead(MojDb& db);
+	MojErr benchUpdate(MojDb& db);
+	MojErr benchSearch(MojDb& db);
+	MojErr benchWatch(MojDb& db);
+	MojErr benchOpenWatches(MojDb& db, MojUInt32 numWatches);
+	MojErr benchIndex(MojDb& db);
+	MojErr benchDump(MojDb& db, const MojChar* name, const MojChar* format, bool compress, MojInt64 threads);
+	MojErr benchLoad(MojDb& db, const MojChar* name, MojUInt32 flags);
+	MojErr benchDelete(MojDb& db);
+
+	MojErr beginScenario();
+	MojErr endOp(const timespec& start);
+	MojErr endScenario(const MojChar* name, MojInt64 bytesPerOp = 0);
+	MojErr shuffledIds(ObjVec& idsOut);
+	MojErr writeResults();
+	MojErr checkBaseline(bool& regressedOut);
+	MojErr checkMetric(const MojChar* scenario, const MojObject& cur, const MojObject& base,
+					   const MojChar* metric, bool higherIsBetter, bool& regressedOut);
+	MojErr bytesWritten(MojInt64& bytesOut);
+
+	static const MojChar* const BenchKindId;
+	static const MojChar* const BenchKindStr;
+	static const MojChar* const BenchKindIndexedStr;
+	static const MojUInt64 NumIndexIterations = 10;
+	static const MojUInt64 NumDumpIterations = 3;
+	static const MojUInt32 NumOpenWatches[];
+
+	const MojDbPerfTestRunner::BenchmarkOptions& m_options;
+	MojObject& m_results;
+	unsigned int m_rand;
+	ObjVec m_ids;
+	LatencyVec m_latencies;
+	MojInt64 m_startBytes;
+	MojUInt64 m_startAllocs;
+	MojObject m_scenarios;
+};
+
+#endif /* MOJDBPERFBENCHMARK_H_ */
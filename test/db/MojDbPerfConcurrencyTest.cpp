@@ -0,0 +1,403 @@
+/* @@@LICENSE
+*
+*  Copyright (c) 2014 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+#include "MojDbPerfConcurrencyTest.h"
+#include "db/MojDbServiceDefs.h"
+#include "core/MojEpollReactor.h"
+#include "core/MojJson.h"
+#include "core/MojServiceMessage.h"
+
+namespace {
+	// Stands in for the bus, which the benchmark bypasses by invoking the handler
+	// directly from its client threads.
+	class BenchService : public MojService
+	{
+	public:
+		virtual MojErr createRequest(MojRefCountedPtr<MojServiceRequest>& reqOut) { MojErrThrow(MojErrNotImplemented); }
+		virtual MojErr dispatch() { return MojErrNone; }
+
+	private:
+		virtual MojErr sendImpl(MojServiceRequest* req, const MojChar* service, const MojChar* method, Token& tokenOut) { MojErrThrow(MojErrNotImplemented); }
+		virtual MojErr cancelImpl(MojServiceRequest* req) { return MojErrNone; }
+		virtual MojErr dispatchReplyImpl(MojServiceRequest* req, MojServiceMessage *msg, MojObject& payload, MojErr errCode) { return MojErrNone; }
+		virtual MojErr enableSubscriptionImpl(MojServiceMessage* msg) { return MojErrNone; }
+		virtual MojErr removeSubscriptionImpl(MojServiceMessage* msg) { return MojErrNone; }
+	};
+
+	// A request as the handler would get it from the bus. The handler formats its
+	// reply as JSON, just like it does for luna.
+	class BenchMessage : public MojServiceMessage
+	{
+	public:
+		BenchMessage(MojService* service, const MojChar* method, const MojChar* appId)
+		: MojServiceMessage(service, NULL), m_method(method), m_appId(appId), m_succeeded(false) {}
+
+		virtual MojObjectVisitor& writer() { return m_writer; }
+		virtual const MojChar* appId() const { return m_appId; }
+		virtual const MojChar* category() const { return MojService::DefaultCategory; }
+		virtual const MojChar* method() const { return m_method; }
+		virtual const MojChar* senderAddress() const { return m_appId; }
+		virtual const MojChar* senderId() const { return m_appId; }
+		virtual const MojChar* queue() const { return NULL; }
+		virtual MojErr payload(MojObjectVisitor& visitor) const { MojErrThrow(MojErrNotImplemented); }
+		virtual MojErr payload(MojObject& objOut) const { MojErrThrow(MojErrNotImplemented); }
+		virtual Token token() const { return 0; }
+		virtual bool hasData() const { return true; }
+
+		bool succeeded() const { return m_succeeded; }
+
+	private:
+		virtual MojErr replyImpl()
+		{
+			m_succeeded = MojStrStr(m_writer.json().data(), _T("\"returnValue\":true")) != NULL;
+			return MojErrNone;
+		}
+
+		MojJsonWriter m_writer;
+		const MojChar* m_method;
+		const MojChar* m_appId;
+		bool m_succeeded;
+	};
+}
+
+const MojChar* const MojDbPerfConcurrencyTest::ConcAppId = _T("com.palm.dbperf");
+const MojChar* const MojDbPerfConcurrencyTest::ConcKindId = _T("ConcKind:1");
+const MojChar* const MojDbPerfConcurrencyTest::ConcKindStr =
+	_T("{\"id\":\"ConcKind:1\",")
+	_T("\"owner\":\"com.palm.dbperf\",")
+	_T("\"indexes\":[{\"name\":\"key\",\"props\":[{\"name\":\"key\"}]}]}");
+
+MojDbPerfConcurrencyTest::MojDbPerfConcurrencyTest(const MojDbPerfTestRunner::BenchmarkOptions& options, MojObject& results)
+: MojDbPerfTest(_T("MojDbPerfConcurrency")),
+  m_options(options),
+  m_results(results),
+  m_service(NULL)
+{
+}
+
+MojErr MojDbPerfConcurrencyTest::run()
+{
+	MojErr err = m_db.open(MojDbTestDir);
+	MojTestErrCheck(err);
+	MojObject kind;
+	err = kind.fromJson(ConcKindStr);
+	MojTestErrCheck(err);
+	err = m_db.putKind(kind);
+	MojTestErrCheck(err);
+	for (MojUInt64 i = 0; i < m_options.m_count; ++i) {
+		MojObject obj;
+		err = obj.putString(MojDb::KindKey, ConcKindId);
+		MojTestErrCheck(err);
+		err = obj.putInt(_T("key"), (MojInt64) i);
+		MojTestErrCheck(err);
+		err = obj.putInt(_T("val"), 0);
+		MojTestErrCheck(err);
+		err = m_db.put(obj);
+		MojTestErrCheck(err);
+	}
+
+	MojEpollReactor reactor;
+	BenchService service;
+	m_service = &service;
+	MojRefCountedPtr<MojDbServiceHandler> handler(new MojDbServiceHandler(m_db, reactor));
+	MojAllocCheck(handler.get());
+	err = handler->open();
+	MojTestErrCheck(err);
+
+	MojObject dbResults;
+	MojObject serviceResults;
+	MojUInt32 numThreads = 1;
+	for (;;) {
+		MojString name;
+		err = name.format(_T("t%u"), numThreads);
+		MojTestErrCheck(err);
+		MojObject result;
+		err = runClients(NULL, numThreads, result);
+		MojTestErrCheck(err);
+		err = dbResults.put(name, result);
+		MojTestErrCheck(err);
+		err = runClients(handler.get(), numThreads, result);
+		MojTestErrCheck(err);
+		err = serviceResults.put(name, result);
+		MojTestErrCheck(err);
+
+		if (numThreads == m_options.m_maxThreads)
+			break;
+		numThreads = MojMin(numThreads * 2, m_options.m_maxThreads);
+	}
+	err = handler->close();
+	MojTestErrCheck(err);
+	m_service = NULL;
+	err = m_db.close();
+	MojTestErrCheck(err);
+
+	MojObject results;
+	err = results.putInt(_T("opsPerThread"), (MojInt64) m_options.m_count);
+	MojTestErrCheck(err);
+	err = results.putInt(_T("writePercent"), m_options.m_writePercent);
+	MojTestErrCheck(err);
+	err = results.putInt(_T("hotPercent"), m_options.m_hotPercent);
+	MojTestErrCheck(err);
+	err = results.put(_T("db"), dbResults);
+	MojTestErrCheck(err);
+	err = results.put(_T("service"), serviceResults);
+	MojTestErrCheck(err);
+	err = m_results.put(_T("concurrency"), results);
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+void MojDbPerfConcurrencyTest::cleanup()
+{
+	(void) MojRmDirRecursive(MojDbTestDir);
+}
+
+MojErr MojDbPerfConcurrencyTest::clientThread(void* arg)
+{
+	Client* client = (Client*) arg;
+	return client->m_test->runClient(*client);
+}
+
+const MojChar* MojDbPerfConcurrencyTest::opName(Op op)
+{
+	switch (op) {
+	case OpPut:
+		return _T("put");
+	case OpFind:
+		return _T("find");
+	case OpMerge:
+		return _T("merge");
+	default:
+		MojAssertNotReached();
+		return NULL;
+	}
+}
+
+MojErr MojDbPerfConcurrencyTest::runClients(MojDbServiceHandler* handler, MojUInt32 numThreads, MojObject& resultOut)
+{
+	MojVector<Client> clients;
+	MojErr err = clients.resize(numThreads);
+	MojTestErrCheck(err);
+	MojVector<Client>::Iterator client;
+	err = clients.begin(client);
+	MojTestErrCheck(err);
+	MojVector<MojThreadT> threads;
+	err = threads.resize(numThreads, MojInvalidThread);
+	MojTestErrCheck(err);
+	MojVector<MojThreadT>::Iterator thread;
+	err = threads.begin(thread);
+	MojTestErrCheck(err);
+
+	timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (MojUInt32 i = 0; i < numThreads; ++i) {
+		client[i].m_test = this;
+		client[i].m_handler = handler;
+		client[i].m_rand = m_options.m_seed + i;
+		err = MojThreadCreate(thread[i], clientThread, &client[i]);
+		MojTestErrCheck(err);
+	}
+	// join every thread before failing so that none outlives the clients
+	MojErr clientErr = MojErrNone;
+	for (MojUInt32 i = 0; i < numThreads; ++i) {
+		MojErr threadErr = MojErrNone;
+		err = MojThreadJoin(thread[i], threadErr);
+		MojTestErrCheck(err);
+		if (clientErr == MojErrNone)
+			clientErr = threadErr;
+	}
+	timespec end;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	MojTestErrCheck(clientErr);
+
+	// throughput is over the wall-clock time of the whole run
+	MojUInt64 elapsed = timeDiff(start, end);
+	MojUInt64 totalOps = m_options.m_count * numThreads;
+	MojObject result;
+	err = result.putInt(_T("ops"), (MojInt64) totalOps);
+	MojTestErrCheck(err);
+	err = result.putInt(_T("opsPerSec"), elapsed ? (MojInt64) (totalOps * 1000000000ULL / elapsed) : 0);
+	MojTestErrCheck(err);
+	for (int op = 0; op < NumOps; ++op) {
+		LatencyVec latencies;
+		for (MojUInt32 i = 0; i < numThreads; ++i) {
+			err = latencies.append(client[i].m_latencies[op].begin(), client[i].m_latencies[op].end());
+			MojTestErrCheck(err);
+		}
+		MojObject stats;
+		err = latencyStats(latencies, stats);
+		MojTestErrCheck(err);
+		err = result.put(opName((Op) op), stats);
+		MojTestErrCheck(err);
+	}
+	resultOut = result;
+
+	return MojErrNone;
+}
+
+MojErr MojDbPerfConcurrencyTest::runClient(Client& client)
+{
+	for (MojUInt64 i = 0; i < m_options.m_count; ++i) {
+		Op op = pickOp(client.m_rand);
+		MojInt64 key = pickKey(client.m_rand);
+
+		timespec start;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		MojErr err = client.m_handler ? serviceOp(client.m_handler, op, key, client.m_rand)
+									  : dbOp(op, key, client.m_rand);
+		MojTestErrCheck(err);
+		timespec end;
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		err = client.m_latencies[op].push(timeDiff(start, end));
+		MojTestErrCheck(err);
+	}
+	return MojErrNone;
+}
+
+MojErr MojDbPerfConcurrencyTest::dbOp(Op op, MojInt64 key, unsigned int& rand)
+{
+	switch (op) {
+	case OpPut: {
+		MojObject obj;
+		MojErr err = obj.putString(MojDb::KindKey, ConcKindId);
+		MojTestErrCheck(err);
+		err = obj.putInt(_T("key"), key);
+		MojTestErrCheck(err);
+		err = obj.putInt(_T("val"), MojRand(&rand));
+		MojTestErrCheck(err);
+		err = m_db.put(obj);
+		MojErrCheck(err);
+		break;
+	}
+	case OpFind: {
+		MojDbQuery query;
+		MojErr err = keyQuery(key, query);
+		MojTestErrCheck(err);
+		MojDbCursor cursor;
+		err = m_db.find(query, cursor);
+		MojErrCheck(err);
+		for (;;) {
+			MojObject obj;
+			bool found = false;
+			err = cursor.get(obj, found);
+			MojErrCheck(err);
+			if (!found)
+				break;
+		}
+		err = cursor.close();
+		MojErrCheck(err);
+		break;
+	}
+	case OpMerge: {
+		MojDbQuery query;
+		MojErr err = keyQuery(key, query);
+		MojTestErrCheck(err);
+		MojObject props;
+		err = props.putInt(_T("val"), MojRand(&rand));
+		MojTestErrCheck(err);
+		MojUInt32 count = 0;
+		err = m_db.merge(query, props, count);
+		MojErrCheck(err);
+		break;
+	}
+	default:
+		MojAssertNotReached();
+	}
+	return MojErrNone;
+}
+
+MojErr MojDbPerfConcurrencyTest::serviceOp(MojDbServiceHandler* handler, Op op, MojInt64 key, unsigned int& rand)
+{
+	MojObject payload;
+	const MojChar* method = NULL;
+	if (op == OpPut) {
+		method = MojDbServiceDefs::PutMethod;
+		MojObject obj;
+		MojErr err = obj.putString(MojDb::KindKey, ConcKindId);
+		MojTestErrCheck(err);
+		err = obj.putInt(_T("key"), key);
+		MojTestErrCheck(err);
+		err = obj.putInt(_T("val"), MojRand(&rand));
+		MojTestErrCheck(err);
+		MojObject objects;
+		err = objects.push(obj);
+		MojTestErrCheck(err);
+		err = payload.put(MojDbServiceDefs::ObjectsKey, objects);
+		MojTestErrCheck(err);
+	} else {
+		MojDbQuery query;
+		MojErr err = keyQuery(key, query);
+		MojTestErrCheck(err);
+		MojObject queryObj;
+		err = query.toObject(queryObj);
+		MojTestErrCheck(err);
+		err = payload.put(MojDbServiceDefs::QueryKey, queryObj);
+		MojTestErrCheck(err);
+		if (op == OpFind) {
+			method = MojDbServiceDefs::FindMethod;
+		} else {
+			method = MojDbServiceDefs::MergeMethod;
+			MojObject props;
+			err = props.putInt(_T("val"), MojRand(&rand));
+			MojTestErrCheck(err);
+			err = payload.put(MojDbServiceDefs::PropsKey, props);
+			MojTestErrCheck(err);
+		}
+	}
+
+	// the service would have built a message for the request, so the benchmark does too
+	MojRefCountedPtr<BenchMessage> msg(new BenchMessage(m_service, method, ConcAppId));
+	MojAllocCheck(msg.get());
+	MojErr err = static_cast<MojService::CategoryHandler*>(handler)->invoke(method, msg.get(), payload);
+	MojErrCheck(err);
+	MojTestAssert(msg->succeeded());
+
+	return MojErrNone;
+}
+
+MojErr MojDbPerfConcurrencyTest::keyQuery(MojInt64 key, MojDbQuery& queryOut)
+{
+	MojErr err = queryOut.from(ConcKindId);
+	MojTestErrCheck(err);
+	err = queryOut.where(_T("key"), MojDbQuery::OpEq, key);
+	MojTestErrCheck(err);
+	queryOut.limit(FindLimit);
+
+	return MojErrNone;
+}
+
+MojInt64 MojDbPerfConcurrencyTest::pickKey(unsigned int& rand) const
+{
+	// with skew, the hot share of operations goes to the first tenth of the keys
+	MojUInt64 numKeys = m_options.m_count;
+	MojUInt64 hotKeys = MojMax(numKeys / 10, (MojUInt64) 1);
+	if ((MojUInt32) (MojRand(&rand) % 100) < m_options.m_hotPercent)
+		return (MojInt64) (MojRand(&rand) % hotKeys);
+	return (MojInt64) (MojRand(&rand) % numKeys);
+}
+
+MojDbPerfConcurrencyTest::Op MojDbPerfConcurrencyTest::pickOp(unsigned int& rand) const
+{
+	// writes are split evenly between puts and merges
+	MojUInt32 r = (MojUInt32) (MojRand(&rand) % 200);
+	if (r >= m_options.m_writePercent * 2)
+		return OpFind;
+	return (r % 2 == 0) ? OpPut : OpMerge;
+}
@@ -0,0 +1,76 @@
+/* @@@LICENSE
+*
+*  Copyright (c) 2014 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+#ifndef MOJDBPERFCONCURRENCYTEST_H_
+#define MOJDBPERFCONCURRENCYTEST_H_
+
+#include "MojDbPerfTest.h"
+#include "db/MojDb.h"
+#include "db/MojDbServiceHandler.h"
+
+// Drives one MojDb from 1, 2, 4... client threads with a mix of put, find and merge,
+// first by calling MojDb directly and then through MojDbServiceHandler, and reports
+// throughput and latency percentiles per operation for each thread count.
+class MojDbPerfConcurrencyTest : public MojDbPerfTest {
+public:
+	MojDbPerfConcurrencyTest(const MojDbPerfTestRunner::BenchmarkOptions& options, MojObject& results);
+
+	virtual MojErr run();
+	virtual void cleanup();
+
+private:
+	enum Op {
+		OpPut,
+		OpFind,
+		OpMerge,
+		NumOps
+	};
+
+	struct Client {
+		Client() : m_test(NULL), m_handler(NULL), m_rand(0) {}
+
+		MojDbPerfConcurrencyTest* m_test;
+		MojDbServiceHandler* m_handler;		// NULL to call MojDb directly
+		unsigned int m_rand;
+		LatencyVec m_latencies[NumOps];
+	};
+
+	static MojErr clientThread(void* arg);
+	static const MojChar* opName(Op op);
+
+	MojErr runClients(MojDbServiceHandler* handler, MojUInt32 numThreads, MojObject& resultOut);
+	MojErr runClient(Client& client);
+	MojErr dbOp(Op op, MojInt64 key, unsigned int& rand);
+	MojErr serviceOp(MojDbServiceHandler* handler, Op op, MojInt64 key, unsigned int& rand);
+	MojErr keyQuery(MojInt64 key, MojDbQuery& queryOut);
+	MojInt64 pickKey(unsigned int& rand) const;
+	Op pickOp(unsigned int& rand) const;
+
+	static const MojChar* const ConcKindId;
+	static const MojChar* const ConcKindStr;
+	static const MojChar* const ConcAppId;
+	static const MojUInt32 FindLimit = 10;
+
+	const MojDbPerfTestRunner::BenchmarkOptions& m_options;
+	MojObject& m_results;
+	MojDb m_db;
+	MojService* m_service;
+};
+
+#endif /* MOJDBPERFCONCURRENCYTEST_H_ */
@@ -23,6 +23,8 @@
 
 static const MojUInt64 numInsert = 1000;
 static const int numRepetitions = 5;
+static const int numWriters[] = {1, 4, 16};
+static const MojUInt32 groupCommitWindowMsec = 2;
 
 extern MojUInt64 allTestsTime;
 static MojUInt64 totalTestTime = 0;
@@ -148,9 +150,184 @@ MojErr MojDbPerfCreateTest::testCreate()
 	err = testBatchInsertLgArrayObj(db, MojPerfLgArrayKind2Id);
 	MojTestErrCheck(err);
 
+	// compressed values: put time and stored size against the plain kinds
+	err = testInsertLgObj(db, MojPerfLgKindZId);
+	MojTestErrCheck(err);
+	err = testInsertLgArrayObj(db, MojPerfLgArrayKindZId);
+	MojTestErrCheck(err);
+	err = testStoredSize(db, MojPerfLgKindId, &MojDbPerfCreateTest::putLargeObj);
+	MojTestErrCheck(err);
+	err = testStoredSize(db, MojPerfLgKindZId, &MojDbPerfCreateTest::putLargeObj);
+	MojTestErrCheck(err);
+	err = testStoredSize(db, MojPerfLgArrayKindId, &MojDbPerfCreateTest::putLargeArrayObj);
+	MojTestErrCheck(err);
+	err = testStoredSize(db, MojPerfLgArrayKindZId, &MojDbPerfCreateTest::putLargeArrayObj);
+	MojTestErrCheck(err);
+
 	err = db.close();
 	MojTestErrCheck(err);
 
+	// concurrent writers sharing group commits
+	err = testConcurrentInsert(MojPerfSmKindId);
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+namespace {
+	struct ConcurrentWriter
+	{
+		MojDbPerfTest* test;
+		MojDb* db;
+		const MojChar* kindId;
+		MojUInt64 first;
+		MojUInt64 count;
+	};
+}
+
+MojErr MojDbPerfCreateTest::testStoredSize(MojDb& db, const MojChar* kindId, MojErr (MojDbPerfCreateTest::*putFn)(MojDb&, const MojChar*, MojUInt64&))
+{
+	// register all the kinds again
+	MojUInt64 time = 0;
+	MojErr err = putKinds(db, time);
+	MojTestErrCheck(err);
+
+	err = (this->*putFn)(db, kindId, time);
+	MojTestErrCheck(err);
+	MojInt64 size = 0;
+	err = storedSize(db, kindId, size);
+	MojTestErrCheck(err);
+	MojDbQuery q;
+	err = q.from(kindId);
+	MojTestErrCheck(err);
+	MojUInt32 count = 0;
+	err = db.del(q, count, MojDb::FlagPurge);
+	MojTestErrCheck(err);
+
+	err = MojPrintF("\n -------------------- \n");
+	MojTestErrCheck(err);
+	err = MojPrintF("   stored size of %llu %s objects: %lld bytes\n", numInsert, kindId, size);
+	MojTestErrCheck(err);
+	err = MojPrintF("   bytes per object: %lld", size / (MojInt64) numInsert);
+	MojTestErrCheck(err);
+	err = MojPrintF("\n\n");
+	MojTestErrCheck(err);
+	MojString buf;
+	err = buf.format("stored bytes of %llu objects,%s,%lld,,%lld,\n", numInsert, kindId, size, size / (MojInt64) numInsert);
+	MojTestErrCheck(err);
+	err = fileWrite(file, buf);
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbPerfCreateTest::testConcurrentInsert(const MojChar* kindId)
+{
+	MojObject conf;
+	MojErr err = conf.fromJson(lazySync() ? _T("{\"db\":{\"sync\":2}}") : _T("{\"db\":{}}"));
+	MojTestErrCheck(err);
+	MojObject dbConf;
+	conf.get(_T("db"), dbConf);
+	err = dbConf.put(_T("groupCommitWindow"), (MojInt64) groupCommitWindowMsec);
+	MojTestErrCheck(err);
+	err = conf.put(_T("db"), dbConf);
+	MojTestErrCheck(err);
+
+	MojDb db;
+	err = db.configure(conf);
+	MojTestErrCheck(err);
+	err = db.open(MojDbTestDir);
+	MojTestErrCheck(err);
+
+	MojUInt64 time = 0;
+	err = putKinds(db, time);
+	MojTestErrCheck(err);
+
+	for (MojSize i = 0; i < sizeof(numWriters) / sizeof(numWriters[0]); ++i) {
+		err = concurrentInsert(db, kindId, numWriters[i]);
+		MojTestErrCheck(err);
+	}
+
+	err = delKinds(db);
+	MojTestErrCheck(err);
+	err = db.close();
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbPerfCreateTest::concurrentInsert(MojDb& db, const MojChar* kindId, int writers)
+{
+	ConcurrentWriter args[16];
+	MojThreadT threads[16];
+	MojAssert(writers <= 16);
+
+	MojUInt64 perWriter = numInsert / writers;
+	MojUInt64 totalTime = 0;
+	for (int rep = 0; rep < numRepetitions; rep++) {
+		timespec startTime;
+		timespec endTime;
+		clock_gettime(CLOCK_REALTIME, &startTime);
+		for (int i = 0; i < writers; ++i) {
+			args[i].test = this;
+			args[i].db = &db;
+			args[i].kindId = kindId;
+			args[i].first = i * perWriter;
+			args[i].count = perWriter;
+			MojErr err = MojThreadCreate(threads[i], concurrentPutThread, &args[i]);
+			MojTestErrCheck(err);
+		}
+		for (int i = 0; i < writers; ++i) {
+			MojErr threadErr = MojErrNone;
+			MojErr err = MojThreadJoin(threads[i], threadErr);
+			MojTestErrCheck(err);
+			MojTestErrCheck(threadErr);
+		}
+		clock_gettime(CLOCK_REALTIME, &endTime);
+		totalTime += timeDiff(startTime, endTime);
+		totalTestTime += timeDiff(startTime, endTime);
+
+		MojDbQuery q;
+		MojErr err = q.from(kindId);
+		MojTestErrCheck(err);
+		MojUInt32 count = 0;
+		err = db.del(q, count, MojDb::FlagPurge);
+		MojTestErrCheck(err);
+	}
+
+	MojUInt64 objects = perWriter * writers * numRepetitions;
+	MojErr err = MojPrintF("\n -------------------- \n");
+	MojTestErrCheck(err);
+	err = MojPrintF("   %d concurrent writers put %llu %s objects %d times: %llu nanosecs\n", writers, perWriter * writers, kindId, numRepetitions, totalTime);
+	MojTestErrCheck(err);
+	err = MojPrintF("   throughput: %llu objects/sec", totalTime ? (objects * 1000000000ULL) / totalTime : 0);
+	MojTestErrCheck(err);
+	err = MojPrintF("\n\n");
+	MojTestErrCheck(err);
+	MojString buf;
+	err = buf.format("put %llu objects %d times with %d writers,%s,%llu,%llu,%llu,\n", perWriter * writers, numRepetitions, writers, kindId, totalTime, totalTime/numRepetitions, totalTime / objects);
+	MojTestErrCheck(err);
+	err = fileWrite(file, buf);
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbPerfCreateTest::concurrentPutThread(void* arg)
+{
+	ConcurrentWriter* writer = (ConcurrentWriter*) arg;
+	MojAssert(writer);
+
+	for (MojUInt64 i = writer->first; i < writer->first + writer->count; i++) {
+		MojObject obj;
+		MojErr err = obj.putString(MojDb::KindKey, writer->kindId);
+		MojErrCheck(err);
+		err = writer->test->createSmallObj(obj, i);
+		MojErrCheck(err);
+		err = writer->db->put(obj);
+		MojErrCheck(err);
+	}
+
 	return MojErrNone;
 }
 
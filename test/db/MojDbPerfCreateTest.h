@@ -41,6 +41,9 @@ private:
 	MojErr testBatchInsertLgObj(MojDb& db, const MojChar* kindId);
 	MojErr testBatchInsertLgNestedObj(MojDb& db, const MojChar* kindId);
 	MojErr testBatchInsertLgArrayObj(MojDb& db, const MojChar* kindId);
+	MojErr testStoredSize(MojDb& db, const MojChar* kindId, MojErr (MojDbPerfCreateTest::*putFn)(MojDb&, const MojChar*, MojUInt64&));
+	MojErr testConcurrentInsert(const MojChar* kindId);
+	MojErr concurrentInsert(MojDb& db, const MojChar* kindId, int writers);
 
 	MojErr putSmallObj(MojDb& db, const MojChar* kindId, MojUInt64& smallObjTime);
 	MojErr putMedObj(MojDb& db, const MojChar* kindId, MojUInt64& medObjTime);
@@ -53,6 +56,8 @@ private:
 	MojErr batchPutLargeNestedObj(MojDb& db, const MojChar* kindId, MojUInt64& lgNestedObjTime);
 	MojErr batchPutLargeArrayObj(MojDb& db, const MojChar* kindId, MojUInt64& lgArrayObjTime);
 
+	static MojErr concurrentPutThread(void* arg);
+
 };
 
 #endif /* MOJDBPERFCREATETEST_H_ */
@@ -0,0 +1,292 @@
+/* @@@LICENSE
+*
+* Copyright (c) 2014 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+#include "MojDbPerfObjectTest.h"
+#include "db/MojDb.h"
+#include "core/MojFlatMap.h"
+#include "core/MojMap.h"
+#include "core/MojObjectBuilder.h"
+#include "core/MojObjectSerialization.h"
+
+static const MojUInt64 numObjects = 1000;
+static const int numRepetitions = 5;
+
+extern MojUInt64 allTestsTime;
+static MojUInt64 totalTestTime = 0;
+static MojFile file;
+const MojChar* const ObjectTestFileName = _T("MojDbPerfObjectTest.csv");
+
+#ifdef MOJ_FLAT_OBJECT_MAP
+static const MojChar* const ObjectImplName = _T("flat");
+#else
+static const MojChar* const ObjectImplName = _T("tree");
+#endif
+
+MojDbPerfObjectTest::MojDbPerfObjectTest()
+: MojDbPerfTest(_T("MojDbPerfObject"))
+{
+}
+
+MojErr MojDbPerfObjectTest::run()
+{
+	MojErr err = file.open(ObjectTestFileName, MOJ_O_RDWR | MOJ_O_CREAT | MOJ_O_TRUNC, MOJ_S_IRUSR | MOJ_S_IWUSR);
+	MojTestErrCheck(err);
+
+	MojString buf;
+	err = buf.format("MojoDb Object Performance Test,,,,,\n\nOperation,Shape,Map,Total Time,Time Per Iteration,Time Per Object\n");
+	MojTestErrCheck(err);
+	err = fileWrite(file, buf);
+	MojTestErrCheck(err);
+
+	err = testObjects(_T("small"), &MojDbPerfTest::createSmallObj);
+	MojTestErrCheck(err);
+	err = testObjects(_T("medium"), &MojDbPerfTest::createMedObj);
+	MojTestErrCheck(err);
+	err = testObjects(_T("large"), &MojDbPerfTest::createLargeObj);
+	MojTestErrCheck(err);
+	err = testObjects(_T("large nested"), &MojDbPerfTest::createLargeNestedObj);
+	MojTestErrCheck(err);
+	err = testLoad();
+	MojTestErrCheck(err);
+	allTestsTime += totalTestTime;
+
+	err = MojPrintF("\n\n TOTAL TEST TIME: %llu nanoseconds. | %10.3f seconds.\n\n", totalTestTime, (double) totalTestTime / 1000000000.0);
+	MojTestErrCheck(err);
+	err = MojPrintF("\n-------\n");
+	MojTestErrCheck(err);
+
+	err = buf.format("\n\nTOTAL TEST TIME,,,%llu,,,", totalTestTime);
+	MojTestErrCheck(err);
+	err = fileWrite(file, buf);
+	MojTestErrCheck(err);
+
+	err = file.close();
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbPerfObjectTest::testObjects(const MojChar* shape, CreateFn createFn)
+{
+	MojObject::ObjectVec objs;
+	for (MojUInt64 i = 0; i < numObjects; ++i) {
+		MojObject obj;
+		MojErr err = (this->*createFn)(obj, i);
+		MojTestErrCheck(err);
+		err = objs.push(obj);
+		MojTestErrCheck(err);
+	}
+
+	MojUInt64 treePut = 0, treeGet = 0, treeIterate = 0;
+	MojUInt64 flatPut = 0, flatGet = 0, flatIterate = 0;
+	MojUInt64 writeTime = 0, readTime = 0;
+	for (int i = 0; i < numRepetitions; ++i) {
+		MojErr err = timeMap<MojMap<MojString, MojObject, const MojChar*> >(objs, treePut, treeGet, treeIterate);
+		MojTestErrCheck(err);
+		err = timeMap<MojFlatMap<MojString, MojObject, const MojChar*> >(objs, flatPut, flatGet, flatIterate);
+		MojTestErrCheck(err);
+		err = timeSerialize(objs, writeTime, readTime);
+		MojTestErrCheck(err);
+	}
+
+	MojErr err = MojPrintF("\n -------------------- \n");
+	MojTestErrCheck(err);
+	err = report(_T("put"), shape, _T("tree"), treePut, objs.size());
+	MojTestErrCheck(err);
+	err = report(_T("put"), shape, _T("flat"), flatPut, objs.size());
+	MojTestErrCheck(err);
+	err = report(_T("get"), shape, _T("tree"), treeGet, objs.size());
+	MojTestErrCheck(err);
+	err = report(_T("get"), shape, _T("flat"), flatGet, objs.size());
+	MojTestErrCheck(err);
+	err = report(_T("iterate"), shape, _T("tree"), treeIterate, objs.size());
+	MojTestErrCheck(err);
+	err = report(_T("iterate"), shape, _T("flat"), flatIterate, objs.size());
+	MojTestErrCheck(err);
+	err = report(_T("serialize"), shape, ObjectImplName, writeTime, objs.size());
+	MojTestErrCheck(err);
+	err = report(_T("deserialize"), shape, ObjectImplName, readTime, objs.size());
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+template<class MAP>
+MojErr MojDbPerfObjectTest::timeMap(const MojObject::ObjectVec& objs, MojUInt64& putTime, MojUInt64& getTime, MojUInt64& iterateTime)
+{
+	timespec startTime;
+	timespec endTime;
+	MojSize found = 0;
+	MojSize visited = 0;
+	MojSize expected = 0;
+
+	for (MojObject::ConstArrayIterator i = objs.begin(); i != objs.end(); ++i) {
+		MAP map;
+		startTime.tv_nsec = 0;
+		endTime.tv_nsec = 0;
+		clock_gettime(CLOCK_REALTIME, &startTime);
+		for (MojObject::ConstIterator j = i->begin(); j != i->end(); ++j) {
+			MojErr err = map.put(j.key(), j.value());
+			MojTestErrCheck(err);
+		}
+		clock_gettime(CLOCK_REALTIME, &endTime);
+		putTime += timeDiff(startTime, endTime);
+
+		clock_gettime(CLOCK_REALTIME, &startTime);
+		for (MojObject::ConstIterator j = i->begin(); j != i->end(); ++j) {
+			if (map.contains(j.key()))
+				++found;
+		}
+		clock_gettime(CLOCK_REALTIME, &endTime);
+		getTime += timeDiff(startTime, endTime);
+
+		clock_gettime(CLOCK_REALTIME, &startTime);
+		for (typename MAP::ConstIterator j = map.begin(); j != map.end(); ++j) {
+			if (j.value().type() != MojObject::TypeUndefined)
+				++visited;
+		}
+		clock_gettime(CLOCK_REALTIME, &endTime);
+		iterateTime += timeDiff(startTime, endTime);
+		expected += i->size();
+	}
+	MojTestAssert(found == expected && visited == expected);
+
+	return MojErrNone;
+}
+
+MojErr MojDbPerfObjectTest::timeSerialize(const MojObject::ObjectVec& objs, MojUInt64& writeTime, MojUInt64& readTime)
+{
+	timespec startTime;
+	timespec endTime;
+
+	for (MojObject::ConstArrayIterator i = objs.begin(); i != objs.end(); ++i) {
+		MojObjectWriter writer;
+		startTime.tv_nsec = 0;
+		endTime.tv_nsec = 0;
+		clock_gettime(CLOCK_REALTIME, &startTime);
+		MojErr err = i->visit(writer);
+		MojTestErrCheck(err);
+		clock_gettime(CLOCK_REALTIME, &endTime);
+		writeTime += timeDiff(startTime, endTime);
+
+		MojBuffer::ByteVec bytes;
+		err = writer.buf().toByteVec(bytes);
+		MojTestErrCheck(err);
+
+		MojObjectBuilder builder;
+		clock_gettime(CLOCK_REALTIME, &startTime);
+		err = MojObjectReader::read(builder, bytes.begin(), bytes.size());
+		MojTestErrCheck(err);
+		clock_gettime(CLOCK_REALTIME, &endTime);
+		readTime += timeDiff(startTime, endTime);
+		MojTestAssert(builder.object() == *i);
+	}
+	return MojErrNone;
+}
+
+MojErr MojDbPerfObjectTest::testLoad()
+{
+	MojDb db;
+	MojErr err = MojErrNone;
+
+	if (lazySync()) {
+		err = db.configure(lazySyncConfig());
+		MojTestErrCheck(err);
+	}
+	err = db.open(MojDbTestDir);
+	MojTestErrCheck(err);
+	MojUInt64 putKindTime = 0;
+	err = putKinds(db, putKindTime);
+	MojTestErrCheck(err);
+
+	const MojUInt32 numLoad = MojDbQuery::MaxQueryLimit;
+	for (MojUInt64 i = 0; i < numLoad; ++i) {
+		MojObject obj;
+		err = obj.putString(MojDb::KindKey, MojPerfLgKindId);
+		MojTestErrCheck(err);
+		err = createLargeObj(obj, i);
+		MojTestErrCheck(err);
+		err = db.put(obj);
+		MojTestErrCheck(err);
+	}
+
+	timespec startTime;
+	startTime.tv_nsec = 0;
+	startTime.tv_sec = 0;
+	timespec endTime;
+	endTime.tv_nsec = 0;
+	endTime.tv_sec = 0;
+
+	MojDbQuery query;
+	err = query.from(MojPerfLgKindId);
+	MojTestErrCheck(err);
+	query.limit(numLoad);
+	MojObjectBuilder builder;
+	clock_gettime(CLOCK_REALTIME, &startTime);
+	MojDbCursor cursor;
+	err = db.find(query, cursor);
+	MojTestErrCheck(err);
+	err = cursor.visit(builder);
+	MojTestErrCheck(err);
+	err = cursor.close();
+	MojTestErrCheck(err);
+	clock_gettime(CLOCK_REALTIME, &endTime);
+	MojUInt64 loadTime = timeDiff(startTime, endTime);
+	totalTestTime += loadTime;
+
+	MojUInt64 shared = builder.sharedNameBytes() / numLoad;
+	MojUInt64 copied = builder.copiedNameBytes() / numLoad;
+	err = MojPrintF("   load %u large objects took: %llu nanosecs, prop name bytes per object: %llu shared, %llu copied\n",
+			numLoad, loadTime, shared, copied);
+	MojTestErrCheck(err);
+
+	MojString buf;
+	err = buf.format("load,large,%s,%llu,%llu,%llu,\nprop name bytes per object,large,shared,%llu,,,\nprop name bytes per object,large,copied,%llu,,,\n",
+			ObjectImplName, loadTime, loadTime, loadTime / numLoad, shared, copied);
+	MojTestErrCheck(err);
+	err = fileWrite(file, buf);
+	MojTestErrCheck(err);
+
+	err = db.close();
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbPerfObjectTest::report(const MojChar* op, const MojChar* shape, const MojChar* impl, MojUInt64 time, MojSize numObjs)
+{
+	MojUInt64 numOps = numObjs * numRepetitions;
+	totalTestTime += time;
+
+	MojErr err = MojPrintF("   %s %s objects (%s map) %d times took: %llu nanosecs, %llu nanosecs per object\n",
+			op, shape, impl, (int) numOps, time, time / numOps);
+	MojTestErrCheck(err);
+
+	MojString buf;
+	err = buf.format("%s,%s,%s,%llu,%llu,%llu,\n", op, shape, impl, time, time / numRepetitions, time / numOps);
+	MojTestErrCheck(err);
+	err = fileWrite(file, buf);
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+void MojDbPerfObjectTest::cleanup()
+{
+	(void) MojRmDirRecursive(MojDbTestDir);
+}
@@ -0,0 +1,47 @@
+/* @@@LICENSE
+*
+* Copyright (c) 2014 LG Electronics, Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+#ifndef MOJDBPERFOBJECTTEST_H_
+#define MOJDBPERFOBJECTTEST_H_
+
+#include "MojDbPerfTest.h"
+
+// Compares the property map behind MojObject (red-black tree MojMap) with MojFlatMap
+// for put, get and iterate, and times serialization with the implementation that
+// MojObject was built with (see MOJ_FLAT_OBJECT_MAP). Also reports how many bytes of
+// prop names objects loaded from the db share with interned names rather than copy.
+class MojDbPerfObjectTest : public MojDbPerfTest {
+public:
+	MojDbPerfObjectTest();
+
+	virtual MojErr run();
+	virtual void cleanup();
+
+private:
+	typedef MojErr (MojDbPerfTest::*CreateFn)(MojObject&, MojUInt64);
+
+	MojErr testObjects(const MojChar* shape, CreateFn createFn);
+	MojErr testLoad();
+	template<class MAP>
+	MojErr timeMap(const MojObject::ObjectVec& objs, MojUInt64& putTime, MojUInt64& getTime, MojUInt64& iterateTime);
+	MojErr timeSerialize(const MojObject::ObjectVec& objs, MojUInt64& writeTime, MojUInt64& readTime);
+	MojErr report(const MojChar* op, const MojChar* shape, const MojChar* impl, MojUInt64 time, MojSize numObjs);
+};
+
+#endif /* MOJDBPERFOBJECTTEST_H_ */
@@ -20,11 +20,14 @@
 #include "MojDbPerfReadTest.h"
 #include "db/MojDb.h"
 #include "core/MojJson.h"
+#include "core/MojObjectBuilder.h"
 
 static const MojUInt64 numInsertForGet = 100;
 static const MojUInt64 numInsertForFind = 500;
 static const MojUInt64 numRepetitionsForGet = 100;
 static const MojUInt64 numRepetitionsForFind = 20;
+static const MojUInt32 numSerialize = 50;
+static const MojUInt64 numRepetitionsForSerialize = 200;
 
 extern MojUInt64 allTestsTime;
 static MojUInt64 totalTestTime = 0;
@@ -63,6 +66,8 @@ MojErr MojDbPerfReadTest::run()
 	MojTestErrCheck(err);
 	err = testFindPaged(db);
 	MojTestErrCheck(err);
+	err = testSerialize(db);
+	MojTestErrCheck(err);
 	allTestsTime += totalTestTime;
 
 	err = MojPrintF("\n\n TOTAL TEST TIME: %llu nanoseconds. | %10.3f seconds.\n\n", totalTestTime, totalTestTime / 1000000000.0f);
@@ -177,6 +182,14 @@ MojErr MojDbPerfReadTest::testFindAll(MojDb& db)
 	MojTestErrCheck(err);
 	err = findObjs(db, MojPerfLgArrayKindId, &MojDbPerfTest::createLargeArrayObj, q);
 	MojTestErrCheck(err);
+	err = q.from(MojPerfLgKindZId);
+	MojTestErrCheck(err);
+	err = findObjs(db, MojPerfLgKindZId, &MojDbPerfTest::createLargeObj, q);
+	MojTestErrCheck(err);
+	err = q.from(MojPerfLgArrayKindZId);
+	MojTestErrCheck(err);
+	err = findObjs(db, MojPerfLgArrayKindZId, &MojDbPerfTest::createLargeArrayObj, q);
+	MojTestErrCheck(err);
 
 	err = MojPrintF("\n--------------\n");
 	MojTestErrCheck(err);
@@ -322,6 +335,10 @@ MojErr MojDbPerfReadTest::testGet(MojDb& db)
 	MojTestErrCheck(err);
 	err = getObjs(db, MojPerfLgArrayKindId, &MojDbPerfTest::createLargeArrayObj);
 	MojTestErrCheck(err);
+	err = getObjs(db, MojPerfLgKindZId, &MojDbPerfTest::createLargeObj);
+	MojTestErrCheck(err);
+	err = getObjs(db, MojPerfLgArrayKindZId, &MojDbPerfTest::createLargeArrayObj);
+	MojTestErrCheck(err);
 
 	return MojErrNone;
 }
@@ -958,6 +975,107 @@ MojErr MojDbPerfReadTest::putObjs(MojDb& db, const MojChar* kindId, MojUInt64 nu
 	return MojErrNone;
 }
 
+MojErr MojDbPerfReadTest::testSerialize(MojDb& db)
+{
+	MojErr err = MojPrintF("\n--------------\n");
+	MojTestErrCheck(err);
+	err = MojPrintF("  SERIALIZE RESULTS");
+	MojTestErrCheck(err);
+	err = MojPrintF("\n--------------\n");
+	MojTestErrCheck(err);
+
+	MojString m_buf;
+	err = m_buf.format("\n\nSERIALIZE RESULTS,,,,,\n");
+	MojTestErrCheck(err);
+	err = fileWrite(file, m_buf);
+	MojTestErrCheck(err);
+
+	err = serializeObjs(db, MojPerfSmKindId, &MojDbPerfTest::createSmallObj);
+	MojTestErrCheck(err);
+	err = serializeObjs(db, MojPerfMedKindId, &MojDbPerfTest::createMedObj);
+	MojTestErrCheck(err);
+	err = serializeObjs(db, MojPerfLgKindId, &MojDbPerfTest::createLargeObj);
+	MojTestErrCheck(err);
+	err = serializeObjs(db, MojPerfLgArrayKindId, &MojDbPerfTest::createLargeArrayObj);
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbPerfReadTest::serializeObjs(MojDb& db, const MojChar* kindId, MojErr (MojDbPerfTest::*createFn)(MojObject&, MojUInt64))
+{
+	// register all the kinds
+	MojUInt64 time = 0;
+	MojErr err = putKinds(db, time);
+	MojTestErrCheck(err);
+
+	MojObject ids;
+	err = putObjs(db, kindId, numSerialize, createFn, ids);
+	MojTestErrCheck(err);
+
+	// load one page of results up front so that only the writer is timed
+	MojDbQuery query;
+	err = query.from(kindId);
+	MojTestErrCheck(err);
+	query.limit(numSerialize);
+	MojDbCursor cursor;
+	err = db.find(query, cursor);
+	MojTestErrCheck(err);
+	MojObjectBuilder builder;
+	err = builder.beginArray();
+	MojTestErrCheck(err);
+	err = cursor.visit(builder);
+	MojTestErrCheck(err);
+	err = builder.endArray();
+	MojTestErrCheck(err);
+	err = cursor.close();
+	MojTestErrCheck(err);
+	const MojObject& results = builder.object();
+	MojUInt64 numObjs = results.size();
+	MojTestAssert(numObjs > 0);
+
+	// one writer for every reply, reset in between, the way a service message reuses it
+	timespec startTime;
+	startTime.tv_nsec = 0;
+	startTime.tv_sec = 0;
+	timespec endTime;
+	endTime.tv_nsec = 0;
+	endTime.tv_sec = 0;
+	MojJsonWriter writer;
+	MojUInt64 serializeTime = 0;
+	MojSize replyLen = 0;
+	for (MojUInt64 i = 0; i < numRepetitionsForSerialize; i++) {
+		clock_gettime(CLOCK_REALTIME, &startTime);
+		err = results.visit(writer);
+		MojTestErrCheck(err);
+		replyLen = writer.json().length();
+		err = writer.reset();
+		MojTestErrCheck(err);
+		clock_gettime(CLOCK_REALTIME, &endTime);
+		serializeTime += timeDiff(startTime, endTime);
+	}
+	totalTestTime += serializeTime;
+
+	err = MojPrintF("\n -------------------- \n");
+	MojTestErrCheck(err);
+	err = MojPrintF("   time to serialize %llu objects of kind %s (%zu bytes) %llu times: %llu nanosecs\n",
+			numObjs, kindId, replyLen, numRepetitionsForSerialize, serializeTime);
+	MojTestErrCheck(err);
+	err = MojPrintF("   time per object: %llu nanosecs", serializeTime / (numObjs * numRepetitionsForSerialize));
+	MojTestErrCheck(err);
+	err = MojPrintF("\n\n");
+	MojTestErrCheck(err);
+
+	MojString m_buf;
+	err = m_buf.format("Serialize %llu objects (%zu bytes) %llu times,%s,%llu,%llu,%llu,\n", numObjs, replyLen, numRepetitionsForSerialize, kindId,
+			serializeTime, serializeTime/numRepetitionsForSerialize, serializeTime/(numObjs*numRepetitionsForSerialize));
+	MojTestErrCheck(err);
+	err = fileWrite(file, m_buf);
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
 void MojDbPerfReadTest::cleanup()
 {
 	(void) MojRmDirRecursive(MojDbTestDir);
@@ -19,6 +19,7 @@
 
 #include "MojDbPerfTest.h"
 #include "db/MojDb.h"
+#include "db/MojDbKind.h"
 #include "core/MojTime.h"
 
 #include <time.h>
@@ -120,6 +121,18 @@ const MojChar* const MojDbPerfTest::MojPerfLgArrayKind2Str =
 	_T("{\"id\":\"LgArrayKind2:1\",")
 	_T("\"owner\":\"mojodb.admin\",")
 	_T("\"indexes\":[{\"name\":\"names_first\",\"props\":[{\"name\":\"names\"},{\"name\":\"first\"}]}]}");
+const MojChar* const MojDbPerfTest::MojPerfLgKindZId = _T("LgKindZ:1");
+const MojChar* const MojDbPerfTest::MojPerfLgKindZStr =
+	_T("{\"id\":\"LgKindZ:1\",")
+	_T("\"owner\":\"mojodb.admin\",")
+	_T("\"compress\":true,")
+	_T("\"indexes\":[{\"name\":\"first\",\"props\":[{\"name\":\"first\"}]}]}");
+const MojChar* const MojDbPerfTest::MojPerfLgArrayKindZId = _T("LgArrayKindZ:1");
+const MojChar* const MojDbPerfTest::MojPerfLgArrayKindZStr =
+	_T("{\"id\":\"LgArrayKindZ:1\",")
+	_T("\"owner\":\"mojodb.admin\",")
+	_T("\"compress\":true,")
+	_T("\"indexes\":[{\"name\":\"names\",\"props\":[{\"name\":\"names\"}]}]}");
 
 const MojChar* const MojDbPerfTest::MojPerfSmKindExtraIndex =
 		_T("{\"name\":\"timestamp\",\"props\":[{\"name\":\"timestamp\"}]}");
@@ -229,6 +242,18 @@ MojErr MojDbPerfTest::putKinds(MojDb& db, MojUInt64& putKindTime)
 	err = timePutKind(db, putKindTime, kind14);
 	MojTestErrCheck(err);
 
+	MojObject kind15;
+	err = kind15.fromJson(MojPerfLgKindZStr);
+	MojTestErrCheck(err);
+	err = timePutKind(db, putKindTime, kind15);
+	MojTestErrCheck(err);
+
+	MojObject kind16;
+	err = kind16.fromJson(MojPerfLgArrayKindZStr);
+	MojTestErrCheck(err);
+	err = timePutKind(db, putKindTime, kind16);
+	MojTestErrCheck(err);
+
 	return MojErrNone;
 }
 
@@ -319,6 +344,37 @@ MojErr MojDbPerfTest::delKinds(MojDb& db)
 	err = db.delKind(kind14Id, found);
 	MojTestErrCheck(err);
 
+	MojString kind15Id;
+	err = kind15Id.assign(MojPerfLgKindZId);
+	MojTestErrCheck(err);
+	err = db.delKind(kind15Id, found);
+	MojTestErrCheck(err);
+
+	MojString kind16Id;
+	err = kind16Id.assign(MojPerfLgArrayKindZId);
+	MojTestErrCheck(err);
+	err = db.delKind(kind16Id, found);
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbPerfTest::storedSize(MojDb& db, const MojChar* kindId, MojInt64& sizeOut)
+{
+	// bytes the kind's objects take in the object db, as reported by stats
+	MojString id;
+	MojErr err = id.assign(kindId);
+	MojTestErrCheck(err);
+	MojObject stats;
+	err = db.stats(stats, MojDbReq(), false, &id);
+	MojTestErrCheck(err);
+	MojObject kindStats;
+	MojTestAssert(stats.get(kindId, kindStats));
+	MojObject objStats;
+	MojTestAssert(kindStats.get(MojDbKind::ObjectsKey, objStats));
+	sizeOut = 0;
+	objStats.get(MojDbKind::SizeKey, sizeOut);
+
 	return MojErrNone;
 }
 
@@ -548,6 +604,30 @@ MojUInt64 MojDbPerfTest::timeDiff(timespec start, timespec end)
 	return temp.tv_sec * 1000000000 + temp.tv_nsec;
 }
 
+// sorts the latencies (in nanoseconds) and puts their count and nearest-rank percentiles into statsOut
+MojErr MojDbPerfTest::latencyStats(LatencyVec& latencies, MojObject& statsOut)
+{
+	static const MojSize percentiles[] = {50, 95, 99};
+	static const MojChar* const percentileKeys[] = {_T("p50Ns"), _T("p95Ns"), _T("p99Ns")};
+
+	MojSize numOps = latencies.size();
+	MojErr err = statsOut.putInt(_T("ops"), (MojInt64) numOps);
+	MojTestErrCheck(err);
+	if (numOps == 0)
+		return MojErrNone;
+
+	LatencyVec::Iterator begin;
+	err = latencies.begin(begin);
+	MojTestErrCheck(err);
+	MojQuickSort(begin, numOps);
+	for (MojSize i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); ++i) {
+		MojSize rank = (numOps * percentiles[i] + 99) / 100;
+		err = statsOut.putInt(percentileKeys[i], (MojInt64) latencies.at(rank > 0 ? rank - 1 : 0));
+		MojTestErrCheck(err);
+	}
+	return MojErrNone;
+}
+
 MojObject MojDbPerfTest::lazySyncConfig() const
 {
     MojObject conf;
@@ -27,6 +27,8 @@
 
 class MojDbPerfTest : public MojTestCase {
 public:
+	typedef MojVector<MojUInt64> LatencyVec;
+
 	MojDbPerfTest(const MojChar* name);
 
 	virtual MojErr run() = 0;
@@ -45,8 +47,10 @@ public:
 	MojErr createLargeArrayObj(MojObject& obj, MojUInt64 i);
 
 	MojErr fileWrite(MojFile& file, MojString buf);
+	MojErr storedSize(MojDb& db, const MojChar* kindId, MojInt64& sizeOut);
 	
 	MojUInt64 timeDiff(timespec start, timespec end);
+	MojErr latencyStats(LatencyVec& latencies, MojObject& statsOut);
 
     MojObject lazySyncConfig() const;
     bool lazySync() const { return m_lazySync; }
@@ -83,6 +87,11 @@ public:
 	static const MojChar* const MojPerfMedArrayKind2Str;
 	static const MojChar* const MojPerfLgArrayKind2Id;
 	static const MojChar* const MojPerfLgArrayKind2Str;
+	// same as LgKind/LgArrayKind, but with compressed values
+	static const MojChar* const MojPerfLgKindZId;
+	static const MojChar* const MojPerfLgKindZStr;
+	static const MojChar* const MojPerfLgArrayKindZId;
+	static const MojChar* const MojPerfLgArrayKindZStr;
 	static const MojChar* const MojPerfSmKindExtraIndex;
 	static const MojChar* const MojPerfMedKindExtraIndex;
 	static const MojChar* const MojPerfLgKindExtraIndex;
@@ -91,7 +100,7 @@ public:
 	static const MojChar* const MojPerfMedArrayKindExtraIndex;
 	static const MojChar* const MojPerfLgArrayKindExtraIndex;
 
-	static const MojUInt64 numKinds = 14;
+	static const MojUInt64 numKinds = 16;
 };
 
 
@@ -23,6 +23,10 @@
 #include "MojDbPerfUpdateTest.h"
 #include "MojDbPerfDeleteTest.h"
 #include "MojDbPerfIndexTest.h"
+#include "MojDbPerfObjectTest.h"
+#include "MojDbPerfBenchmark.h"
+#include "MojDbPerfConcurrencyTest.h"
+#include "core/MojUtil.h"
 
 
 MojString getTestDir()
@@ -52,6 +56,153 @@ void MojDbPerfTestRunner::runTests()
 	test(MojDbPerfReadTest());
 	test(MojDbPerfUpdateTest());
 	test(MojDbPerfDeleteTest());
+	test(MojDbPerfObjectTest());
+	test(MojDbPerfBenchmark(m_benchOptions, m_benchResults));
+	test(MojDbPerfConcurrencyTest(m_benchOptions, m_benchResults));
 	MojDouble res = allTestsTime / 1000000000.0f;
 	(void) MojPrintF("\n\n ALL TESTS FINISHED. TIME ELAPSED: %10.3f seconds.\n\n", res);
+
+	MojErr err = writeBenchmarkResults();
+	if (err != MojErrNone)
+		(void) displayErr(err, _T("error writing benchmark results"));
+}
+
+MojErr MojDbPerfTestRunner::writeBenchmarkResults()
+{
+	if (m_benchResults.empty())
+		return MojErrNone;
+
+	MojString json;
+	MojErr err = m_benchResults.toJson(json);
+	MojErrCheck(err);
+	if (m_benchOptions.m_outPath.empty()) {
+		err = MojPrintF(_T("%s\n"), json.data());
+		MojErrCheck(err);
+	} else {
+		err = MojFileFromString(m_benchOptions.m_outPath, json);
+		MojErrCheck(err);
+	}
+	return MojErrNone;
+}
+
+MojErr MojDbPerfTestRunner::init()
+{
+	MojErr err = MojTestRunner::init();
+	MojErrCheck(err);
+	err = registerOption((OptionHandler) &MojDbPerfTestRunner::handleSeed, _T("-s"),
+			_T("Seed for the benchmark data and access order."), true);
+	MojErrCheck(err);
+	err = registerOption((OptionHandler) &MojDbPerfTestRunner::handleCount, _T("-n"),
+			_T("Number of objects in the benchmark data set."), true);
+	MojErrCheck(err);
+	err = registerOption((OptionHandler) &MojDbPerfTestRunner::handleOutput, _T("-o"),
+			_T("Write benchmark results as JSON to this file instead of stdout."), true);
+	MojErrCheck(err);
+	err = registerOption((OptionHandler) &MojDbPerfTestRunner::handleBaseline, _T("-b"),
+			_T("Fail if the benchmark regressed against the results in this file."), true);
+	MojErrCheck(err);
+	err = registerOption((OptionHandler) &MojDbPerfTestRunner::handleThreshold, _T("-t"),
+			_T("Allowed benchmark regression in percent (default 10)."), true);
+	MojErrCheck(err);
+	err = registerOption((OptionHandler) &MojDbPerfTestRunner::handleThreads, _T("-c"),
+			_T("Maximum number of client threads in the concurrency benchmark (default 8)."), true);
+	MojErrCheck(err);
+	err = registerOption((OptionHandler) &MojDbPerfTestRunner::handleWritePercent, _T("-w"),
+			_T("Percentage of writes in the concurrency benchmark (default 20)."), true);
+	MojErrCheck(err);
+	err = registerOption((OptionHandler) &MojDbPerfTestRunner::handleHotPercent, _T("-z"),
+			_T("Percentage of concurrency benchmark operations on the hottest tenth of the keys (default 0, uniform)."), true);
+	MojErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbPerfTestRunner::handleSeed(const MojString& opt, const MojString& val)
+{
+	MojInt64 num = 0;
+	MojErr err = parseNumber(opt, val, num);
+	MojErrCheck(err);
+	m_benchOptions.m_seed = (MojUInt32) num;
+
+	return MojErrNone;
+}
+
+MojErr MojDbPerfTestRunner::handleCount(const MojString& opt, const MojString& val)
+{
+	MojInt64 num = 0;
+	MojErr err = parseNumber(opt, val, num);
+	MojErrCheck(err);
+	if (num == 0)
+		MojErrThrowMsg(MojErrInvalidArg, _T("%s: count must be positive"), opt.data());
+	m_benchOptions.m_count = (MojUInt64) num;
+
+	return MojErrNone;
+}
+
+MojErr MojDbPerfTestRunner::handleOutput(const MojString& opt, const MojString& val)
+{
+	m_benchOptions.m_outPath = val;
+	return MojErrNone;
+}
+
+MojErr MojDbPerfTestRunner::handleBaseline(const MojString& opt, const MojString& val)
+{
+	m_benchOptions.m_baselinePath = val;
+	return MojErrNone;
+}
+
+MojErr MojDbPerfTestRunner::handleThreshold(const MojString& opt, const MojString& val)
+{
+	MojInt64 num = 0;
+	MojErr err = parseNumber(opt, val, num);
+	MojErrCheck(err);
+	if (num >= 100)
+		MojErrThrowMsg(MojErrInvalidArg, _T("%s: threshold must be below 100"), opt.data());
+	m_benchOptions.m_threshold = num;
+
+	return MojErrNone;
+}
+
+MojErr MojDbPerfTestRunner::handleThreads(const MojString& opt, const MojString& val)
+{
+	MojInt64 num = 0;
+	MojErr err = parseNumber(opt, val, num);
+	MojErrCheck(err);
+	if (num == 0 || num > MojUInt32Max)
+		MojErrThrowMsg(MojErrInvalidArg, _T("%s: invalid number of threads"), opt.data());
+	m_benchOptions.m_maxThreads = (MojUInt32) num;
+
+	return MojErrNone;
+}
+
+MojErr MojDbPerfTestRunner::handleWritePercent(const MojString& opt, const MojString& val)
+{
+	return parsePercent(opt, val, m_benchOptions.m_writePercent);
+}
+
+MojErr MojDbPerfTestRunner::handleHotPercent(const MojString& opt, const MojString& val)
+{
+	return parsePercent(opt, val, m_benchOptions.m_hotPercent);
+}
+
+MojErr MojDbPerfTestRunner::parsePercent(const MojString& opt, const MojString& val, MojUInt32& percentOut)
+{
+	MojInt64 num = 0;
+	MojErr err = parseNumber(opt, val, num);
+	MojErrCheck(err);
+	if (num > 100)
+		MojErrThrowMsg(MojErrInvalidArg, _T("%s: percentage must not exceed 100"), opt.data());
+	percentOut = (MojUInt32) num;
+
+	return MojErrNone;
+}
+
+MojErr MojDbPerfTestRunner::parseNumber(const MojString& opt, const MojString& val, MojInt64& numOut)
+{
+	const MojChar* end = NULL;
+	numOut = MojStrToInt64(val.data(), &end, 10);
+	if (val.empty() || *end != _T('\0') || numOut < 0)
+		MojErrThrowMsg(MojErrInvalidArg, _T("%s: invalid number '%s'"), opt.data(), val.data());
+
+	return MojErrNone;
 }
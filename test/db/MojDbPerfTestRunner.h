@@ -21,14 +21,55 @@
 #define MOJDBPERFTESTRUNNER_H_
 
 #include "db/MojDbDefs.h"
+#include "core/MojObject.h"
+#include "core/MojString.h"
 #include "core/MojTestRunner.h"
 
 extern const MojChar* const MojDbTestDir;
 
 class MojDbPerfTestRunner : public MojTestRunner
 {
+public:
+	// settings for the benchmarks, taken from the command line
+	struct BenchmarkOptions {
+		BenchmarkOptions()
+		: m_seed(DefaultSeed), m_count(DefaultCount), m_threshold(DefaultThreshold),
+		  m_maxThreads(DefaultMaxThreads), m_writePercent(DefaultWritePercent), m_hotPercent(0) {}
+
+		MojUInt32 m_seed;
+		MojUInt64 m_count;			// objects in the data set
+		MojInt64 m_threshold;		// allowed regression against the baseline, in percent
+		MojString m_outPath;		// results go to stdout if empty
+		MojString m_baselinePath;	// no comparison if empty
+		MojUInt32 m_maxThreads;		// client threads in the concurrency benchmark
+		MojUInt32 m_writePercent;	// share of puts and merges in the concurrency benchmark
+		MojUInt32 m_hotPercent;		// share of operations on the hottest tenth of the keys
+	};
+	static const MojUInt32 DefaultSeed = 42;
+	static const MojUInt64 DefaultCount = 1000;
+	static const MojInt64 DefaultThreshold = 10;
+	static const MojUInt32 DefaultMaxThreads = 8;
+	static const MojUInt32 DefaultWritePercent = 20;
+
+	virtual MojErr init();
+
 private:
 	void runTests();
+
+	MojErr handleSeed(const MojString& opt, const MojString& val);
+	MojErr handleCount(const MojString& opt, const MojString& val);
+	MojErr handleOutput(const MojString& opt, const MojString& val);
+	MojErr handleBaseline(const MojString& opt, const MojString& val);
+	MojErr handleThreshold(const MojString& opt, const MojString& val);
+	MojErr handleThreads(const MojString& opt, const MojString& val);
+	MojErr handleWritePercent(const MojString& opt, const MojString& val);
+	MojErr handleHotPercent(const MojString& opt, const MojString& val);
+	MojErr parsePercent(const MojString& opt, const MojString& val, MojUInt32& percentOut);
+	MojErr writeBenchmarkResults();
+	MojErr parseNumber(const MojString& opt, const MojString& val, MojInt64& numOut);
+
+	BenchmarkOptions m_benchOptions;
+	MojObject m_benchResults;
 };
 
 #endif /* MOJDBPERFTESTRUNNER_H_ */
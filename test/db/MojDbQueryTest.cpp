@@ -51,6 +51,10 @@ static const MojChar* const MojKind5Str =
 	_T("{\"id\":\"QueryTest5:1\",")
 	_T("\"owner\":\"mojodb.admin\",")
 	_T("\"indexes\":[{\"name\":\"foo\",\"props\":[{\"name\":\"foo\"}],\"incDel\":true}]}");
+static const MojChar* const MojKind6Str =
+	_T("{\"id\":\"QueryTest6:1\",")
+	_T("\"owner\":\"mojodb.admin\",")
+	_T("\"indexes\":[{\"name\":\"foo\",\"props\":[{\"name\":\"foo\"}]}]}");
 
 static const MojChar* const MojNestedObjStr =
 	_T("{\"foobar\":\"nested string\"}");
@@ -128,6 +132,8 @@ MojErr MojDbQueryTest::run()
 	MojTestErrCheck(err);
 	err = basicTest();
 	MojTestErrCheck(err);
+	err = liveCountTest();
+	MojTestErrCheck(err);
 	err = invalidTest();
 	MojTestErrCheck(err);
 
@@ -1778,6 +1784,134 @@ MojErr MojDbQueryTest::checkInvalid(const MojChar* queryJson, MojErr expectedErr
 	return MojErrNone;
 }
 
+MojErr MojDbQueryTest::liveCountTest()
+{
+	MojDb db;
+	MojErr err = db.open(MojDbTestDir);
+	MojTestErrCheck(err);
+	MojObject kindObj;
+	err = kindObj.fromJson(MojKind6Str);
+	MojTestErrCheck(err);
+	err = db.putKind(kindObj);
+	MojTestErrCheck(err);
+
+	MojObject ids;
+	for (int i = 0; i < 20; ++i) {
+		MojObject obj;
+		err = obj.putString(MojDb::KindKey, _T("QueryTest6:1"));
+		MojTestErrCheck(err);
+		err = obj.putInt(_T("foo"), i);
+		MojTestErrCheck(err);
+		err = db.put(obj);
+		MojTestErrCheck(err);
+		MojObject id;
+		err = obj.getRequired(MojDb::IdKey, id);
+		MojTestErrCheck(err);
+		err = ids.push(id);
+		MojTestErrCheck(err);
+	}
+
+	// a query without clauses is answered from the stored count, one with a
+	// clause by walking the index, so the two have to agree
+	MojDbQuery allQuery;
+	err = allQuery.from(_T("QueryTest6:1"));
+	MojTestErrCheck(err);
+	MojDbQuery fooQuery;
+	err = fooQuery.from(_T("QueryTest6:1"));
+	MojTestErrCheck(err);
+	err = fooQuery.where(_T("foo"), MojDbQuery::OpGreaterThanEq, 0);
+	MojTestErrCheck(err);
+	err = checkCount(db, allQuery, 20);
+	MojTestErrCheck(err);
+	err = checkCount(db, fooQuery, 20);
+	MojTestErrCheck(err);
+
+	// deleted objects are not counted
+	for (int i = 0; i < 5; ++i) {
+		bool found = false;
+		err = db.del(ids.arrayBegin()[i], found);
+		MojTestErrCheck(err);
+		MojTestAssert(found);
+	}
+	err = checkCount(db, allQuery, 15);
+	MojTestErrCheck(err);
+	err = checkCount(db, fooQuery, 15);
+	MojTestErrCheck(err);
+
+	// puts in an open txn are seen by that txn only, and are dropped on abort
+	MojDbReq req;
+	req.beginBatch();
+	for (int i = 0; i < 3; ++i) {
+		MojObject obj;
+		err = obj.putString(MojDb::KindKey, _T("QueryTest6:1"));
+		MojTestErrCheck(err);
+		err = obj.putInt(_T("foo"), 100 + i);
+		MojTestErrCheck(err);
+		err = db.put(obj, MojDb::FlagNone, req);
+		MojTestErrCheck(err);
+	}
+	err = checkCount(db, allQuery, 18, req);
+	MojTestErrCheck(err);
+	err = req.abort();
+	MojTestErrCheck(err);
+	err = req.endBatch();
+	MojTestErrCheck(err);
+	err = checkCount(db, allQuery, 15);
+	MojTestErrCheck(err);
+
+	// purging already deleted objects leaves the count alone
+	MojUInt32 purgeCount = 0;
+	err = db.purge(purgeCount, 0);
+	MojTestErrCheck(err);
+	err = checkCount(db, allQuery, 15);
+	MojTestErrCheck(err);
+
+	// and the count survives a reopen
+	err = db.close();
+	MojTestErrCheck(err);
+	err = db.open(MojDbTestDir);
+	MojTestErrCheck(err);
+	err = checkCount(db, allQuery, 15);
+	MojTestErrCheck(err);
+	err = checkCount(db, fooQuery, 15);
+	MojTestErrCheck(err);
+
+	// dropping a kind with live objects takes its counts with it
+	MojString kindId;
+	err = kindId.assign(_T("QueryTest6:1"));
+	MojTestErrCheck(err);
+	bool found = false;
+	err = db.delKind(kindId, found);
+	MojTestErrCheck(err);
+	MojTestAssert(found);
+	err = db.putKind(kindObj);
+	MojTestErrCheck(err);
+	err = checkCount(db, allQuery, 0);
+	MojTestErrCheck(err);
+	err = checkCount(db, fooQuery, 0);
+	MojTestErrCheck(err);
+
+	err = db.close();
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbQueryTest::checkCount(MojDb& db, const MojDbQuery& query, MojUInt32 expected, MojDbReqRef req)
+{
+	MojDbCursor cursor;
+	MojErr err = db.find(query, cursor, req);
+	MojTestErrCheck(err);
+	MojUInt32 count = 0;
+	err = cursor.count(count);
+	MojTestErrCheck(err);
+	MojTestAssert(count == expected);
+	err = cursor.close();
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
 void MojDbQueryTest::cleanup()
 {
 	(void) MojRmDirRecursive(MojDbTestDir);
@@ -22,6 +22,7 @@
 
 #include "MojDbTestRunner.h"
 #include "db/MojDbQuery.h"
+#include "db/MojDbReq.h"
 
 class MojDbQueryTest : public MojTestCase
 {
@@ -35,6 +36,8 @@ private:
 	typedef MojSet<MojObject> ObjectSet;
 
 	MojErr basicTest();
+	MojErr liveCountTest();
+	MojErr checkCount(MojDb& db, const MojDbQuery& query, MojUInt32 expected, MojDbReqRef req = MojDbReq());
 	MojErr eqTest(MojDb& db);
 	MojErr neqTest(MojDb& db);
 	MojErr ltTest(MojDb& db);
@@ -51,6 +51,14 @@ static const MojChar* const MojTestKind3Str2 =
 	_T("{\"id\":\"Test3:1\",")
 	_T("\"owner\":\"com.bar\"}");
 
+static const MojChar* const MojTestDeferKindStrs[] = {
+	_T("{\"id\":\"DeferA:1\",\"owner\":\"com.foo.defer\",")
+	_T("\"indexes\":[{\"name\":\"foo\",\"props\":[{\"name\":\"foo\"}]}]}"),
+	_T("{\"id\":\"DeferB:1\",\"owner\":\"com.foo.defer\",")
+	_T("\"indexes\":[{\"name\":\"foo\",\"props\":[{\"name\":\"foo\"}]}]}"),
+	NULL
+};
+
 static const MojChar* MojTestKind1Objects[] = {
 	_T("{\"_id\":1,\"_kind\":\"Test:1\",\"foo\":\"cote\"}"),
 	_T("{\"_id\":2,\"_kind\":\"Test:1\",\"foo\":\"coté\"}"),
@@ -102,6 +110,8 @@ MojErr MojDbQuotaTest::run()
 	MojTestErrCheck(err);
 	err = testEnforce(db);
 	MojTestErrCheck(err);
+	err = testDeferredKeys(db);
+	MojTestErrCheck(err);
 
 	err = db.close();
 	MojErrCheck(err);
@@ -352,6 +362,60 @@ MojErr MojDbQuotaTest::testEnforce(MojDb& db)
 	return MojErrNone;
 }
 
+MojErr MojDbQuotaTest::testDeferredKeys(MojDb& db)
+{
+	MojObject obj;
+	MojErr err = obj.fromJson(_T("{\"owner\":\"com.foo.defer\",\"size\":100000}"));
+	MojTestErrCheck(err);
+	err = db.putQuotas(&obj, &obj + 1);
+	MojTestErrCheck(err);
+	for (const MojChar* const* i = MojTestDeferKindStrs; *i; ++i) {
+		err = obj.fromJson(*i);
+		MojTestErrCheck(err);
+		err = db.putKind(obj);
+		MojTestErrCheck(err);
+	}
+
+	// put one object of each kind in a txn, first writing index keys as they come and then
+	// deferring them to commit, by which time the second kind is the current one
+	MojInt64 offsets[2][2];
+	for (int defer = 0; defer < 2; ++defer) {
+		MojInt64 before[2];
+		err = getKindUsage(db, _T("DeferA:1"), before[0]);
+		MojTestErrCheck(err);
+		err = getKindUsage(db, _T("DeferB:1"), before[1]);
+		MojTestErrCheck(err);
+
+		MojDbReq req;
+		err = req.begin(&db, false);
+		MojTestErrCheck(err);
+		req.txn()->deferIndexKeys(defer != 0);
+		err = obj.fromJson(_T("{\"_kind\":\"DeferA:1\",\"foo\":\"cote\"}"));
+		MojTestErrCheck(err);
+		err = db.put(obj, MojDb::FlagNone, req);
+		MojTestErrCheck(err);
+		err = obj.fromJson(_T("{\"_kind\":\"DeferB:1\",\"foo\":\"cote\"}"));
+		MojTestErrCheck(err);
+		err = db.put(obj, MojDb::FlagNone, req);
+		MojTestErrCheck(err);
+		err = req.end();
+		MojTestErrCheck(err);
+
+		MojInt64 after[2];
+		err = getKindUsage(db, _T("DeferA:1"), after[0]);
+		MojTestErrCheck(err);
+		err = getKindUsage(db, _T("DeferB:1"), after[1]);
+		MojTestErrCheck(err);
+		offsets[defer][0] = after[0] - before[0];
+		offsets[defer][1] = after[1] - before[1];
+	}
+	// deferred keys are charged to the kind that made them
+	MojTestAssert(offsets[1][0] == offsets[0][0]);
+	MojTestAssert(offsets[1][1] == offsets[0][1]);
+
+	return MojErrNone;
+}
+
 MojErr MojDbQuotaTest::testErrors()
 {
 	MojErr err;
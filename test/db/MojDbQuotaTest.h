@@ -34,6 +34,7 @@ private:
 	MojErr testUsage(MojDb& db);
 	MojErr testMultipleQuotas(MojDb& db);
 	MojErr testEnforce(MojDb& db);
+	MojErr testDeferredKeys(MojDb& db);
 	MojErr testErrors();
 	MojErr put(MojDb& db, const MojChar* objJson);
 	MojErr getKindUsage(MojDb& db, const MojChar* kindId, MojInt64& usageOut);
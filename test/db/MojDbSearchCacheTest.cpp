@@ -81,6 +81,9 @@ MojErr MojDbSearchCacheTest::run()
     err = operatorTest(db);
     MojTestErrCheck(err);
 
+    err = lruTest();
+    MojTestErrCheck(err);
+
     /*** :: TODO :: make query scenario
     err = queryTest(db);
     MojTestErrCheck(err);
@@ -259,30 +262,13 @@ MojErr MojDbSearchCacheTest::operatorTest(MojDb& db)
     err = cache->createCache(key2, ids2);
     MojTestErrCheck(err);
 
-    /*** :: For debug ::
-    for(MojDbSearchCache::Container::const_iterator i = cache->container().begin(); i != cache->container().end(); ++i) {
-        MojString str1, str2;
-        MojObject obj;
-        MojUInt32 rev = i->first.getRev();
-        str1 = i->first.getQuery();
-        for(MojDbSearchCache::IdSet::ConstIterator it = i->second.begin(); it != i->second.end(); ++it) {
-            err = it->toJson(str2);
-            MojTestErrCheck(err);
-        }
-
-        printf("key(rev, query) : (%d, %s), ids : %s\n", rev, str1.data(), str2.data());
-    }
-    ***/
-
-    MojTestAssert(cache->container().count(key1) == 1);
-    MojTestAssert(cache->container().size() == 1);
+    MojTestAssert(cache->size() == 1);
     MojTestAssert(cache->contain(key1) == true);
 
     // nothing to update -> no-op
     err = cache->updateCache(key1, ids1);
     MojTestErrCheck(err);
-    MojTestAssert(cache->container().count(key1) == 1);
-    MojTestAssert(cache->container().size() == 1);
+    MojTestAssert(cache->size() == 1);
     MojTestAssert(cache->contain(key1) == true);
 
     err = query1.from(_T("test.cache:1"));
@@ -292,10 +278,11 @@ MojErr MojDbSearchCacheTest::operatorTest(MojDb& db)
     key3.setRev(rev);
     key3.setQuery(query1);
 
-    // key is changed, but kind is same --> update cache
+    // query is changed, but kind and revision are same --> both queries are cached
     err = cache->updateCache(key3, ids1);
-    MojTestAssert(cache->container().count(key3) == 1);
-    MojTestAssert(cache->container().size() == 1);
+    MojTestErrCheck(err);
+    MojTestAssert(cache->size() == 2);
+    MojTestAssert(cache->contain(key1) == true);
     MojTestAssert(cache->contain(key3) == true);
 
     err = query2.from(_T("test.update:1"));
@@ -309,16 +296,90 @@ MojErr MojDbSearchCacheTest::operatorTest(MojDb& db)
     // key is changed -> update cache(add new cache because it is owned by different kind)
     err = cache->updateCache(key4, ids1);
     MojTestErrCheck(err);
-    MojTestAssert(cache->container().count(key4) == 1);
-    MojTestAssert(cache->container().size() == 2);
+    MojTestAssert(cache->size() == 3);
     MojTestAssert(cache->contain(key4) == true);
 
     //delete the cache added
     err = cache->destroyCache(key4);
     MojTestErrCheck(err);
-    MojTestAssert(cache->container().count(key4) == 0);
-    MojTestAssert(cache->container().size() == 1);
+    MojTestAssert(cache->size() == 2);
     MojTestAssert(cache->contain(key4) == false);
 
+    // a newer revision of the kind drops both entries built from the old one
+    key4.setRev(rev + 1);
+    key4.setQuery(query);
+    err = cache->updateCache(key4, ids1);
+    MojTestErrCheck(err);
+    MojTestAssert(cache->size() == 1);
+    MojTestAssert(cache->contain(key1) == false);
+    MojTestAssert(cache->contain(key3) == false);
+
+    delete cache;
+
+    return MojErrNone;
+}
+
+MojErr MojDbSearchCacheTest::lruTest()
+{
+    MojDbSearchCache cache;
+    MojObject conf;
+    MojErr err = conf.put(MojDbSearchCache::MaxBytesKey, (MojInt64) 4096);
+    MojTestErrCheck(err);
+    err = cache.configure(conf);
+    MojTestErrCheck(err);
+
+    MojDbSearchCache::IdSet ids;
+    const char *nameArray[] = { "Junku", "Hongbin", "Hyungjoon", "Seonghwan", "Steve" };
+    err = prepareIdSet(ids, nameArray, (sizeof(nameArray)/sizeof(nameArray[0])));
+    MojTestErrCheck(err);
+
+    // fill well past the budget; the oldest entries are evicted
+    MojDbSearchCache::QueryKey firstKey;
+    MojDbSearchCache::QueryKey lastKey;
+    for (int i = 0; i < 100; ++i) {
+        MojDbQuery query;
+        err = query.from(_T("test.lru:1"));
+        MojTestErrCheck(err);
+        err = query.where(_T("attr1"), MojDbQuery::OpEq, i);
+        MojTestErrCheck(err);
+        MojDbSearchCache::QueryKey key;
+        err = key.fromQuery(query, 1);
+        MojTestErrCheck(err);
+        err = cache.createCache(key, ids);
+        MojTestErrCheck(err);
+        if (i == 0)
+            firstKey = key;
+        lastKey = key;
+
+        // keep the first entry hot
+        bool found = false;
+        MojDbSearchCache::IdSet result;
+        err = cache.getIdSet(firstKey, result, found);
+        MojTestErrCheck(err);
+    }
+    MojTestAssert(cache.bytes() <= cache.maxBytes());
+    MojTestAssert(cache.size() < 100);
+    MojTestAssert(cache.contain(firstKey));
+    MojTestAssert(cache.contain(lastKey));
+
+    // an update of the kind invalidates everything cached for it
+    MojString kind;
+    err = kind.assign(_T("test.lru:1"));
+    MojTestErrCheck(err);
+    err = cache.invalidate(kind, 2);
+    MojTestErrCheck(err);
+    MojTestAssert(cache.size() == 0);
+    MojTestAssert(cache.bytes() == 0);
+
+    MojObject stats;
+    err = cache.stats(stats);
+    MojTestErrCheck(err);
+    MojInt64 hits = 0;
+    MojInt64 evictions = 0;
+    MojInt64 invalidations = 0;
+    MojTestAssert(stats.get(_T("hits"), hits) && hits == 100);
+    MojTestAssert(stats.get(_T("evictions"), evictions) && evictions > 0);
+    MojTestAssert(stats.get(_T("invalidations"), invalidations) && invalidations > 0);
+
     return MojErrNone;
 }
@@ -33,6 +33,7 @@ public:
 
 private:
     MojErr operatorTest(MojDb& db);
+    MojErr lruTest();
 
     MojErr testQueryKey();
     MojErr testCache();
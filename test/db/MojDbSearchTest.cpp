@@ -67,6 +67,13 @@ static const MojChar* const MojSearchTestObjects2[] = {
     _T("{\"_id\":\"++IWp1fmm1ggMvpb\",\"_kind\":\"SearchTest:2\",\"foo\":\"carap\"}")
 };
 
+static const MojChar* const MojSearchKindStr3 =
+    _T("{\"id\":\"SearchTest:3\",")
+    _T("\"owner\":\"mojodb.admin\",")
+    _T("\"indexes\":[")
+        _T("{\"name\":\"foo\",\"props\":[{\"name\":\"foo\",\"tokenize\":\"all\",\"collate\":\"primary\"}]}")
+    _T("]}");
+static const MojInt64 MojSearchLargeCount = 10050;
 
 MojDbSearchTest::MojDbSearchTest()
 : MojTestCase(_T("MojDbSearch"))
@@ -117,6 +124,62 @@ MojErr MojDbSearchTest::run()
     err = pageTest(db);
     MojTestErrCheck(err);
 
+    // add kind and objects for large result test
+    err = kindObj.fromJson(MojSearchKindStr3);
+    MojTestErrCheck(err);
+    err = db.putKind(kindObj);
+    MojTestErrCheck(err);
+    for (MojInt64 i = 0; i <= MojSearchLargeCount; ++i) {
+        MojObject obj;
+        err = obj.putString(_T("_kind"), _T("SearchTest:3"));
+        MojTestErrCheck(err);
+        err = obj.put(_T("_id"), i);
+        MojTestErrCheck(err);
+        // the last object only matches one of the words
+        err = obj.putString(_T("foo"), i < MojSearchLargeCount ? _T("many items") : _T("many"));
+        MojTestErrCheck(err);
+        err = obj.put(_T("bar"), MojSearchLargeCount - i);
+        MojTestErrCheck(err);
+        err = db.put(obj);
+        MojTestErrCheck(err);
+    }
+    err = largeTest(db);
+    MojTestErrCheck(err);
+
+	err = db.close();
+	MojTestErrCheck(err);
+
+	err = spillTest();
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
+MojErr MojDbSearchTest::spillTest()
+{
+	// reopen with a tiny sort budget so that every query merges spilled runs
+	MojObject dbConf;
+	MojErr err = dbConf.put(_T("searchRunBytes"), 64);
+	MojTestErrCheck(err);
+	MojObject conf;
+	err = conf.put(_T("db"), dbConf);
+	MojTestErrCheck(err);
+
+	MojDb db;
+	err = db.configure(conf);
+	MojTestErrCheck(err);
+	err = db.open(MojDbTestDir);
+	MojTestErrCheck(err);
+
+	err = simpleTest(db);
+	MojTestErrCheck(err);
+	err = filterTest(db);
+	MojTestErrCheck(err);
+	err = pageTest(db);
+	MojTestErrCheck(err);
+	err = largeTest(db);
+	MojTestErrCheck(err);
+
 	err = db.close();
 	MojTestErrCheck(err);
 
@@ -250,6 +313,57 @@ MojErr MojDbSearchTest::pageTest(MojDb& db)
     return MojErrNone;
 }
 
+MojErr MojDbSearchTest::largeTest(MojDb& db)
+{
+    // more matches than the old result cap, all of which have to be sorted
+    MojDbQuery query;
+    MojErr err = query.from(_T("SearchTest:3"));
+    MojTestErrCheck(err);
+    MojString val;
+    err = val.assign(_T("many items"));
+    MojTestErrCheck(err);
+    err = query.where(_T("foo"), MojDbQuery::OpSearch, val, MojDbCollationPrimary);
+    MojTestErrCheck(err);
+    err = query.order(_T("bar"));
+    MojTestErrCheck(err);
+    query.limit(3);
+
+    MojString str;
+    MojDbSearchCursor cursor(str);
+    err = db.find(query, cursor);
+    MojTestErrCheck(err);
+    MojUInt32 count = 0;
+    err = cursor.count(count);
+    MojTestErrCheck(err);
+    MojTestAssert(count == MojSearchLargeCount);
+    err = cursor.close();
+    MojTestErrCheck(err);
+
+    MojString expected;
+    err = expected.format(_T("[%lld,%lld,%lld]"), MojSearchLargeCount - 1, MojSearchLargeCount - 2, MojSearchLargeCount - 3);
+    MojTestErrCheck(err);
+    err = check(db, query, expected);
+    MojTestErrCheck(err);
+    query.desc(true);
+    err = check(db, query, _T("[0,1,2]"));
+    MojTestErrCheck(err);
+
+    // one word only, so the last object matches too
+    query.clear();
+    err = query.from(_T("SearchTest:3"));
+    MojTestErrCheck(err);
+    err = val.assign(_T("many"));
+    MojTestErrCheck(err);
+    err = query.where(_T("foo"), MojDbQuery::OpSearch, val, MojDbCollationPrimary);
+    MojTestErrCheck(err);
+    err = query.order(_T("bar"));
+    MojTestErrCheck(err);
+    query.limit(3);
+    err = check(db, query, _T("[10050,10049,10048]"));
+    MojTestErrCheck(err);
+
+    return MojErrNone;
+}
 
 MojErr MojDbSearchTest::initQuery(MojDbQuery& query, const MojChar* queryStr, const MojChar* orderBy, const MojObject& barVal, bool desc)
 {
@@ -34,6 +34,8 @@ private:
 	MojErr simpleTest(MojDb& db);
 	MojErr filterTest(MojDb& db);
     MojErr pageTest(MojDb& db);
+    MojErr largeTest(MojDb& db);
+	MojErr spillTest();
 
 	MojErr initQuery(MojDbQuery& query, const MojChar* queryStr,
 			const MojChar* orderBy = NULL, const MojObject& barVal = MojObject::Undefined, bool desc = false);
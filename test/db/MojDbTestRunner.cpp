@@ -26,6 +26,7 @@
 #include "MojDbConcurrencyTest.h"
 #include "MojDbCrudTest.h"
 #include "MojDbDumpLoadTest.h"
+#include "MojDbExternalSorterTest.h"
 #include "MojDbIndexTest.h"
 #include "MojDbKindTest.h"
 #include "MojDbLocaleTest.h"
@@ -74,6 +75,7 @@ void MojDbTestRunner::runTests()
 	test(MojDbConcurrencyTest());
 	test(MojDbCrudTest());
 	test(MojDbDumpLoadTest());
+	test(MojDbExternalSorterTest());
 	test(MojDbIndexTest());
 	test(MojDbKindTest());
 	test(MojDbLocaleTest());
@@ -141,6 +141,12 @@ MojErr MojDbTestStorageEngine::compact()
 	return m_engine->compact();
 }
 
+MojErr MojDbTestStorageEngine::stats(MojObject& objOut)
+{
+	MojAssert(m_engine.get());
+	return m_engine->stats(objOut);
+}
+
 MojErr MojDbTestStorageEngine::setNextError(const MojChar* methodName, MojErr err)
 {
 	if (err == MojErrNone) {
@@ -227,6 +233,24 @@ MojErr MojDbTestStorageDatabase::update(const MojObject& id, MojBuffer& val, Moj
 	return m_db->update(id, val, oldVal, MojTestTxn(txn));
 }
 
+MojErr MojDbTestStorageDatabase::insertCompressed(const MojObject& id, MojBuffer& val, MojDbStorageTxn* txn)
+{
+	MojErr err = m_testEngine->checkErrMap(_T("db.insert"));
+	MojErrCheck(err);
+
+	MojAssert(m_db.get());
+	return m_db->insertCompressed(id, val, MojTestTxn(txn));
+}
+
+MojErr MojDbTestStorageDatabase::updateCompressed(const MojObject& id, MojBuffer& val, MojDbStorageItem* oldVal, MojDbStorageTxn* txn)
+{
+	MojErr err = m_testEngine->checkErrMap(_T("db.update"));
+	MojErrCheck(err);
+
+	MojAssert(m_db.get());
+	return m_db->updateCompressed(id, val, oldVal, MojTestTxn(txn));
+}
+
 MojErr MojDbTestStorageDatabase::del(const MojObject& id, MojDbStorageTxn* txn, bool& foundOut)
 {
 	MojErr err = m_testEngine->checkErrMap(_T("db.del"));
@@ -519,3 +543,12 @@ MojErr MojDbTestStorageSeq::get(MojInt64& valOut)
 	MojAssert(m_seq.get());
 	return m_seq->get(valOut);
 }
+
+MojErr MojDbTestStorageSeq::get(MojInt64& valOut, MojDbStorageTxn* txn)
+{
+	MojErr err = m_testEngine->checkErrMap(_T("seq.get"));
+	MojErrCheck(err);
+
+	MojAssert(m_seq.get());
+	return m_seq->get(valOut, MojTestTxn(txn));
+}
@@ -39,6 +39,7 @@ public:
 	virtual MojErr openDatabase(const MojChar* name, MojDbStorageTxn* txn, MojRefCountedPtr<MojDbStorageDatabase>& dbOut);
 	virtual MojErr openSequence(const MojChar* name, MojDbStorageTxn* txn, MojRefCountedPtr<MojDbStorageSeq>& seqOut);
 	virtual MojErr beginTxn(MojRefCountedPtr<MojDbStorageTxn>& txnOut);
+	virtual MojErr stats(MojObject& objOut);
 
 	ErrorMap& errMap() { return m_errMap; }
 	MojDbStorageEngine* engine() { return m_engine.get(); }
@@ -77,6 +78,7 @@ public:
 
 	virtual MojErr close();
 	virtual MojErr get(MojInt64& valOut);
+	virtual MojErr get(MojInt64& valOut, MojDbStorageTxn* txn);
 
 private:
 	MojRefCountedPtr<MojDbStorageSeq> m_seq;
@@ -93,6 +95,8 @@ public:
 	virtual MojErr stats(MojDbStorageTxn* txn, MojSize& countOut, MojSize& sizeOut);
 	virtual MojErr insert(const MojObject& id, MojBuffer& val, MojDbStorageTxn* txn);
 	virtual MojErr update(const MojObject& id, MojBuffer& val, MojDbStorageItem* oldVal, MojDbStorageTxn* txn);
+	virtual MojErr insertCompressed(const MojObject& id, MojBuffer& val, MojDbStorageTxn* txn);
+	virtual MojErr updateCompressed(const MojObject& id, MojBuffer& val, MojDbStorageItem* oldVal, MojDbStorageTxn* txn);
 	virtual MojErr del(const MojObject& id, MojDbStorageTxn* txn, bool& foundOut);
 	virtual MojErr get(const MojObject& id, MojDbStorageTxn* txn, bool forUpdate, MojRefCountedPtr<MojDbStorageItem>& itemOut);
 	virtual MojErr find(MojAutoPtr<MojDbQueryPlan> plan, MojDbStorageTxn* txn, MojRefCountedPtr<MojDbStorageQuery>& queryOut);
@@ -135,6 +139,7 @@ public:
 	virtual MojErr count(MojUInt32& countOut);
 	virtual MojErr nextPage(MojDbQuery::Page& pageOut);
 	virtual MojUInt32 groupCount() const { return m_query->groupCount(); }
+	virtual MojUInt32 keysScanned() const { return m_query->keysScanned(); }
 	virtual void excludeKinds(const StringSet& toExclude) { m_query->excludeKinds(toExclude); }
 
 private:
@@ -258,7 +258,7 @@ MojErr MojDbTextCollatorTest::simpleTest1()
 	MojTestErrCheck(err);
 	err = colEn1.sortKey(str8, key2);
 	MojTestErrCheck(err);
-	err = key1.byteVec().pop();
+	err = key1.truncate(key1.size() - 1);
 	MojTestErrCheck(err);
 	MojTestAssert(key1.prefixOf(key2));
 
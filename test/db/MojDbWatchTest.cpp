@@ -87,6 +87,10 @@ MojErr MojDbWatchTest::run()
 	err = db.close();
 	MojTestErrCheck(err);
 
+	err = asyncTest();
+	MojTestErrCheck(err);
+	MojTestAssert(TestWatcher::s_instanceCount == 0);
+
 	return MojErrNone;
 }
 
@@ -506,6 +510,100 @@ MojErr MojDbWatchTest::limitTest(MojDb& db)
 	return MojErrNone;
 }
 
+MojErr MojDbWatchTest::asyncTest()
+{
+	// a window long enough that only flush and close deliver
+	MojObject dbConf;
+	MojErr err = dbConf.put(MojDbWatchNotifier::AsyncKey, true);
+	MojTestErrCheck(err);
+	err = dbConf.put(MojDbWatchNotifier::WindowKey, 60000);
+	MojTestErrCheck(err);
+	MojObject conf;
+	err = conf.put(_T("db"), dbConf);
+	MojTestErrCheck(err);
+	MojDb db;
+	err = db.configure(conf);
+	MojTestErrCheck(err);
+	err = db.open(MojDbTestDir);
+	MojTestErrCheck(err);
+
+	MojDbQuery query;
+	err = query.from(_T("WatchTest:1"));
+	MojTestErrCheck(err);
+	err = query.where(_T("foo"), MojDbQuery::OpEq, 7);
+	MojTestErrCheck(err);
+	MojRefCountedPtr<TestWatcher> watcher(new TestWatcher);
+	MojTestAssert(watcher.get());
+	MojDbCursor cursor;
+	err = db.find(query, cursor, watcher->m_slot);
+	MojTestErrCheck(err);
+	err = cursor.close();
+	MojTestErrCheck(err);
+
+	// every commit hits the watcher, but it is only fired once, and not on the committing thread
+	const int numPuts = 10;
+	MojObject id;
+	for (int i = 0; i < numPuts; ++i) {
+		err = put(db, 7, i, id, m_rev);
+		MojTestErrCheck(err);
+	}
+	MojTestAssert(watcher->m_count == 0);
+	err = db.watchNotifier()->flush();
+	MojTestErrCheck(err);
+	MojTestAssert(watcher->m_count == 1);
+
+	MojObject stats;
+	err = db.watchNotifier()->stats(stats);
+	MojTestErrCheck(err);
+	MojInt64 posts = 0;
+	MojTestAssert(stats.get(_T("posts"), posts) && posts >= numPuts);
+	MojInt64 coalesced = 0;
+	MojTestAssert(stats.get(_T("coalesced"), coalesced) && coalesced == posts - 1);
+	MojInt64 delivered = 0;
+	MojTestAssert(stats.get(_T("delivered"), delivered) && delivered == 1);
+
+	// close delivers whatever is still pending
+	watcher.reset(new TestWatcher);
+	MojTestAssert(watcher.get());
+	err = db.find(query, cursor, watcher->m_slot);
+	MojTestErrCheck(err);
+	err = cursor.close();
+	MojTestErrCheck(err);
+	err = put(db, 7, 0, id, m_rev);
+	MojTestErrCheck(err);
+	MojTestAssert(watcher->m_count == 0);
+	err = db.close();
+	MojTestErrCheck(err);
+	MojTestAssert(watcher->m_count == 1);
+
+	// a fire still queued when its kind is deleted is delivered once the index is gone
+	err = db.open(MojDbTestDir);
+	MojTestErrCheck(err);
+	watcher.reset(new TestWatcher);
+	MojTestAssert(watcher.get());
+	err = db.find(query, cursor, watcher->m_slot);
+	MojTestErrCheck(err);
+	err = cursor.close();
+	MojTestErrCheck(err);
+	err = put(db, 7, 0, id, m_rev);
+	MojTestErrCheck(err);
+	MojTestAssert(watcher->m_count == 0);
+	MojString kindId;
+	err = kindId.assign(_T("WatchTest:1"));
+	MojTestErrCheck(err);
+	bool found = false;
+	err = db.delKind(kindId, found);
+	MojTestErrCheck(err);
+	MojTestAssert(found);
+	err = db.watchNotifier()->flush();
+	MojTestErrCheck(err);
+	MojTestAssert(watcher->m_count == 1);
+	err = db.close();
+	MojTestErrCheck(err);
+
+	return MojErrNone;
+}
+
 MojErr MojDbWatchTest::put(MojDb& db, const MojObject& fooVal, const MojObject& barVal, MojObject& idOut, MojInt64& revOut)
 {
 	MojObject obj;
@@ -38,6 +38,7 @@ private:
 	MojErr rangeTest(MojDb& db);
 	MojErr pageTest(MojDb& db);
 	MojErr limitTest(MojDb& db);
+	MojErr asyncTest();
 
 	MojErr put(MojDb& db, const MojObject& fooVal, const MojObject& barVal, MojObject& idOut, MojInt64& revOut);
 	MojErr merge(MojDb& db, const MojObject& id, const MojObject& barVal);
@@ -28,7 +28,7 @@
 
 struct TestContainerIterator: public ::testing::Test
 {
-    std::map<std::string, std::string> db;
+    MojDbLevelTxnBuffer db;
 
     void SetUp()
     {
@@ -42,10 +42,10 @@ struct TestContainerIterator: public ::testing::Test
 
     void initSample()
     {
-        db["b"] = "db-0";
-        db["d"] = "db-1";
-        db["e"] = "db-2";
-        db["g"] = "db-3";
+        db.put("b", "db-0");
+        db.put("d", "db-1");
+        db.put("e", "db-2");
+        db.put("g", "db-3");
     }
 };
 
@@ -55,8 +55,8 @@ TEST_F(TestContainerIterator, tails)
 
     it.toFirst();
     ASSERT_TRUE( it.isValid() );
-    EXPECT_EQ( "b", it->first );
-    EXPECT_EQ( "db-0", it->second );
+    EXPECT_EQ( "b", it->key );
+    EXPECT_EQ( "db-0", it->value );
     --it;
     ASSERT_FALSE( it.isValid() );
     EXPECT_TRUE( it.isBegin() );
@@ -64,8 +64,8 @@ TEST_F(TestContainerIterator, tails)
 
     it.toLast();
     ASSERT_TRUE( it.isValid() );
-    EXPECT_EQ( "g", it->first );
-    EXPECT_EQ( "db-3", it->second );
+    EXPECT_EQ( "g", it->key );
+    EXPECT_EQ( "db-3", it->value );
     ++it;
     EXPECT_FALSE( it.isValid() );
     EXPECT_FALSE( it.isBegin() );
@@ -77,8 +77,8 @@ TEST_F(TestContainerIterator, tails)
     EXPECT_FALSE( it.isEnd() );
     ++it;
     ASSERT_TRUE( it.isValid() );
-    EXPECT_EQ( "b", it->first );
-    EXPECT_EQ( "db-0", it->second );
+    EXPECT_EQ( "b", it->key );
+    EXPECT_EQ( "db-0", it->value );
 
     it.toEnd();
     EXPECT_FALSE( it.isValid() );
@@ -86,8 +86,8 @@ TEST_F(TestContainerIterator, tails)
     EXPECT_TRUE( it.isEnd() );
     --it;
     ASSERT_TRUE( it.isValid() );
-    EXPECT_EQ( "g", it->first );
-    EXPECT_EQ( "db-3", it->second );
+    EXPECT_EQ( "g", it->key );
+    EXPECT_EQ( "db-3", it->value );
 }
 
 TEST_F(TestContainerIterator, walk)
@@ -96,48 +96,48 @@ TEST_F(TestContainerIterator, walk)
 
     it.toFirst();
     ASSERT_TRUE( it.isValid() );
-    EXPECT_EQ( "b", it->first );
-    EXPECT_EQ( "db-0", it->second );
+    EXPECT_EQ( "b", it->key );
+    EXPECT_EQ( "db-0", it->value );
     ++it;
     ASSERT_TRUE( it.isValid() );
-    EXPECT_EQ( "d", it->first );
-    EXPECT_EQ( "db-1", it->second );
+    EXPECT_EQ( "d", it->key );
+    EXPECT_EQ( "db-1", it->value );
     ++it;
     ASSERT_TRUE( it.isValid() );
-    EXPECT_EQ( "e", it->first );
-    EXPECT_EQ( "db-2", it->second );
+    EXPECT_EQ( "e", it->key );
+    EXPECT_EQ( "db-2", it->value );
     --it;
     ASSERT_TRUE( it.isValid() );
-    EXPECT_EQ( "d", it->first );
-    EXPECT_EQ( "db-1", it->second );
+    EXPECT_EQ( "d", it->key );
+    EXPECT_EQ( "db-1", it->value );
     ++it;
     ASSERT_TRUE( it.isValid() );
-    EXPECT_EQ( "e", it->first );
-    EXPECT_EQ( "db-2", it->second );
+    EXPECT_EQ( "e", it->key );
+    EXPECT_EQ( "db-2", it->value );
     ++it;
     ASSERT_TRUE( it.isValid() );
-    EXPECT_EQ( "g", it->first );
-    EXPECT_EQ( "db-3", it->second );
+    EXPECT_EQ( "g", it->key );
+    EXPECT_EQ( "db-3", it->value );
     ++it;
     EXPECT_FALSE( it.isValid() );
     EXPECT_FALSE( it.isBegin() );
     EXPECT_TRUE( it.isEnd() );
     --it;
     ASSERT_TRUE( it.isValid() );
-    EXPECT_EQ( "g", it->first );
-    EXPECT_EQ( "db-3", it->second );
+    EXPECT_EQ( "g", it->key );
+    EXPECT_EQ( "db-3", it->value );
     it.toFirst();
     ASSERT_TRUE( it.isValid() );
-    EXPECT_EQ( "b", it->first );
-    EXPECT_EQ( "db-0", it->second );
+    EXPECT_EQ( "b", it->key );
+    EXPECT_EQ( "db-0", it->value );
     --it;
     EXPECT_FALSE( it.isValid() );
     EXPECT_TRUE( it.isBegin() );
     EXPECT_FALSE( it.isEnd() );
     ++it;
     ASSERT_TRUE( it.isValid() );
-    EXPECT_EQ( "b", it->first );
-    EXPECT_EQ( "db-0", it->second );
+    EXPECT_EQ( "b", it->key );
+    EXPECT_EQ( "db-0", it->value );
 }
 
 TEST_F(TestContainerIterator, seek)
@@ -145,22 +145,22 @@ TEST_F(TestContainerIterator, seek)
     MojDbLevelContainerIterator it(db);
 
     // it.seek("b");
-    it = db.lower_bound("b");
+    it = db.lowerBound("b");
     ASSERT_TRUE( it.isValid() );
-    EXPECT_EQ( "b", it->first );
-    EXPECT_EQ( "db-0", it->second );
+    EXPECT_EQ( "b", it->key );
+    EXPECT_EQ( "db-0", it->value );
 
     // it.seek("c");
-    it = db.lower_bound("c");
+    it = db.lowerBound("c");
     ASSERT_TRUE( it.isValid() );
-    EXPECT_EQ( "d", it->first );
-    EXPECT_EQ( "db-1", it->second );
+    EXPECT_EQ( "d", it->key );
+    EXPECT_EQ( "db-1", it->value );
 
     // it.seek("g");
-    it = db.lower_bound("g");
+    it = db.lowerBound("g");
     ASSERT_TRUE( it.isValid() );
-    EXPECT_EQ( "g", it->first );
-    EXPECT_EQ( "db-3", it->second );
+    EXPECT_EQ( "g", it->key );
+    EXPECT_EQ( "db-3", it->value );
 }
 
 TEST_F(TestContainerIterator, seekReverse)
@@ -168,14 +168,14 @@ TEST_F(TestContainerIterator, seekReverse)
     MojDbLevelContainerIterator it(db);
 
     // it.seek("h");
-    it = db.lower_bound("h");
+    it = db.lowerBound("h");
     EXPECT_FALSE( it.isValid() );
     EXPECT_FALSE( it.isBegin() );
     EXPECT_TRUE( it.isEnd() );
     --it;
     ASSERT_TRUE( it.isValid() );
-    EXPECT_EQ( "g", it->first );
-    EXPECT_EQ( "db-3", it->second );
+    EXPECT_EQ( "g", it->key );
+    EXPECT_EQ( "db-3", it->value );
 }
 
 TEST_F(TestContainerIterator, seekMissing)
@@ -183,14 +183,14 @@ TEST_F(TestContainerIterator, seekMissing)
     MojDbLevelContainerIterator it(db);
 
     // it.seek("d");
-    it = db.lower_bound("d");
+    it = db.lowerBound("d");
     ASSERT_TRUE( it.isValid() );
-    EXPECT_EQ( "d", it->first );
-    EXPECT_EQ( "db-1", it->second );
+    EXPECT_EQ( "d", it->key );
+    EXPECT_EQ( "db-1", it->value );
     --it;
     ASSERT_TRUE( it.isValid() );
-    EXPECT_EQ( "b", it->first );
-    EXPECT_EQ( "db-0", it->second );
+    EXPECT_EQ( "b", it->key );
+    EXPECT_EQ( "db-0", it->value );
 }
 
 TEST_F(TestContainerIterator, seekOutside)
@@ -198,13 +198,45 @@ TEST_F(TestContainerIterator, seekOutside)
     MojDbLevelContainerIterator it(db);
 
     // it.seek("0");
-    it = db.lower_bound("zzz");
+    it = db.lowerBound("zzz");
     EXPECT_FALSE( it.isValid() );
     EXPECT_FALSE( it.isBegin() );
     EXPECT_TRUE( it.isEnd() );
 
     --it;
     ASSERT_TRUE( it.isValid() );
-    EXPECT_EQ( "g", it->first );
-    EXPECT_EQ( "db-3", it->second );
+    EXPECT_EQ( "g", it->key );
+    EXPECT_EQ( "db-3", it->value );
+}
+
+TEST_F(TestContainerIterator, tombstones)
+{
+    db.del("d");
+    db.del("f");
+    db.put("g", "txn-0");
+
+    MojDbLevelContainerIterator it(db);
+
+    it.toFirst();
+    ASSERT_TRUE( it.isValid() );
+    EXPECT_EQ( "b", it->key );
+    ++it;
+    ASSERT_TRUE( it.isValid() );
+    EXPECT_EQ( "e", it->key );
+    ++it;
+    ASSERT_TRUE( it.isValid() );
+    EXPECT_EQ( "g", it->key );
+    EXPECT_EQ( "txn-0", it->value );
+    --it;
+    --it;
+    ASSERT_TRUE( it.isValid() );
+    EXPECT_EQ( "b", it->key );
+
+    // seek lands on the next live key
+    it = db.lowerBound("c");
+    ASSERT_TRUE( it.isValid() );
+    EXPECT_EQ( "e", it->key );
+
+    EXPECT_EQ( 3u, db.puts() );
+    EXPECT_EQ( 2u, db.deletes() );
 }
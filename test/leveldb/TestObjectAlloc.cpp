@@ -0,0 +1,185 @@
+/****************************************************************
+ * @@@LICENSE
+ *
+ * Copyright (c) 2014 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * LICENSE@@@
+ ****************************************************************/
+
+/****************************************************************
+ *  @file TestObjectAlloc.cpp
+ *  Heap allocations made by MojObject and by puts and finds through
+ *  MojDb. They live here rather than in test_core because only this
+ *  binary replaces the global allocator (see utils.cpp).
+ ****************************************************************/
+
+#include <cstdio>
+
+#include "db-luna/leveldb/MojDbLevelEngine.h"
+#include "db/MojDb.h"
+#include "core/MojObject.h"
+#include "core/MojUtil.h"
+
+#include "Runner.h"
+#include "utils.h"
+
+namespace {
+    const int NumCopies = 1000;
+    const int NumObjects = 500;
+    const int NumFinds = 20;
+    const MojUInt32 PageSize = 50;
+
+    const MojChar* const AllocKindStr =
+        _T("{\"id\":\"AllocTest:1\",")
+        _T("\"owner\":\"mojodb.admin\",")
+        _T("\"indexes\":[{\"name\":\"foo\",\"props\":[{\"name\":\"foo\"}]}]}");
+
+    // helpers return on the first error; callers stop counting either way
+    MojErr copyObject(const MojObject& obj, MojObject::ObjectVec& copies)
+    {
+        for (int i = 0; i < NumCopies; ++i) {
+            MojObject copy(obj);
+            MojObject array;
+            if (!copy.get(_T("array"), array))
+                MojErrThrow(MojErrNotFound);
+            MojErr err = copies.push(copy);
+            MojErrCheck(err);
+        }
+        return MojErrNone;
+    }
+
+    MojErr putObjects(MojDb& db, const MojString& kindId, const MojString& bar)
+    {
+        for (int i = 0; i < NumObjects; ++i) {
+            MojObject obj;
+            MojErr err = obj.put(MojDb::KindKey, kindId);
+            MojErrCheck(err);
+            err = obj.put(_T("foo"), (MojInt64) i);
+            MojErrCheck(err);
+            err = obj.put(_T("bar"), bar);
+            MojErrCheck(err);
+            err = db.put(obj);
+            MojErrCheck(err);
+        }
+        return MojErrNone;
+    }
+
+    MojErr findObjects(MojDb& db, const MojDbQuery& query, MojUInt32& countOut)
+    {
+        MojDbCursor cursor;
+        MojErr err = db.find(query, cursor);
+        MojErrCheck(err);
+        for (;;) {
+            MojObject obj;
+            bool found = false;
+            err = cursor.get(obj, found);
+            MojErrCheck(err);
+            if (!found)
+                break;
+            ++countOut;
+        }
+        err = cursor.close();
+        MojErrCheck(err);
+
+        return MojErrNone;
+    }
+}
+
+TEST(TestObjectAlloc, scalars)
+{
+    // scalars are stored inline
+    start_counting_allocations();
+    for (int i = 0; i < NumCopies; ++i) {
+        MojObject undef;
+        MojObject null(MojObject::TypeNull);
+        MojObject boolVal(true);
+        MojObject intVal((MojInt64) i);
+        MojObject decimalVal(MojDecimal(i, 5));
+        undef = intVal;
+        intVal = decimalVal;
+    }
+    size_t allocs = stop_counting_allocations();
+    EXPECT_EQ( 0u, allocs );
+}
+
+TEST(TestObjectAlloc, copies)
+{
+    MojObject obj;
+    MojAssertNoErr( obj.fromJson(_T("{\"str\":\"hello\",\"int\":5,\"array\":[1,2,3],\"obj\":{\"bool\":true}}")) );
+    MojObject::ObjectVec copies;
+    MojAssertNoErr( copies.reserve(NumCopies) );
+
+    // copies share the container payload
+    start_counting_allocations();
+    MojErr err = copyObject(obj, copies);
+    size_t allocs = stop_counting_allocations();
+    MojAssertNoErr( err );
+    EXPECT_EQ( 0u, allocs );
+
+    // until one side is modified
+    MojObject copy = obj;
+    start_counting_allocations();
+    err = copy.put(_T("int"), 6);
+    allocs = stop_counting_allocations();
+    MojAssertNoErr( err );
+#ifndef MOJ_FLAT_OBJECT_MAP
+    // flat maps un-share through MojRefCountAlloc, which is not counted here
+    EXPECT_LT( 0u, allocs );
+#endif
+}
+
+TEST(TestObjectAlloc, putFind)
+{
+    MojString path;
+    MojAssertNoErr( path.format(_T("%s/%s"), tempFolder, "object-alloc") );
+
+    MojRefCountedPtr<MojDbLevelEngine> engine(new MojDbLevelEngine);
+    ASSERT_TRUE( engine.get() );
+    MojAssertNoErr( engine->configure(MojObject()) );
+    MojAssertNoErr( engine->open(path.data()) );
+    MojDb db;
+    MojAssertNoErr( db.open(path.data(), engine.get()) );
+    MojObject kind;
+    MojAssertNoErr( kind.fromJson(AllocKindStr) );
+    MojAssertNoErr( db.putKind(kind) );
+
+    MojString kindId;
+    MojAssertNoErr( kindId.assign(_T("AllocTest:1")) );
+    MojString bar;
+    MojAssertNoErr( bar.assign(_T("a value that is put with every object")) );
+    start_counting_allocations();
+    MojErr err = putObjects(db, kindId, bar);
+    size_t putAllocs = stop_counting_allocations();
+    MojAssertNoErr( err );
+
+    MojDbQuery query;
+    MojAssertNoErr( query.from(_T("AllocTest:1")) );
+    query.limit(PageSize);
+    size_t findAllocs = 0;
+    MojUInt32 results = 0;
+    for (int i = 0; i < NumFinds; ++i) {
+        start_counting_allocations();
+        err = findObjects(db, query, results);
+        findAllocs += stop_counting_allocations();
+        MojAssertNoErr( err );
+    }
+    ASSERT_EQ( NumFinds * PageSize, results );
+
+    printf("[ PERF     ] %zu allocs per put, %zu allocs per object found\n",
+           putAllocs / NumObjects, findAllocs / results);
+
+    MojAssertNoErr( db.close() );
+    MojExpectNoErr( MojRmDirRecursive(path.data()) );
+}
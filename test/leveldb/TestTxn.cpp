@@ -22,7 +22,13 @@
  *  @file TestTxn.cpp
  ****************************************************************/
 
+#include <cstdio>
+#include <unistd.h>
+
 #include "db-luna/leveldb/MojDbLevelTxn.h"
+#include "db-luna/leveldb/MojDbLevelEngine.h"
+#include "db-luna/leveldb/MojDbLevelDatabase.h"
+#include "core/MojUtil.h"
 
 #include "Runner.h"
 #include "TestTxn.h"
@@ -173,3 +179,163 @@ TEST_F(TestTxn, snapshotTransparency)
     AssertLdbOk( ttxn.Get("b", val) );
     EXPECT_EQ( "db-0", val );
 }
+
+TEST_F(TestTxn, redoRoundTrip)
+{
+    initSample();
+    ttxn.begin(*db);
+    initTxnSampleA(ttxn);
+
+    std::string record;
+    ttxn.appendRedo(record);
+    ttxn.abort();
+
+    // replaying the record must give the same result as a direct commit
+    leveldb::Slice rest(record);
+    leveldb::WriteBatch batch;
+    ASSERT_EQ( MojErrNone, MojDbLevelTableTxn::parseRedo(rest, batch) );
+    EXPECT_TRUE( rest.empty() );
+    AssertLdbOk( db->Write(leveldb::WriteOptions(), &batch) );
+
+    std::string val;
+    leveldb::ReadOptions ro;
+
+    AssertLdbOk( db->Get(ro, "a", &val) );
+    EXPECT_EQ( "txn-0", val );
+
+    EXPECT_TRUE( db->Get(ro, "b", &val).IsNotFound() );
+
+    AssertLdbOk( db->Get(ro, "h", &val) );
+    EXPECT_EQ( "txn-4", val );
+
+    // truncated record is rejected
+    leveldb::Slice truncated(record.data(), record.size() - 1);
+    leveldb::WriteBatch batch2;
+    EXPECT_NE( MojErrNone, MojDbLevelTableTxn::parseRedo(truncated, batch2) );
+}
+
+TEST_F(TestTxn, redoReplay)
+{
+    MojString path;
+    MojAssertNoErr( path.format(_T("%s/%s"), tempFolder, "redo-engine") );
+
+    // log a two-table record but crash before applying it
+    {
+        MojDbLevelEngine engine;
+        MojAssertNoErr( engine.configure(MojObject()) );
+        MojAssertNoErr( engine.open(path.data()) );
+
+        bool created = false;
+        MojRefCountedPtr<MojDbLevelDatabase> dbA(new MojDbLevelDatabase);
+        MojRefCountedPtr<MojDbLevelDatabase> dbB(new MojDbLevelDatabase);
+        MojAssertNoErr( dbA->open(_T("a.ldb"), &engine, created, NULL) );
+        MojAssertNoErr( dbB->open(_T("b.ldb"), &engine, created, NULL) );
+
+        MojDbLevelTableTxn txnA, txnB;
+        MojAssertNoErr( txnA.begin(*dbA->impl()) );
+        MojAssertNoErr( txnB.begin(*dbB->impl()) );
+        initTxnSampleA(txnA);
+        txnB.Put("x", "txn-b");
+
+        std::string record;
+        MojDbLevelTableTxn::putFixed32(record, 2);
+        MojDbLevelTableTxn::putBytes(record, leveldb::Slice(dbA->name().data(), dbA->name().length()));
+        txnA.appendRedo(record);
+        MojDbLevelTableTxn::putBytes(record, leveldb::Slice(dbB->name().data(), dbB->name().length()));
+        txnB.appendRedo(record);
+        txnA.abort();
+        txnB.abort();
+
+        std::string key;
+        MojAssertNoErr( engine.redoBegin(record, key) );
+        EXPECT_TRUE( engine.redoPending() );
+
+        MojAssertNoErr( dbA->close() );
+        MojAssertNoErr( dbB->close() );
+        MojAssertNoErr( engine.close() );
+    }
+
+    // records name tables relative to the engine, so they replay where the directory now lives
+    MojString movedPath;
+    MojAssertNoErr( movedPath.format(_T("%s/%s"), tempFolder, "redo-engine-moved") );
+    ASSERT_EQ( 0, rename(path.data(), movedPath.data()) );
+
+    // opening the engine again applies it to both tables
+    {
+        MojDbLevelEngine engine;
+        MojAssertNoErr( engine.configure(MojObject()) );
+        MojAssertNoErr( engine.open(movedPath.data()) );
+        EXPECT_FALSE( engine.redoPending() );
+
+        bool created = false;
+        MojRefCountedPtr<MojDbLevelDatabase> dbA(new MojDbLevelDatabase);
+        MojRefCountedPtr<MojDbLevelDatabase> dbB(new MojDbLevelDatabase);
+        MojAssertNoErr( dbA->open(_T("a.ldb"), &engine, created, NULL) );
+        MojAssertNoErr( dbB->open(_T("b.ldb"), &engine, created, NULL) );
+
+        std::string val;
+        leveldb::ReadOptions ro;
+        AssertLdbOk( dbA->impl()->Get(ro, "a", &val) );
+        EXPECT_EQ( "txn-0", val );
+        AssertLdbOk( dbA->impl()->Get(ro, "h", &val) );
+        EXPECT_EQ( "txn-4", val );
+        AssertLdbOk( dbB->impl()->Get(ro, "x", &val) );
+        EXPECT_EQ( "txn-b", val );
+
+        // a retired record stays in the log until a checkpoint syncs its tables
+        std::string key;
+        MojAssertNoErr( engine.redoBegin(std::string(4, '\0'), key) );
+        MojAssertNoErr( engine.redoEnd(key) );
+        EXPECT_TRUE( engine.redoPending() );
+        AssertLdbOk( engine.redoDb()->impl()->Get(ro, key, &val) );
+
+        MojAssertNoErr( engine.redoCheckpoint() );
+        EXPECT_FALSE( engine.redoPending() );
+        EXPECT_TRUE( engine.redoDb()->impl()->Get(ro, key, &val).IsNotFound() );
+
+        MojAssertNoErr( dbA->close() );
+        MojAssertNoErr( dbB->close() );
+        MojAssertNoErr( engine.close() );
+    }
+    EXPECT_NE( 0, access(path.data(), F_OK) );
+
+    MojExpectNoErr( MojRmDirRecursive(movedPath.data()) );
+}
+
+TEST_F(TestTxn, redoReplayMissingTable)
+{
+    MojString path;
+    MojAssertNoErr( path.format(_T("%s/%s"), tempFolder, "redo-missing") );
+
+    // log a record for a table that is gone by the time it replays
+    {
+        MojDbLevelEngine engine;
+        MojAssertNoErr( engine.configure(MojObject()) );
+        MojAssertNoErr( engine.open(path.data()) );
+
+        MojDbLevelTableTxn txn;
+        txn.Put("x", "lost");
+        std::string record;
+        MojDbLevelTableTxn::putFixed32(record, 1);
+        const std::string name("gone.ldb");
+        MojDbLevelTableTxn::putBytes(record, name);
+        txn.appendRedo(record);
+
+        std::string key;
+        MojAssertNoErr( engine.redoBegin(record, key) );
+        MojAssertNoErr( engine.close() );
+    }
+
+    // replay refuses to create it
+    {
+        MojDbLevelEngine engine;
+        MojAssertNoErr( engine.configure(MojObject()) );
+        EXPECT_NE( MojErrNone, engine.open(path.data()) );
+        MojExpectNoErr( engine.close() );
+    }
+    MojString gone;
+    MojAssertNoErr( gone.format(_T("%s/%s"), path.data(), "gone.ldb") );
+    EXPECT_NE( 0, access(gone.data(), F_OK) );
+
+    MojExpectNoErr( MojRmDirRecursive(path.data()) );
+}
@@ -0,0 +1,112 @@
+/****************************************************************
+ * @@@LICENSE
+ *
+ * Copyright (c) 2014 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * LICENSE@@@
+ ****************************************************************/
+
+/****************************************************************
+ *  @file TestTxnPerf.cpp
+ *  Cost of a batch of puts, each read back, committed through the
+ *  engine's txn. Only engine and database calls are used, so the
+ *  same test runs against older txn implementations for comparison.
+ ****************************************************************/
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <sys/time.h>
+
+#include "db-luna/leveldb/MojDbLevelEngine.h"
+#include "db-luna/leveldb/MojDbLevelDatabase.h"
+#include "db-luna/leveldb/MojDbLevelItem.h"
+#include "core/MojUtil.h"
+
+#include "Runner.h"
+#include "utils.h"
+
+namespace {
+    const int BatchSize = 1000;
+    const int Rounds = 20;
+
+    double now()
+    {
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        return (double) tv.tv_sec * 1e6 + (double) tv.tv_usec;
+    }
+
+    void makeKey(int round, int i, char* buf, size_t len)
+    {
+        // object-like keys: kind prefix plus id, arriving out of order
+        snprintf(buf, len, "objects/kind.test:1/%02x%08x", round, (unsigned) ((i * 2654435761u) % 1000003));
+    }
+}
+
+TEST(TestTxnPerf, batchPutCommit)
+{
+    MojString path;
+    MojAssertNoErr( path.format(_T("%s/%s"), tempFolder, "txn-perf") );
+
+    MojDbLevelEngine engine;
+    MojAssertNoErr( engine.configure(MojObject()) );
+    MojAssertNoErr( engine.open(path.data()) );
+    bool created = false;
+    MojRefCountedPtr<MojDbLevelDatabase> db(new MojDbLevelDatabase);
+    MojAssertNoErr( db->open(_T("objects.ldb"), &engine, created, NULL) );
+
+    const std::string val(200, 'v');
+    char key[64];
+    size_t allocs = 0;
+    double putTime = 0;
+    double commitTime = 0;
+    for (int r = 0; r < Rounds; ++r)
+    {
+        MojRefCountedPtr<MojDbStorageTxn> txn;
+        MojAssertNoErr( engine.beginTxn(txn) );
+        bool found = true;
+        start_counting_allocations();
+        double start = now();
+        for (int i = 0; i < BatchSize; ++i)
+        {
+            makeKey(r, i, key, sizeof(key));
+            MojDbLevelItem keyItem;
+            MojDbLevelItem valItem;
+            MojAssertNoErr( keyItem.fromBytes((const MojByte*) key, strlen(key)) );
+            MojAssertNoErr( valItem.fromBytes((const MojByte*) val.data(), val.size()) );
+            MojAssertNoErr( db->put(keyItem, valItem, txn.get(), false) );
+
+            MojDbLevelItem readItem;
+            bool readFound = false;
+            MojAssertNoErr( db->get(keyItem, txn.get(), false, readItem, readFound) );
+            found = readFound && found;
+        }
+        double committing = now();
+        MojAssertNoErr( txn->commit() );
+        double done = now();
+        allocs += stop_counting_allocations();
+        putTime += committing - start;
+        commitTime += done - committing;
+        EXPECT_TRUE( found );
+    }
+
+    printf("[ PERF     ] %d x %d puts: %zu allocs, put+get %.0f us, commit %.0f us per txn\n",
+           Rounds, BatchSize, allocs / Rounds, putTime / Rounds, commitTime / Rounds);
+
+    MojAssertNoErr( db->close() );
+    MojAssertNoErr( engine.close() );
+    MojExpectNoErr( MojRmDirRecursive(path.data()) );
+}
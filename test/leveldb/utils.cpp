@@ -26,6 +26,8 @@
 #include <dirent.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdlib.h>
+#include <new>
 
 using std::string;
 
@@ -69,4 +71,62 @@ int remove_directory(const string& path)
     }
 
     return r;
-}
\ No newline at end of file
+}
+
+// Global allocation hooks for the perf tests. This file must not include
+// core headers: with MOJ_INTERNAL they declare their own inline operator new.
+// Only allocations made between start and stop are counted, so gtest's own
+// bookkeeping stays out of the numbers. Tests are built with -fno-exceptions,
+// so running out of memory aborts instead of throwing.
+static bool counting = false;
+static size_t allocations = 0;
+
+void start_counting_allocations()
+{
+    allocations = 0;
+    counting = true;
+}
+
+size_t stop_counting_allocations()
+{
+    counting = false;
+    return allocations;
+}
+
+static void* allocate(size_t size)
+{
+    if (counting) ++allocations;
+    return malloc(size ? size : 1);
+}
+
+void* operator new(size_t size)
+{
+    void* p = allocate(size);
+    if (!p) abort();
+    return p;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) throw()
+{
+    return allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) throw()
+{
+    return allocate(size);
+}
+
+void operator delete(void* p) throw()
+{
+    free(p);
+}
+
+void operator delete[](void* p) throw()
+{
+    free(p);
+}
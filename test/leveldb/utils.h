@@ -25,4 +25,8 @@
 
 int remove_directory(const std::string& path);
 
+// count the heap allocations made until stop_counting_allocations, which returns them
+void start_counting_allocations();
+size_t stop_counting_allocations();
+
 #endif
\ No newline at end of file
@@ -56,8 +56,9 @@ MojErr genDbImage(const MojChar* dirPath, MojDb& db, DATA_TYPE type)
         MojErrGoto(err, Done);
         if (stat.st_mode & S_IFREG){
             if (type == dataTypeObject) {
-                MojUInt32 count;
-                err = db.load(entryPath.data(), count);
+                // images are generated offline, nobody reads them while we load
+                MojUInt32 count = 0;
+                err = db.load(entryPath.data(), count, MojDb::FlagBulk);
             } else {
                 MojString inputStr;
                 MojObject inputObj;
@@ -176,6 +176,36 @@ MojErr doMigrate(MojObject& confObj)
     return MojErrNone;
 }
 
+MojErr doUpgrade(MojObject& confObj)
+{
+    MojObject dbConf;
+    MojErr err = confObj.getRequired("db", dbConf);
+    MojErrCheck(err);
+    MojString path;
+    err = dbConf.getRequired("path", path);
+    MojErrCheck(err);
+
+    // the current version is only stamped once retokenize succeeds, so an upgrade
+    // that was skipped or interrupted is picked up by the next run
+    MojDb db;
+    err = db.configure(confObj);
+    MojErrCheck(err);
+    err = db.open(path);
+    MojErrCheck(err);
+    if (db.openedVersion() < db.version()) {
+        // rewrite objects stored before prop tokens could exceed one byte
+        MojUInt32 count = 0;
+        err = db.retokenize(count);
+        MojErrCheck(err);
+        LOG_DEBUG("[db_mojodb] upgraded database from version %lld: %u objects rewritten",
+                  db.openedVersion(), count);
+    }
+    err = db.close();
+    MojErrCheck(err);
+
+    return MojErrNone;
+}
+
 int main(int argc, char**argv)
 {
 	if (argc != 2) {
@@ -208,6 +238,13 @@ int main(int argc, char**argv)
 		return 0;
 	}
 
+	err = doUpgrade(confObj);
+	if (err != MojErrNone)
+	{
+		LOG_ERROR(MSGID_DB_ERROR, 0, "Can't upgrade database");
+		return 0;
+	}
+
 	return 0;
 }
 